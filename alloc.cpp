@@ -0,0 +1,86 @@
+#include "alloc.hpp"
+#include "metrics.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <sstream>
+
+namespace alloc {
+
+static thread_local uint64_t t_count = 0;
+static thread_local uint64_t t_bytes = 0;
+
+Stats thread_totals() {
+	return Stats{t_count, t_bytes};
+}
+
+/** Фиксированная таблица областей: отчёт не должен сам аллоцировать внутри учитываемых областей. */
+struct ScopeRow {
+	const char* name;
+	uint64_t calls, count, bytes;
+};
+static const size_t kMaxScopes = 32;
+static ScopeRow g_rows[kMaxScopes];
+static size_t g_row_count = 0;
+static std::mutex g_mu;
+
+Scope::Scope(const char* name) : name_(name), start_(thread_totals()) {}
+
+Scope::~Scope() {
+	Stats now = thread_totals();
+	std::lock_guard<std::mutex> lk(g_mu);
+	size_t i = 0;
+	while (i < g_row_count && std::strcmp(g_rows[i].name, name_) != 0) ++i;
+	if (i == g_row_count) {
+		if (g_row_count == kMaxScopes) return;
+		g_rows[g_row_count++] = ScopeRow{name_, 0, 0, 0};
+	}
+	g_rows[i].calls++;
+	g_rows[i].count += now.count - start_.count;
+	g_rows[i].bytes += now.bytes - start_.bytes;
+}
+
+std::string report_json(const Stats& total) {
+	std::ostringstream js;
+	js << "{\"total\":{\"count\":" << total.count << ",\"bytes\":" << total.bytes << "},\"scopes\":{";
+	std::lock_guard<std::mutex> lk(g_mu);
+	for (size_t i = 0; i < g_row_count; ++i) {
+		if (i) js << ",";
+		js << "\"" << g_rows[i].name << "\":{\"calls\":" << g_rows[i].calls << ",\"count\":" << g_rows[i].count
+		   << ",\"bytes\":" << g_rows[i].bytes << "}";
+	}
+	js << "}}";
+	return js.str();
+}
+
+} // namespace alloc
+
+#if LABYRINTH_ALLOC_ACCOUNTING
+
+static void* counted_alloc(std::size_t n) {
+	alloc::t_count++;
+	alloc::t_bytes += n;
+	metrics::add(metrics::Counter::Allocations);
+	metrics::add(metrics::Counter::AllocBytes, n);
+	void* p = std::malloc(n ? n : 1);
+	if (!p) throw std::bad_alloc();
+	return p;
+}
+
+void* operator new(std::size_t n) { return counted_alloc(n); }
+void* operator new[](std::size_t n) { return counted_alloc(n); }
+void* operator new(std::size_t n, const std::nothrow_t&) noexcept {
+	try { return counted_alloc(n); } catch (...) { return nullptr; }
+}
+void* operator new[](std::size_t n, const std::nothrow_t&) noexcept {
+	try { return counted_alloc(n); } catch (...) { return nullptr; }
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+
+#endif
@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+/**
+ * Учёт аллокаций (опция сборки LABYRINTH_ALLOC_ACCOUNTING): счётчики operator new/delete
+ * и отчёт по областям LAB_ALLOC_SCOPE — CLI-команда и вызовы движка (load/save, ходы, бот, рендер).
+ * Без опции хуки не ставятся, области пустые, enabled() == false.
+ */
+namespace alloc {
+
+struct Stats {
+	uint64_t count{0};
+	uint64_t bytes{0};
+};
+
+constexpr bool enabled() {
+#if LABYRINTH_ALLOC_ACCOUNTING
+	return true;
+#else
+	return false;
+#endif
+}
+
+/** Аллокации текущего потока с начала работы. */
+Stats thread_totals();
+
+/** Включительный счёт аллокаций области; имя — строка со статическим временем жизни. */
+class Scope {
+public:
+	explicit Scope(const char* name);
+	~Scope();
+	Scope(const Scope&) = delete;
+	Scope& operator=(const Scope&) = delete;
+private:
+	const char* name_;
+	Stats start_;
+};
+
+/** {"total":{count,bytes},"scopes":{name:{calls,count,bytes}}} — по накопленным областям. */
+std::string report_json(const Stats& total);
+
+} // namespace alloc
+
+#if LABYRINTH_ALLOC_ACCOUNTING
+#define LAB_ALLOC_CAT2(a, b) a##b
+#define LAB_ALLOC_CAT(a, b) LAB_ALLOC_CAT2(a, b)
+#define LAB_ALLOC_SCOPE(name) alloc::Scope LAB_ALLOC_CAT(lab_alloc_scope_, __LINE__)(name)
+#else
+#define LAB_ALLOC_SCOPE(name) ((void)0)
+#endif
@@ -0,0 +1,19 @@
+#include "arena.hpp"
+
+namespace arena {
+
+static thread_local std::pmr::memory_resource* t_current = nullptr;
+
+std::pmr::memory_resource* current() {
+	return t_current ? t_current : std::pmr::new_delete_resource();
+}
+
+Scope::Scope() : res_(buf_, sizeof(buf_), std::pmr::new_delete_resource()), prev_(t_current) {
+	t_current = &res_;
+}
+
+Scope::~Scope() {
+	t_current = prev_;
+}
+
+} // namespace arena
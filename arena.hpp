@@ -0,0 +1,34 @@
+#pragma once
+#include <cstddef>
+#include <memory_resource>
+
+/**
+ * Арена короткоживущих данных действия: монотонный ресурс, который освобождается целиком в конце
+ * области arena::Scope (действие игрока, ход бота, рендер, проверка связности). Контейнеры берут
+ * ресурс через arena::current() и не должны переживать свою область. Вне областей current() —
+ * обычный new/delete.
+ */
+namespace arena {
+
+/** Ресурс самой внутренней открытой области потока. */
+std::pmr::memory_resource* current();
+
+/**
+ * Своя арена на время жизни объекта: первые kInline байт — в самом объекте (на стеке),
+ * дальше — блоки из new/delete. Вложенная область не трогает внешнюю и отдаёт память раньше неё.
+ */
+class Scope {
+public:
+	static constexpr size_t kInline = 8192;
+
+	Scope();
+	~Scope();
+	Scope(const Scope&) = delete;
+	Scope& operator=(const Scope&) = delete;
+private:
+	alignas(std::max_align_t) unsigned char buf_[kInline];
+	std::pmr::monotonic_buffer_resource res_;
+	std::pmr::memory_resource* prev_;
+};
+
+} // namespace arena
@@ -0,0 +1,94 @@
+#include "board256.hpp"
+#include "map.hpp"
+
+size_t Bits256::count() const {
+	size_t n = 0;
+	for (uint64_t x : w) n += static_cast<size_t>(__builtin_popcountll(x));
+	return n;
+}
+
+size_t Bits256::lowest() const {
+	for (size_t i = 0; i < 4; ++i)
+		if (w[i]) return i * 64 + static_cast<size_t>(__builtin_ctzll(w[i]));
+	return 256;
+}
+
+Bits256 Bits256::operator&(const Bits256& o) const {
+	return Bits256{{w[0] & o.w[0], w[1] & o.w[1], w[2] & o.w[2], w[3] & o.w[3]}};
+}
+
+Bits256 Bits256::operator|(const Bits256& o) const {
+	return Bits256{{w[0] | o.w[0], w[1] | o.w[1], w[2] | o.w[2], w[3] | o.w[3]}};
+}
+
+Bits256 Bits256::and_not(const Bits256& o) const {
+	return Bits256{{w[0] & ~o.w[0], w[1] & ~o.w[1], w[2] & ~o.w[2], w[3] & ~o.w[3]}};
+}
+
+Bits256 Bits256::shl(unsigned k) const {
+	if (k == 0) return *this;
+	return Bits256{{w[0] << k, (w[1] << k) | (w[0] >> (64 - k)), (w[2] << k) | (w[1] >> (64 - k)),
+	                (w[3] << k) | (w[2] >> (64 - k))}};
+}
+
+Bits256 Bits256::shr(unsigned k) const {
+	if (k == 0) return *this;
+	return Bits256{{(w[0] >> k) | (w[1] << (64 - k)), (w[1] >> k) | (w[2] << (64 - k)),
+	                (w[2] >> k) | (w[3] << (64 - k)), w[3] >> k}};
+}
+
+Board256::Board256(const LabyrinthMap& m) : width(m.width), height(m.height) {
+	for (size_t y = 0; y < height; ++y) {
+		for (size_t x = 0; x < width; ++x) {
+			const size_t i = bit(x, y);
+			cells.set(i);
+			if (m.can_move_right(x, y)) right.set(i);
+			if (m.can_move_down(x, y)) down.set(i);
+		}
+	}
+}
+
+Bits256 Board256::step(const Bits256& f) const {
+	// проход вправо есть только внутри строки, поэтому переносы между строками маска отсекает сама
+	return (f & right).shl(1) | (f.shr(1) & right) | (f & down).shl(kSide) | (f.shr(kSide) & down);
+}
+
+size_t Board256::distances(size_t sx, size_t sy, uint32_t* dist) const {
+	if (sx >= width || sy >= height) return 0;
+	Bits256 front, seen;
+	front.set(bit(sx, sy));
+	seen = front;
+	dist[sy * width + sx] = 0;
+	size_t nodes = 1;
+	for (uint32_t layer = 1;; ++layer) {
+		front = step(front).and_not(seen);
+		if (!front.any()) break;
+		seen = seen | front;
+		for (size_t i = 0; i < 4; ++i) {
+			for (uint64_t bits = front.w[i]; bits; bits &= bits - 1) {
+				const size_t b = i * 64 + static_cast<size_t>(__builtin_ctzll(bits));
+				dist[(b / kSide) * width + b % kSide] = layer;
+				nodes++;
+			}
+		}
+	}
+	return nodes;
+}
+
+size_t Board256::count_components(size_t& nodes) const {
+	size_t comps = 0;
+	Bits256 left = cells;
+	while (left.any()) {
+		Bits256 front;
+		front.set(left.lowest());
+		Bits256 seen = front;
+		while (front.any()) {
+			front = step(front).and_not(seen);
+			seen = seen | front;
+		}
+		nodes += seen.count();
+		left = left.and_not(seen);
+		comps++;
+	}
+	return comps;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+struct LabyrinthMap;
+
+/**
+ * Карты до 16×16 целиком в 256 битах: бит y*16 + x — клетка (x, y), строка — 16 бит подряд.
+ * Шаг волны по всей карте — несколько сдвигов и масок над четырьмя словами, без списков строк,
+ * как у общего flood::Grid. flood выбирает эту доску сам, когда карта помещается (fits);
+ * расстояния, компоненты и счётчик bfs_nodes совпадают с общим путём.
+ */
+struct Bits256 {
+	uint64_t w[4]{0, 0, 0, 0};
+
+	bool any() const { return (w[0] | w[1] | w[2] | w[3]) != 0; }
+	bool test(size_t i) const { return (w[i >> 6] >> (i & 63)) & 1u; }
+	void set(size_t i) { w[i >> 6] |= uint64_t{1} << (i & 63); }
+	size_t count() const;
+	/** Индекс младшего бита; только для непустого множества. */
+	size_t lowest() const;
+
+	Bits256 operator&(const Bits256& o) const;
+	Bits256 operator|(const Bits256& o) const;
+	Bits256 and_not(const Bits256& o) const;
+	/** Сдвиг к старшим битам (k < 64): клетка i → i + k. */
+	Bits256 shl(unsigned k) const;
+	Bits256 shr(unsigned k) const;
+};
+
+struct Board256 {
+	static constexpr size_t kSide = 16;
+
+	size_t width{0}, height{0};
+	Bits256 cells; // клетки карты
+	Bits256 right; // бит (x, y) — проход (x, y) → (x+1, y)
+	Bits256 down;  // бит (x, y) — проход (x, y) → (x, y+1)
+
+	static bool fits(size_t w, size_t h) { return w <= kSide && h <= kSide; }
+	static size_t bit(size_t x, size_t y) { return y * kSide + x; }
+	explicit Board256(const LabyrinthMap& m);
+
+	/** Клетки, соседние с front через открытые проходы (front тоже может попасть в ответ). */
+	Bits256 step(const Bits256& front) const;
+	/**
+	 * BFS-расстояния от (sx, sy) в dist[y*width + x] (width*height элементов, заранее kUnreached).
+	 * Возвращает число посещённых клеток — как bfs_nodes у flood::distances.
+	 */
+	size_t distances(size_t sx, size_t sy, uint32_t* dist) const;
+	/** Компоненты связности и посещённые клетки (для bfs_nodes). */
+	size_t count_components(size_t& nodes) const;
+};
@@ -0,0 +1,203 @@
+#include "botsearch.hpp"
+#include "arena.hpp"
+#include "flood.hpp"
+#include "metrics.hpp"
+#include "trace.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <memory_resource>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t kResponders = 2;   // отвечают только ближайшие к боту игроки, остальные стоят
+constexpr uint64_t kWorkPerUs = 4;  // единиц работы на микросекунду бюджета — с запасом для медленных машин
+constexpr double kKill = 1e9;       // удар ценнее любого сближения; раньше — лучше
+
+/** Расстояния от клетки бота и клетки в пределах его хода (по возрастанию индекса). */
+struct Field {
+	std::pmr::vector<uint32_t> dist;
+	std::pmr::vector<uint32_t> ball;
+};
+
+struct Search {
+	const LabyrinthMap& map;
+	// поля расстояний: на картах до 16×16 — Board256, иначе общий Grid
+	std::optional<Board256> board;
+	std::optional<flood::Grid> grid;
+	const size_t w, h, n;
+	std::pmr::unordered_map<uint32_t, Field> fields;
+	std::pmr::vector<char> hospital;
+	uint64_t work{0};
+	uint64_t limit;
+	Clock::time_point deadline;
+	bool aborted{false};
+	bool timed_out{false};
+
+	Search(const LabyrinthMap& m, size_t steps, unsigned budget_us)
+		: map(m), w(m.width), h(m.height), n(steps), fields(arena::current()),
+		  hospital(m.width * m.height, 0, arena::current()), limit(uint64_t{budget_us} * kWorkPerUs),
+		  deadline(Clock::now() + std::chrono::microseconds(budget_us)) {
+		for (size_t y = 0; y < h; ++y)
+			for (size_t x = 0; x < w; ++x) hospital[y * w + x] = m.cells[y][x] == CellContent::Hospital;
+		if (Board256::fits(w, h)) board.emplace(m);
+		else grid.emplace(m);
+	}
+
+	/** Учесть работу; false — бюджет кончился, текущая глубина не считается. */
+	bool tick(uint64_t units) {
+		if (aborted) return false;
+		const uint64_t before = work;
+		work += units;
+		if (work > limit) aborted = true;
+		else if ((before >> 10) != (work >> 10) && Clock::now() >= deadline) aborted = timed_out = true;
+		return !aborted;
+	}
+
+	const Field& field(uint32_t from) {
+		auto it = fields.find(from);
+		if (it != fields.end()) return it->second;
+		tick(board ? 2 : 1 + w * h / 16); // волна доски — несколько слов на слой
+		Field f{board ? flood::distances(*board, from % w, from / w) : flood::distances(*grid, from % w, from / w),
+		        std::pmr::vector<uint32_t>(arena::current())};
+		for (uint32_t c = 0; c < f.dist.size(); ++c)
+			if (f.dist[c] <= n) f.ball.push_back(c);
+		return fields.emplace(from, std::move(f)).first->second;
+	}
+
+	/** Шагов от клетки бота до клетки удара по игроку p (сама клетка или соседняя, как в жадном ходе). */
+	uint32_t strike_dist(const Field& f, uint32_t p) const {
+		const size_t x = p % w, y = p / w;
+		uint32_t d = f.dist[p];
+		if (x > 0) d = std::min(d, f.dist[p - 1]);
+		if (x + 1 < w) d = std::min(d, f.dist[p + 1]);
+		if (y > 0) d = std::min(d, f.dist[p - w]);
+		if (y + 1 < h) d = std::min(d, f.dist[p + w]);
+		return d;
+	}
+
+	bool adjacent_victim(uint32_t c, const std::pmr::vector<uint32_t>& players) const {
+		const size_t cx = c % w, cy = c / w;
+		for (uint32_t p : players) {
+			if (hospital[p]) continue;
+			const size_t px = p % w, py = p / w;
+			const size_t dx = cx > px ? cx - px : px - cx, dy = cy > py ? cy - py : py - cy;
+			if (dx + dy <= 1) return true;
+		}
+		return false;
+	}
+
+	/** Лист: ближе всех к удару — главное, сумма по остальным — разбивка равенств. */
+	double evaluate(uint32_t b, const std::pmr::vector<uint32_t>& players) {
+		const Field& f = field(b);
+		uint32_t best = flood::kUnreached;
+		double sum = 0;
+		for (uint32_t p : players) {
+			if (hospital[p]) continue;
+			const uint32_t d = strike_dist(f, p);
+			if (d == flood::kUnreached) continue;
+			best = std::min(best, d);
+			sum += d;
+		}
+		if (best == flood::kUnreached) return -2.0 * static_cast<double>(w * h);
+		return -static_cast<double>(best) - 1e-3 * sum;
+	}
+
+	/** Ход бота из b: лучшая клетка хода; depth — сколько ходов бота ещё просчитать. */
+	double bot_node(uint32_t b, std::pmr::vector<uint32_t>& players, int depth, int ply, uint32_t* best_cell) {
+		const Field& f = field(b);
+		double best = -std::numeric_limits<double>::infinity();
+		for (uint32_t c : f.ball) {
+			if (!tick(1)) return best;
+			double v;
+			if (f.dist[c] + 1 <= n && adjacent_victim(c, players)) v = kKill - ply;
+			else if (depth == 1) v = evaluate(c, players);
+			else v = chance_node(c, players, depth - 1, ply + 1);
+			if (v > best) {
+				best = v;
+				if (best_cell) *best_cell = c;
+			}
+		}
+		return best;
+	}
+
+	/** Ответ игроков на бота в c: среднее по шагам ближайших kResponders игроков. */
+	double chance_node(uint32_t c, std::pmr::vector<uint32_t>& players, int depth, int ply) {
+		const Field& f = field(c);
+		size_t who[kResponders];
+		uint32_t near[kResponders];
+		size_t k = 0;
+		for (size_t i = 0; i < players.size(); ++i) {
+			if (hospital[players[i]]) continue;
+			const uint32_t d = strike_dist(f, players[i]);
+			if (d == flood::kUnreached) continue;
+			size_t j;
+			if (k < kResponders) j = k++;
+			else if (d < near[kResponders - 1]) j = kResponders - 1;
+			else continue;
+			while (j > 0 && near[j - 1] > d) {
+				who[j] = who[j - 1];
+				near[j] = near[j - 1];
+				--j;
+			}
+			who[j] = i;
+			near[j] = d;
+		}
+		return respond(c, players, who, k, 0, depth, ply);
+	}
+
+	double respond(uint32_t c, std::pmr::vector<uint32_t>& players, const size_t* who, size_t k, size_t r,
+	               int depth, int ply) {
+		if (r >= k || r >= kResponders) return bot_node(c, players, depth, ply, nullptr);
+		const uint32_t p = players[who[r]];
+		const size_t x = p % w, y = p / w;
+		uint32_t opts[5];
+		size_t m = 0;
+		opts[m++] = p;
+		if (x > 0 && map.can_move_left(x, y)) opts[m++] = p - 1;
+		if (x + 1 < w && map.can_move_right(x, y)) opts[m++] = p + 1;
+		if (y > 0 && map.can_move_up(x, y)) opts[m++] = p - static_cast<uint32_t>(w);
+		if (y + 1 < h && map.can_move_down(x, y)) opts[m++] = p + static_cast<uint32_t>(w);
+		double sum = 0;
+		for (size_t i = 0; i < m && !aborted; ++i) {
+			players[who[r]] = opts[i];
+			sum += respond(c, players, who, k, r + 1, depth, ply);
+		}
+		players[who[r]] = p;
+		return sum / static_cast<double>(m);
+	}
+};
+
+} // namespace
+
+bool bot_search(const Game& g, const LabyrinthMap& map, size_t& tx, size_t& ty) {
+	LAB_TRACE_SCOPE("bot.search");
+	if (g.bot_search_depth <= 0 || g.bot_x >= map.width || g.bot_y >= map.height) return false;
+	arena::Scope scratch;
+	Search s(map, static_cast<size_t>(std::max(1, g.bot_steps_per_turn)), g.bot_search_budget_us);
+	std::pmr::vector<uint32_t> players(arena::current());
+	players.reserve(g.players.size());
+	for (PlayerId id = 0; id < g.players.size(); ++id)
+		players.push_back(static_cast<uint32_t>(g.players.pos[id].second * map.width + g.players.pos[id].first));
+
+	const uint32_t start = static_cast<uint32_t>(g.bot_y * map.width + g.bot_x);
+	bool found = false;
+	for (int depth = 1; depth <= g.bot_search_depth; ++depth) {
+		uint32_t cell = start;
+		const double v = s.bot_node(start, players, depth, 0, &cell);
+		if (s.aborted) break;
+		tx = cell % map.width;
+		ty = cell / map.width;
+		found = true;
+		if (v >= kKill) break; // удар сейчас глубже не улучшить
+	}
+	metrics::add(metrics::Counter::BotSearchWork, s.work);
+	if (s.timed_out) metrics::add(metrics::Counter::BotSearchTimeouts);
+	return found;
+}
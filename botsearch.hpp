@@ -0,0 +1,18 @@
+#pragma once
+#include "game.hpp"
+#include "map.hpp"
+
+#include <cstddef>
+
+/**
+ * Поиск хода бота с заглядыванием вперёд: expectimax с итеративным углублением. Узел бота — выбор
+ * клетки в пределах bot_steps_per_turn шагов (удар — как в жадном ходе), узел случая — ответ
+ * ближайших игроков: шаг в любую сторону или на месте, равновероятно.
+ *
+ * Бюджет bot_search_budget_us переводится в детерминированный лимит работы, поэтому при одном
+ * и том же состоянии ход один и тот же; часы — только страховка на медленной машине. Результат —
+ * последняя полностью просчитанная глубина. Генератор случайных чисел поиск не трогает.
+ */
+
+/** Клетка, куда идти боту; false — не успели просчитать даже один ход (остаётся жадный путь). */
+bool bot_search(const Game& g, const LabyrinthMap& map, size_t& tx, size_t& ty);
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/labyrinth.dir/main.cpp.o"
+  "CMakeFiles/labyrinth.dir/main.cpp.o.d"
+  "labyrinth"
+  "labyrinth.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/labyrinth.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/labyrinth_board256_check.dir/tests/board256_check.cpp.o"
+  "CMakeFiles/labyrinth_board256_check.dir/tests/board256_check.cpp.o.d"
+  "labyrinth_board256_check"
+  "labyrinth_board256_check.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/labyrinth_board256_check.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,50 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/alloc.cpp" "CMakeFiles/labyrinth_core.dir/alloc.cpp.o" "gcc" "CMakeFiles/labyrinth_core.dir/alloc.cpp.o.d"
+  "/root/repo/arena.cpp" "CMakeFiles/labyrinth_core.dir/arena.cpp.o" "gcc" "CMakeFiles/labyrinth_core.dir/arena.cpp.o.d"
+  "/root/repo/board256.cpp" "CMakeFiles/labyrinth_core.dir/board256.cpp.o" "gcc" "CMakeFiles/labyrinth_core.dir/board256.cpp.o.d"
+  "/root/repo/botsearch.cpp" "CMakeFiles/labyrinth_core.dir/botsearch.cpp.o" "gcc" "CMakeFiles/labyrinth_core.dir/botsearch.cpp.o.d"
+  "/root/repo/cellset.cpp" "CMakeFiles/labyrinth_core.dir/cellset.cpp.o" "gcc" "CMakeFiles/labyrinth_core.dir/cellset.cpp.o.d"
+  "/root/repo/engine.cpp" "CMakeFiles/labyrinth_core.dir/engine.cpp.o" "gcc" "CMakeFiles/labyrinth_core.dir/engine.cpp.o.d"
+  "/root/repo/events.cpp" "CMakeFiles/labyrinth_core.dir/events.cpp.o" "gcc" "CMakeFiles/labyrinth_core.dir/events.cpp.o.d"
+  "/root/repo/flood.cpp" "CMakeFiles/labyrinth_core.dir/flood.cpp.o" "gcc" "CMakeFiles/labyrinth_core.dir/flood.cpp.o.d"
+  "/root/repo/game.cpp" "CMakeFiles/labyrinth_core.dir/game.cpp.o" "gcc" "CMakeFiles/labyrinth_core.dir/game.cpp.o.d"
+  "/root/repo/generator.cpp" "CMakeFiles/labyrinth_core.dir/generator.cpp.o" "gcc" "CMakeFiles/labyrinth_core.dir/generator.cpp.o.d"
+  "/root/repo/items/Armor.cpp" "CMakeFiles/labyrinth_core.dir/items/Armor.cpp.o" "gcc" "CMakeFiles/labyrinth_core.dir/items/Armor.cpp.o.d"
+  "/root/repo/items/Flashlight.cpp" "CMakeFiles/labyrinth_core.dir/items/Flashlight.cpp.o" "gcc" "CMakeFiles/labyrinth_core.dir/items/Flashlight.cpp.o.d"
+  "/root/repo/items/Item.cpp" "CMakeFiles/labyrinth_core.dir/items/Item.cpp.o" "gcc" "CMakeFiles/labyrinth_core.dir/items/Item.cpp.o.d"
+  "/root/repo/items/Knife.cpp" "CMakeFiles/labyrinth_core.dir/items/Knife.cpp.o" "gcc" "CMakeFiles/labyrinth_core.dir/items/Knife.cpp.o.d"
+  "/root/repo/items/LootTreasure.cpp" "CMakeFiles/labyrinth_core.dir/items/LootTreasure.cpp.o" "gcc" "CMakeFiles/labyrinth_core.dir/items/LootTreasure.cpp.o.d"
+  "/root/repo/items/Rifle.cpp" "CMakeFiles/labyrinth_core.dir/items/Rifle.cpp.o" "gcc" "CMakeFiles/labyrinth_core.dir/items/Rifle.cpp.o.d"
+  "/root/repo/items/Shotgun.cpp" "CMakeFiles/labyrinth_core.dir/items/Shotgun.cpp.o" "gcc" "CMakeFiles/labyrinth_core.dir/items/Shotgun.cpp.o.d"
+  "/root/repo/journal.cpp" "CMakeFiles/labyrinth_core.dir/journal.cpp.o" "gcc" "CMakeFiles/labyrinth_core.dir/journal.cpp.o.d"
+  "/root/repo/locations/Arsenal.cpp" "CMakeFiles/labyrinth_core.dir/locations/Arsenal.cpp.o" "gcc" "CMakeFiles/labyrinth_core.dir/locations/Arsenal.cpp.o.d"
+  "/root/repo/locations/Exit.cpp" "CMakeFiles/labyrinth_core.dir/locations/Exit.cpp.o" "gcc" "CMakeFiles/labyrinth_core.dir/locations/Exit.cpp.o.d"
+  "/root/repo/locations/Hospital.cpp" "CMakeFiles/labyrinth_core.dir/locations/Hospital.cpp.o" "gcc" "CMakeFiles/labyrinth_core.dir/locations/Hospital.cpp.o.d"
+  "/root/repo/locations/Location.cpp" "CMakeFiles/labyrinth_core.dir/locations/Location.cpp.o" "gcc" "CMakeFiles/labyrinth_core.dir/locations/Location.cpp.o.d"
+  "/root/repo/locations/LocationUtils.cpp" "CMakeFiles/labyrinth_core.dir/locations/LocationUtils.cpp.o" "gcc" "CMakeFiles/labyrinth_core.dir/locations/LocationUtils.cpp.o.d"
+  "/root/repo/locations/Treasure.cpp" "CMakeFiles/labyrinth_core.dir/locations/Treasure.cpp.o" "gcc" "CMakeFiles/labyrinth_core.dir/locations/Treasure.cpp.o.d"
+  "/root/repo/map.cpp" "CMakeFiles/labyrinth_core.dir/map.cpp.o" "gcc" "CMakeFiles/labyrinth_core.dir/map.cpp.o.d"
+  "/root/repo/mapstats.cpp" "CMakeFiles/labyrinth_core.dir/mapstats.cpp.o" "gcc" "CMakeFiles/labyrinth_core.dir/mapstats.cpp.o.d"
+  "/root/repo/metrics.cpp" "CMakeFiles/labyrinth_core.dir/metrics.cpp.o" "gcc" "CMakeFiles/labyrinth_core.dir/metrics.cpp.o.d"
+  "/root/repo/raycast.cpp" "CMakeFiles/labyrinth_core.dir/raycast.cpp.o" "gcc" "CMakeFiles/labyrinth_core.dir/raycast.cpp.o.d"
+  "/root/repo/snapshot.cpp" "CMakeFiles/labyrinth_core.dir/snapshot.cpp.o" "gcc" "CMakeFiles/labyrinth_core.dir/snapshot.cpp.o.d"
+  "/root/repo/state.cpp" "CMakeFiles/labyrinth_core.dir/state.cpp.o" "gcc" "CMakeFiles/labyrinth_core.dir/state.cpp.o.d"
+  "/root/repo/trace.cpp" "CMakeFiles/labyrinth_core.dir/trace.cpp.o" "gcc" "CMakeFiles/labyrinth_core.dir/trace.cpp.o.d"
+  "/root/repo/viz.cpp" "CMakeFiles/labyrinth_core.dir/viz.cpp.o" "gcc" "CMakeFiles/labyrinth_core.dir/viz.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
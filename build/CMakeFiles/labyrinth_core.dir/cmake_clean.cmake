@@ -0,0 +1,71 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/labyrinth_core.dir/alloc.cpp.o"
+  "CMakeFiles/labyrinth_core.dir/alloc.cpp.o.d"
+  "CMakeFiles/labyrinth_core.dir/arena.cpp.o"
+  "CMakeFiles/labyrinth_core.dir/arena.cpp.o.d"
+  "CMakeFiles/labyrinth_core.dir/board256.cpp.o"
+  "CMakeFiles/labyrinth_core.dir/board256.cpp.o.d"
+  "CMakeFiles/labyrinth_core.dir/botsearch.cpp.o"
+  "CMakeFiles/labyrinth_core.dir/botsearch.cpp.o.d"
+  "CMakeFiles/labyrinth_core.dir/cellset.cpp.o"
+  "CMakeFiles/labyrinth_core.dir/cellset.cpp.o.d"
+  "CMakeFiles/labyrinth_core.dir/engine.cpp.o"
+  "CMakeFiles/labyrinth_core.dir/engine.cpp.o.d"
+  "CMakeFiles/labyrinth_core.dir/events.cpp.o"
+  "CMakeFiles/labyrinth_core.dir/events.cpp.o.d"
+  "CMakeFiles/labyrinth_core.dir/flood.cpp.o"
+  "CMakeFiles/labyrinth_core.dir/flood.cpp.o.d"
+  "CMakeFiles/labyrinth_core.dir/game.cpp.o"
+  "CMakeFiles/labyrinth_core.dir/game.cpp.o.d"
+  "CMakeFiles/labyrinth_core.dir/generator.cpp.o"
+  "CMakeFiles/labyrinth_core.dir/generator.cpp.o.d"
+  "CMakeFiles/labyrinth_core.dir/items/Armor.cpp.o"
+  "CMakeFiles/labyrinth_core.dir/items/Armor.cpp.o.d"
+  "CMakeFiles/labyrinth_core.dir/items/Flashlight.cpp.o"
+  "CMakeFiles/labyrinth_core.dir/items/Flashlight.cpp.o.d"
+  "CMakeFiles/labyrinth_core.dir/items/Item.cpp.o"
+  "CMakeFiles/labyrinth_core.dir/items/Item.cpp.o.d"
+  "CMakeFiles/labyrinth_core.dir/items/Knife.cpp.o"
+  "CMakeFiles/labyrinth_core.dir/items/Knife.cpp.o.d"
+  "CMakeFiles/labyrinth_core.dir/items/LootTreasure.cpp.o"
+  "CMakeFiles/labyrinth_core.dir/items/LootTreasure.cpp.o.d"
+  "CMakeFiles/labyrinth_core.dir/items/Rifle.cpp.o"
+  "CMakeFiles/labyrinth_core.dir/items/Rifle.cpp.o.d"
+  "CMakeFiles/labyrinth_core.dir/items/Shotgun.cpp.o"
+  "CMakeFiles/labyrinth_core.dir/items/Shotgun.cpp.o.d"
+  "CMakeFiles/labyrinth_core.dir/journal.cpp.o"
+  "CMakeFiles/labyrinth_core.dir/journal.cpp.o.d"
+  "CMakeFiles/labyrinth_core.dir/locations/Arsenal.cpp.o"
+  "CMakeFiles/labyrinth_core.dir/locations/Arsenal.cpp.o.d"
+  "CMakeFiles/labyrinth_core.dir/locations/Exit.cpp.o"
+  "CMakeFiles/labyrinth_core.dir/locations/Exit.cpp.o.d"
+  "CMakeFiles/labyrinth_core.dir/locations/Hospital.cpp.o"
+  "CMakeFiles/labyrinth_core.dir/locations/Hospital.cpp.o.d"
+  "CMakeFiles/labyrinth_core.dir/locations/Location.cpp.o"
+  "CMakeFiles/labyrinth_core.dir/locations/Location.cpp.o.d"
+  "CMakeFiles/labyrinth_core.dir/locations/LocationUtils.cpp.o"
+  "CMakeFiles/labyrinth_core.dir/locations/LocationUtils.cpp.o.d"
+  "CMakeFiles/labyrinth_core.dir/locations/Treasure.cpp.o"
+  "CMakeFiles/labyrinth_core.dir/locations/Treasure.cpp.o.d"
+  "CMakeFiles/labyrinth_core.dir/map.cpp.o"
+  "CMakeFiles/labyrinth_core.dir/map.cpp.o.d"
+  "CMakeFiles/labyrinth_core.dir/mapstats.cpp.o"
+  "CMakeFiles/labyrinth_core.dir/mapstats.cpp.o.d"
+  "CMakeFiles/labyrinth_core.dir/metrics.cpp.o"
+  "CMakeFiles/labyrinth_core.dir/metrics.cpp.o.d"
+  "CMakeFiles/labyrinth_core.dir/raycast.cpp.o"
+  "CMakeFiles/labyrinth_core.dir/raycast.cpp.o.d"
+  "CMakeFiles/labyrinth_core.dir/snapshot.cpp.o"
+  "CMakeFiles/labyrinth_core.dir/snapshot.cpp.o.d"
+  "CMakeFiles/labyrinth_core.dir/state.cpp.o"
+  "CMakeFiles/labyrinth_core.dir/state.cpp.o.d"
+  "CMakeFiles/labyrinth_core.dir/trace.cpp.o"
+  "CMakeFiles/labyrinth_core.dir/trace.cpp.o.d"
+  "CMakeFiles/labyrinth_core.dir/viz.cpp.o"
+  "CMakeFiles/labyrinth_core.dir/viz.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/labyrinth_core.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/labyrinth_scenarios.dir/tests/scenario_runner.cpp.o"
+  "CMakeFiles/labyrinth_scenarios.dir/tests/scenario_runner.cpp.o.d"
+  "labyrinth_scenarios"
+  "labyrinth_scenarios.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/labyrinth_scenarios.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,10 @@
+# CMake generated Testfile for 
+# Source directory: /root/repo
+# Build directory: /root/repo/build
+# 
+# This file includes the relevant testing commands required for 
+# testing this directory and lists subdirectories to be tested as well.
+add_test(scenarios "/root/repo/build/labyrinth_scenarios" "/root/repo/tests/scenarios")
+set_tests_properties(scenarios PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;109;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(board256 "/root/repo/build/labyrinth_board256_check")
+set_tests_properties(board256 PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;110;add_test;/root/repo/CMakeLists.txt;0;")
@@ -0,0 +1,57 @@
+#include "cellset.hpp"
+
+void CellSet::reset(size_t n) {
+	tree.assign(n + 1, 0);
+	bits.assign(n, 0);
+	count = 0;
+	top = 1;
+	while (top * 2 <= n) top *= 2;
+}
+
+void CellSet::add(size_t i, int delta) {
+	for (size_t j = i + 1; j < tree.size(); j += j & (~j + 1)) tree[j] = static_cast<uint32_t>(static_cast<int64_t>(tree[j]) + delta);
+}
+
+void CellSet::insert(size_t i) {
+	if (i >= bits.size() || bits[i]) return;
+	bits[i] = 1;
+	++count;
+	add(i, 1);
+}
+
+void CellSet::erase(size_t i) {
+	if (i >= bits.size() || !bits[i]) return;
+	bits[i] = 0;
+	--count;
+	add(i, -1);
+}
+
+size_t CellSet::rank(size_t i) const {
+	size_t s = 0;
+	for (size_t j = i < bits.size() ? i : bits.size(); j > 0; j -= j & (~j + 1)) s += tree[j];
+	return s;
+}
+
+size_t CellSet::select(size_t k) const {
+	// спуск по дереву: наибольшая позиция pos с префиксной суммой ≤ k
+	size_t pos = 0;
+	size_t rest = k;
+	for (size_t step = top; step > 0; step >>= 1) {
+		const size_t next = pos + step;
+		if (next < tree.size() && tree[next] <= rest) {
+			pos = next;
+			rest -= tree[next];
+		}
+	}
+	return pos; // 1-based pos → 0-based индекс pos
+}
+
+size_t CellSet::select_excluding(size_t k, const std::vector<size_t>& exclude) const {
+	// исключённые с рангом ≤ искомого сдвигают k на единицу каждый
+	size_t target = k;
+	for (size_t e : exclude) {
+		if (rank(e) <= target) ++target;
+		else break;
+	}
+	return select(target);
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Упорядоченное множество индексов клеток (y*width + x) на дереве Фенвика:
+ * вставка, удаление, ранг и k-й по порядку элемент за O(log n), размер за O(1).
+ * k-й элемент совпадает с k-м в обходе карты по строкам, поэтому выборка «случайной
+ * свободной клетки» даёт тот же результат, что и прежний список кандидатов при том же RNG.
+ */
+struct CellSet {
+	void reset(size_t n);
+	size_t capacity() const { return bits.size(); }
+	size_t size() const { return count; }
+	bool contains(size_t i) const { return i < bits.size() && bits[i]; }
+
+	void insert(size_t i);
+	void erase(size_t i);
+	void assign(size_t i, bool present) { if (present) insert(i); else erase(i); }
+
+	/** Сколько элементов строго меньше i. */
+	size_t rank(size_t i) const;
+	/** k-й по порядку элемент (с нуля), k < size(). */
+	size_t select(size_t k) const;
+	/**
+	 * k-й элемент множества без exclude; exclude отсортирован, без повторов и целиком
+	 * входит в множество. k < size() - exclude.size().
+	 */
+	size_t select_excluding(size_t k, const std::vector<size_t>& exclude) const;
+
+private:
+	std::vector<uint32_t> tree; // 1-based
+	std::vector<char> bits;
+	size_t count{0};
+	size_t top{0}; // старшая степень двойки ≤ n
+	void add(size_t i, int delta);
+};
@@ -105,12 +105,17 @@ echo ""
 echo ">> Building C++ backend..."
 mkdir -p "$PROJECT_DIR/build"
 cd "$PROJECT_DIR/build"
-cmake .. -DCMAKE_BUILD_TYPE=Release -DCMAKE_CXX_FLAGS="-O2" >/dev/null 2>&1
+cmake .. -DCMAKE_BUILD_TYPE=Release -DCMAKE_CXX_FLAGS="-O2" -DLABYRINTH_NODE_ADDON=ON >/dev/null 2>&1
 if ! make -j"$(nproc)" 2>&1; then
   echo "ERROR: C++ build failed (see errors above)"
   exit 1
 fi
-echo "   Binary: $PROJECT_DIR/build/labyrinth"
+echo "   Binary: $PROJECT_DIR/build/labyrinth (+ build/labyrinth_node.node)"
+if ! ./labyrinth_scenarios "$PROJECT_DIR/tests/scenarios" >/dev/null; then
+  ./labyrinth_scenarios "$PROJECT_DIR/tests/scenarios" | grep -v '^ok '
+  echo "ERROR: scenario tests failed"
+  exit 1
+fi
 
 # ── 4. Install Node.js dependencies ──
 echo ""
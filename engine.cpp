@@ -0,0 +1,415 @@
+#include "engine.hpp"
+#include "items/Knife.hpp"
+#include "items/Shotgun.hpp"
+#include "items/Rifle.hpp"
+#include "items/Flashlight.hpp"
+#include "items/Armor.hpp"
+#include "items/LootTreasure.hpp"
+#include "generator.hpp"
+#include "rng.hpp"
+#include "trace.hpp"
+#include "arena.hpp"
+#include "undo.hpp"
+
+#include <algorithm>
+#include <sstream>
+
+std::unique_ptr<Item> make_item(const std::string& id) {
+	if (id == "knife") return std::make_unique<Knife>();
+	if (id == "shotgun") return std::make_unique<Shotgun>();
+	if (id == "rifle") return std::make_unique<Rifle>();
+	if (id == "flashlight") return std::make_unique<Flashlight>();
+	if (id == "armor") return std::make_unique<Armor>();
+	if (id == "treasure") return std::make_unique<LootTreasure>();
+	return nullptr;
+}
+
+std::string json_escape(const std::string& s) {
+	std::string out;
+	for (char c : s) {
+		if (c == '"') out += "\\\"";
+		else if (c == '\\') out += "\\\\";
+		else if (c == '\n') out += "\\n";
+		else out += c;
+	}
+	return out;
+}
+
+size_t rng_pick(AppState& st, size_t maxExclusive) {
+	uint64_t key = (static_cast<uint64_t>(st.random_seed) << 32) ^ st.random_nonce;
+	uint64_t r = game_rng::splitmix64(key);
+	st.random_nonce += 1;
+	return static_cast<size_t>(r % static_cast<uint64_t>(maxExclusive));
+}
+
+void generate_state(AppState& st, const GenerateOptions& opt, LabyrinthMap* map) {
+	set_rng_seed(opt.seed);
+	st.random_seed = opt.seed;
+	st.random_nonce = 0;
+	st.game.turn_rng_state = game_rng::initial_turn_rng_state(opt.seed);
+	st.game.enforce_turns = opt.turns;
+	st.game.actions_per_turn = std::max(1, opt.turn_actions);
+	st.game.actions_left = st.game.actions_per_turn;
+	if (map) st.map = std::move(*map);
+	else st.map = generate_maze_with_items(opt.width, opt.height, std::min(1.0f, std::max(0.0f, opt.openness)));
+	// Bot enable and initial placement
+	st.game.bot_enabled = false;
+	if (opt.bot_steps > 0) {
+		st.game.bot_enabled = true;
+		st.game.bot_steps_per_turn = opt.bot_steps;
+		st.game.bot_search_depth = std::max(0, opt.bot_search_depth);
+		st.game.bot_search_budget_us = opt.bot_budget_us;
+		// place bot to random empty cell
+		EmptyCellPicker spots(st.map);
+		if (spots.count() > 0) {
+			auto pos = spots.pick(rng_pick(st, spots.count()));
+			st.game.bot_x = pos.first; st.game.bot_y = pos.second;
+		} else {
+			st.game.bot_x = 0; st.game.bot_y = 0;
+		}
+	}
+}
+
+bool add_player_random(AppState& st, const std::string& name, std::pair<size_t,size_t>& pos, std::string& err) {
+	// empty, unoccupied cells
+	EmptyCellPicker spots(st.map, true);
+	if (spots.count() == 0) { err = "Нет свободных клеток для размещения"; return false; }
+	// С ботом: не ставить игрока на соседнюю с ботом клетку (манхэттен ≤ 1), иначе при первом же
+	// resolve-bots / ходе бота он может убить сразу — кажется, что «всегда спавн в больнице».
+	if (st.game.bot_enabled) {
+		EmptyCellPicker far_from_bot = spots;
+		const size_t bx = st.game.bot_x, by = st.game.bot_y;
+		far_from_bot.exclude_cell(bx, by);
+		if (bx > 0) far_from_bot.exclude_cell(bx - 1, by);
+		far_from_bot.exclude_cell(bx + 1, by);
+		if (by > 0) far_from_bot.exclude_cell(bx, by - 1);
+		far_from_bot.exclude_cell(bx, by + 1);
+		if (far_from_bot.count() > 0) spots.exclude = std::move(far_from_bot.exclude);
+	}
+	pos = spots.pick(rng_pick(st, spots.count()));
+	if (!st.game.add_player(name, pos, st.map, err)) return false;
+	st.log.push_back(LogEntry{LogType::AddPlayerRandom, name, Direction::Up, pos.first, pos.second, {}});
+	feed_player_added(st, name, pos.first, pos.second);
+	return true;
+}
+
+bool add_item_at(AppState& st, const std::string& item, size_t x, size_t y, int charges, std::string& err) {
+	if (!st.map.in_bounds((long)x,(long)y)) { err = "Вне карты"; return false; }
+	if (st.map.get_cell(x,y) != CellContent::Empty) { err = "Клетка занята не-пустой меткой"; return false; }
+	long long key = (long long)y * 1000000LL + (long long)x;
+	undo::ground(st.game, key);
+	st.game.ground_items[key][item] += std::max(1, charges);
+	return true;
+}
+
+bool add_item_random(AppState& st, const std::string& item, int charges, std::pair<size_t,size_t>& pos, std::string& err) {
+	// empty cells without special content; multiple items per cell allowed
+	EmptyCellPicker spots(st.map);
+	if (spots.count() == 0) { err = "Нет пустых клеток для размещения"; return false; }
+	pos = spots.pick(rng_pick(st, spots.count()));
+	long long key = (long long)pos.second * 1000000LL + (long long)pos.first;
+	undo::ground(st.game, key);
+	st.game.ground_items[key][item] += std::max(1, charges);
+	return true;
+}
+
+bool give_item(AppState& st, const std::string& name, const std::string& item, int charges, std::string& err) {
+	const PlayerId id = st.game.players.find(name);
+	if (id == kNoPlayer) { err = "Игрок не найден"; return false; }
+	auto& inv = st.game.players.edit_inventory(id);
+	int cur = inv.getCharges(item);
+	inv.setCharges(item, cur + std::max(1, charges));
+	if (item == "knife" && inv.getCharges("knife") > 0) st.game.players.set_knife_broken(id, false);
+	return true;
+}
+
+void init_turns(AppState& st) {
+	// Один и тот же порядок при generate + init-turns из scenario.json и при записи в dev:
+	// перетасовка только от random_seed (RNG файла после сессии не используем).
+	st.game.turn_rng_state = game_rng::initial_turn_rng_state(st.random_seed);
+	st.game.init_turns();
+}
+
+void write_user_messages(std::ostream& os, const std::string& player, const Outcome& o,
+                         const std::vector<std::string>& names) {
+	os << "[" << player << "]:" << "\n";
+	for (const auto& ev : o.events) {
+		os << "\t";
+		if (ev.addressed()) os << "PLAYER:" << names[ev.recipient] << ":";
+		ev.writeWire(os, names);
+		os << "\n";
+	}
+}
+
+void write_bot_feed(std::ostream& os, const std::vector<MessageEvent>& feed, const std::vector<std::string>& names) {
+	for (const auto& ev : feed) {
+		if (ev.addressed()) os << "[" << names[ev.recipient] << "]:" << "\n\t";
+		ev.writeWire(os, names);
+		os << "\n";
+	}
+}
+
+// Hard cap: if every human is in hospital, advance_turn can pick "bot" again forever — avoid hanging the process.
+bool run_pending_bot_turns(AppState& st, std::vector<MessageEvent>& feed) {
+	LAB_TRACE_SCOPE("bots.pending");
+	const int kMaxBotSteps = 512;
+	auto bot_to_move = [&]() {
+		return st.game.enforce_turns && st.game.bot_enabled && !st.game.turn_order.empty()
+		    && st.game.turn_index < st.game.turn_order.size()
+		    && st.game.turn_order[st.game.turn_index] == "bot";
+	};
+	for (int step = 0; step < kMaxBotSteps && bot_to_move(); ++step) {
+		Outcome botBlog;
+		std::vector<BotReplayStep> bot_replay;
+		st.game.run_bot_turn(st.map, botBlog, &bot_replay);
+		for (const auto& s : bot_replay) {
+			if (s.kind == BotReplayStep::Kind::Move)
+				st.log.push_back(LogEntry{LogType::BotMove, "", Direction::Up, s.x, s.y, {}});
+			else
+				st.log.push_back(LogEntry{LogType::BotKill, s.victim, Direction::Up, 0, 0, {}});
+		}
+		feed_bot_steps(st, bot_replay);
+		feed_turn(st, "bot");
+		// адресованные события (жертвы бота) — отдельным блоком игроку
+		for (const auto& ev : botBlog.events)
+			if (ev.addressed()) feed.push_back(ev);
+		// В фиде одна строка на ход бота (без пошаговых координат)
+		for (const auto& ev : botBlog.events) {
+			if (!ev.addressed() && ev.code == Message::BotMoved && ev.argc == 0) {
+				feed.push_back(ev);
+				break;
+			}
+		}
+	}
+	return !bot_to_move();
+}
+
+/** Перенос бота после удара игрока: в лог replay и в ленту. */
+static void log_bot_respawn(AppState& st, size_t x, size_t y) {
+	st.log.push_back(LogEntry{LogType::BotMove, "", Direction::Up, x, y, {}});
+	FeedEvent fe;
+	fe.type = FeedEventType::BotMoved;
+	fe.has_at = true;
+	fe.x = x;
+	fe.y = y;
+	feed_emit(st, std::move(fe));
+}
+
+static void perform_action(AppState& st, ActionKind kind, const std::string& name, Direction dir,
+                           const std::string& item, ActionResult& res) {
+	// временные данные предметов и очереди ходов; исход (res) в арену не попадает
+	arena::Scope action_arena;
+	std::ostringstream es;
+	FeedEvent fe;
+	fe.name = name;
+	fe.has_dir = true;
+	fe.dir = dir;
+	switch (kind) {
+		case ActionKind::Move: {
+			const PlayerId id = st.game.players.find(name);
+			const bool had_old = id != kNoPlayer;
+			const auto oldpos = had_old ? st.game.players.pos[id] : std::pair<size_t,size_t>{0, 0};
+			MoveOutcome out = st.game.move_player(name, dir, st.map);
+			st.log.push_back(LogEntry{LogType::Move, name, dir, 0, 0, {}});
+			fe.type = FeedEventType::PlayerMoved;
+			fe.has_from = had_old;
+			fe.fx = oldpos.first;
+			fe.fy = oldpos.second;
+			fe.has_at = true;
+			fe.x = out.position.first;
+			fe.y = out.position.second;
+			fe.moved = out.moved;
+			feed_emit(st, std::move(fe));
+			feed_outcome(st, name, out.events);
+			if (had_old) {
+				es << "MOVE " << name << " from " << oldpos.first << "," << oldpos.second
+				   << " to " << out.position.first << "," << out.position.second
+				   << (out.moved ? " [moved]" : " [blocked]");
+			} else {
+				es << "MOVE " << name << " (no previous position)";
+			}
+			res.outcome.events = std::move(out.events);
+			break;
+		}
+		case ActionKind::Attack: {
+			AttackOutcome out = st.game.attack(name, dir, st.map);
+			st.log.push_back(LogEntry{LogType::Attack, name, dir, 0, 0, {}});
+			fe.type = FeedEventType::Attack;
+			feed_emit(st, std::move(fe));
+			feed_outcome(st, name, out.events);
+			if (out.bot_respawn_for_log) log_bot_respawn(st, out.bot_log_x, out.bot_log_y);
+			es << "ATTACK " << name << " dir=" << dir_wire(dir) << (out.attacked ? " [done]" : " [failed]");
+			res.outcome.events = std::move(out.events);
+			break;
+		}
+		case ActionKind::UseItem: {
+			UseOutcome out = st.game.use_item(name, item, dir, st.map);
+			st.log.push_back(LogEntry{LogType::UseItem, name, dir, 0, 0, item});
+			fe.type = FeedEventType::ItemUsed;
+			fe.item = item;
+			feed_emit(st, std::move(fe));
+			feed_outcome(st, name, out.events);
+			if (out.bot_respawn_for_log) log_bot_respawn(st, out.bot_log_x, out.bot_log_y);
+			es << "USE " << name << " item=" << item << " dir=" << dir_wire(dir) << (out.used ? " [applied]" : " [failed]");
+			res.outcome.events = std::move(out.events);
+			break;
+		}
+	}
+	feed_turn(st, name);
+	res.detail = es.str();
+}
+
+bool apply_player_action(AppState& st, const std::string& path, ActionKind kind, const std::string& name,
+                         Direction dir, const std::string& item, ActionResult& res, std::string& err) {
+	if (path.empty()) {
+		perform_action(st, kind, name, dir, item, res);
+		res.bot_cap_reached = !run_pending_bot_turns(st, res.bot_feed);
+		return true;
+	}
+	feed_attach(st, path);
+	UndoMark before(st);
+	perform_action(st, kind, name, dir, item, res);
+	const bool recorded = journal_record(st, before);
+	if (!AppState::save(st, path, err)) return false;
+	res.bot_cap_reached = !run_pending_bot_turns(st, res.bot_feed);
+	// действие и ходы бота — один шаг отката
+	journal_record(st, before, recorded);
+	if (!AppState::save(st, path, err)) return false;
+	feed_flush(st, path);
+	return true;
+}
+
+bool resolve_bots(AppState& st, const std::string& path, std::vector<MessageEvent>& feed, bool& settled, std::string& err) {
+	if (path.empty()) {
+		settled = run_pending_bot_turns(st, feed);
+		return true;
+	}
+	feed_attach(st, path);
+	UndoMark before(st);
+	settled = run_pending_bot_turns(st, feed);
+	journal_record(st, before);
+	if (!AppState::save(st, path, err)) return false;
+	feed_flush(st, path);
+	return true;
+}
+
+bool undo_and_save(AppState& st, const std::string& path, size_t n, size_t& done, std::string& err) {
+	feed_attach(st, path);
+	done = undo_steps(st, n);
+	if (done == 0) return true;
+	// зрителям: состояние ушло назад — перечитать целиком
+	FeedEvent fe;
+	fe.type = FeedEventType::Reset;
+	fe.count = static_cast<long long>(done);
+	feed_emit(st, std::move(fe));
+	if (!AppState::save(st, path, err)) return false;
+	feed_flush(st, path);
+	return true;
+}
+
+PlayerView player_view(const AppState& st, PlayerId me) {
+	PlayerView v;
+	v.name = st.game.players.name[me];
+	v.x = st.game.players.pos[me].first;
+	v.y = st.game.players.pos[me].second;
+	v.knife_broken = st.game.players.knife_broken[me] != 0;
+	const Inventory& inv = st.game.players.inventory[me];
+	v.items.assign(inv.item_charges.begin(), inv.item_charges.end());
+
+	// Breathing detection
+	const auto myPos = st.game.players.pos[me];
+	bool breathing = false;
+	bool meInHospital = st.map.get_cell(myPos.first, myPos.second) == CellContent::Hospital;
+	for (PlayerId id = 0; id < st.game.players.size(); ++id) {
+		if (id == me) continue;
+		const auto p = st.game.players.pos[id];
+		if (st.map.get_cell(p.first, p.second) == CellContent::Hospital) continue;
+		size_t dx = (myPos.first > p.first) ? (myPos.first - p.first) : (p.first - myPos.first);
+		size_t dy = (myPos.second > p.second) ? (myPos.second - p.second) : (p.second - myPos.second);
+		if (dx + dy != 1) continue;
+		bool vis = false;
+		if (p.first + 1 == myPos.first && p.second == myPos.second) vis = st.map.can_move_left(myPos.first, myPos.second);
+		else if (p.first == myPos.first + 1 && p.second == myPos.second) vis = st.map.can_move_right(myPos.first, myPos.second);
+		else if (p.second + 1 == myPos.second && p.first == myPos.first) vis = st.map.can_move_up(myPos.first, myPos.second);
+		else if (p.second == myPos.second + 1 && p.first == myPos.first) vis = st.map.can_move_down(myPos.first, myPos.second);
+		if (vis) { breathing = true; break; }
+	}
+	if (meInHospital) breathing = false;
+	if (!breathing && !meInHospital && st.game.bot_enabled) {
+		size_t bx = st.game.bot_x, by = st.game.bot_y;
+		size_t dx = (myPos.first > bx) ? (myPos.first - bx) : (bx - myPos.first);
+		size_t dy = (myPos.second > by) ? (myPos.second - by) : (by - myPos.second);
+		if (dx + dy == 1) {
+			if (bx + 1 == myPos.first && by == myPos.second) breathing = st.map.can_move_left(myPos.first, myPos.second);
+			else if (bx == myPos.first + 1 && by == myPos.second) breathing = st.map.can_move_right(myPos.first, myPos.second);
+			else if (by + 1 == myPos.second && bx == myPos.first) breathing = st.map.can_move_up(myPos.first, myPos.second);
+			else if (by == myPos.second + 1 && bx == myPos.first) breathing = st.map.can_move_down(myPos.first, myPos.second);
+		}
+	}
+	v.breathing = breathing;
+	return v;
+}
+
+void player_status_json(const PlayerView& v, std::string& out) {
+	auto charges_of = [&](const char* id) -> const int* {
+		for (const auto& kv : v.items)
+			if (kv.first == id) return &kv.second;
+		return nullptr;
+	};
+	const int* treasure = charges_of("treasure");
+	bool hasTreasure = treasure && *treasure > 0;
+
+	std::ostringstream js;
+	js << "{";
+	js << "\"name\":\"" << json_escape(v.name) << "\",";
+	js << "\"hasTreasure\":" << (hasTreasure ? "true" : "false") << ",";
+	js << "\"items\":[";
+
+	static const char* itemOrder[] = {"knife","shotgun","rifle","flashlight","armor","treasure"};
+	bool first = true;
+	for (const char* iid : itemOrder) {
+		const int* c = charges_of(iid);
+		if (!c) continue;
+		const int charges = *c;
+		auto item = make_item(iid);
+		if (!item) continue;
+
+		if (!first) js << ",";
+		first = false;
+		bool broken = (std::string(iid) == "knife" && v.knife_broken);
+		js << "{";
+		js << "\"id\":\"" << iid << "\",";
+		js << "\"displayName\":\"" << json_escape(item->displayName()) << "\",";
+		js << "\"description\":\"" << json_escape(item->description()) << "\",";
+		js << "\"rechargeHint\":\"" << json_escape(item->rechargeHint()) << "\",";
+		js << "\"charges\":" << charges << ",";
+		js << "\"broken\":" << (broken ? "true" : "false");
+		js << "}";
+	}
+	// extra items not in predefined order
+	for (const auto& kv : v.items) {
+		if (kv.first=="knife"||kv.first=="shotgun"||kv.first=="rifle"||kv.first=="flashlight"||kv.first=="armor"||kv.first=="treasure") continue;
+		if (!first) js << ",";
+		first = false;
+		js << "{\"id\":\"" << json_escape(kv.first) << "\",";
+		js << "\"displayName\":\"" << json_escape(kv.first) << "\",";
+		js << "\"description\":\"\",\"rechargeHint\":\"\",";
+		js << "\"charges\":" << kv.second << ",\"broken\":false}";
+	}
+
+	js << "],";
+	js << "\"nearbyBreathing\":" << (v.breathing ? "true" : "false") << ",";
+	js << "\"messages\":[";
+	if (v.breathing) {
+		js << "\"" << json_escape(messageWire(Message::Breathe)) << "\"";
+	}
+	js << "]}";
+	out = js.str();
+}
+
+bool player_status_json(const AppState& st, const std::string& name, std::string& out) {
+	const PlayerId me = st.game.players.find(name);
+	if (me == kNoPlayer) return false;
+	player_status_json(player_view(st, me), out);
+	return true;
+}
@@ -0,0 +1,108 @@
+#pragma once
+#include "state.hpp"
+#include "items/Item.hpp"
+
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * Действия движка над файлом состояния — общий слой CLI (main.cpp) и нативного аддона для Node
+ * (node/addon.cpp): один и тот же порядок «действие → лог → save → ходы бота → save» и тот же вывод.
+ */
+
+std::unique_ptr<Item> make_item(const std::string& id);
+std::string json_escape(const std::string& s);
+
+/** Реестр id предметов — один источник для CLI, list-items и внешних инструментов. */
+inline constexpr const char* ITEM_REGISTRY_IDS[] = {"knife", "shotgun", "rifle", "flashlight", "armor", "treasure"};
+inline constexpr size_t ITEM_REGISTRY_COUNT = sizeof(ITEM_REGISTRY_IDS) / sizeof(ITEM_REGISTRY_IDS[0]);
+
+inline bool item_id_is_valid(const std::string& id) {
+	for (size_t i = 0; i < ITEM_REGISTRY_COUNT; ++i)
+		if (id == ITEM_REGISTRY_IDS[i]) return true;
+	return false;
+}
+
+/** Детерминированный выбор в [0, maxExclusive) от random_seed и random_nonce файла (nonce растёт). */
+size_t rng_pick(AppState& st, size_t maxExclusive);
+
+/**
+ * Команды подготовки партии над загруженным st (без save): CLI сохраняет сам, labyrinth_scenarios
+ * держит состояние в памяти. false и err — отказ (код 3 у CLI).
+ */
+struct GenerateOptions {
+	size_t width{0}, height{0};
+	float openness{0.0f};
+	unsigned int seed{0};
+	bool turns{true};
+	int turn_actions{1};
+	int bot_steps{0}; // 0 — без бота
+	int bot_search_depth{0}; // 0 — жадный бот
+	unsigned bot_budget_us{2000};
+};
+/** map — уже сгенерированная карта сида opt.seed (например, из search_map_seed): забирается, а не строится заново. */
+void generate_state(AppState& st, const GenerateOptions& opt, LabyrinthMap* map = nullptr);
+/** Свободная клетка не вплотную к боту (если такие есть), запись ADDR в лог. */
+bool add_player_random(AppState& st, const std::string& name, std::pair<size_t,size_t>& pos, std::string& err);
+bool add_item_at(AppState& st, const std::string& item, size_t x, size_t y, int charges, std::string& err);
+bool add_item_random(AppState& st, const std::string& item, int charges, std::pair<size_t,size_t>& pos, std::string& err);
+bool give_item(AppState& st, const std::string& name, const std::string& item, int charges, std::string& err);
+/** Очередь заново от random_seed (как после generate) и текущего набора игроков. */
+void init_turns(AppState& st);
+
+enum class ActionKind { Move, Attack, UseItem };
+
+struct ActionResult {
+	/** События действующего игрока — блок `[имя]:` в stdout. */
+	Outcome outcome;
+	/** Ходы бота после действия: адресованные жертвам события и одна строка BotMoved на ход. */
+	std::vector<MessageEvent> bot_feed;
+	/** Служебная строка для stderr (MOVE …, ATTACK …, USE …). */
+	std::string detail;
+	/** Ходы бота упёрлись в предел итераций (очередь так и осталась на боте). */
+	bool bot_cap_reached{false};
+};
+
+/** Строка stderr, когда очередь так и осталась на боте после предела итераций. */
+inline constexpr const char* kBotCapMessage =
+	"run_pending_bot_turns: iteration cap reached (stuck on bot turn; check hospital/turn logic)";
+
+/** Ходы бота подряд, пока очередь на нём; false — упёрлись в предел итераций. */
+bool run_pending_bot_turns(AppState& st, std::vector<MessageEvent>& feed);
+
+/**
+ * Действие игрока name (item — только для UseItem) над загруженным st: запись в лог, save в path,
+ * ходы бота и повторный save. Действие вместе с ходами бота — один шаг журнала отката.
+ * Пустой path — прогон в памяти: без save и журнала. false и err — ошибка записи состояния.
+ */
+bool apply_player_action(AppState& st, const std::string& path, ActionKind kind, const std::string& name,
+                         Direction dir, const std::string& item, ActionResult& res, std::string& err);
+
+/** resolve-bots: ходы бота, шаг журнала отката и save в path (пустой — в памяти); settled = false — упёрлись в предел. */
+bool resolve_bots(AppState& st, const std::string& path, std::vector<MessageEvent>& feed, bool& settled, std::string& err);
+
+/** undo: откатить до n шагов журнала и сохранить в path; done = 0 — журнал пуст, файл не трогается. */
+bool undo_and_save(AppState& st, const std::string& path, size_t n, size_t& done, std::string& err);
+
+/**
+ * Вывод как у CLI: `[player]:` и wire-строки с табом; фид бота — блоки жертв и строки BotMoved.
+ * names — st.game.players.name: по нему PlayerId в событиях превращаются в имена.
+ */
+void write_user_messages(std::ostream& os, const std::string& player, const Outcome& o,
+                         const std::vector<std::string>& names);
+void write_bot_feed(std::ostream& os, const std::vector<MessageEvent>& feed, const std::vector<std::string>& names);
+
+/** Всё, из чего собирается player-status: те же данные публикует снимок комнаты (snapshot.hpp). */
+struct PlayerView {
+	std::string name;
+	size_t x{0}, y{0};
+	bool knife_broken{false};
+	bool breathing{false}; // живой игрок или бот за соседней открытой стенкой
+	std::vector<std::pair<std::string, int>> items; // в порядке инвентаря
+};
+PlayerView player_view(const AppState& st, PlayerId id);
+void player_status_json(const PlayerView& v, std::string& js);
+/** JSON для player-status: инвентарь в фиксированном порядке и «дыхание» рядом; false — нет игрока. */
+bool player_status_json(const AppState& st, const std::string& name, std::string& js);
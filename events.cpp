@@ -0,0 +1,226 @@
+#include "events.hpp"
+#include "state.hpp"
+#include "engine.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char* const kFeedTypeNames[] = {
+#define FEED_EVENT_NAME(id, name) name,
+	FEED_EVENT_LIST(FEED_EVENT_NAME)
+#undef FEED_EVENT_NAME
+};
+
+void put_string(std::string& out, const char* key, const std::string& v) {
+	if (v.empty()) return;
+	out += ",\"";
+	out += key;
+	out += "\":\"";
+	out += json_escape(v);
+	out += '"';
+}
+
+void put_cell(std::string& out, const char* key, size_t x, size_t y) {
+	out += ",\"";
+	out += key;
+	out += "\":[";
+	out += std::to_string(x);
+	out += ',';
+	out += std::to_string(y);
+	out += ']';
+}
+
+/** Предмет, подобранный по коду сообщения; nullptr — код не про подбор. */
+const char* picked_item(const MessageEvent& ev) {
+	switch (ev.code) {
+		case Message::TreasureFound:
+		case Message::TreasurePicked: return "treasure";
+		case Message::FlashLightFound: return "flashlight";
+		case Message::RifleFound: return "rifle";
+		case Message::ShotgunFound: return "shotgun";
+		case Message::KnifeFound: return "knife";
+		case Message::ArmourFound: return "armor";
+		case Message::ItemFound: return ev.argc > 0 && ev.args[0].kind == MessageArg::Kind::Token ? ev.args[0].token : nullptr;
+		default: return nullptr;
+	}
+}
+
+/**
+ * seq последнего события в ленте-файле (0 — пусто, FIFO или нет файла). Строка начинается с
+ * {"seq":N, события короткие — хватает хвоста файла.
+ */
+unsigned long long last_feed_seq(const std::string& path) {
+	const int fd = ::open(path.c_str(), O_RDONLY | O_NONBLOCK);
+	if (fd < 0) return 0;
+	struct stat sb;
+	std::string tail;
+	if (::fstat(fd, &sb) == 0 && S_ISREG(sb.st_mode) && sb.st_size > 0) {
+		const off_t from = sb.st_size > 4096 ? sb.st_size - 4096 : 0;
+		tail.resize(static_cast<size_t>(sb.st_size - from));
+		const ssize_t n = ::pread(fd, &tail[0], tail.size(), from);
+		tail.resize(n > 0 ? static_cast<size_t>(n) : 0);
+	}
+	::close(fd);
+	static const std::string kPrefix = "{\"seq\":";
+	for (size_t at = tail.rfind(kPrefix); at != std::string::npos; at = at ? tail.rfind(kPrefix, at - 1) : std::string::npos) {
+		if (at > 0 && tail[at - 1] != '\n') continue;
+		unsigned long long seq = 0;
+		size_t i = at + kPrefix.size();
+		if (i >= tail.size() || tail[i] < '0' || tail[i] > '9') continue;
+		for (; i < tail.size() && tail[i] >= '0' && tail[i] <= '9'; ++i) seq = seq * 10 + static_cast<unsigned long long>(tail[i] - '0');
+		return seq;
+	}
+	return 0;
+}
+
+} // namespace
+
+std::string events_path(const std::string& state_path) {
+	return state_path + ".events";
+}
+
+void feed_attach(AppState& st, const std::string& state_path) {
+	struct stat sb;
+	st.feed = EventFeed{};
+	st.feed.on = !state_path.empty() && ::stat(events_path(state_path).c_str(), &sb) == 0;
+	if (!st.feed.on) return;
+	st.event_seq = std::max(st.event_seq, last_feed_seq(events_path(state_path)));
+	st.feed.turn = feed_current_turn(st);
+	st.feed.finished = st.game.finished;
+}
+
+void feed_emit(AppState& st, FeedEvent ev) {
+	if (!st.feed.on) return;
+	ev.seq = ++st.event_seq;
+	st.feed.pending.push_back(std::move(ev));
+}
+
+void feed_flush(AppState& st, const std::string& state_path) {
+	if (st.feed.pending.empty()) return;
+	std::string buf;
+	for (const auto& ev : st.feed.pending) {
+		write_feed_json(buf, ev);
+		buf += '\n';
+	}
+	st.feed.pending.clear();
+	// O_NONBLOCK: FIFO без читателя даёт ENXIO сразу, а не вешает команду
+	const int fd = ::open(events_path(state_path).c_str(), O_WRONLY | O_APPEND | O_NONBLOCK);
+	if (fd < 0) return;
+	const char* p = buf.data();
+	size_t left = buf.size();
+	while (left > 0) {
+		const ssize_t n = ::write(fd, p, left);
+		if (n < 0 && errno == EINTR) continue;
+		if (n <= 0) break; // переполненный FIFO: читатель отстал, остаток теряется — он увидит пропуск seq
+		p += n;
+		left -= static_cast<size_t>(n);
+	}
+	::close(fd);
+}
+
+std::string feed_current_turn(const AppState& st) {
+	const Game& g = st.game;
+	if (!g.enforce_turns || g.turn_order.empty()) return std::string();
+	return g.turn_order[g.turn_index % g.turn_order.size()];
+}
+
+void feed_outcome(AppState& st, const std::string& name, const std::vector<MessageEvent>& events) {
+	if (!st.feed.on) return;
+	for (const auto& ev : events) {
+		if (ev.addressed()) continue;
+		if (const char* item = picked_item(ev)) {
+			FeedEvent fe;
+			fe.type = FeedEventType::ItemPicked;
+			fe.name = name;
+			fe.item = item;
+			fe.count = 1;
+			feed_emit(st, std::move(fe));
+			continue;
+		}
+		if ((ev.code == Message::KnifeHitPlayer || ev.code == Message::RifleHitPlayer ||
+		     ev.code == Message::ShotgunHitPlayer) && ev.argc > 1 && ev.args[1].kind == MessageArg::Kind::Player &&
+		    ev.args[1].player < st.game.players.size()) {
+			FeedEvent fe;
+			fe.type = FeedEventType::PlayerKilled;
+			fe.name = name;
+			fe.victim = st.game.players.name[ev.args[1].player];
+			feed_emit(st, std::move(fe));
+		}
+	}
+}
+
+void feed_player_added(AppState& st, const std::string& name, size_t x, size_t y) {
+	if (!st.feed.on) return;
+	FeedEvent fe;
+	fe.type = FeedEventType::PlayerAdded;
+	fe.name = name;
+	fe.has_at = true;
+	fe.x = x;
+	fe.y = y;
+	feed_emit(st, std::move(fe));
+	feed_turn(st, name);
+}
+
+void feed_bot_steps(AppState& st, const std::vector<BotReplayStep>& steps) {
+	if (!st.feed.on) return;
+	for (const auto& s : steps) {
+		FeedEvent fe;
+		if (s.kind == BotReplayStep::Kind::Move) {
+			fe.type = FeedEventType::BotMoved;
+			fe.has_at = true;
+			fe.x = s.x;
+			fe.y = s.y;
+		} else {
+			fe.type = FeedEventType::BotKill;
+			fe.victim = s.victim;
+		}
+		feed_emit(st, std::move(fe));
+	}
+}
+
+void feed_turn(AppState& st, const std::string& actor) {
+	if (!st.feed.on) return;
+	if (!st.feed.finished && st.game.finished) {
+		st.feed.finished = true;
+		FeedEvent fe;
+		fe.type = FeedEventType::GameFinished;
+		fe.name = actor;
+		feed_emit(st, std::move(fe));
+	}
+	std::string cur = feed_current_turn(st);
+	if (cur == st.feed.turn) return;
+	st.feed.turn = cur;
+	FeedEvent fe;
+	fe.type = FeedEventType::TurnAdvanced;
+	fe.name = std::move(cur);
+	feed_emit(st, std::move(fe));
+}
+
+void write_feed_json(std::string& out, const FeedEvent& ev) {
+	out += "{\"seq\":";
+	out += std::to_string(ev.seq);
+	out += ",\"type\":\"";
+	out += kFeedTypeNames[static_cast<size_t>(ev.type)];
+	out += '"';
+	put_string(out, "name", ev.name);
+	put_string(out, "item", ev.item);
+	put_string(out, "victim", ev.victim);
+	if (ev.has_dir) {
+		out += ",\"dir\":\"";
+		out += dir_wire(ev.dir);
+		out += '"';
+	}
+	if (ev.has_from) put_cell(out, "from", ev.fx, ev.fy);
+	if (ev.has_at) put_cell(out, "at", ev.x, ev.y);
+	if (ev.type == FeedEventType::PlayerMoved) out += ev.moved ? ",\"moved\":true" : ",\"moved\":false";
+	if (ev.count) {
+		out += ",\"count\":";
+		out += std::to_string(ev.count);
+	}
+	out += '}';
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include "map.hpp"
+#include "message.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct AppState;
+struct BotReplayStep;
+
+/**
+ * Лента событий для зрителей: X(Id, "type"). Строка JSONL на событие, seq растёт на 1 на всю
+ * историю комнаты (откат его не возвращает). Пропуск seq у клиента — повод перечитать состояние.
+ */
+#define FEED_EVENT_LIST(X) \
+	X(PlayerAdded, "player_added") \
+	X(PlayerMoved, "player_moved") \
+	X(Attack, "attack") \
+	X(ItemUsed, "item_used") \
+	X(ItemPicked, "item_picked") \
+	X(PlayerKilled, "player_killed") \
+	X(BotMoved, "bot_moved") \
+	X(BotKill, "bot_kill") \
+	X(TurnAdvanced, "turn") \
+	X(GameFinished, "finished") \
+	X(Reset, "reset")
+
+enum class FeedEventType {
+#define FEED_EVENT_ENUM(id, name) id,
+	FEED_EVENT_LIST(FEED_EVENT_ENUM)
+#undef FEED_EVENT_ENUM
+};
+
+/** Событие ленты; в JSON попадают только заданные поля. */
+struct FeedEvent {
+	FeedEventType type{FeedEventType::PlayerMoved};
+	unsigned long long seq{0};
+	std::string name;   // автор действия; для turn — чей ход, для finished — победитель
+	std::string item;
+	std::string victim;
+	bool has_dir{false};
+	Direction dir{Direction::Up};
+	bool has_from{false};
+	size_t fx{0}, fy{0};
+	bool has_at{false};  // куда пришёл / где появился
+	size_t x{0}, y{0};
+	bool moved{false};   // player_moved: шаг состоялся
+	long long count{0};  // item_picked — сколько, reset — шагов отката
+};
+
+/** Лента одной команды: включена ли, что уже объявлено зрителям и что ещё не дописано. */
+struct EventFeed {
+	bool on{false};
+	std::string turn;     // чей ход объявлен последним
+	bool finished{false};
+	std::vector<FeedEvent> pending;
+};
+
+/** Путь ленты комнаты: `<state>.events` — обычный файл (дописывается) или FIFO. */
+std::string events_path(const std::string& state_path);
+
+/**
+ * Включить ленту, если путь ленты существует (его создаёт сервер для комнаты), и запомнить
+ * текущий ход. Без ленты feed_* ничего не делают и seq не растёт — файлы состояния без зрителей не меняются.
+ * seq продолжается с большего из EVSEQ состояния и последнего seq в файле ленты: подменённое
+ * состояние (save-as в комнату) не откатывает ленту назад.
+ */
+void feed_attach(AppState& st, const std::string& state_path);
+/** Присвоить событию следующий seq и поставить в очередь на запись. */
+void feed_emit(AppState& st, FeedEvent ev);
+/** Дописать накопленные события одной записью; вызывается после успешного save. FIFO без читателя — пропуск. */
+void feed_flush(AppState& st, const std::string& state_path);
+
+/** Чей ход сейчас ("" — очереди нет): от него считается событие turn. */
+std::string feed_current_turn(const AppState& st);
+/** События исхода действия name: подобранные предметы и убийства (по кодам сообщений). */
+void feed_outcome(AppState& st, const std::string& name, const std::vector<MessageEvent>& events);
+/** Новый игрок на (x, y); его вставка в очередь может сменить ход. */
+void feed_player_added(AppState& st, const std::string& name, size_t x, size_t y);
+/** Шаги бота из replay-лога его хода. */
+void feed_bot_steps(AppState& st, const std::vector<BotReplayStep>& steps);
+/** turn — если ход перешёл к другому; finished — если партия закончилась действием actor. */
+void feed_turn(AppState& st, const std::string& actor);
+
+void write_feed_json(std::string& out, const FeedEvent& ev);
@@ -0,0 +1,176 @@
+#include "flood.hpp"
+#include "map.hpp"
+#include "metrics.hpp"
+
+namespace flood {
+
+Grid::Grid(const LabyrinthMap& m)
+	: width(m.width), height(m.height), words((m.width + 63) / 64), right(arena::current()), down(arena::current()) {
+	right.assign(height * words, 0);
+	down.assign(height * words, 0);
+	for (size_t y = 0; y < height; ++y) {
+		uint64_t* r = &right[y * words];
+		uint64_t* d = &down[y * words];
+		for (size_t x = 0; x < width; ++x) {
+			const uint64_t bit = uint64_t{1} << (x & 63);
+			if (m.can_move_right(x, y)) r[x >> 6] |= bit;
+			if (m.can_move_down(x, y)) d[x >> 6] |= bit;
+		}
+	}
+}
+
+namespace {
+
+/**
+ * Волновой фронт по слоям. Обрабатываются только строки с непустым фронтом, поэтому в узком
+ * лабиринте слой стоит O(активных строк × words), а не O(всей карты).
+ */
+struct Wave {
+	const Grid& g;
+	std::pmr::vector<uint64_t> seen, front, next;
+	std::pmr::vector<size_t> rows, next_rows;
+	std::pmr::vector<char> row_marked;
+
+	explicit Wave(const Grid& grid)
+		: g(grid), seen(grid.height * grid.words, 0, arena::current()), front(seen.size(), 0, arena::current()),
+		  next(seen.size(), 0, arena::current()), rows(arena::current()), next_rows(arena::current()),
+		  row_marked(grid.height, 0, arena::current()) {}
+
+	void seed(size_t x, size_t y) {
+		const size_t i = y * g.words + (x >> 6);
+		const uint64_t bit = uint64_t{1} << (x & 63);
+		seen[i] |= bit;
+		front[i] |= bit;
+		rows.push_back(y);
+	}
+
+	void mark(size_t y) {
+		if (!row_marked[y]) {
+			row_marked[y] = 1;
+			next_rows.push_back(y);
+		}
+	}
+
+	/** Один слой: next = соседи(front) \ seen. Возвращает число новых клеток. */
+	size_t step() {
+		const size_t W = g.words;
+		for (size_t y : rows) {
+			const uint64_t* f = &front[y * W];
+			const uint64_t* r = &g.right[y * W];
+			uint64_t* n = &next[y * W];
+			// вправо: (f & r) << 1 с переносом между словами; влево: (f >> 1) & r
+			uint64_t carry = 0;
+			for (size_t i = 0; i < W; ++i) {
+				const uint64_t fr = f[i] & r[i];
+				const uint64_t from_right = (f[i] >> 1) | (i + 1 < W ? f[i + 1] << 63 : 0);
+				n[i] |= (fr << 1) | carry | (from_right & r[i]);
+				carry = fr >> 63;
+			}
+			mark(y);
+			if (y + 1 < g.height) {
+				const uint64_t* d = &g.down[y * W];
+				uint64_t* nd = &next[(y + 1) * W];
+				for (size_t i = 0; i < W; ++i) nd[i] |= f[i] & d[i];
+				mark(y + 1);
+			}
+			if (y > 0) {
+				const uint64_t* d = &g.down[(y - 1) * W];
+				uint64_t* nu = &next[(y - 1) * W];
+				for (size_t i = 0; i < W; ++i) nu[i] |= f[i] & d[i];
+				mark(y - 1);
+			}
+		}
+		for (size_t y : rows) {
+			uint64_t* f = &front[y * W];
+			for (size_t i = 0; i < W; ++i) f[i] = 0;
+		}
+		rows.clear();
+		size_t added = 0;
+		for (size_t y : next_rows) {
+			row_marked[y] = 0;
+			uint64_t* n = &next[y * W];
+			uint64_t* s = &seen[y * W];
+			uint64_t* f = &front[y * W];
+			uint64_t any = 0;
+			for (size_t i = 0; i < W; ++i) {
+				const uint64_t fresh = n[i] & ~s[i];
+				n[i] = 0;
+				s[i] |= fresh;
+				f[i] = fresh;
+				any |= fresh;
+				added += static_cast<size_t>(__builtin_popcountll(fresh));
+			}
+			if (any) rows.push_back(y);
+		}
+		next_rows.clear();
+		return added;
+	}
+};
+
+} // namespace
+
+size_t count_components(const Grid& g) {
+	if (g.width == 0 || g.height == 0) return 0;
+	Wave w(g);
+	size_t comps = 0;
+	size_t nodes = 0;
+	for (size_t y = 0; y < g.height; ++y) {
+		for (size_t x = 0; x < g.width; ++x) {
+			if (w.seen[y * g.words + (x >> 6)] & (uint64_t{1} << (x & 63))) continue;
+			comps++;
+			w.seed(x, y);
+			nodes += 1;
+			while (!w.rows.empty()) nodes += w.step();
+		}
+	}
+	metrics::add(metrics::Counter::BfsNodes, nodes);
+	return comps;
+}
+
+size_t count_components(const LabyrinthMap& m) {
+	if (Board256::fits(m.width, m.height)) {
+		size_t nodes = 0;
+		const size_t comps = Board256(m).count_components(nodes);
+		metrics::add(metrics::Counter::BfsNodes, nodes);
+		return comps;
+	}
+	arena::Scope scratch;
+	return count_components(Grid(m));
+}
+
+std::pmr::vector<uint32_t> distances(const Grid& g, size_t sx, size_t sy) {
+	std::pmr::vector<uint32_t> dist(g.width * g.height, kUnreached, arena::current());
+	if (sx >= g.width || sy >= g.height) return dist;
+	Wave w(g);
+	w.seed(sx, sy);
+	dist[sy * g.width + sx] = 0;
+	size_t nodes = 1;
+	for (uint32_t layer = 1; !w.rows.empty(); ++layer) {
+		nodes += w.step();
+		for (size_t y : w.rows) {
+			const uint64_t* f = &w.front[y * g.words];
+			for (size_t i = 0; i < g.words; ++i) {
+				for (uint64_t bits = f[i]; bits; bits &= bits - 1) {
+					const size_t x = i * 64 + static_cast<size_t>(__builtin_ctzll(bits));
+					dist[y * g.width + x] = layer;
+				}
+			}
+		}
+	}
+	metrics::add(metrics::Counter::BfsNodes, nodes);
+	return dist;
+}
+
+std::pmr::vector<uint32_t> distances(const Board256& b, size_t sx, size_t sy) {
+	std::pmr::vector<uint32_t> dist(b.width * b.height, kUnreached, arena::current());
+	const size_t nodes = b.distances(sx, sy, dist.data());
+	if (nodes) metrics::add(metrics::Counter::BfsNodes, nodes);
+	return dist;
+}
+
+std::pmr::vector<uint32_t> distances(const LabyrinthMap& m, size_t sx, size_t sy) {
+	if (Board256::fits(m.width, m.height)) return distances(Board256(m), sx, sy);
+	return distances(Grid(m), sx, sy);
+}
+
+} // namespace flood
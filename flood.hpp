@@ -0,0 +1,40 @@
+#pragma once
+#include "arena.hpp"
+#include "board256.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct LabyrinthMap;
+
+/**
+ * Бит-параллельный flood fill: проходы карты хранятся битовыми строками (бит x строки y — клетка (x, y)),
+ * волна расширяется сразу на 64 клетки за операцию. Общий кернел для проверок связности генератора
+ * и поля расстояний бота. Битовые строки и волна живут в arena::current(). Карты до 16×16
+ * идут через Board256 (board256.hpp) — с тем же результатом.
+ */
+namespace flood {
+
+struct Grid {
+	size_t width{0}, height{0};
+	size_t words{0}; // слов uint64_t на строку
+	std::pmr::vector<uint64_t> right; // [y*words + i]: бит x — проход (x, y) → (x+1, y)
+	std::pmr::vector<uint64_t> down;  // бит x — проход (x, y) → (x, y+1)
+
+	explicit Grid(const LabyrinthMap& m);
+};
+
+constexpr uint32_t kUnreached = UINT32_MAX;
+
+size_t count_components(const Grid& g);
+/** Своя arena::Scope на сетку и волну: генератор зовёт её сотни раз подряд. Малые карты — Board256. */
+size_t count_components(const LabyrinthMap& m);
+
+/** BFS-расстояния от (sx, sy), плоско [y*width + x]; kUnreached — недостижимо. Вектор — в текущей арене. */
+std::pmr::vector<uint32_t> distances(const Grid& g, size_t sx, size_t sy);
+std::pmr::vector<uint32_t> distances(const Board256& b, size_t sx, size_t sy);
+/** Board256, если карта помещается, иначе Grid. */
+std::pmr::vector<uint32_t> distances(const LabyrinthMap& m, size_t sx, size_t sy);
+
+} // namespace flood
@@ -0,0 +1,90 @@
+import fs from 'fs';
+import { createRequire } from 'module';
+import { LAB_ADDON } from './repoPaths.js';
+
+/**
+ * Движок внутри процесса: build/labyrinth_node.node (node/addon.cpp). Те же действия, что у CLI,
+ * без spawn и пайпов; работа идёт в пуле потоков libuv. Каждый вызов отдаёт {code, out, err}
+ * как у runLab плюс структурированные поля (events, botFeed, players…).
+ * Аддона нет или LABYRINTH_NATIVE=0 — engineNative === null, всё идёт через бинарник.
+ */
+const require = createRequire(import.meta.url);
+
+function loadAddon() {
+  if (process.env.LABYRINTH_NATIVE === '0' || !fs.existsSync(LAB_ADDON)) return null;
+  try {
+    return require(LAB_ADDON);
+  } catch (e) {
+    console.warn(`[engineNative] аддон не загрузился, работаем через бинарник: ${e.message}`);
+    return null;
+  }
+}
+
+export const engineNative = loadAddon();
+
+const DIRECTIONS = new Set(['up', 'down', 'left', 'right']);
+
+function argValue(args, key) {
+  const i = args.indexOf(key);
+  return i >= 0 && i + 1 < args.length ? args[i + 1] : undefined;
+}
+
+/** Только перечисленные --ключи со значениями (без флагов и позиционных хвостов). */
+function onlyKeys(args, keys) {
+  for (let i = 1; i < args.length; i += 2) {
+    if (!keys.includes(args[i])) return false;
+  }
+  return args.length % 2 === 1;
+}
+
+function trimmed(r) {
+  return { ...r, out: r.out.trim(), err: r.err.trim() };
+}
+
+/**
+ * argv команды CLI → вызов аддона с тем же результатом, что у runLab.
+ * null — аддона нет или команда/опции не поддержаны (вызывающий идёт через spawn).
+ */
+export function runNative(args) {
+  if (!engineNative || !Array.isArray(args) || args.length === 0) return null;
+  const cmd = args[0];
+  const state = argValue(args, '--state');
+  const name = argValue(args, '--name');
+  const dir = args[args.length - 1];
+  if (!state) return null;
+  switch (cmd) {
+    case 'move':
+    case 'attack':
+      if (!name || !DIRECTIONS.has(dir) || args.length !== 6) return null;
+      return engineNative[cmd](state, name, dir).then(trimmed);
+    case 'use-item': {
+      const item = argValue(args, '--item');
+      if (!name || !item || !DIRECTIONS.has(dir) || args.length !== 8) return null;
+      return engineNative.useItem(state, name, item, dir).then(trimmed);
+    }
+    case 'resolve-bots':
+      if (!onlyKeys(args, ['--state'])) return null;
+      return engineNative.resolveBots(state).then(trimmed);
+    case 'undo': {
+      if (!onlyKeys(args, ['--state', '--steps'])) return null;
+      const steps = argValue(args, '--steps');
+      return engineNative.undo(state, steps === undefined ? 1 : Number(steps)).then(trimmed);
+    }
+    case 'player-status': {
+      const snapshot = args[args.length - 1] === '--snapshot';
+      if (!name || !onlyKeys(snapshot ? args.slice(0, -1) : args, ['--state', '--name'])) return null;
+      return engineNative.playerStatus(state, name, snapshot).then(trimmed);
+    }
+    case 'export-svg': {
+      if (!onlyKeys(args, ['--state', '--out', '--cell', '--margin'])) return null;
+      const out = argValue(args, '--out');
+      if (!out) return null;
+      const opts = {};
+      if (argValue(args, '--cell') !== undefined) opts.cell = Number(argValue(args, '--cell'));
+      if (argValue(args, '--margin') !== undefined) opts.margin = Number(argValue(args, '--margin'));
+      return engineNative.exportSvg(state, out, opts).then(trimmed);
+    }
+    default:
+      return null;
+  }
+}
@@ -10,5 +10,7 @@ const __dirname = path.dirname(fileURLToPath(import.meta.url));
 export const REPO_ROOT = path.resolve(__dirname, '..', '..');
 
 export const LAB_BIN = path.join(REPO_ROOT, 'build', 'labyrinth');
+/** N-API аддон движка (cmake -DLABYRINTH_NODE_ADDON=ON); без него всё идёт через LAB_BIN */
+export const LAB_ADDON = path.join(REPO_ROOT, 'build', 'labyrinth_node.node');
 export const ROOMS_DIR = path.join(REPO_ROOT, 'rooms');
 export const SCENARIOS_DIR = path.join(REPO_ROOT, 'tests', 'scenarios');
@@ -0,0 +1,72 @@
+/**
+ * Лента событий комнаты (`rooms/<id>.txt.events`, JSONL с seq) — её дописывает движок после каждого
+ * изменения состояния. Сервер читает только новый хвост файла, так что обновление зрителей стоит
+ * O(событий), а не перечитывания всего состояния.
+ */
+import fs from 'fs';
+import { stateFile } from './roomFiles.js';
+
+/** room → байтовое смещение уже прочитанной части ленты */
+const offsets = new Map();
+
+export function eventsFile(room) {
+  return stateFile(room) + '.events';
+}
+
+/** Включить ленту комнаты: движок пишет события, только если файл существует. */
+export function createRoomEvents(room) {
+  fs.writeFileSync(eventsFile(room), '');
+  offsets.set(room, 0);
+}
+
+function parseLines(text) {
+  const out = [];
+  for (const line of text.split('\n')) {
+    if (!line) continue;
+    try {
+      out.push(JSON.parse(line));
+    } catch {
+      // недописанная/битая строка — пропуск; клиент увидит дыру в seq
+    }
+  }
+  return out;
+}
+
+/** Новые события с прошлого вызова (полные строки); [] — ленты нет или ничего не добавилось. */
+export function readNewRoomEvents(room) {
+  const file = eventsFile(room);
+  let fd;
+  try {
+    fd = fs.openSync(file, 'r');
+  } catch {
+    return [];
+  }
+  try {
+    const size = fs.fstatSync(fd).size;
+    let from = offsets.get(room) ?? size; // после рестарта сервера — только новое
+    if (from > size) from = 0;           // файл пересоздан
+    if (size === from) {
+      offsets.set(room, from);
+      return [];
+    }
+    const buf = Buffer.alloc(size - from);
+    fs.readSync(fd, buf, 0, buf.length, from);
+    const text = buf.toString('utf8');
+    const end = text.lastIndexOf('\n') + 1;
+    offsets.set(room, from + Buffer.byteLength(text.slice(0, end)));
+    return parseLines(text.slice(0, end));
+  } finally {
+    fs.closeSync(fd);
+  }
+}
+
+/** Все события с seq > since — догнать ленту после переподключения. */
+export function readRoomEventsSince(room, since) {
+  let text;
+  try {
+    text = fs.readFileSync(eventsFile(room), 'utf8');
+  } catch {
+    return [];
+  }
+  return parseLines(text).filter(ev => ev.seq > since);
+}
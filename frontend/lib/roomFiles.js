@@ -13,6 +13,11 @@ export function svgFile(room) {
   return path.join(ROOMS_DIR, `${room}.svg`);
 }
 
+/** Копия состояния, с которого клиенту последний раз отдан SVG, — база для svg-patch. */
+export function renderedStateFile(room) {
+  return path.join(ROOMS_DIR, `${room}.rendered.txt`);
+}
+
 export function metaFile(room) {
   return path.join(ROOMS_DIR, `${room}.json`);
 }
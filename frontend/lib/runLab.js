@@ -1,10 +1,15 @@
 import { spawn } from 'child_process';
 import { LAB_BIN } from './repoPaths.js';
+import { runNative } from './engineNative.js';
 
 /**
  * Запуск бинарника labyrinth; stdout/stderr обрезаются по краям как в server.js.
+ * Горячие команды (move/attack/use-item/resolve-bots/undo/player-status/export-svg) при собранном
+ * аддоне выполняются в процессе — результат тот же.
  */
 export function runLab(args) {
+  const native = runNative(args);
+  if (native) return native;
   return new Promise((resolve) => {
     const p = spawn(LAB_BIN, args, { stdio: ['ignore', 'pipe', 'pipe'] });
     let out = '';
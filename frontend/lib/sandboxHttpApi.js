@@ -5,7 +5,7 @@ import fs from 'fs';
 import express from 'express';
 import { runLab } from './runLab.js';
 import { ROOMS_DIR } from './repoPaths.js';
-import { stateFile, svgFile, readMeta, writeMeta } from './roomFiles.js';
+import { stateFile, svgFile, renderedStateFile, readMeta, writeMeta } from './roomFiles.js';
 import { SANDBOX_ROOM_ID, SANDBOX_CREATOR_TOKEN } from './sandboxConstants.js';
 import {
   validatePlayerName,
@@ -141,12 +141,33 @@ export function createSandboxApiRouter() {
       const r = await runLab(['export-svg', '--state', sf, '--out', out]);
       if (r.code !== 0) return res.status(400).json({ ok: false, error: r.err || 'export-svg failed' });
       const svg = fs.readFileSync(out, 'utf8');
+      fs.copyFileSync(sf, renderedStateFile(SANDBOX_ROOM_ID));
       res.type('image/svg+xml').send(svg);
     } catch (e) {
       res.status(500).send(String(e?.message || e));
     }
   });
 
+  /** Патч к последнему отданному SVG (изменённые клетки, стены, маркеры); full — клиенту нужен /svg. */
+  router.get('/svg-patch', async (_req, res) => {
+    try {
+      let patch = { full: true };
+      await enqueueSandbox(async () => {
+        await ensureSandbox();
+        const sf = stateFile(SANDBOX_ROOM_ID);
+        const prev = renderedStateFile(SANDBOX_ROOM_ID);
+        if (!fs.existsSync(prev)) return;
+        const r = await runLab(['svg-patch', '--state', sf, '--prev', prev]);
+        if (r.code !== 0) throw new Error(r.err || 'svg-patch failed');
+        patch = JSON.parse(r.out);
+        if (!patch.full) fs.copyFileSync(sf, prev);
+      });
+      return res.json({ ok: true, ...patch });
+    } catch (e) {
+      return res.status(500).json({ ok: false, error: e?.message || String(e) });
+    }
+  });
+
   router.post('/generate', async (req, res) => {
     try {
       let lastCli = { stdout: '', stderr: '' };
@@ -264,6 +285,31 @@ export function createSandboxApiRouter() {
     }
   });
 
+  /** Откат последних steps команд по журналу движка (без replay); 409 — журнал пуст. */
+  router.post('/undo', async (req, res) => {
+    try {
+      const steps = Math.min(Math.max(Math.floor(Number(req.body?.steps) || 1), 1), 64);
+      let lastCli = { code: 0, stdout: '', stderr: '' };
+      await enqueueSandbox(async () => {
+        await ensureSandbox();
+        const r = await runLab(['undo', '--state', stateFile(SANDBOX_ROOM_ID), '--steps', String(steps)]);
+        lastCli = { code: r.code, stdout: r.out || '', stderr: r.err || '' };
+      });
+      if (lastCli.code !== 0) {
+        return res.status(lastCli.code === 3 ? 409 : 400).json({ ok: false, error: lastCli.stderr || 'undo failed' });
+      }
+      const snap = readStateSnapshot(stateFile(SANDBOX_ROOM_ID));
+      return res.json({
+        ok: true,
+        stdout: lastCli.stdout,
+        stderr: lastCli.stderr,
+        ...snap,
+      });
+    } catch (e) {
+      return res.status(400).json({ ok: false, error: e?.message || String(e) });
+    }
+  });
+
   router.post('/give-item', async (req, res) => {
     try {
       const name = String(req.body?.name || '').trim();
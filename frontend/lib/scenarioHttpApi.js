@@ -6,7 +6,8 @@ import path from 'path';
 import express from 'express';
 import { readMeta, stateFile } from './roomFiles.js';
 import { validateRoomId, validateScenarioId, validateManifestAction } from './gameConstants.js';
-import { readStateSnapshot } from './stateParse.js';
+import { readStateSnapshot, removeStateFiles } from './stateParse.js';
+import { runLab } from './runLab.js';
 import { enqueueSandbox } from './sandboxHttpApi.js';
 import {
   listScenarios,
@@ -81,6 +82,17 @@ function verifyCapture(req, res) {
   return { room, sf };
 }
 
+/**
+ * Временное состояние tmp → state комнаты через save движка (save-as), а не копией файла:
+ * так сайдкары комнаты (.turn) пишутся заново по новому состоянию. tmp и его сайдкары удаляются.
+ */
+async function installState(payload, tmp, sf) {
+  const r = await runLab(['save-as', '--state', tmp, '--out', sf]);
+  removeStateFiles(tmp);
+  if (r.code !== 0) return { ok: false, error: 'save-as failed', stdout: r.out, stderr: r.err };
+  return payload;
+}
+
 /** CORS для запросов с игры (другой порт на localhost). */
 export function scenarioCorsMiddleware(req, res, next) {
   const o = req.headers.origin;
@@ -157,10 +169,7 @@ export function createScenarioApiRouter() {
       await enqueueSandbox(async () => {
         payload = await runSetupOnly(dir);
         if (!payload.ok) return;
-        fs.copyFileSync(payload.tmpPath, v.sf);
-        try {
-          fs.unlinkSync(payload.tmpPath);
-        } catch (_) {}
+        payload = await installState(payload, payload.tmpPath, v.sf);
       });
       if (!payload || !payload.ok) {
         return res.status(400).json({
@@ -192,10 +201,7 @@ export function createScenarioApiRouter() {
       await enqueueSandbox(async () => {
         payload = await replayAllSteps(dir);
         if (!payload.ok) return;
-        fs.copyFileSync(payload.finalTmpPath, v.sf);
-        try {
-          fs.unlinkSync(payload.finalTmpPath);
-        } catch (_) {}
+        payload = await installState(payload, payload.finalTmpPath, v.sf);
       });
       if (!payload || !payload.ok) {
         return res.status(400).json({
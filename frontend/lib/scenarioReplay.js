@@ -7,6 +7,7 @@ import os from 'os';
 import { SCENARIOS_DIR } from './repoPaths.js';
 import { runLab } from './runLab.js';
 import { validateManifestAction } from './gameConstants.js';
+import { removeStateFiles } from './stateParse.js';
 
 export const SCENARIO_FILE = 'scenario.json';
 
@@ -84,7 +85,11 @@ export function buildSetupCmd(statePath, action) {
     if (action.seed != null) args.push('--seed', String(Number(action.seed)));
     if (action.turns != null) args.push('--turns', action.turns ? '1' : '0');
     if (action.turn_actions != null) args.push('--turn-actions', String(Number(action.turn_actions)));
-    if (action.bot_steps) args.push('--bot-steps', String(Number(action.bot_steps)));
+    if (action.bot_steps) {
+      args.push('--bot-steps', String(Number(action.bot_steps)));
+      if (action.bot_search) args.push('--bot-search', String(Number(action.bot_search)));
+      if (action.bot_budget_us != null) args.push('--bot-budget-us', String(Number(action.bot_budget_us)));
+    }
     return args;
   }
   if (t === 'add-player') {
@@ -247,9 +252,7 @@ export async function runScenario(scenarioDirPath) {
     `lab_scn_${Date.now()}_${Math.random().toString(36).slice(2)}.txt`,
   );
   function fail(payload) {
-    try {
-      fs.unlinkSync(tmp);
-    } catch (_) {}
+    removeStateFiles(tmp);
     return payload;
   }
   let accumulatedStdout = '';
@@ -349,9 +352,7 @@ export async function runScenario(scenarioDirPath) {
       stderr: accumulatedStderr,
     };
   } catch (e) {
-    try {
-      fs.unlinkSync(tmp);
-    } catch (_) {}
+    removeStateFiles(tmp);
     return { ok: false, error: e?.message || String(e) };
   }
 }
@@ -371,9 +372,7 @@ export async function runSetupOnly(scenarioDirPath) {
       const step = setup[i];
       const r = await runLab(buildSetupCmd(tmp, step));
       if (r.code !== 0) {
-        try {
-          fs.unlinkSync(tmp);
-        } catch (_) {}
+        removeStateFiles(tmp);
         return {
           ok: false,
           error: `setup[${i}] failed`,
@@ -384,9 +383,7 @@ export async function runSetupOnly(scenarioDirPath) {
     }
     return { ok: true, tmpPath: tmp, description: data.description || data.title };
   } catch (e) {
-    try {
-      fs.unlinkSync(tmp);
-    } catch (_) {}
+    removeStateFiles(tmp);
     return { ok: false, error: e?.message || String(e) };
   }
 }
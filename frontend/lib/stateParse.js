@@ -1,5 +1,6 @@
 /**
  * Разбор state.txt (как в server.js parseTurnInfo + список имён из PLAYERS).
+ * Сначала читается сайдкар `<state>.turn`, который движок пишет при каждом сохранении.
  */
 import fs from 'fs';
 
@@ -43,8 +44,70 @@ export function parseTurnInfoFromStateText(txt) {
   }
 }
 
+/** Сайдкар движка рядом с состоянием: очередь и ростер без разбора всего state.txt. */
+export function turnSidecarPath(statePath) {
+  return `${statePath}.turn`;
+}
+
+/**
+ * Разбор `<state>.turn` (TURNINFO 1). null — сайдкара нет или формат незнакомый
+ * (старое состояние) — тогда вызывающий разбирает state.txt.
+ */
+export function parseTurnSidecarText(txt) {
+  const arr = String(txt).split('\n');
+  if (arr[0] !== 'TURNINFO 1') return null;
+  const field = (i, key) => {
+    const parts = (arr[i] || '').split(/\s+/);
+    return parts[0] === key ? parts : null;
+  };
+  const ver = field(1, 'VERSION');
+  const fin = field(2, 'FINISHED');
+  const turns = field(3, 'TURNS');
+  if (!ver || !fin || !turns) return null;
+  const cnt = Number(turns[3]) || 0;
+  const order = arr.slice(4, 4 + cnt).map((l) => l.trim());
+  const pl = field(4 + cnt, 'PLAYERS');
+  if (!pl) return null;
+  const np = Number(pl[1]) || 0;
+  const players = arr.slice(5 + cnt, 5 + cnt + np).map((l) => l.trim()).filter(Boolean);
+  const index = order.length ? (Number(turns[2]) || 0) % order.length : 0;
+  return {
+    version: Number(ver[1]) || 0,
+    finished: Number(fin[1]) !== 0,
+    players,
+    turn: {
+      enforce: Number(turns[1]) !== 0,
+      order,
+      index,
+      current: order.length ? order[index] : null,
+    },
+  };
+}
+
+/** Сайдкары, которые движок пишет рядом с состоянием при каждом save. */
+export const STATE_SIDECARS = ['.turn', '.shm'];
+
+/** Удалить временное состояние вместе с его сайдкарами (ошибки — файла уже нет — не важны). */
+export function removeStateFiles(statePath) {
+  for (const p of [statePath, ...STATE_SIDECARS.map((s) => statePath + s)]) {
+    try {
+      fs.unlinkSync(p);
+    } catch (_) {}
+  }
+}
+
+export function readTurnSidecar(statePath) {
+  try {
+    return parseTurnSidecarText(fs.readFileSync(turnSidecarPath(statePath), 'utf8'));
+  } catch {
+    return null;
+  }
+}
+
 export function readStateSnapshot(statePath) {
   if (!fs.existsSync(statePath)) return { players: [], turn: { enforce: false, order: [], current: null } };
+  const side = readTurnSidecar(statePath);
+  if (side) return { players: side.players, turn: side.turn };
   const txt = fs.readFileSync(statePath, 'utf8');
   return {
     players: parsePlayersFromStateText(txt),
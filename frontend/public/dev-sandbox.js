@@ -115,13 +115,66 @@
     session = { room: d.room, creatorToken: d.creatorToken };
   }
 
-  async function refreshSvg() {
+  async function refreshFullSvg() {
     const r = await fetch(API + '/sandbox/svg');
     if (!r.ok) throw new Error('svg');
     const svg = await r.text();
     document.getElementById('mapHolder').innerHTML = svg;
   }
 
+  const SVG_NS = 'http://www.w3.org/2000/svg';
+
+  /** Применяет svg-patch к показанной карте; false — разметка не та (старый SVG), нужен полный. */
+  function applySvgPatch(svg, p) {
+    const cells = svg.querySelector('#lab-cells');
+    const items = svg.querySelector('#lab-items');
+    const markers = svg.querySelector('#lab-markers');
+    if (!cells || !items || !markers) return false;
+    for (const c of p.cells || []) {
+      const sel = `[data-x="${c.x}"][data-y="${c.y}"]`;
+      cells.querySelector('rect.cell' + sel)?.remove();
+      items.querySelector('g' + sel)?.remove();
+      const tmp = document.createElementNS(SVG_NS, 'g');
+      tmp.innerHTML = c.svg;
+      for (const el of Array.from(tmp.children)) {
+        (el.tagName === 'rect' ? cells : items).appendChild(el);
+      }
+    }
+    if (p.walls != null) {
+      const walls = svg.querySelector('#lab-walls');
+      // SVG без разметки линий (старый экспорт) — точечно не заменить, нужен полный рендер
+      if (!walls || !walls.querySelector('g.exit')) return false;
+      const replace = (attr, lines) => {
+        for (const l of lines || []) {
+          walls.querySelector(`path[${attr}="${l.i}"]`)?.remove();
+          const tmp = document.createElementNS(SVG_NS, 'g');
+          tmp.innerHTML = l.svg;
+          for (const el of Array.from(tmp.children)) walls.appendChild(el);
+        }
+      };
+      replace('data-col', p.walls.cols);
+      replace('data-row', p.walls.rows);
+      walls.querySelector('g.exit').remove();
+      const tmp = document.createElementNS(SVG_NS, 'g');
+      tmp.innerHTML = p.walls.exit;
+      for (const el of Array.from(tmp.children)) walls.appendChild(el);
+    }
+    markers.innerHTML = p.markers || '';
+    const panel = svg.querySelector('#lab-panel');
+    if (panel && p.panel != null) panel.innerHTML = p.panel;
+    return true;
+  }
+
+  /** Обновляет карту патчем к уже показанному SVG; полный экспорт — только при первой загрузке или смене размера. */
+  async function refreshSvg() {
+    const svg = document.querySelector('#mapHolder svg');
+    if (svg) {
+      const p = await jfetch(API + '/sandbox/svg-patch');
+      if (!p.full && applySvgPatch(svg, p)) return;
+    }
+    await refreshFullSvg();
+  }
+
   function attachItemTooltip(infoEl, displayName, description, rechargeHint) {
     const tip = document.createElement('div');
     tip.className = 'tooltip';
@@ -555,7 +608,7 @@
     }
   };
 
-  document.getElementById('btnRefreshSvg').onclick = () => refreshSvg().catch((e) => logStderr(String(e)));
+  document.getElementById('btnRefreshSvg').onclick = () => refreshFullSvg().catch((e) => logStderr(String(e)));
 
   document.getElementById('btnAddPl').onclick = async () => {
     try {
@@ -24,6 +24,8 @@ import {
   WEAPON_IDS_FOR_LOBBY,
 } from './lib/gameConstants.js';
 import { stateFile, svgFile, readMeta, writeMeta } from './lib/roomFiles.js';
+import { createRoomEvents, readNewRoomEvents, readRoomEventsSince } from './lib/roomEvents.js';
+import { readTurnSidecar, parseTurnInfoFromStateText } from './lib/stateParse.js';
 import { createScenarioApiRouter, scenarioCorsMiddleware } from './lib/scenarioHttpApi.js';
 import { createSandboxApiRouter } from './lib/sandboxHttpApi.js';
 
@@ -40,6 +42,11 @@ function sanitizeStr(s, maxLen) {
 }
 
 const ALLOWED_ORIGINS = (process.env.ALLOWED_ORIGINS || '').split(',').filter(Boolean);
+// Условия на карту комнаты (generate --constraints), напр. "treasure_exit>=8,exit_hospital>=4"; пусто — любой сид.
+const MAP_CONSTRAINTS = String(process.env.LAB_MAP_CONSTRAINTS || '').trim();
+// Бот с поиском вперёд (generate --bot-search): глубина в ходах бота и бюджет хода в мкс; 0 — жадный бот.
+const BOT_SEARCH_DEPTH = Math.max(0, Math.floor(Number(process.env.LAB_BOT_SEARCH_DEPTH) || 0));
+const BOT_BUDGET_US = Math.max(1, Math.floor(Number(process.env.LAB_BOT_BUDGET_US) || 2000));
 
 const app = express();
 const server = http.createServer(app);
@@ -167,23 +174,18 @@ async function resolveBotTurns(roomId) {
   return lines;
 }
 
+/** Разослать зрителям и игрокам комнаты новые события ленты. */
+function pumpRoomEvents(roomId) {
+  const events = readNewRoomEvents(roomId);
+  if (events.length) io.to('game:' + roomId).emit('roomEvents', { events });
+}
+
 function parseTurnInfo(room) {
+  const sf = stateFile(room);
+  const side = readTurnSidecar(sf);
+  if (side) return side.turn;
   try {
-    const txt = fs.readFileSync(stateFile(room), 'utf8');
-    const arr = txt.split('\n');
-    const ti = arr.findIndex(l => l.startsWith('TURNS '));
-    if (ti === -1) return { enforce: false, order: [], index: 0, current: null };
-    const parts = arr[ti].split(/\s+/);
-    const enforce = Number(parts[1]) !== 0;
-    const idx = Number(parts[2]) || 0;
-    const cnt = Number(parts[3]) || 0;
-    const order = [];
-    for (let i = 0; i < cnt; i++) {
-      const line = arr[ti + 1 + i];
-      if (line !== undefined) order.push(line.trim());
-    }
-    const safeIdx = order.length ? (Number(parts[2]) || 0) % order.length : 0;
-    return { enforce, order, index: safeIdx, current: order.length ? order[safeIdx] : null };
+    return parseTurnInfoFromStateText(fs.readFileSync(sf, 'utf8'));
   } catch { return { enforce: false, order: [], index: 0, current: null }; }
 }
 
@@ -214,7 +216,7 @@ io.on('connection', (socket) => {
       const width = Math.min(Math.max(Number(payload?.width) || DEFAULT_MAP_WIDTH, 4), 50);
       const height = Math.min(Math.max(Number(payload?.height) || DEFAULT_MAP_HEIGHT, 4), 50);
       const openness = Math.min(Math.max(Number(payload?.openness) || 0.5, 0), 1);
-      const seed = payload?.seed != null ? Number(payload.seed) : Math.floor(Math.random() * 100000);
+      let seed = payload?.seed != null ? Number(payload.seed) : Math.floor(Math.random() * 100000);
       const turnActions = Math.min(Math.max(Number(payload?.turnActions) || 1, 1), 10);
       const itemCounts = Object.fromEntries(ITEM_IDS.map((id) => [id, 0]));
       if (payload?.itemCounts && typeof payload.itemCounts === 'object') {
@@ -254,8 +256,17 @@ io.on('connection', (socket) => {
           '--turns', enforceTurns ? '1' : '0',
         ];
         if (botEnabled) genArgs.push('--bot-steps', String(botSteps));
-        const gen = await runLab(genArgs);
+        if (botEnabled && BOT_SEARCH_DEPTH > 0) {
+          genArgs.push('--bot-search', String(BOT_SEARCH_DEPTH), '--bot-budget-us', String(BOT_BUDGET_US));
+        }
+        if (MAP_CONSTRAINTS) genArgs.push('--constraints', MAP_CONSTRAINTS);
+        let gen = await runLab(genArgs);
+        // ни один сид не прошёл условия — комната всё равно создаётся, на исходном сиде
+        if (gen.code === 3 && MAP_CONSTRAINTS) gen = await runLab(genArgs.slice(0, -2));
         if (gen.code !== 0) throw new Error(gen.err || gen.out || 'generate failed');
+        const picked = /Сид: (\d+)/.exec(gen.out || '');
+        if (picked) seed = Number(picked[1]);
+        createRoomEvents(roomId);
         // Place items on the map (counts per type)
         for (const id of ITEM_IDS) {
           for (let i = 0; i < itemCounts[id]; i++) {
@@ -332,6 +343,7 @@ io.on('connection', (socket) => {
           const res = await runLab(['add-player-random', '--state', stateFile(roomId), '--name', name]);
           if (res.code !== 0) throw new Error(res.err || res.out || 'Не удалось добавить игрока');
         });
+        pumpRoomEvents(roomId);
         return cb?.({ ok: true, started: true });
       }
 
@@ -387,6 +399,7 @@ io.on('connection', (socket) => {
       meta.started = true;
       writeMeta(myRoom, meta);
 
+      pumpRoomEvents(myRoom);
       const turn = parseTurnInfo(myRoom);
       io.to('lobby:' + myRoom).emit('gameStarted', { turn });
       cb?.({ ok: true });
@@ -420,6 +433,7 @@ io.on('connection', (socket) => {
       myIsCreator = isCreator;
 
       const botLines = await resolveBotTurns(roomId);
+      pumpRoomEvents(roomId);
       const turn = parseTurnInfo(roomId);
       const status = await fetchPlayerStatus(roomId, name);
       cb?.({ ok: true, turn, isCreator, playerStatus: status });
@@ -432,7 +446,18 @@ io.on('connection', (socket) => {
   });
 
   // ─── Game actions ───
+  /** player-status из снимка комнаты (rooms/<id>.txt.shm): без очереди комнаты, не ждёт записей. */
+  async function snapshotPlayerStatus(room, name) {
+    try {
+      const res = await runLab(['player-status', '--state', stateFile(room), '--name', name, '--snapshot']);
+      if (res.code === 0) return JSON.parse(res.out);
+    } catch {}
+    return null;
+  }
+
   async function fetchPlayerStatus(room, name) {
+    const snap = await snapshotPlayerStatus(room, name);
+    if (snap) return snap;
     try {
       const res = await runLab(['player-status', '--state', stateFile(room), '--name', name]);
       if (res.code === 0) return JSON.parse(res.out);
@@ -466,6 +491,7 @@ io.on('connection', (socket) => {
           }
         });
         socket.emit('feedback', { lines: feedback, who: myName });
+        pumpRoomEvents(myRoom);
         const turn = parseTurnInfo(myRoom);
         io.to('game:' + myRoom).emit('turn', turn);
         // Broadcast action summary to other players
@@ -509,12 +535,20 @@ io.on('connection', (socket) => {
     p => VALID_DIRS.has(p?.dir) && VALID_ITEMS.has(p?.item)
   ));
 
+  // ─── Лента событий: догнать пропущенное после переподключения (seq > since) ───
+  socket.on('roomEventsSince', (payload, cb) => {
+    if (!myRoom) return cb?.({ ok: false, error: 'Не в комнате' });
+    const since = Number(payload?.since) || 0;
+    cb?.({ ok: true, events: readRoomEventsSince(myRoom, since) });
+  });
+
   // ─── Player status (inventory) ───
   socket.on('getPlayerStatus', async (_payload, cb) => {
     if (!myRoom || !myName) return cb?.({ ok: false, error: 'Не в игре' });
     try {
-      let data;
-      await enqueue(myRoom, async () => {
+      let data = await snapshotPlayerStatus(myRoom, myName);
+      // снимка нет (комната от старой версии) — полное чтение в очереди комнаты
+      if (!data) await enqueue(myRoom, async () => {
         const res = await runLab(['player-status', '--state', stateFile(myRoom), '--name', myName]);
         if (res.code !== 0) throw new Error(res.err || 'player-status failed');
         data = JSON.parse(res.out);
@@ -536,6 +570,7 @@ io.on('connection', (socket) => {
         msg = res.out?.trim();
         if (res.code !== 0) throw new Error(res.err || 'set-turns failed');
       });
+      pumpRoomEvents(myRoom);
       const turn = parseTurnInfo(myRoom);
       io.to('game:' + myRoom).emit('turn', turn);
       io.to('game:' + myRoom).emit('turnsToggled', { enabled: !!payload?.enabled });
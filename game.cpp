@@ -6,12 +6,18 @@
 #include "items/Flashlight.hpp"
 #include "items/LootTreasure.hpp"
 #include "locations/Location.hpp"
+#include "botsearch.hpp"
+#include "flood.hpp"
 #include "generator.hpp"
 #include "locations/Hospital.hpp"
+#include "metrics.hpp"
 #include "rng.hpp"
+#include "alloc.hpp"
+#include "arena.hpp"
+#include "trace.hpp"
+#include "undo.hpp"
 #include <algorithm>
 #include <memory>
-#include <queue>
 
 static size_t manhattan(std::pair<size_t,size_t> a, std::pair<size_t,size_t> b) {
 	size_t dx = a.first > b.first ? a.first - b.first : b.first - a.first;
@@ -24,10 +30,8 @@ static void ensure_turns_initialized(Game& g) {
 	if (!g.turn_order.empty()) return;
 	if (g.turn_rng_state == 0)
 		g.turn_rng_state = game_rng::splitmix64(0xA5A5A5A5A5A5A5A5ull);
-	std::vector<std::string> names;
-	names.reserve(g.players.size());
-	for (const auto& kv : g.players) names.push_back(kv.first);
-	// Порядок обхода unordered_map не задан — фиксируем вход перестановки.
+	std::vector<std::string> names = g.players.name;
+	// Вход перестановки не зависит от порядка добавления игроков.
 	std::sort(names.begin(), names.end());
 	// Fisher–Yates с сохраняемым turn_rng_state (SplitMix64).
 	for (size_t i = names.size(); i > 1; --i) {
@@ -46,23 +50,26 @@ static bool is_players_turn(Game& g, const std::string& name) {
 	if (g.turn_order.empty()) return true;
 	return g.turn_order[g.turn_index] == name;
 }
+/** Очередь на месте: только живые игроки в прежнем порядке + бот в конце (без копии очереди). */
+static void compact_turn_order(Game& g) {
+	auto& order = g.turn_order;
+	order.erase(std::remove_if(order.begin(), order.end(),
+	                           [&](const std::string& n) { return n == "bot" || !g.players.contains(n); }),
+	            order.end());
+	if (g.bot_enabled) order.emplace_back("bot");
+}
 static void advance_turn(Game& g, LabyrinthMap& map) {
 	(void)map;
 	if (!g.enforce_turns) return;
 	if (g.turn_order.empty()) return;
 	// Нормализованная очередь: только живые игроки (порядок как в turn_order) + бот всегда в конце.
 	// Так не остаётся «мёртвых» имён и не нужна отдельная логика «после бота не брать бота».
-	std::vector<std::string> filtered;
-	filtered.reserve(g.turn_order.size());
-	for (const auto& n : g.turn_order) {
-		if (n == "bot") continue;
-		if (g.players.count(n)) filtered.push_back(n);
-	}
-	if (g.bot_enabled) filtered.push_back("bot");
-	if (filtered.empty()) { g.turn_order.clear(); g.turn_index = 0; return; }
-
 	std::string cur_name;
 	if (g.turn_index < g.turn_order.size()) cur_name = g.turn_order[g.turn_index];
+	compact_turn_order(g);
+	const auto& filtered = g.turn_order;
+	if (filtered.empty()) { g.turn_index = 0; return; }
+
 	size_t cur_idx = 0;
 	{
 		bool found = false;
@@ -77,28 +84,10 @@ static void advance_turn(Game& g, LabyrinthMap& map) {
 			cur_idx = filtered.size() - 1; // «как после бота» → следующий шаг даст первого человека
 	}
 
-	std::string next_name;
-	for (size_t step = 1; step <= filtered.size(); ++step) {
-		size_t j = (cur_idx + step) % filtered.size();
-		const std::string& cand = filtered[j];
-		if (cand == "bot") {
-			if (g.bot_enabled) {
-				next_name = cand;
-				break;
-			}
-			continue;
-		}
-		next_name = cand;
-		break;
-	}
-
-	size_t next_idx = 0;
-	if (!next_name.empty()) {
-		auto it = std::find(filtered.begin(), filtered.end(), next_name);
-		if (it != filtered.end()) next_idx = static_cast<size_t>(it - filtered.begin());
-	}
-	g.turn_order = std::move(filtered);
-	g.turn_index = next_idx % g.turn_order.size();
+	// бот в очереди только при bot_enabled, поэтому следующий — просто следующий по кругу
+	// (первое вхождение имени — как раньше при поиске по имени)
+	const size_t next = (cur_idx + 1) % filtered.size();
+	g.turn_index = static_cast<size_t>(std::find(filtered.begin(), filtered.end(), filtered[next]) - filtered.begin());
 	g.actions_left = std::max(1, g.actions_per_turn);
 }
 static void consume_action_or_advance(Game& g, LabyrinthMap& map) {
@@ -120,18 +109,7 @@ void Game::canonicalize_turn_order() {
 	std::string current_name;
 	if (!turn_order.empty() && turn_index < turn_order.size())
 		current_name = turn_order[turn_index];
-	std::vector<std::string> filtered;
-	for (const auto& n : turn_order) {
-		if (n == "bot") continue;
-		if (players.count(n)) filtered.push_back(n);
-	}
-	if (bot_enabled) filtered.push_back("bot");
-	if (filtered.empty()) {
-		turn_order.clear();
-		turn_index = 0;
-		return;
-	}
-	turn_order = std::move(filtered);
+	compact_turn_order(*this);
 	turn_index = 0;
 	for (size_t i = 0; i < turn_order.size(); ++i) {
 		if (turn_order[i] == current_name) {
@@ -143,16 +121,20 @@ void Game::canonicalize_turn_order() {
 	turn_index = 0;
 }
 
-bool Game::add_player(const std::string& name, std::pair<size_t,size_t> at, const LabyrinthMap& map, std::string& err) {
+bool Game::add_player(const std::string& name, std::pair<size_t,size_t> at, LabyrinthMap& map, std::string& err) {
 	if (!map.in_bounds(static_cast<long>(at.first), static_cast<long>(at.second))) {
 		err = "Координаты вне карты";
 		return false;
 	}
-	players[name] = at;
+	const PlayerId known = players.find(name);
+	if (known != kNoPlayer) map.vacate(players.pos[known].first, players.pos[known].second);
+	const PlayerId id = players.intern(name);
+	players.set_pos(id, at);
+	map.occupy(at.first, at.second);
 	// initially knife is active
-	broken_knife.erase(name);
+	players.set_knife_broken(id, false);
 	// initially only knife is available: 1 charge
-	inventories[name].setCharges("knife", 1);
+	players.edit_inventory(id).setCharges("knife", 1);
 	// if turn order already exists — случайная позиция среди людей (детерминированно от turn_rng_state)
 	if (enforce_turns && !turn_order.empty()) {
 		if (turn_rng_state == 0)
@@ -176,18 +158,16 @@ bool Game::add_player(const std::string& name, std::pair<size_t,size_t> at, cons
 		}
 	}
 	// assign stable color if not set
-	if (!player_color.count(name)) {
+	if (players.color[id].empty()) {
 		static const char* palette[] = {
 			"#1f77b4","#ff7f0e","#2ca02c","#d62728","#9467bd",
 			"#8c564b","#e377c2","#17becf","#bcbd22","#7f7f7f"
 		};
-		std::unordered_set<std::string> used;
-		for (const auto& kv : player_color) used.insert(kv.second);
 		const char* chosen = palette[0];
 		for (const char* c : palette) {
-			if (!used.count(c)) { chosen = c; break; }
+			if (std::find(players.color.begin(), players.color.end(), c) == players.color.end()) { chosen = c; break; }
 		}
-		player_color[name] = chosen;
+		players.set_color(id, chosen);
 	}
 	return true;
 }
@@ -197,19 +177,20 @@ static long long key_xy(size_t x, size_t y) {
 }
 
 /** Сбросить весь carried treasure в кучу loot_treasure на клетке. */
-static void drop_carried_treasure_on_ground(Game& g, const std::string& victim, size_t x, size_t y) {
-	auto itInv = g.inventories.find(victim);
-	if (itInv == g.inventories.end()) return;
-	int t = itInv->second.getCharges("treasure");
+static void drop_carried_treasure_on_ground(Game& g, PlayerId victim, size_t x, size_t y) {
+	const int t = g.players.inventory[victim].getCharges("treasure");
 	if (t <= 0) return;
-	itInv->second.removeItem("treasure");
+	g.players.edit_inventory(victim).removeItem("treasure");
+	undo::loot(g, key_xy(x, y));
 	g.loot_treasure[key_xy(x, y)] += t;
 }
 
 MoveOutcome Game::move_player(const std::string& name, Direction dir, LabyrinthMap& map) {
+	LAB_TRACE_SCOPE("game.move");
+	LAB_ALLOC_SCOPE("game.move");
 	MoveOutcome out;
-	auto it = players.find(name);
-	if (it == players.end()) {
+	const PlayerId id = players.find(name);
+	if (id == kNoPlayer) {
 		out.logMessage(Message::InvalidTargetPlayer);
 		return out;
 	}
@@ -217,7 +198,7 @@ MoveOutcome Game::move_player(const std::string& name, Direction dir, LabyrinthM
 		out.logMessage(Message::NotYourMove);
 		return out;
 	}
-	auto pos = it->second;
+	const auto pos = players.pos[id];
 	long nx = static_cast<long>(pos.first);
 	long ny = static_cast<long>(pos.second);
 	bool can = false;
@@ -244,7 +225,7 @@ MoveOutcome Game::move_player(const std::string& name, Direction dir, LabyrinthM
 			// Exit the maze
 			out.moved = true;
 			out.position = pos; // remain at border cell
-			if (player_has_treasure(*this, name)) {
+			if (player_has_treasure(*this, id)) {
 				out.logMessage(Message::ExitFoundWithTreasure);
 				finished = true;
 			} else {
@@ -275,7 +256,9 @@ MoveOutcome Game::move_player(const std::string& name, Direction dir, LabyrinthM
 	std::pair<size_t,size_t> new_pos{static_cast<size_t>(nx), static_cast<size_t>(ny)};
 	// onExit for previous location if leaving it
 	CellContent prevCell = map.get_cell(pos.first, pos.second);
-	players[name] = new_pos;
+	players.set_pos(id, new_pos);
+	map.vacate(pos.first, pos.second);
+	map.occupy(new_pos.first, new_pos.second);
 	out.moved = true;
 	out.position = new_pos;
     out.logMessage(Message::Moved, {dir_wire(dir)});
@@ -284,13 +267,13 @@ MoveOutcome Game::move_player(const std::string& name, Direction dir, LabyrinthM
 	// If moved between different location types, call onExit for previous
 	if (prevCell != newCell) {
 		auto* locPrev = getLocationFor(prevCell);
-		locPrev->onExit(*this, map, name, pos.first, pos.second, out);
+		locPrev->onExit(*this, map, id, pos.first, pos.second, out);
 	}
 
 	// Generic onEnter for any cell
 	{
 		auto* locNew = getLocationFor(newCell);
-		locNew->onEnter(*this, map, name, new_pos.first, new_pos.second, out);
+		locNew->onEnter(*this, map, id, new_pos.first, new_pos.second, out);
 	}
 
 	switch (newCell) {
@@ -300,8 +283,10 @@ MoveOutcome Game::move_player(const std::string& name, Direction dir, LabyrinthM
 	auto lk = key_xy(new_pos.first, new_pos.second);
 	auto itloot = loot_treasure.find(lk);
 	if (itloot != loot_treasure.end() && itloot->second > 0) {
-		int cur = inventories[name].getCharges("treasure");
-		inventories[name].setCharges("treasure", cur + 1);
+		undo::loot(*this, lk);
+		Inventory& inv = players.edit_inventory(id);
+		int cur = inv.getCharges("treasure");
+		inv.setCharges("treasure", cur + 1);
 		itloot->second -= 1;
 		if (itloot->second <= 0) loot_treasure.erase(itloot);
 		out.logMessage(Message::TreasureFound);
@@ -309,20 +294,22 @@ MoveOutcome Game::move_player(const std::string& name, Direction dir, LabyrinthM
 	// Pick up ground items if present
 	auto itItems = ground_items.find(lk);
 	if (itItems != ground_items.end() && !itItems->second.empty()) {
+		undo::ground(*this, lk);
+		Inventory& inv = players.edit_inventory(id);
 		for (const auto& kv : itItems->second) {
 			const std::string& itemId = kv.first;
 			int grant = kv.second;
 			if (grant <= 0) continue;
-			int cur = inventories[name].getCharges(itemId);
-			inventories[name].setCharges(itemId, cur + grant);
-			if (itemId == "knife" && inventories[name].getCharges("knife") > 0) broken_knife.erase(name);
+			int cur = inv.getCharges(itemId);
+			inv.setCharges(itemId, cur + grant);
+			if (itemId == "knife" && inv.getCharges("knife") > 0) players.set_knife_broken(id, false);
 			if (itemId == "flashlight") out.logMessage(Message::FlashLightFound);
 			else if (itemId == "rifle") out.logMessage(Message::RifleFound);
 			else if (itemId == "shotgun") out.logMessage(Message::ShotgunFound);
 			else if (itemId == "knife") out.logMessage(Message::KnifeFound);
 			else if (itemId == "armor") out.logMessage(Message::ArmourFound);
 			else if (itemId == "treasure") out.logMessage(Message::TreasurePicked);
-            else out.logMessage(Message::ItemFound, {itemId});
+            else out.logMessage(Message::ItemFound, {messageToken(itemId)});
 		}
 		ground_items.erase(itItems);
 	}
@@ -334,9 +321,9 @@ MoveOutcome Game::move_player(const std::string& name, Direction dir, LabyrinthM
 		return false;
 	};
 	bool feltBreathing = false;
-	for (const auto& kv : players) {
-		if (kv.first == name) continue;
-		auto other = kv.second;
+	for (PlayerId o = 0; o < players.size(); ++o) {
+		if (o == id) continue;
+		const auto other = players.pos[o];
 		size_t dx = (new_pos.first > other.first) ? (new_pos.first - other.first) : (other.first - new_pos.first);
 		size_t dy = (new_pos.second > other.second) ? (new_pos.second - other.second) : (other.second - new_pos.second);
 		if (dx + dy != 1) continue; // only adjacent, not same cell
@@ -357,6 +344,8 @@ MoveOutcome Game::move_player(const std::string& name, Direction dir, LabyrinthM
 }
 
 AttackOutcome Game::attack(const std::string& name, Direction dir, LabyrinthMap& map) {
+	LAB_TRACE_SCOPE("game.attack");
+	LAB_ALLOC_SCOPE("game.attack");
 	// Backward compatibility: attack = use knife
 	AttackOutcome out;
 	if (!is_players_turn(*this, name)) {
@@ -365,7 +354,7 @@ AttackOutcome Game::attack(const std::string& name, Direction dir, LabyrinthMap&
 	}
 	auto use = use_item(name, std::string("knife"), dir, map);
 	out.attacked = use.used;
-	out.messages = std::move(use.messages);
+	out.events = std::move(use.events);
 	out.bot_respawn_for_log = use.bot_respawn_for_log;
 	out.bot_log_x = use.bot_log_x;
 	out.bot_log_y = use.bot_log_y;
@@ -373,10 +362,12 @@ AttackOutcome Game::attack(const std::string& name, Direction dir, LabyrinthMap&
 }
 
 UseOutcome Game::use_item(const std::string& name, const std::string& itemId, Direction dir, LabyrinthMap& map) {
+	LAB_TRACE_SCOPE("game.use_item");
+	LAB_ALLOC_SCOPE("game.use_item");
 	UseOutcome out;
 	pending_bot_respawn_log = false;
-	auto itp = players.find(name);
-	if (itp == players.end()) { out.logMessage(Message::InvalidTargetPlayer); return out; }
+	const PlayerId id = players.find(name);
+	if (id == kNoPlayer) { out.logMessage(Message::InvalidTargetPlayer); return out; }
 	if (!is_players_turn(*this, name)) {
 		out.logMessage(Message::NotYourMove);
 		return out;
@@ -390,7 +381,8 @@ UseOutcome Game::use_item(const std::string& name, const std::string& itemId, Di
 	else if (itemId == "treasure") item = std::make_unique<LootTreasure>();
 	else { out.logMessage(Message::UnknownItem); return out; }
 	// Delegate charge logic to item
-	out.used = item_use(*this, *item, map, name, dir, out);
+	out.used = item_use(*this, *item, map, id, dir, out);
+	if (out.used) metrics::add(metrics::Counter::ItemsUsed);
 	if (pending_bot_respawn_log) {
 		out.bot_respawn_for_log = true;
 		out.bot_log_x = pending_bot_log_x;
@@ -409,20 +401,17 @@ UseOutcome Game::use_item(const std::string& name, const std::string& itemId, Di
 	return out;
 }
 
-void Game::apply_replay_bot_kill(const std::string& victim, LabyrinthMap& map) {
-	auto itp = players.find(victim);
-	if (itp == players.end()) return;
-	drop_carried_treasure_on_ground(*this, victim, itp->second.first, itp->second.second);
+void Game::apply_replay_bot_kill(PlayerId victim, LabyrinthMap& map) {
+	if (victim >= players.size()) return;
+	drop_carried_treasure_on_ground(*this, victim, players.pos[victim].first, players.pos[victim].second);
 	if (auto* loc = getLocationFor(CellContent::Hospital)) {
 		if (auto* hosp = dynamic_cast<HospitalLocation*>(loc))
 			hosp->teleportToHospital(*this, map, victim);
 	}
 }
 
-static bool player_stands_on_hospital(const Game& g, const LabyrinthMap& map, const std::string& name) {
-	auto it = g.players.find(name);
-	if (it == g.players.end()) return false;
-	return map.get_cell(it->second.first, it->second.second) == CellContent::Hospital;
+static bool player_stands_on_hospital(const Game& g, const LabyrinthMap& map, PlayerId id) {
+	return map.get_cell(g.players.pos[id].first, g.players.pos[id].second) == CellContent::Hospital;
 }
 
 static bool try_random_bot_step(Game& g, LabyrinthMap& map, std::vector<BotReplayStep>* replay_log) {
@@ -460,6 +449,10 @@ static bool try_random_bot_step(Game& g, LabyrinthMap& map, std::vector<BotRepla
 // Бот: n = bot_steps_per_turn шагов за ход. Удар возможен только если кратчайший путь к дистанции удара ≤ n−1;
 // если кратчайший путь ровно n — до цели дойти можно, удара нет. Удар до исчерпания n шагов — ход сразу кончается.
 void Game::run_bot_turn(LabyrinthMap& map, Outcome& outcome, std::vector<BotReplayStep>* replay_log) {
+	LAB_TRACE_SCOPE("bot.turn");
+	LAB_ALLOC_SCOPE("bot.turn");
+	arena::Scope turn_arena; // поле расстояний, кандидаты и путь — до конца хода
+	metrics::add(metrics::Counter::BotTurns);
 	if (!bot_enabled) { advance_turn(*this, map); return; }
 	if (players.empty()) { advance_turn(*this, map); return; }
 	if (bot_x >= map.width || bot_y >= map.height) { advance_turn(*this, map); return; }
@@ -468,18 +461,16 @@ void Game::run_bot_turn(LabyrinthMap& map, Outcome& outcome, std::vector<BotRepl
 	const size_t sx = bot_x, sy = bot_y;
 	const size_t INF = map.width * map.height + 5;
 
-	auto try_kill_victim = [&](const std::string& victim) -> bool {
-		auto itp = players.find(victim);
-		if (itp == players.end()) return false;
-		drop_carried_treasure_on_ground(*this, victim, itp->second.first, itp->second.second);
+	auto try_kill_victim = [&](PlayerId victim) -> bool {
+		drop_carried_treasure_on_ground(*this, victim, players.pos[victim].first, players.pos[victim].second);
 		if (auto* loc = getLocationFor(CellContent::Hospital)) {
 			if (auto* hosp = dynamic_cast<HospitalLocation*>(loc)) {
 				if (hosp->teleportToHospital(*this, map, victim)) {
-					outcome.logPlayerMessage(victim, Message::KilledByBot, {victim});
+					outcome.logPlayerMessage(victim, Message::KilledByBot, {MessageArg::of(victim)});
 					if (replay_log) {
 						BotReplayStep ks;
 						ks.kind = BotReplayStep::Kind::Kill;
-						ks.victim = victim;
+						ks.victim = players.name[victim];
 						replay_log->push_back(ks);
 					}
 					return true;
@@ -489,20 +480,20 @@ void Game::run_bot_turn(LabyrinthMap& map, Outcome& outcome, std::vector<BotRepl
 		return false;
 	};
 
+	// Соседи в порядке добавления (PlayerId), жертва — случайная из них, как и раньше
 	auto try_kill_adjacent = [&]() -> bool {
-		std::vector<std::string> adj;
-		for (const auto& kv : players) {
-			if (player_stands_on_hospital(*this, map, kv.first)) continue;
-			if (manhattan({bot_x, bot_y}, kv.second) <= 1) adj.push_back(kv.first);
+		std::pmr::vector<PlayerId> adj(arena::current());
+		for (PlayerId id = 0; id < players.size(); ++id) {
+			if (player_stands_on_hospital(*this, map, id)) continue;
+			if (manhattan({bot_x, bot_y}, players.pos[id]) <= 1) adj.push_back(id);
 		}
 		if (adj.empty()) return false;
-		const std::string& victim = adj[static_cast<size_t>(rand_u32() % adj.size())];
-		return try_kill_victim(victim);
+		return try_kill_victim(adj[static_cast<size_t>(rand_u32() % adj.size())]);
 	};
 
 	bool any_outside_hospital = false;
-	for (const auto& kv : players) {
-		if (!player_stands_on_hospital(*this, map, kv.first)) {
+	for (PlayerId id = 0; id < players.size(); ++id) {
+		if (!player_stands_on_hospital(*this, map, id)) {
 			any_outside_hospital = true;
 			break;
 		}
@@ -517,35 +508,22 @@ void Game::run_bot_turn(LabyrinthMap& map, Outcome& outcome, std::vector<BotRepl
 		return;
 	}
 
-	std::vector<std::vector<size_t>> dist(map.height, std::vector<size_t>(map.width, INF));
-	std::vector<std::vector<std::pair<int, int>>> prev(map.height, std::vector<std::pair<int, int>>(map.width, {-1, -1}));
-	std::queue<std::pair<size_t, size_t>> q;
-	dist[sy][sx] = 0;
-	q.push({sx, sy});
-	while (!q.empty()) {
-		std::pair<size_t, size_t> curp = q.front();
-		q.pop();
-		size_t cx = curp.first, cy = curp.second;
-		auto relax = [&](size_t nx, size_t ny, bool can) {
-			if (!can || dist[ny][nx] != INF) return;
-			dist[ny][nx] = dist[cy][cx] + 1;
-			prev[ny][nx] = {static_cast<int>(cx), static_cast<int>(cy)};
-			q.push({nx, ny});
-		};
-		if (cx > 0) relax(cx - 1, cy, map.can_move_left(cx, cy));
-		if (cx + 1 < map.width) relax(cx + 1, cy, map.can_move_right(cx, cy));
-		if (cy > 0) relax(cx, cy - 1, map.can_move_up(cx, cy));
-		if (cy + 1 < map.height) relax(cx, cy + 1, map.can_move_down(cx, cy));
-	}
+	trace::Span bfs_span("bot.bfs");
+	const std::pmr::vector<uint32_t> field = flood::distances(map, sx, sy);
+	auto dist_at = [&](size_t x, size_t y) -> size_t {
+		const uint32_t d = field[y * map.width + x];
+		return d == flood::kUnreached ? INF : static_cast<size_t>(d);
+	};
+	bfs_span.end();
 
 	size_t bestD = INF;
 	std::pair<size_t, size_t> bestCell{0, 0};
-	std::string bestName;
+	PlayerId best = kNoPlayer;
 
-	for (const auto& kv : players) {
-		if (player_stands_on_hospital(*this, map, kv.first)) continue;
-		size_t px = kv.second.first, py = kv.second.second;
-		std::vector<std::pair<size_t, size_t>> cand;
+	for (PlayerId id = 0; id < players.size(); ++id) {
+		if (player_stands_on_hospital(*this, map, id)) continue;
+		const auto [px, py] = players.pos[id];
+		std::pmr::vector<std::pair<size_t, size_t>> cand(arena::current());
 		cand.push_back({px, py});
 		if (px > 0) cand.push_back({px - 1, py});
 		if (px + 1 < map.width) cand.push_back({px + 1, py});
@@ -553,16 +531,15 @@ void Game::run_bot_turn(LabyrinthMap& map, Outcome& outcome, std::vector<BotRepl
 		if (py + 1 < map.height) cand.push_back({px, py + 1});
 		for (const auto& c : cand) {
 			if (c.first >= map.width || c.second >= map.height) continue;
-			size_t d = dist[c.second][c.first];
+			size_t d = dist_at(c.first, c.second);
 			if (d == INF) continue;
-			if (d < bestD || (d == bestD && kv.first < bestName)) {
+			if (d < bestD || (d == bestD && players.name[id] < players.name[best])) {
 				bestD = d;
 				bestCell = c;
-				bestName = kv.first;
+				best = id;
 			}
 		}
 	}
-	(void)bestName;
 
 	if (bestD == INF) {
 		for (size_t s = 0; s < n; ++s) {
@@ -574,6 +551,13 @@ void Game::run_bot_turn(LabyrinthMap& map, Outcome& outcome, std::vector<BotRepl
 		return;
 	}
 
+	// Поиск вперёд выбирает клетку в пределах хода; дальше — тот же путь и удар, что у жадного
+	size_t tx = 0, ty = 0;
+	if (bot_search_depth > 0 && bot_search(*this, map, tx, ty)) {
+		bestCell = {tx, ty};
+		bestD = dist_at(tx, ty);
+	}
+
 	// d = 0: уже в зоне удара; удар только если 0 ≤ n−1 (n ≥ 1)
 	if (bestD == 0 && bestD <= n - 1) {
 		try_kill_adjacent();
@@ -583,15 +567,33 @@ void Game::run_bot_turn(LabyrinthMap& map, Outcome& outcome, std::vector<BotRepl
 		return;
 	}
 
-	std::vector<std::pair<size_t, size_t>> path_cells;
+	// Путь — как у BFS с очередью: родитель клетки — первый извлечённый сосед (влево, вправо, вверх, вниз).
+	// Расстояния уже дало ядро flood, поэтому проход родителей останавливается, как только открыта цель.
+	std::pmr::vector<std::pair<size_t, size_t>> path_cells(arena::current());
 	{
-		auto cur = bestCell;
-		while (!(cur.first == sx && cur.second == sy)) {
-			path_cells.push_back(cur);
-			auto p = prev[cur.second][cur.first];
-			if (p.first < 0) break;
-			cur = {static_cast<size_t>(p.first), static_cast<size_t>(p.second)};
+		const size_t W = map.width;
+		const uint32_t kNone = UINT32_MAX;
+		const uint32_t src = static_cast<uint32_t>(sy * W + sx);
+		const uint32_t goal = static_cast<uint32_t>(bestCell.second * W + bestCell.first);
+		std::pmr::vector<uint32_t> prev(W * map.height, kNone, arena::current());
+		std::pmr::vector<uint32_t> queue(arena::current());
+		prev[src] = src;
+		queue.push_back(src);
+		for (size_t head = 0; head < queue.size() && prev[goal] == kNone; ++head) {
+			const uint32_t c = queue[head];
+			const size_t cx = c % W, cy = c / W;
+			auto relax = [&](uint32_t nb, bool can) {
+				if (!can || prev[nb] != kNone) return;
+				prev[nb] = c;
+				queue.push_back(nb);
+			};
+			relax(c - 1, map.can_move_left(cx, cy));
+			relax(c + 1, map.can_move_right(cx, cy));
+			relax(static_cast<uint32_t>(c - W), map.can_move_up(cx, cy));
+			relax(static_cast<uint32_t>(c + W), map.can_move_down(cx, cy));
 		}
+		for (uint32_t cur = goal; cur != src && prev[cur] != kNone; cur = prev[cur])
+			path_cells.push_back({cur % W, cur / W});
 		std::reverse(path_cells.begin(), path_cells.end());
 	}
 
@@ -624,29 +626,16 @@ void Game::run_bot_turn(LabyrinthMap& map, Outcome& outcome, std::vector<BotRepl
 bool hit_bot_at(Game& game, LabyrinthMap& map, size_t tx, size_t ty, Outcome& out) {
 	if (!game.bot_enabled) return false;
 	if (tx != game.bot_x || ty != game.bot_y) return false;
-	std::vector<std::pair<size_t, size_t>> spots;
-	for (size_t y = 0; y < map.height; ++y) {
-		for (size_t x = 0; x < map.width; ++x) {
-			if (map.get_cell(x, y) != CellContent::Empty) continue;
-			bool occupied = false;
-			for (const auto& kv : game.players) {
-				if (kv.second.first == x && kv.second.second == y) {
-					occupied = true;
-					break;
-				}
-			}
-			if (occupied) continue;
-			spots.emplace_back(x, y);
-		}
-	}
-	if (spots.empty()) {
+	EmptyCellPicker spots(map, true);
+	if (spots.count() == 0) {
 		out.logMessage(Message::BotStays);
 		game.pending_bot_respawn_log = false;
 		return true;
 	}
-	const size_t pick = static_cast<size_t>(rand_u32() % spots.size());
-	game.bot_x = spots[pick].first;
-	game.bot_y = spots[pick].second;
+	const size_t pick = static_cast<size_t>(rand_u32() % spots.count());
+	const auto pos = spots.pick(pick);
+	game.bot_x = pos.first;
+	game.bot_y = pos.second;
 	out.logMessage(Message::BotDestroyedRelocated);
 	game.pending_bot_respawn_log = true;
 	game.pending_bot_log_x = game.bot_x;
@@ -654,26 +643,23 @@ bool hit_bot_at(Game& game, LabyrinthMap& map, size_t tx, size_t ty, Outcome& ou
 	return true;
 }
 
-bool attempt_kill(Game& game, LabyrinthMap& map, const std::string& victim, Outcome& out) {
-	auto itp = game.players.find(victim);
-	if (itp == game.players.end()) return false;
+bool attempt_kill(Game& game, LabyrinthMap& map, PlayerId victim, Outcome& out) {
+	if (victim >= game.players.size()) return false;
 
 	// Check armor
-	auto itInv = game.inventories.find(victim);
-	if (itInv != game.inventories.end()) {
-		int armor = itInv->second.getCharges("armor");
-		if (armor > 0) {
-			armor -= 1;
-			if (armor <= 0)
-				itInv->second.removeItem("armor");
-			else
-				itInv->second.setCharges("armor", armor);
-			out.logMessage(Message::ArmorAbsorbedHit, {victim});
-			return false;
-		}
+	int armor = game.players.inventory[victim].getCharges("armor");
+	if (armor > 0) {
+		Inventory& inv = game.players.edit_inventory(victim);
+		armor -= 1;
+		if (armor <= 0)
+			inv.removeItem("armor");
+		else
+			inv.setCharges("armor", armor);
+		out.logMessage(Message::ArmorAbsorbedHit, {MessageArg::of(victim)});
+		return false;
 	}
 
-	auto pos = itp->second;
+	auto pos = game.players.pos[victim];
 	drop_carried_treasure_on_ground(game, victim, pos.first, pos.second);
 
 	bool sent = false;
@@ -2,15 +2,13 @@
 #include "map.hpp"
 #include "message.hpp"
 #include "items.hpp"
+#include "players.hpp"
 
 #include <cstdint>
 #include <string>
 #include <unordered_map>
-#include <unordered_set>
 #include <vector>
 
-enum class Direction { Up, Down, Left, Right };
-
 /** Токен направления для wire (совпадает с ключами в messageParse.js). */
 inline const char* dir_wire(Direction d) {
 	switch (d) {
@@ -23,14 +21,15 @@ inline const char* dir_wire(Direction d) {
 }
 
 struct Outcome {
-	std::vector<std::string> messages;
-	void logMessage(Message message) { messages.push_back(messageWire(message)); }
-	void logMessage(Message message, std::initializer_list<std::string> args) {
-		messages.push_back(messageWire(message, args));
+	/** Типизированные события; в wire превращаются только при печати. */
+	std::vector<MessageEvent> events;
+	void logMessage(Message message, std::initializer_list<MessageArg> args = {}) {
+		events.emplace_back(message, args);
 	}
-	/** Сообщение конкретному игроку (жертве бота): `PLAYER:имя:WIRE…` */
-	void logPlayerMessage(const std::string& victim, Message message, std::initializer_list<std::string> args = {}) {
-		messages.push_back(std::string("PLAYER:") + victim + ":" + messageWire(message, args));
+	/** Сообщение конкретному игроку (жертве бота); в wire — `PLAYER:имя:WIRE…` */
+	void logPlayerMessage(PlayerId victim, Message message, std::initializer_list<MessageArg> args = {}) {
+		events.emplace_back(message, args);
+		events.back().recipient = victim;
 	}
 };
 struct MoveOutcome : Outcome {
@@ -57,7 +56,8 @@ struct BotReplayStep {
 };
 
 struct Game {
-	std::unordered_map<std::string, std::pair<size_t,size_t>> players;
+	/** Позиции, нож, цвет и инвентарь по плотному PlayerId; имена — только на границе. */
+	PlayerTable players;
 	bool finished{false};
 
 	bool enforce_turns{false};
@@ -72,22 +72,19 @@ struct Game {
 	size_t bot_x{0};
 	size_t bot_y{0};
 	int bot_steps_per_turn{1};
+	/** Поиск вперёд (botsearch.hpp): глубина в ходах бота, 0 — жадный путь; бюджет хода в мкс. */
+	int bot_search_depth{0};
+	unsigned bot_search_budget_us{2000};
 
 	void run_bot_turn(LabyrinthMap& map, Outcome& outcome, std::vector<BotReplayStep>* replay_log = nullptr);
 	/** Только для replay: убийство ботом (как в run_bot_turn, без проверки брони). */
-	void apply_replay_bot_kill(const std::string& victim, LabyrinthMap& map);
-	// inventory: broken knife set; if name is in set -> knife broken, else active
-	std::unordered_set<std::string> broken_knife;
-	// stable per-player color hex (e.g., "#1f77b4")
-	std::unordered_map<std::string, std::string> player_color;
+	void apply_replay_bot_kill(PlayerId victim, LabyrinthMap& map);
 	// ground loot: treasure count per cell key = y*1e6 + x
 	std::unordered_map<long long, int> loot_treasure;
-	// per-player inventory
-	std::unordered_map<std::string, Inventory> inventories;
 	// ground items: per cell -> map of itemId to charges granted on pickup
 	std::unordered_map<long long, std::unordered_map<std::string,int>> ground_items;
 
-	bool add_player(const std::string& name, std::pair<size_t,size_t> at, const LabyrinthMap& map, std::string& err);
+	bool add_player(const std::string& name, std::pair<size_t,size_t> at, LabyrinthMap& map, std::string& err);
 	void init_turns();
 	/** Привести turn_order к виду [живые игроки…, bot]; сохранить текущего актёра по имени. Вызывать после load. */
 	void canonicalize_turn_order();
@@ -101,14 +98,13 @@ struct Game {
 };
 
 /** Игрок несёт сокровище (charges предмета `treasure` > 0). */
-inline bool player_has_treasure(const Game& g, const std::string& name) {
-	auto it = g.inventories.find(name);
-	return it != g.inventories.end() && it->second.getCharges("treasure") > 0;
+inline bool player_has_treasure(const Game& g, PlayerId id) {
+	return id < g.players.size() && g.players.inventory[id].getCharges("treasure") > 0;
 }
 
 // Attempt to kill a victim (weapon attack). Returns true if hospitalized.
 // If victim has armor, the armor absorbs the hit and the player survives.
-bool attempt_kill(Game& game, LabyrinthMap& map, const std::string& victim, Outcome& out);
+bool attempt_kill(Game& game, LabyrinthMap& map, PlayerId victim, Outcome& out);
 
 /** Удар по клетке (tx,ty): если там бот — перенос на случайную пустую клетку. */
 bool hit_bot_at(Game& game, LabyrinthMap& map, size_t tx, size_t ty, Outcome& out);
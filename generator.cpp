@@ -1,36 +1,14 @@
 #include "generator.hpp"
+#include "flood.hpp"
 #include "rng.hpp"
+#include "trace.hpp"
 #include <random>
 #include <stack>
 #include <unordered_set>
-#include <queue>
 #include "locations/Location.hpp"
+#include "locations/LocationUtils.hpp"
 #include "game.hpp"
 
-static size_t count_components(const LabyrinthMap& m) {
-	std::vector<std::vector<bool>> vis(m.height, std::vector<bool>(m.width, false));
-	auto enqueue = [&](std::queue<std::pair<size_t,size_t>>& q, size_t x, size_t y) {
-		if (!vis[y][x]) { vis[y][x] = true; q.push({x,y}); }
-	};
-	size_t comps = 0;
-	for (size_t y = 0; y < m.height; ++y) {
-		for (size_t x = 0; x < m.width; ++x) {
-			if (vis[y][x]) continue;
-			comps++;
-			std::queue<std::pair<size_t,size_t>> q;
-			enqueue(q, x, y);
-			while (!q.empty()) {
-				auto [cx, cy] = q.front(); q.pop();
-				if (m.can_move_left(cx, cy)) enqueue(q, cx - 1, cy);
-				if (m.can_move_right(cx, cy)) enqueue(q, cx + 1, cy);
-				if (m.can_move_up(cx, cy)) enqueue(q, cx, cy - 1);
-				if (m.can_move_down(cx, cy)) enqueue(q, cx, cy + 1);
-			}
-		}
-	}
-	return comps;
-}
-
 static std::mt19937& rng() {
 	static thread_local std::mt19937 g{std::random_device{}()};
 	return g;
@@ -63,10 +41,10 @@ void carve_maze(LabyrinthMap& map) {
 		game_rng::shuffle_portable(neighbors.begin(), neighbors.end(), rng());
 		auto [nx, ny] = neighbors.front();
 		// remove wall between cells
-		if (nx > cx) map.v_walls[cy][cx+1] = false;
-		else if (nx < cx) map.v_walls[cy][cx] = false;
-		else if (ny > cy) map.h_walls[cy+1][cx] = false;
-		else if (ny < cy) map.h_walls[cy][cx] = false;
+		if (nx > cx) map.set_vwall(cy, cx+1, false);
+		else if (nx < cx) map.set_vwall(cy, cx, false);
+		else if (ny > cy) map.set_hwall(cy+1, cx, false);
+		else if (ny < cy) map.set_hwall(cy, cx, false);
 		visited[ny][nx] = true;
 		st.push({nx, ny});
 	}
@@ -110,14 +88,15 @@ void remove_extra_walls(LabyrinthMap& map, float openness) {
 	for (size_t i = 0; i < remove_count && i < candidates.size(); ++i) {
 		auto e = candidates[i];
 		if (e.vertical) {
-			map.v_walls[e.y][e.x] = false;
+			map.set_vwall(e.y, e.x, false);
 		} else {
-			map.h_walls[e.y][e.x] = false;
+			map.set_hwall(e.y, e.x, false);
 		}
 	}
 }
 
 LabyrinthMap generate_maze_with_items(size_t width, size_t height, float openness) {
+	LAB_TRACE_SCOPE("generate");
 	LabyrinthMap map(width, height);
 	carve_maze(map);
 	remove_extra_walls(map, openness);
@@ -153,9 +132,9 @@ void place_exit_edge(LabyrinthMap& map) {
 		map.exit_y = y;
 		map.exit_x = x;
 		if (vert) {
-			map.v_walls[y][x] = false;
+			map.set_vwall(y, x, false);
 		} else {
-			map.h_walls[y][x] = false;
+			map.set_hwall(y, x, false);
 		}
 		break;
 	}
@@ -165,10 +144,10 @@ void ensure_exit_open(LabyrinthMap& map) {
 	if (!map.has_exit) return;
 	if (map.exit_vertical) {
 		// vertical edge at (exit_x, exit_y)
-		map.v_walls[map.exit_y][map.exit_x] = false;
+		map.set_vwall(map.exit_y, map.exit_x, false);
 	} else {
 		// horizontal edge at (exit_x, exit_y)
-		map.h_walls[map.exit_y][map.exit_x] = false;
+		map.set_hwall(map.exit_y, map.exit_x, false);
 	}
 }
 
@@ -183,22 +162,12 @@ void place_arsenal_cluster(LabyrinthMap& map) {
 		{{1,0},{0,1},{1,1},{2,1},{1,2}},
 	};
 	game_rng::shuffle_portable(patterns.begin(), patterns.end(), rng());
-	std::vector<std::tuple<size_t,size_t,P>> candidates;
-	for (const auto& pat : patterns) {
-		int max_dx = 0, max_dy = 0;
-		for (auto [dx,dy] : pat) { if (dx > max_dx) max_dx = dx; if (dy > max_dy) max_dy = dy; }
-		for (size_t sy = 0; sy + static_cast<size_t>(max_dy) < map.height; ++sy) {
-			for (size_t sx = 0; sx + static_cast<size_t>(max_dx) < map.width; ++sx) {
-				candidates.emplace_back(sx, sy, pat);
-			}
-		}
-	}
-	if (candidates.empty()) return;
-	game_rng::shuffle_portable(candidates.begin(), candidates.end(), rng());
-	for (auto& cand : candidates) {
-		size_t sx = std::get<0>(cand);
-		size_t sy = std::get<1>(cand);
-		const auto& pat = std::get<2>(cand);
+	const LocationUtils::AnchorSpace space(map.width, map.height, patterns);
+	if (space.total == 0) return;
+	for (uint32_t k : space.shuffled(rng())) {
+		size_t pi, sx, sy;
+		space.decode(k, pi, sx, sy);
+		const auto& pat = patterns[pi];
 		LabyrinthMap test = map;
 		std::vector<std::pair<size_t,size_t>> cells;
 		for (auto [dx,dy] : pat) cells.emplace_back(static_cast<size_t>(sx + dx), static_cast<size_t>(sy + dy));
@@ -207,28 +176,28 @@ void place_arsenal_cluster(LabyrinthMap& map) {
 		for (auto [x,y] : cells) in.insert(static_cast<long long>(y)*1000000LL + static_cast<long long>(x));
 		for (auto [x,y] : cells) {
 			long long nr = static_cast<long long>(y)*1000000LL + static_cast<long long>(x+1);
-			if (x + 1 < test.width && in.count(nr)) test.v_walls[y][x+1] = false;
+			if (x + 1 < test.width && in.count(nr)) test.set_vwall(y, x+1, false);
 			long long nd = static_cast<long long>(y+1)*1000000LL + static_cast<long long>(x);
-			if (y + 1 < test.height && in.count(nd)) test.h_walls[y+1][x] = false;
+			if (y + 1 < test.height && in.count(nd)) test.set_hwall(y+1, x, false);
 		}
 		std::vector<std::tuple<bool,size_t,size_t>> perimeter;
 		for (auto [x,y] : cells) {
 			{ bool border = (x==0); long long n= (long long)y*1000000LL + (long long)(x-1);
-			  if (border || !in.count(n)) { test.v_walls[y][x]=true; if(!border) perimeter.emplace_back(true,y,x); } }
+			  if (border || !in.count(n)) { test.set_vwall(y, x, true); if(!border) perimeter.emplace_back(true,y,x); } }
 			{ bool border = (x+1==test.width); long long n= (long long)y*1000000LL + (long long)(x+1);
-			  if (border || !in.count(n)) { test.v_walls[y][x+1]=true; if(!border) perimeter.emplace_back(true,y,x+1); } }
+			  if (border || !in.count(n)) { test.set_vwall(y, x+1, true); if(!border) perimeter.emplace_back(true,y,x+1); } }
 			{ bool border = (y==0); long long n= (long long)(y-1)*1000000LL + (long long)x;
-			  if (border || !in.count(n)) { test.h_walls[y][x]=true; if(!border) perimeter.emplace_back(false,y,x); } }
+			  if (border || !in.count(n)) { test.set_hwall(y, x, true); if(!border) perimeter.emplace_back(false,y,x); } }
 			{ bool border = (y+1==test.height); long long n= (long long)(y+1)*1000000LL + (long long)x;
-			  if (border || !in.count(n)) { test.h_walls[y+1][x]=true; if(!border) perimeter.emplace_back(false,y+1,x); } }
+			  if (border || !in.count(n)) { test.set_hwall(y+1, x, true); if(!border) perimeter.emplace_back(false,y+1,x); } }
 		}
 		if (perimeter.empty()) continue;
 		game_rng::shuffle_portable(perimeter.begin(), perimeter.end(), rng());
 		for (auto e : perimeter) {
 			LabyrinthMap test2 = test;
-			if (std::get<0>(e)) test2.v_walls[std::get<1>(e)][std::get<2>(e)] = false;
-			else test2.h_walls[std::get<1>(e)][std::get<2>(e)] = false;
-			if (count_components(test2) == 1) { map = std::move(test2); return; }
+			if (std::get<0>(e)) test2.set_vwall(std::get<1>(e), std::get<2>(e), false);
+			else test2.set_hwall(std::get<1>(e), std::get<2>(e), false);
+			if (flood::count_components(test2) == 1) { map = std::move(test2); return; }
 		}
 	}
 }
@@ -250,27 +219,15 @@ void place_hospital_cluster(LabyrinthMap& map) {
 	};
 	game_rng::shuffle_portable(patterns.begin(), patterns.end(), rng());
 
-	// Find all valid anchors for any pattern (keep away from map border by at least 1)
-	std::vector<std::tuple<size_t,size_t,P>> candidates;
-	for (const auto& pat : patterns) {
-		// Determine bounding box
-		int max_dx = 0, max_dy = 0;
-		for (auto [dx,dy] : pat) { if (dx > max_dx) max_dx = dx; if (dy > max_dy) max_dy = dy; }
-		for (size_t sy = 0; sy + static_cast<size_t>(max_dy) < map.height; ++sy) {
-			for (size_t sx = 0; sx + static_cast<size_t>(max_dx) < map.width; ++sx) {
-				// Fits entirely within [0..width-1]/[0..height-1] (can touch border)
-				candidates.emplace_back(sx, sy, pat);
-			}
-		}
-	}
-	if (candidates.empty()) return;
-	game_rng::shuffle_portable(candidates.begin(), candidates.end(), rng());
+	// Анкоры всех шаблонов (шаблон целиком внутри карты, может касаться края) — без списка кортежей
+	const LocationUtils::AnchorSpace space(map.width, map.height, patterns);
+	if (space.total == 0) return;
 
 	// Try candidates until placed without creating unreachable islands
-	for (auto& cand : candidates) {
-		size_t sx = std::get<0>(cand);
-		size_t sy = std::get<1>(cand);
-		const auto& pat = std::get<2>(cand);
+	for (uint32_t k : space.shuffled(rng())) {
+		size_t pi, sx, sy;
+		space.decode(k, pi, sx, sy);
+		const auto& pat = patterns[pi];
 		// Work on a copy to validate connectivity
 		LabyrinthMap test = map;
 		// Build set of cells
@@ -286,9 +243,9 @@ void place_hospital_cluster(LabyrinthMap& map) {
 		for (auto [x,y] : cells) in.insert(static_cast<long long>(y)*1000000LL + static_cast<long long>(x));
 		for (auto [x,y] : cells) {
 			long long nr = static_cast<long long>(y)*1000000LL + static_cast<long long>(x+1);
-			if (x + 1 < test.width && in.count(nr)) test.v_walls[y][x+1] = false;
+			if (x + 1 < test.width && in.count(nr)) test.set_vwall(y, x+1, false);
 			long long nd = static_cast<long long>(y+1)*1000000LL + static_cast<long long>(x);
-			if (y + 1 < test.height && in.count(nd)) test.h_walls[y+1][x] = false;
+			if (y + 1 < test.height && in.count(nd)) test.set_hwall(y+1, x, false);
 		}
 		// Close perimeter around cluster
 		std::vector<std::tuple<bool,size_t,size_t>> perimeter;
@@ -298,7 +255,7 @@ void place_hospital_cluster(LabyrinthMap& map) {
 				bool is_border = (x == 0);
 				long long nkey = static_cast<long long>(y)*1000000LL + static_cast<long long>(x-1);
 				if (is_border || !in.count(nkey)) {
-					test.v_walls[y][x] = true;
+					test.set_vwall(y, x, true);
 					if (!is_border) perimeter.emplace_back(true,y,x);
 				}
 			}
@@ -307,7 +264,7 @@ void place_hospital_cluster(LabyrinthMap& map) {
 				bool is_border = (x + 1 == test.width);
 				long long nkey = static_cast<long long>(y)*1000000LL + static_cast<long long>(x+1);
 				if (is_border || !in.count(nkey)) {
-					test.v_walls[y][x+1] = true;
+					test.set_vwall(y, x+1, true);
 					if (!is_border) perimeter.emplace_back(true,y,x+1);
 				}
 			}
@@ -316,7 +273,7 @@ void place_hospital_cluster(LabyrinthMap& map) {
 				bool is_border = (y == 0);
 				long long nkey = static_cast<long long>(y-1)*1000000LL + static_cast<long long>(x);
 				if (is_border || !in.count(nkey)) {
-					test.h_walls[y][x] = true;
+					test.set_hwall(y, x, true);
 					if (!is_border) perimeter.emplace_back(false,y,x);
 				}
 			}
@@ -325,7 +282,7 @@ void place_hospital_cluster(LabyrinthMap& map) {
 				bool is_border = (y + 1 == test.height);
 				long long nkey = static_cast<long long>(y+1)*1000000LL + static_cast<long long>(x);
 				if (is_border || !in.count(nkey)) {
-					test.h_walls[y+1][x] = true;
+					test.set_hwall(y+1, x, true);
 					if (!is_border) perimeter.emplace_back(false,y+1,x);
 				}
 			}
@@ -335,9 +292,9 @@ void place_hospital_cluster(LabyrinthMap& map) {
 		game_rng::shuffle_portable(perimeter.begin(), perimeter.end(), rng());
 		for (auto e : perimeter) {
 			LabyrinthMap test2 = test;
-			if (std::get<0>(e)) test2.v_walls[std::get<1>(e)][std::get<2>(e)] = false;
-			else test2.h_walls[std::get<1>(e)][std::get<2>(e)] = false;
-			if (count_components(test2) == 1) {
+			if (std::get<0>(e)) test2.set_vwall(std::get<1>(e), std::get<2>(e), false);
+			else test2.set_hwall(std::get<1>(e), std::get<2>(e), false);
+			if (flood::count_components(test2) == 1) {
 				map = std::move(test2);
 				return;
 			}
@@ -1,6 +1,6 @@
 #include "Armor.hpp"
 #include "../game.hpp"
 
-void Armor::apply(Game& /*game*/, LabyrinthMap& /*map*/, const std::string& /*playerName*/, Direction /*dir*/, Outcome& out) {
+void Armor::apply(Game& /*game*/, LabyrinthMap& /*map*/, PlayerId /*player*/, Direction /*dir*/, Outcome& out) {
 	out.logMessage(Message::ArmorPassive);
 }
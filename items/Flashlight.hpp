@@ -2,15 +2,17 @@
 #include "Item.hpp"
 
 struct Flashlight : public Item {
+	/** Дальность луча в клетках. */
+	static constexpr size_t kRange = 3;
 	const char* id() const override { return "flashlight"; }
 	const char* displayName() const override { return "Фонарь"; }
 	const char* description() const override { return "Освещает 3 клетки в выбранном направлении, показывая содержимое. Не тратит ход."; }
 	const char* rechargeHint() const override { return "Одноразовый. Найдите новый на карте."; }
-	void apply(Game& game, LabyrinthMap& map, const std::string& playerName, Direction dir, Outcome& out) override;
+	void apply(Game& game, LabyrinthMap& map, PlayerId player, Direction dir, Outcome& out) override;
 	int chargesPerUse() const override { return 1; }
 	int defaultInitialCharges() const override { return 0; }
 	bool persistsWhenDepleted() const override { return false; }
-	void onDepleted(Game& game, LabyrinthMap& map, const std::string& playerName, Outcome& out) override;
+	void onDepleted(Game& game, LabyrinthMap& map, PlayerId player, Outcome& out) override;
 };
 
 
@@ -3,9 +3,8 @@
 #include "../map.hpp"
 
 // Centralized item use wrapper: checks/consumes charges and runs apply()
-bool item_use(Game& game, Item& item, LabyrinthMap& map, const std::string& playerName, Direction dir, Outcome& out) {
-	// ensure inventory exists
-	Inventory& inv = game.inventories[playerName];
+bool item_use(Game& game, Item& item, LabyrinthMap& map, PlayerId player, Direction dir, Outcome& out) {
+	Inventory& inv = game.players.edit_inventory(player);
 	int charges = inv.getCharges(item.id());
 	const int spend = item.chargesPerUse();
 	if (charges < spend) {
@@ -14,18 +13,15 @@ bool item_use(Game& game, Item& item, LabyrinthMap& map, const std::string& play
 		return false;
 	}
 	// run effect
-	item.apply(game, map, playerName, dir, out);
+	item.apply(game, map, player, dir, out);
 	// consume
 	charges -= spend;
 	inv.setCharges(item.id(), charges);
 	// sync knife flag
-	if (std::string(item.id()) == "knife") {
-		if (charges <= 0) game.broken_knife.insert(playerName);
-		else game.broken_knife.erase(playerName);
-	}
+	if (std::string(item.id()) == "knife") game.players.set_knife_broken(player, charges <= 0);
 	// depletion behavior
 	if (charges <= 0 && !item.persistsWhenDepleted()) {
-		item.onDepleted(game, map, playerName, out);
+		item.onDepleted(game, map, player, out);
 		inv.removeItem(item.id());
 	}
 	return true;
@@ -1,4 +1,5 @@
 #pragma once
+#include "../players.hpp"
 #include <string>
 
 struct Game;
@@ -12,16 +13,16 @@ struct Item {
 	virtual const char* displayName() const = 0;
 	virtual const char* description() const = 0;
 	virtual const char* rechargeHint() const = 0;
-	virtual void apply(Game& game, LabyrinthMap& map, const std::string& playerName, Direction dir, Outcome& out) = 0;
+	virtual void apply(Game& game, LabyrinthMap& map, PlayerId player, Direction dir, Outcome& out) = 0;
 	// item consumption profile
 	virtual int chargesPerUse() const { return 1; }
 	virtual int defaultInitialCharges() const { return 0; }
 	// behavior on depletion
 	virtual bool persistsWhenDepleted() const { return false; }
-	virtual void onDepleted(Game& /*game*/, LabyrinthMap& /*map*/, const std::string& /*playerName*/, Outcome& /*out*/) {}
+	virtual void onDepleted(Game& /*game*/, LabyrinthMap& /*map*/, PlayerId /*player*/, Outcome& /*out*/) {}
 };
 
 /** Проверка зарядов, apply(), списание — общий путь для use_item. */
-bool item_use(Game& game, Item& item, LabyrinthMap& map, const std::string& playerName, Direction dir, Outcome& out);
+bool item_use(Game& game, Item& item, LabyrinthMap& map, PlayerId player, Direction dir, Outcome& out);
 
 
@@ -2,12 +2,10 @@
 #include "../map.hpp"
 #include "Knife.hpp"
 
-void Knife::apply(Game& game, LabyrinthMap& map, const std::string& playerName, Direction dir, Outcome& out) {
-	auto ita = game.players.find(playerName);
-	if (ita == game.players.end()) { out.logMessage(Message::InvalidTargetPlayer); return; }
+void Knife::apply(Game& game, LabyrinthMap& map, PlayerId player, Direction dir, Outcome& out) {
+	if (player >= game.players.size()) { out.logMessage(Message::InvalidTargetPlayer); return; }
 
-	auto pos = ita->second;
-	size_t tx = pos.first, ty = pos.second;
+	auto [tx, ty] = game.players.pos[player];
 	bool can = false;
 	switch (dir) {
 		case Direction::Left:  can = map.can_move_left(tx, ty);  if (can) --tx; break;
@@ -15,19 +13,15 @@ void Knife::apply(Game& game, LabyrinthMap& map, const std::string& playerName,
 		case Direction::Up:    can = map.can_move_up(tx, ty);    if (can) --ty; break;
 		case Direction::Down:  can = map.can_move_down(tx, ty);  if (can) ++ty; break;
 	}
-	std::string victim;
-	for (const auto& kv : game.players) {
-		if (kv.first == playerName) continue;
-		if (kv.second.first == tx && kv.second.second == ty) { victim = kv.first; break; }
-	}
+	const PlayerId victim = can ? game.players.at(tx, ty, player) : kNoPlayer;
 	if (!can) {
 		out.logMessage(Message::KnifeMiss, {dir_wire(dir)});
 		out.logMessage(Message::KnifeSpent);
 		return;
 	}
-	if (!victim.empty()) {
+	if (victim != kNoPlayer) {
 		if (attempt_kill(game, map, victim, out))
-			out.logMessage(Message::KnifeHitPlayer, {dir_wire(dir), victim});
+			out.logMessage(Message::KnifeHitPlayer, {dir_wire(dir), MessageArg::of(victim)});
 		out.logMessage(Message::KnifeSpent);
 		return;
 	}
@@ -2,6 +2,6 @@
 #include "../game.hpp"
 #include "../map.hpp"
 
-void LootTreasure::apply(Game& /*game*/, LabyrinthMap& /*map*/, const std::string& /*playerName*/, Direction /*dir*/, Outcome& out) {
+void LootTreasure::apply(Game& /*game*/, LabyrinthMap& /*map*/, PlayerId /*player*/, Direction /*dir*/, Outcome& out) {
 	out.logMessage(Message::TreasureUseHint);
 }
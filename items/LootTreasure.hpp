@@ -7,7 +7,7 @@ struct LootTreasure : public Item {
 	const char* displayName() const override { return "Сокровище"; }
 	const char* description() const override { return "Несите к выходу из лабиринта."; }
 	const char* rechargeHint() const override { return "Подбирается на клетке сокровища или с кучи на земле."; }
-	void apply(Game& game, LabyrinthMap& map, const std::string& playerName, Direction dir, Outcome& out) override;
+	void apply(Game& game, LabyrinthMap& map, PlayerId player, Direction dir, Outcome& out) override;
 	/** Как у брони: «использование» не тратит заряд — несёте до выхода. */
 	int chargesPerUse() const override { return 0; }
 	bool persistsWhenDepleted() const override { return true; }
@@ -1,36 +1,26 @@
 #include "../game.hpp"
 #include "../map.hpp"
 #include "Rifle.hpp"
+#include "../raycast.hpp"
 
-static bool step_forward(const LabyrinthMap& map, size_t& x, size_t& y, Direction dir) {
-	switch (dir) {
-		case Direction::Left:  if (!map.can_move_left(x, y)) return false;  --x; return true;
-		case Direction::Right: if (!map.can_move_right(x, y)) return false; ++x; return true;
-		case Direction::Up:    if (!map.can_move_up(x, y)) return false;    --y; return true;
-		case Direction::Down:  if (!map.can_move_down(x, y)) return false;  ++y; return true;
-	}
-	return false;
-}
+void Rifle::apply(Game& game, LabyrinthMap& map, PlayerId player, Direction dir, Outcome& out) {
+	if (player >= game.players.size()) { out.logMessage(Message::InvalidTargetPlayer); return; }
 
-void Rifle::apply(Game& game, LabyrinthMap& map, const std::string& playerName, Direction dir, Outcome& out) {
-	auto ita = game.players.find(playerName);
-	if (ita == game.players.end()) { out.logMessage(Message::InvalidTargetPlayer); return; }
-
-	size_t cx = ita->second.first, cy = ita->second.second;
+	const auto [sx, sy] = game.players.pos[player];
+	const RayCast ray = cast_ray(game, map, sx, sy, dir, kRange, player);
 	bool any = false;
-	for (int i = 0; i < 3; ++i) {
-		if (!step_forward(map, cx, cy, dir)) break;
+	size_t next = 0;
+	for (size_t d = 1; d <= ray.span; ++d) {
 		bool step_hit = false;
-		for (const auto& kv : game.players) {
-			if (kv.first == playerName) continue;
-			if (kv.second.first == cx && kv.second.second == cy) {
-				if (attempt_kill(game, map, kv.first, out))
-					out.logMessage(Message::RifleHitPlayer, {dir_wire(dir), kv.first});
-				any = true;
-				step_hit = true;
-			}
+		for (; next < ray.occupants.size() && ray.occupants[next].dist == d; ++next) {
+			const PlayerId victim = ray.occupants[next].id;
+			if (attempt_kill(game, map, victim, out))
+				out.logMessage(Message::RifleHitPlayer, {dir_wire(dir), MessageArg::of(victim)});
+			any = true;
+			step_hit = true;
 		}
-		if (!step_hit && hit_bot_at(game, map, cx, cy, out)) {
+		const auto cell = ray_cell(sx, sy, dir, d);
+		if (!step_hit && hit_bot_at(game, map, cell.first, cell.second, out)) {
 			out.logMessage(Message::RifleHitBot, {dir_wire(dir)});
 			any = true;
 		}
@@ -1,25 +1,17 @@
 #include "../game.hpp"
 #include "../map.hpp"
 #include "Shotgun.hpp"
+#include "../raycast.hpp"
+#include "../arena.hpp"
 
-static bool step_forward_sg(const LabyrinthMap& map, size_t& x, size_t& y, Direction dir) {
-	switch (dir) {
-		case Direction::Left:  if (!map.can_move_left(x, y)) return false;  --x; return true;
-		case Direction::Right: if (!map.can_move_right(x, y)) return false; ++x; return true;
-		case Direction::Up:    if (!map.can_move_up(x, y)) return false;    --y; return true;
-		case Direction::Down:  if (!map.can_move_down(x, y)) return false;  ++y; return true;
-	}
-	return false;
-}
-
-void Shotgun::apply(Game& game, LabyrinthMap& map, const std::string& playerName, Direction dir, Outcome& out) {
-	auto ita = game.players.find(playerName);
-	if (ita == game.players.end()) { out.logMessage(Message::InvalidTargetPlayer); return; }
+void Shotgun::apply(Game& game, LabyrinthMap& map, PlayerId player, Direction dir, Outcome& out) {
+	if (player >= game.players.size()) { out.logMessage(Message::InvalidTargetPlayer); return; }
 
-	size_t fx = ita->second.first, fy = ita->second.second;
-	if (!step_forward_sg(map, fx, fy, dir)) { out.logMessage(Message::ShotgunWall, {dir_wire(dir)}); return; }
+	const auto [sx, sy] = game.players.pos[player];
+	if (map.run_length(sx, sy, dir) == 0) { out.logMessage(Message::ShotgunWall, {dir_wire(dir)}); return; }
+	const auto [fx, fy] = ray_cell(sx, sy, dir, 1);
 
-	std::vector<std::pair<size_t,size_t>> targets;
+	std::pmr::vector<std::pair<size_t,size_t>> targets(arena::current());
 	switch (dir) {
 		case Direction::Up:
 		case Direction::Down: {
@@ -40,11 +32,12 @@ void Shotgun::apply(Game& game, LabyrinthMap& map, const std::string& playerName
 	bool any = false;
 	for (auto [tx, ty] : targets) {
 		bool cell_hit = false;
-		for (const auto& kv : game.players) {
-			if (kv.first == playerName) continue;
-			if (kv.second.first == tx && kv.second.second == ty) {
-				if (attempt_kill(game, map, kv.first, out))
-					out.logMessage(Message::ShotgunHitPlayer, {dir_wire(dir), kv.first});
+		// на одной клетке — в порядке добавления (PlayerId); сценарий basic/shotgun-hits-in-join-order
+		for (PlayerId id = 0; id < game.players.size(); ++id) {
+			if (id == player) continue;
+			if (game.players.pos[id] == std::make_pair(tx, ty)) {
+				if (attempt_kill(game, map, id, out))
+					out.logMessage(Message::ShotgunHitPlayer, {dir_wire(dir), MessageArg::of(id)});
 				any = true;
 				cell_hit = true;
 			}
@@ -0,0 +1,337 @@
+#include "journal.hpp"
+#include "state.hpp"
+#include "trace.hpp"
+#include "undo.hpp"
+
+#include <algorithm>
+#include <random>
+
+bool StateScalars::operator==(const StateScalars& o) const {
+	return log_size == o.log_size && random_nonce == o.random_nonce && finished == o.finished &&
+	       enforce_turns == o.enforce_turns && turn_rng_state == o.turn_rng_state && turn_index == o.turn_index &&
+	       actions_per_turn == o.actions_per_turn && actions_left == o.actions_left && bot_enabled == o.bot_enabled &&
+	       bot_x == o.bot_x && bot_y == o.bot_y && bot_steps_per_turn == o.bot_steps_per_turn &&
+	       has_exit == o.has_exit && exit_vertical == o.exit_vertical && exit_y == o.exit_y && exit_x == o.exit_x &&
+	       players_size == o.players_size;
+}
+
+static StateScalars scalars_of(const LabyrinthMap& m, const Game& g, size_t log_size, unsigned long long nonce) {
+	StateScalars s;
+	s.log_size = log_size;
+	s.random_nonce = nonce;
+	s.finished = g.finished;
+	s.enforce_turns = g.enforce_turns;
+	s.turn_rng_state = g.turn_rng_state;
+	s.turn_index = g.turn_index;
+	s.actions_per_turn = g.actions_per_turn;
+	s.actions_left = g.actions_left;
+	s.bot_enabled = g.bot_enabled;
+	s.bot_x = g.bot_x; s.bot_y = g.bot_y;
+	s.bot_steps_per_turn = g.bot_steps_per_turn;
+	s.has_exit = m.has_exit;
+	s.exit_vertical = m.exit_vertical;
+	s.exit_y = m.exit_y; s.exit_x = m.exit_x;
+	s.players_size = g.players.size();
+	return s;
+}
+
+thread_local UndoMark* undo::active = nullptr;
+
+UndoMark::UndoMark(const AppState& st)
+	: map(&st.map), players(&st.game.players), game(&st.game), width(st.map.width), height(st.map.height),
+	  scalars(scalars_of(st.map, st.game, st.log.size(), st.random_nonce)), turn_order(st.game.turn_order),
+	  outer(undo::active) {
+	undo::active = this;
+}
+
+UndoMark::~UndoMark() { undo::active = outer; }
+
+enum class Touch : uint64_t { Cell, VWall, HWall, Player, Loot, Ground };
+
+/** Первое касание (kind, index) отметкой m; ключи куч — y*1e6 + x, в 56 бит помещаются. */
+static bool first_touch(UndoMark& m, Touch kind, uint64_t index) {
+	return m.seen.insert(static_cast<uint64_t>(kind) << 56 | index).second;
+}
+
+void undo::touch_cell(const LabyrinthMap& map, size_t x, size_t y) {
+	for (UndoMark* m = active; m; m = m->outer)
+		if (m->map == &map && first_touch(*m, Touch::Cell, y * map.width + x))
+			m->touched_cells.push_back({x, y, map.cells[y][x]});
+}
+
+void undo::touch_wall(const LabyrinthMap& map, bool vertical, size_t y, size_t x) {
+	for (UndoMark* m = active; m; m = m->outer) {
+		if (m->map != &map) continue;
+		if (!first_touch(*m, vertical ? Touch::VWall : Touch::HWall, y * (map.width + 1) + x)) continue;
+		m->touched_walls.push_back({vertical, y, x, vertical ? bool(map.v_walls[y][x]) : bool(map.h_walls[y][x])});
+	}
+}
+
+void undo::touch_player(const PlayerTable& p, uint32_t id) {
+	// игроки, добавленные командой, откатываются отрезанием по players_size
+	for (UndoMark* m = active; m; m = m->outer)
+		if (m->players == &p && id < m->scalars.players_size && first_touch(*m, Touch::Player, id))
+			m->touched_players.push_back({id, p.pos[id], p.knife_broken[id], p.color[id], p.inventory[id]});
+}
+
+void undo::touch_loot(const Game& g, long long key) {
+	for (UndoMark* m = active; m; m = m->outer) {
+		if (m->game != &g || !first_touch(*m, Touch::Loot, static_cast<uint64_t>(key))) continue;
+		auto it = g.loot_treasure.find(key);
+		m->touched_loot.emplace_back(key, it == g.loot_treasure.end() ? -1 : it->second);
+	}
+}
+
+void undo::touch_ground(const Game& g, long long key) {
+	for (UndoMark* m = active; m; m = m->outer) {
+		if (m->game != &g || !first_touch(*m, Touch::Ground, static_cast<uint64_t>(key))) continue;
+		auto it = g.ground_items.find(key);
+		m->touched_ground.emplace_back(key, it == g.ground_items.end() ? std::unordered_map<std::string,int>{} : it->second);
+	}
+}
+
+static uint64_t new_step_id() {
+	thread_local std::mt19937_64 gen{(uint64_t{std::random_device{}()} << 32) ^ std::random_device{}()};
+	uint64_t id = 0;
+	while (id == 0) id = gen();
+	return id;
+}
+
+static bool same_player(const StateDelta::PlayerBefore& p, const PlayerTable& now) {
+	const PlayerId id = p.id;
+	return p.pos == now.pos[id] && p.knife_broken == now.knife_broken[id] && p.color == now.color[id] &&
+	       p.inventory.item_charges == now.inventory[id].item_charges;
+}
+
+bool journal_record(AppState& st, const UndoMark& mark, bool replace_head) {
+	LAB_TRACE_SCOPE("journal.record");
+	if (replace_head && st.journal) st.journal = st.journal->prev;
+	const LabyrinthMap& m1 = st.map;
+	if (mark.width != m1.width || mark.height != m1.height) {
+		st.journal.reset();
+		return false;
+	}
+	auto node = std::make_shared<UndoNode>();
+	StateDelta& d = node->delta;
+	d.id = new_step_id();
+	d.before = mark.scalars;
+	bool changed = d.before != scalars_of(m1, st.game, st.log.size(), st.random_nonce);
+
+	if (mark.turn_order != st.game.turn_order) {
+		d.has_turn_order = true;
+		d.turn_order = mark.turn_order;
+	}
+	// касание ещё не изменение: в дельту идёт только то, что к концу команды отличается
+	const PlayerTable& p1 = st.game.players;
+	for (const auto& p : mark.touched_players)
+		if (p.id < p1.size() && !same_player(p, p1)) d.players.push_back(p);
+	for (const auto& c : mark.touched_cells)
+		if (m1.cells[c.y][c.x] != c.c) d.cells.push_back(c);
+	for (const auto& w : mark.touched_walls)
+		if ((w.vertical ? m1.v_walls[w.y][w.x] : m1.h_walls[w.y][w.x]) != w.present) d.walls.push_back(w);
+	const auto& l1 = st.game.loot_treasure;
+	for (const auto& kv : mark.touched_loot) {
+		auto it = l1.find(kv.first);
+		if ((it == l1.end() ? -1 : it->second) != kv.second) d.loot_treasure.push_back(kv);
+	}
+	const auto& g1 = st.game.ground_items;
+	for (const auto& kv : mark.touched_ground) {
+		auto it = g1.find(kv.first);
+		const bool now_absent = it == g1.end();
+		if (now_absent ? !kv.second.empty() : it->second != kv.second) d.ground_items.push_back(kv);
+	}
+
+	changed = changed || d.has_turn_order || !d.players.empty() || !d.cells.empty() || !d.walls.empty() ||
+	          !d.loot_treasure.empty() || !d.ground_items.empty();
+	if (!changed) return false;
+	node->prev = st.journal;
+	node->depth = journal_depth(st.journal) + 1;
+	st.journal = std::move(node);
+	return true;
+}
+
+static void apply_delta(AppState& st, const StateDelta& d) {
+	const StateScalars& s = d.before;
+	Game& g = st.game;
+	if (st.log.size() > s.log_size) st.log.resize(s.log_size);
+	st.random_nonce = s.random_nonce;
+	g.finished = s.finished;
+	g.enforce_turns = s.enforce_turns;
+	g.turn_rng_state = s.turn_rng_state;
+	g.turn_index = s.turn_index;
+	g.actions_per_turn = s.actions_per_turn;
+	g.actions_left = s.actions_left;
+	g.bot_enabled = s.bot_enabled;
+	g.bot_x = s.bot_x; g.bot_y = s.bot_y;
+	g.bot_steps_per_turn = s.bot_steps_per_turn;
+	st.map.has_exit = s.has_exit;
+	st.map.exit_vertical = s.exit_vertical;
+	st.map.exit_y = s.exit_y; st.map.exit_x = s.exit_x;
+	if (d.has_turn_order) g.turn_order = d.turn_order;
+	for (size_t id = s.players_size; id < g.players.size(); ++id)
+		st.map.vacate(g.players.pos[id].first, g.players.pos[id].second);
+	g.players.truncate(s.players_size);
+	for (const auto& p : d.players) {
+		if (p.id >= g.players.size()) continue;
+		st.map.vacate(g.players.pos[p.id].first, g.players.pos[p.id].second);
+		st.map.occupy(p.pos.first, p.pos.second);
+		g.players.pos[p.id] = p.pos;
+		g.players.knife_broken[p.id] = p.knife_broken;
+		g.players.color[p.id] = p.color;
+		g.players.inventory[p.id] = p.inventory;
+	}
+	for (const auto& c : d.cells) st.map.set_cell(c.x, c.y, c.c);
+	for (const auto& w : d.walls) {
+		if (w.vertical) st.map.set_vwall(w.y, w.x, w.present);
+		else st.map.set_hwall(w.y, w.x, w.present);
+	}
+	for (const auto& kv : d.loot_treasure) {
+		if (kv.second < 0) g.loot_treasure.erase(kv.first);
+		else g.loot_treasure[kv.first] = kv.second;
+	}
+	for (const auto& kv : d.ground_items) {
+		if (kv.second.empty()) g.ground_items.erase(kv.first);
+		else g.ground_items[kv.first] = kv.second;
+	}
+}
+
+bool journal_divergence(const UndoJournal& from, const UndoJournal& to, std::vector<const StateDelta*>& steps) {
+	steps.clear();
+	std::unordered_set<uint64_t> from_ids;
+	for (const UndoNode* n = from.get(); n; n = n->prev.get())
+		if (n->delta.id) from_ids.insert(n->delta.id);
+	uint64_t common = 0;
+	for (const UndoNode* n = to.get(); n; n = n->prev.get()) {
+		if (n->delta.id && from_ids.count(n->delta.id)) { common = n->delta.id; break; }
+		steps.push_back(&n->delta);
+	}
+	if (common == 0) { steps.clear(); return false; }
+	for (const UndoNode* n = from.get(); n->delta.id != common; n = n->prev.get()) steps.push_back(&n->delta);
+	return true;
+}
+
+size_t undo_steps(AppState& st, size_t n) {
+	LAB_TRACE_SCOPE("journal.undo");
+	size_t done = 0;
+	while (done < n && st.journal) {
+		apply_delta(st, st.journal->delta);
+		st.journal = st.journal->prev;
+		++done;
+	}
+	return done;
+}
+
+static void write_charges(std::ostream& os, const std::unordered_map<std::string,int>& charges) {
+	os << charges.size();
+	for (const auto& iv : charges) os << " " << iv.first << " " << iv.second;
+}
+
+static void write_delta(std::ostream& os, const StateDelta& d) {
+	const StateScalars& s = d.before;
+	os << "STEP " << s.log_size << " " << s.random_nonce << " " << (s.finished ? 1 : 0) << " "
+	   << (s.enforce_turns ? 1 : 0) << " " << s.turn_rng_state << " " << s.turn_index << " "
+	   << s.actions_per_turn << " " << s.actions_left << " " << (s.bot_enabled ? 1 : 0) << " "
+	   << s.bot_x << " " << s.bot_y << " " << s.bot_steps_per_turn << " " << (s.has_exit ? 1 : 0) << " "
+	   << (s.exit_vertical ? 1 : 0) << " " << s.exit_y << " " << s.exit_x << " " << s.players_size << "\n";
+	if (d.id) os << "ID " << d.id << "\n";
+	if (d.has_turn_order) {
+		os << "ORDER " << d.turn_order.size();
+		for (const auto& n : d.turn_order) os << " " << n;
+		os << "\n";
+	}
+	for (const auto& p : d.players) {
+		os << "P " << p.id << " " << p.pos.first << " " << p.pos.second << " " << int(p.knife_broken) << " "
+		   << (p.color.empty() ? "-" : p.color) << " ";
+		write_charges(os, p.inventory.item_charges);
+		os << "\n";
+	}
+	for (const auto& c : d.cells) os << "C " << c.x << " " << c.y << " " << static_cast<int>(c.c) << "\n";
+	for (const auto& w : d.walls) os << (w.vertical ? "V " : "H ") << w.y << " " << w.x << " " << (w.present ? 1 : 0) << "\n";
+	for (const auto& kv : d.loot_treasure)
+		os << "LT " << kv.first % 1000000LL << " " << kv.first / 1000000LL << " " << kv.second << "\n";
+	for (const auto& kv : d.ground_items) {
+		os << "LI " << kv.first % 1000000LL << " " << kv.first / 1000000LL << " ";
+		write_charges(os, kv.second);
+		os << "\n";
+	}
+	os << "END\n";
+}
+
+void write_journal(std::ostream& os, const UndoJournal& journal) {
+	std::vector<const StateDelta*> steps;
+	for (const UndoNode* n = journal.get(); n && steps.size() < kUndoDepth; n = n->prev.get()) steps.push_back(&n->delta);
+	os << "UNDO " << steps.size() << "\n";
+	for (auto it = steps.rbegin(); it != steps.rend(); ++it) write_delta(os, **it);
+}
+
+static bool read_charges(std::istream& is, std::unordered_map<std::string,int>& charges) {
+	size_t k = 0;
+	if (!(is >> k)) return false;
+	for (size_t i = 0; i < k; ++i) {
+		std::string item; int c = 0;
+		if (!(is >> item >> c)) return false;
+		charges[item] = c;
+	}
+	return true;
+}
+
+bool read_journal(std::istream& is, UndoJournal& journal, std::string& err) {
+	journal.reset();
+	size_t count = 0;
+	if (!(is >> count)) { err = "Некорректный UNDO"; return false; }
+	for (size_t i = 0; i < count; ++i) {
+		std::string tag;
+		auto node = std::make_shared<UndoNode>();
+		StateDelta& d = node->delta;
+		StateScalars& s = d.before;
+		int fin = 0, enf = 0, bot = 0, hex = 0, exv = 0;
+		if (!(is >> tag) || tag != "STEP") { err = "Ожидался STEP"; return false; }
+		if (!(is >> s.log_size >> s.random_nonce >> fin >> enf >> s.turn_rng_state >> s.turn_index
+		         >> s.actions_per_turn >> s.actions_left >> bot >> s.bot_x >> s.bot_y >> s.bot_steps_per_turn
+		         >> hex >> exv >> s.exit_y >> s.exit_x >> s.players_size)) { err = "Некорректный STEP"; return false; }
+		s.finished = fin != 0; s.enforce_turns = enf != 0; s.bot_enabled = bot != 0;
+		s.has_exit = hex != 0; s.exit_vertical = exv != 0;
+		while (is >> tag && tag != "END") {
+			if (tag == "ID") {
+				if (!(is >> d.id)) { err = "Некорректный ID"; return false; }
+			} else if (tag == "ORDER") {
+				size_t k = 0;
+				if (!(is >> k)) { err = "Некорректный ORDER"; return false; }
+				d.has_turn_order = true;
+				for (size_t j = 0; j < k; ++j) { std::string n; if (!(is >> n)) { err = "Некорректный ORDER"; return false; } d.turn_order.push_back(n); }
+			} else if (tag == "P") {
+				StateDelta::PlayerBefore p; int kb = 0;
+				if (!(is >> p.id >> p.pos.first >> p.pos.second >> kb >> p.color) ||
+				    !read_charges(is, p.inventory.item_charges)) { err = "Некорректная запись P"; return false; }
+				p.knife_broken = kb != 0;
+				if (p.color == "-") p.color.clear();
+				d.players.push_back(std::move(p));
+			} else if (tag == "C") {
+				StateDelta::CellBefore c; int v = 0;
+				if (!(is >> c.x >> c.y >> v) || v < 0 || v > static_cast<int>(CellContent::Exit)) { err = "Некорректная запись C"; return false; }
+				c.c = static_cast<CellContent>(v);
+				d.cells.push_back(c);
+			} else if (tag == "V" || tag == "H") {
+				StateDelta::WallBefore w; int pr = 0;
+				if (!(is >> w.y >> w.x >> pr)) { err = "Некорректная запись стены"; return false; }
+				w.vertical = tag == "V"; w.present = pr != 0;
+				d.walls.push_back(w);
+			} else if (tag == "LT") {
+				size_t x = 0, y = 0; int c = 0;
+				if (!(is >> x >> y >> c)) { err = "Некорректная запись LT"; return false; }
+				d.loot_treasure.emplace_back((long long)y * 1000000LL + (long long)x, c);
+			} else if (tag == "LI") {
+				size_t x = 0, y = 0; std::unordered_map<std::string,int> items;
+				if (!(is >> x >> y) || !read_charges(is, items)) { err = "Некорректная запись LI"; return false; }
+				d.ground_items.emplace_back((long long)y * 1000000LL + (long long)x, std::move(items));
+			} else {
+				err = "Неизвестная запись UNDO"; return false;
+			}
+		}
+		if (tag != "END") { err = "Ожидался END"; return false; }
+		node->prev = journal;
+		node->depth = journal_depth(journal) + 1;
+		journal = std::move(node);
+	}
+	return true;
+}
@@ -0,0 +1,133 @@
+#pragma once
+#include "map.hpp"
+#include "game.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+struct AppState;
+
+/** Сколько последних шагов журнала отката попадает в файл состояния (в памяти — без предела). */
+constexpr size_t kUndoDepth = 64;
+
+/** Скаляры состояния до команды: пишутся в дельту всегда — дешевле, чем сравнивать по одному. */
+struct StateScalars {
+	size_t log_size{0};
+	unsigned long long random_nonce{0};
+	bool finished{false};
+	bool enforce_turns{false};
+	uint64_t turn_rng_state{0};
+	size_t turn_index{0};
+	int actions_per_turn{1};
+	int actions_left{1};
+	bool bot_enabled{false};
+	size_t bot_x{0}, bot_y{0};
+	int bot_steps_per_turn{1};
+	bool has_exit{false};
+	bool exit_vertical{false};
+	size_t exit_y{0}, exit_x{0};
+	size_t players_size{0};
+
+	bool operator==(const StateScalars& o) const;
+	bool operator!=(const StateScalars& o) const { return !(*this == o); }
+};
+
+/**
+ * Обратимая дельта одной команды: прежние значения только того, что команда изменила.
+ * Игроки только добавляются — новые отрезаются по players_size; лог только дописывается — по log_size.
+ */
+struct StateDelta {
+	/** Метка шага: случайная, переживает сохранение и копии файла; 0 — шаг из файла без меток. */
+	uint64_t id{0};
+	StateScalars before;
+	bool has_turn_order{false};
+	std::vector<std::string> turn_order;
+	struct PlayerBefore {
+		PlayerId id{kNoPlayer};
+		std::pair<size_t,size_t> pos{0, 0};
+		uint8_t knife_broken{0};
+		std::string color;
+		Inventory inventory;
+	};
+	std::vector<PlayerBefore> players;
+	struct CellBefore { size_t x{0}, y{0}; CellContent c{CellContent::Empty}; };
+	std::vector<CellBefore> cells;
+	struct WallBefore { bool vertical{false}; size_t y{0}, x{0}; bool present{false}; };
+	std::vector<WallBefore> walls;
+	/** Клетка → прежнее число сокровищ на земле; -1 — записи не было. */
+	std::vector<std::pair<long long,int>> loot_treasure;
+	/** Клетка → прежние предметы на земле; пустой набор — клетки не было. */
+	std::vector<std::pair<long long, std::unordered_map<std::string,int>>> ground_items;
+};
+
+/**
+ * Журнал отката — неизменяемый односвязный список от последнего шага к первому. Копия AppState
+ * делит его целиком, поэтому ветка «что если» стоит одного shared_ptr, а общая история не копируется.
+ */
+struct UndoNode {
+	StateDelta delta;
+	std::shared_ptr<const UndoNode> prev;
+	size_t depth{1};
+};
+using UndoJournal = std::shared_ptr<const UndoNode>;
+
+inline size_t journal_depth(const UndoJournal& j) { return j ? j->depth : 0; }
+
+/**
+ * Отметка перед командой. Пока жива, точки записи (undo.hpp) складывают сюда прежние значения того,
+ * что команда трогает в st: клетки, стены, игроки, кучи на земле — по первому касанию, без копии
+ * карты и игры. Скаляры и очередь ходов запоминаются сразу. Отметки вкладываются (касание видят все
+ * живые), живут на стеке и не копируются.
+ */
+struct UndoMark {
+	explicit UndoMark(const AppState& st);
+	~UndoMark();
+	UndoMark(const UndoMark&) = delete;
+	UndoMark& operator=(const UndoMark&) = delete;
+
+	const LabyrinthMap* map;
+	const PlayerTable* players;
+	const Game* game;
+	size_t width, height;
+	StateScalars scalars;
+	std::vector<std::string> turn_order;
+	/** Первые касания; сравниваются с итогом в journal_record. */
+	std::vector<StateDelta::PlayerBefore> touched_players;
+	std::vector<StateDelta::CellBefore> touched_cells;
+	std::vector<StateDelta::WallBefore> touched_walls;
+	std::vector<std::pair<long long,int>> touched_loot;
+	std::vector<std::pair<long long, std::unordered_map<std::string,int>>> touched_ground;
+	/** Уже тронутое: вид (старшие биты) | индекс клетки, стены, игрока или ключ кучи. */
+	std::unordered_set<uint64_t> seen;
+	UndoMark* outer;
+};
+
+/**
+ * Дописать в st.journal дельту «mark → st»; false — дельта пустая, шаг не записан.
+ * replace_head — команда сохраняется в несколько приёмов (действие, потом ходы бота) и её шаг
+ * уже записан: заменить его. Смена размеров карты обратимой не считается — журнал сбрасывается.
+ */
+bool journal_record(AppState& st, const UndoMark& mark, bool replace_head = false);
+
+/**
+ * Шаги, которыми расходятся две версии одной истории: от общего шага до головы каждого журнала
+ * (откаченные после from и сделанные после него). Дельты этих шагов покрывают все клетки и стены,
+ * где версии могут различаться. false — общего шага среди хранимых нет, сравнивать надо целиком.
+ */
+bool journal_divergence(const UndoJournal& from, const UndoJournal& to, std::vector<const StateDelta*>& steps);
+
+/** Откатить до n последних шагов журнала; вернуть, сколько откатилось. */
+size_t undo_steps(AppState& st, size_t n);
+
+/** Секция UNDO файла состояния: не больше kUndoDepth шагов, от старого к новому. */
+void write_journal(std::ostream& os, const UndoJournal& journal);
+/** Разбор секции после токена UNDO. */
+bool read_journal(std::istream& is, UndoJournal& journal, std::string& err);
@@ -5,18 +5,16 @@
 #include "LocationUtils.hpp"
 #include <algorithm>
 
-void ArsenalLocation::onEnter(Game& game, LabyrinthMap& /*map*/, const std::string& playerName, size_t /*x*/, size_t /*y*/, Outcome& out) {
+void ArsenalLocation::onEnter(Game& game, LabyrinthMap& /*map*/, PlayerId player, size_t /*x*/, size_t /*y*/, Outcome& out) {
 	out.logMessage(Message::ArsenalEnter);
-	auto it = game.inventories.find(playerName);
-	if (it == game.inventories.end()) return;
-	auto& inv = it->second;
+	auto& inv = game.players.edit_inventory(player);
 	for (auto& kv : inv.item_charges) {
 		const std::string& itemId = kv.first;
 		int& charges = kv.second;
 		if (charges <= 0) {
 			charges = 1;
 			if (itemId == "knife") {
-				game.broken_knife.erase(playerName);
+				game.players.set_knife_broken(player, false);
 				out.logMessage(Message::KnifeFixed);
 			} else if (itemId == "rifle") {
 				out.logMessage(Message::RifleFixed);
@@ -25,13 +23,13 @@ void ArsenalLocation::onEnter(Game& game, LabyrinthMap& /*map*/, const std::stri
 			} else if (itemId == "flashlight") {
 				out.logMessage(Message::LanternFixed);
 			} else {
-				out.logMessage(Message::ItemRecharged, {itemId});
+				out.logMessage(Message::ItemRecharged, {messageToken(itemId)});
 			}
 		}
 	}
 }
 
-void ArsenalLocation::onExit(Game& /*game*/, LabyrinthMap& /*map*/, const std::string& /*playerName*/, size_t /*x*/, size_t /*y*/, Outcome& out) {
+void ArsenalLocation::onExit(Game& /*game*/, LabyrinthMap& /*map*/, PlayerId /*player*/, size_t /*x*/, size_t /*y*/, Outcome& out) {
 	out.logMessage(Message::ArsenalExit);
 }
 
@@ -3,9 +3,9 @@
 
 struct ArsenalLocation : public Location {
 	const char* id() const override { return "arsenal"; }
-	void onEnter(Game& game, LabyrinthMap& map, const std::string& playerName, size_t x, size_t y, Outcome& out) override;
+	void onEnter(Game& game, LabyrinthMap& map, PlayerId player, size_t x, size_t y, Outcome& out) override;
 	void onPlaced(Game& game, LabyrinthMap& map) override;
-	void onExit(Game& game, LabyrinthMap& map, const std::string& playerName, size_t x, size_t y, Outcome& out) override;
+	void onExit(Game& game, LabyrinthMap& map, PlayerId player, size_t x, size_t y, Outcome& out) override;
 };
 
 
@@ -2,9 +2,9 @@
 #include "../game.hpp"
 #include "../map.hpp"
 
-void ExitLocation::onEnter(Game& game, LabyrinthMap& map, const std::string& playerName, size_t x, size_t y, Outcome& out) {
+void ExitLocation::onEnter(Game& game, LabyrinthMap& map, PlayerId player, size_t x, size_t y, Outcome& out) {
 	(void)map; (void)x; (void)y;
-	if (player_has_treasure(game, playerName)) {
+	if (player_has_treasure(game, player)) {
 		out.logMessage(Message::ExitLocationWithTreasure);
 		game.finished = true;
 	} else {
@@ -12,7 +12,7 @@ void ExitLocation::onEnter(Game& game, LabyrinthMap& map, const std::string& pla
 	}
 }
 
-void ExitLocation::onExit(Game& /*game*/, LabyrinthMap& /*map*/, const std::string& /*playerName*/, size_t /*x*/, size_t /*y*/, Outcome& /*out*/) {
+void ExitLocation::onExit(Game& /*game*/, LabyrinthMap& /*map*/, PlayerId /*player*/, size_t /*x*/, size_t /*y*/, Outcome& /*out*/) {
 }
 
 void ExitLocation::onPlaced(Game& /*game*/, LabyrinthMap& /*map*/) {
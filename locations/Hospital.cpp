@@ -1,15 +1,16 @@
 #include "Hospital.hpp"
 #include "../game.hpp"
 #include "../map.hpp"
+#include "../metrics.hpp"
 #include "../generator.hpp"
 #include "LocationUtils.hpp"
 #include <algorithm>
 
-void HospitalLocation::onEnter(Game& /*game*/, LabyrinthMap& /*map*/, const std::string& /*playerName*/, size_t /*x*/, size_t /*y*/, Outcome& out) {
+void HospitalLocation::onEnter(Game& /*game*/, LabyrinthMap& /*map*/, PlayerId /*player*/, size_t /*x*/, size_t /*y*/, Outcome& out) {
 	out.logMessage(Message::HospitalEnter);
 }
 
-void HospitalLocation::onExit(Game& /*game*/, LabyrinthMap& /*map*/, const std::string& /*playerName*/, size_t /*x*/, size_t /*y*/, Outcome& out) {
+void HospitalLocation::onExit(Game& /*game*/, LabyrinthMap& /*map*/, PlayerId /*player*/, size_t /*x*/, size_t /*y*/, Outcome& out) {
 	out.logMessage(Message::HospitalExit);
 }
 
@@ -38,14 +39,13 @@ void HospitalLocation::onPlaced(Game& /*game*/, LabyrinthMap& map) {
 	LocationUtils::pick_and_place_location_cluster(map, CellContent::Hospital, patterns, gen, dummy);
 }
 
-bool HospitalLocation::teleportToHospital(Game& game, LabyrinthMap& map, const std::string& victim) {
-	for (size_t y = 0; y < map.height; ++y) {
-		for (size_t x = 0; x < map.width; ++x) {
-			if (map.get_cell(x, y) == CellContent::Hospital) {
-				game.players[victim] = {x, y};
-				return true;
-			}
-		}
-	}
-	return false;
+bool HospitalLocation::teleportToHospital(Game& game, LabyrinthMap& map, PlayerId victim) {
+	// первая клетка больницы по обходу строк — из индекса карты, без скана
+	metrics::add(metrics::Counter::HospitalCellsScanned);
+	size_t x = 0, y = 0;
+	if (!map.first_cell_of(CellContent::Hospital, x, y)) return false;
+	map.vacate(game.players.pos[victim].first, game.players.pos[victim].second);
+	game.players.set_pos(victim, {x, y});
+	map.occupy(x, y);
+	return true;
 }
@@ -1,4 +1,5 @@
 #pragma once
+#include "../players.hpp"
 #include <string>
 
 struct Game;
@@ -10,12 +11,12 @@ struct Location {
 	virtual ~Location() = default;
 	virtual const char* id() const = 0;
 	// Called when a player stands on a cell of this location
-	virtual void onEnter(Game& game, LabyrinthMap& map, const std::string& playerName, size_t x, size_t y, Outcome& out) = 0;
+	virtual void onEnter(Game& game, LabyrinthMap& map, PlayerId player, size_t x, size_t y, Outcome& out) = 0;
 	// Called after location cells are placed on the map (can adjust walls etc.)
 	// Implementations should choose their own shape and placement based on global seed.
 	virtual void onPlaced(Game& game, LabyrinthMap& map) = 0;
 	// Called when a player leaves a cell of this location
-	virtual void onExit(Game& game, LabyrinthMap& map, const std::string& playerName, size_t x, size_t y, Outcome& out) = 0;
+	virtual void onExit(Game& game, LabyrinthMap& map, PlayerId player, size_t x, size_t y, Outcome& out) = 0;
 };
 
 // Registry helpers
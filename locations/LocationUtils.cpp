@@ -1,33 +1,56 @@
 #include "LocationUtils.hpp"
+#include "../flood.hpp"
 #include "../map.hpp"
 #include "../rng.hpp"
-#include <queue>
+#include <algorithm>
 #include <tuple>
 
 namespace LocationUtils {
 
-size_t count_components(const LabyrinthMap& m) {
-	std::vector<std::vector<bool>> vis(m.height, std::vector<bool>(m.width, false));
-	auto enqueue = [&](std::queue<std::pair<size_t,size_t>>& q, size_t x, size_t y) {
-		if (!vis[y][x]) { vis[y][x] = true; q.push({x,y}); }
-	};
-	size_t comps = 0;
+AnchorSpace::AnchorSpace(size_t width, size_t height, const std::vector<Pattern>& patterns) {
+	offset.reserve(patterns.size());
+	cols.reserve(patterns.size());
+	for (const auto& pat : patterns) {
+		int max_dx = 0, max_dy = 0;
+		for (auto [dx,dy] : pat) { if (dx > max_dx) max_dx = dx; if (dy > max_dy) max_dy = dy; }
+		const size_t mx = static_cast<size_t>(max_dx), my = static_cast<size_t>(max_dy);
+		const size_t c = mx < width ? width - mx : 0;
+		const size_t r = my < height ? height - my : 0;
+		offset.push_back(total);
+		cols.push_back(c);
+		total += c * r;
+	}
+}
+
+void AnchorSpace::decode(size_t k, size_t& pattern, size_t& sx, size_t& sy) const {
+	pattern = static_cast<size_t>(std::upper_bound(offset.begin(), offset.end(), k) - offset.begin()) - 1;
+	// шаблоны без анкоров дают пустые диапазоны с тем же offset — берём последний из них
+	const size_t local = k - offset[pattern];
+	sy = local / cols[pattern];
+	sx = local % cols[pattern];
+}
+
+std::vector<uint32_t> AnchorSpace::shuffled(std::mt19937& gen) const {
+	std::vector<uint32_t> order(total);
+	for (size_t i = 0; i < total; ++i) order[i] = static_cast<uint32_t>(i);
+	game_rng::shuffle_portable(order.begin(), order.end(), gen);
+	return order;
+}
+
+OccupancySat::OccupancySat(const LabyrinthMap& m) : width(m.width), sum((m.width + 1) * (m.height + 1), 0) {
+	const size_t W = width + 1;
 	for (size_t y = 0; y < m.height; ++y) {
+		uint32_t row = 0;
 		for (size_t x = 0; x < m.width; ++x) {
-			if (vis[y][x]) continue;
-			comps++;
-			std::queue<std::pair<size_t,size_t>> q;
-			enqueue(q, x, y);
-			while (!q.empty()) {
-				auto [cx, cy] = q.front(); q.pop();
-				if (m.can_move_left(cx, cy)) enqueue(q, cx - 1, cy);
-				if (m.can_move_right(cx, cy)) enqueue(q, cx + 1, cy);
-				if (m.can_move_up(cx, cy)) enqueue(q, cx, cy - 1);
-				if (m.can_move_down(cx, cy)) enqueue(q, cx, cy + 1);
-			}
+			row += m.get_cell(x, y) != CellContent::Empty ? 1u : 0u;
+			sum[(y + 1) * W + (x + 1)] = sum[y * W + (x + 1)] + row;
 		}
 	}
-	return comps;
+}
+
+size_t OccupancySat::count(size_t x, size_t y, size_t w, size_t h) const {
+	const size_t W = width + 1;
+	return sum[(y + h) * W + (x + w)] - sum[y * W + (x + w)] - sum[(y + h) * W + x] + sum[y * W + x];
 }
 
 static bool keyIn(const std::vector<std::pair<size_t,size_t>>& cells, size_t x, size_t y) {
@@ -38,7 +61,7 @@ static bool keyIn(const std::vector<std::pair<size_t,size_t>>& cells, size_t x,
 bool pick_and_place_location_cluster(
 	LabyrinthMap& map,
 	CellContent type,
-	const std::vector<std::vector<std::pair<int,int>>>& patterns,
+	const std::vector<Pattern>& patterns,
 	std::mt19937& gen,
 	std::vector<std::pair<size_t,size_t>>& out_cells
 ) {
@@ -46,48 +69,48 @@ bool pick_and_place_location_cluster(
 	std::vector<size_t> idx(patterns.size());
 	for (size_t i=0;i<idx.size();++i) idx[i]=i;
 	game_rng::shuffle_portable(idx.begin(), idx.end(), gen);
+	const OccupancySat occupied(map);
 	for (size_t pi : idx) {
 		const auto& pat = patterns[pi];
+		const AnchorSpace space(map.width, map.height, {pat});
 		int max_dx = 0, max_dy = 0;
 		for (auto [dx,dy] : pat) { if (dx > max_dx) max_dx = dx; if (dy > max_dy) max_dy = dy; }
-		std::vector<std::pair<size_t,size_t>> anchors;
-		for (size_t sy = 0; sy + static_cast<size_t>(max_dy) < map.height; ++sy) {
-			for (size_t sx = 0; sx + static_cast<size_t>(max_dx) < map.width; ++sx) {
-				anchors.emplace_back(sx, sy);
+		for (uint32_t k : space.shuffled(gen)) {
+			size_t unused, sx, sy;
+			space.decode(k, unused, sx, sy);
+			// do not overwrite existing special cells (require empties): пустая рамка — сразу да,
+			// иначе проверяем только клетки шаблона (у креста углы рамки не входят в шаблон)
+			if (occupied.count(sx, sy, static_cast<size_t>(max_dx) + 1, static_cast<size_t>(max_dy) + 1) != 0) {
+				bool all_empty = true;
+				for (auto [dx,dy] : pat) {
+					if (map.get_cell(sx + static_cast<size_t>(dx), sy + static_cast<size_t>(dy)) != CellContent::Empty) { all_empty = false; break; }
+				}
+				if (!all_empty) continue;
 			}
-		}
-		game_rng::shuffle_portable(anchors.begin(), anchors.end(), gen);
-		for (auto [sx,sy] : anchors) {
 			LabyrinthMap test = map;
 			std::vector<std::pair<size_t,size_t>> cells;
 			cells.reserve(pat.size());
 			for (auto [dx,dy] : pat) cells.emplace_back(static_cast<size_t>(sx+dx), static_cast<size_t>(sy+dy));
-			// do not overwrite existing special cells (require empties)
-			bool all_empty = true;
-			for (auto [x,y] : cells) {
-				if (test.get_cell(x, y) != CellContent::Empty) { all_empty = false; break; }
-			}
-			if (!all_empty) continue;
 			for (auto [x,y] : cells) test.set_cell(x, y, type);
 			// Remove internal walls, close cluster perimeter
 			std::vector<std::tuple<bool,size_t,size_t>> perimeter;
 			for (auto [x,y] : cells) {
 				// internal links
-				if (x + 1 < test.width && keyIn(cells,x+1,y)) test.v_walls[y][x+1] = false;
-				if (y + 1 < test.height && keyIn(cells,x,y+1)) test.h_walls[y+1][x] = false;
+				if (x + 1 < test.width && keyIn(cells,x+1,y)) test.set_vwall(y, x+1, false);
+				if (y + 1 < test.height && keyIn(cells,x,y+1)) test.set_hwall(y+1, x, false);
 				// perimeter closing and candidates
-				if (x==0 || !keyIn(cells,x-1,y)) { test.v_walls[y][x]=true; if (x>0) perimeter.emplace_back(true,y,x); }
-				if (x+1==test.width || !keyIn(cells,x+1,y)) { test.v_walls[y][x+1]=true; if (x+1<test.width) perimeter.emplace_back(true,y,x+1); }
-				if (y==0 || !keyIn(cells,x,y-1)) { test.h_walls[y][x]=true; if (y>0) perimeter.emplace_back(false,y,x); }
-				if (y+1==test.height || !keyIn(cells,x,y+1)) { test.h_walls[y+1][x]=true; if (y+1<test.height) perimeter.emplace_back(false,y+1,x); }
+				if (x==0 || !keyIn(cells,x-1,y)) { test.set_vwall(y, x, true); if (x>0) perimeter.emplace_back(true,y,x); }
+				if (x+1==test.width || !keyIn(cells,x+1,y)) { test.set_vwall(y, x+1, true); if (x+1<test.width) perimeter.emplace_back(true,y,x+1); }
+				if (y==0 || !keyIn(cells,x,y-1)) { test.set_hwall(y, x, true); if (y>0) perimeter.emplace_back(false,y,x); }
+				if (y+1==test.height || !keyIn(cells,x,y+1)) { test.set_hwall(y+1, x, true); if (y+1<test.height) perimeter.emplace_back(false,y+1,x); }
 			}
 			if (perimeter.empty()) continue;
 			game_rng::shuffle_portable(perimeter.begin(), perimeter.end(), gen);
 			for (auto e : perimeter) {
 				LabyrinthMap test2 = test;
-				if (std::get<0>(e)) test2.v_walls[std::get<1>(e)][std::get<2>(e)] = false;
-				else test2.h_walls[std::get<1>(e)][std::get<2>(e)] = false;
-				if (count_components(test2) == 1) {
+				if (std::get<0>(e)) test2.set_vwall(std::get<1>(e), std::get<2>(e), false);
+				else test2.set_hwall(std::get<1>(e), std::get<2>(e), false);
+				if (flood::count_components(test2) == 1) {
 					map = std::move(test2);
 					out_cells = std::move(cells);
 					return true;
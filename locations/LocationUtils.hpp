@@ -1,4 +1,5 @@
 #pragma once
+#include <cstdint>
 #include <vector>
 #include <utility>
 #include <random>
@@ -8,8 +9,33 @@ enum class CellContent;
 
 namespace LocationUtils {
 
-// Count connected components in the current passability graph (using walls)
-size_t count_components(const LabyrinthMap& m);
+using Pattern = std::vector<std::pair<int,int>>;
+
+/**
+ * Пространство анкоров шаблонов без материализации списка: кандидат k ↔ (шаблон, sx, sy)
+ * в порядке шаблон → sy → sx. Перемешивается только вектор индексов (тот же расход RNG,
+ * что у перемешивания списка кортежей), кандидат декодируется по мере перебора.
+ */
+struct AnchorSpace {
+	std::vector<size_t> offset; // первый индекс шаблона
+	std::vector<size_t> cols;   // число допустимых sx для шаблона
+	size_t total{0};
+
+	AnchorSpace(size_t width, size_t height, const std::vector<Pattern>& patterns);
+	void decode(size_t k, size_t& pattern, size_t& sx, size_t& sy) const;
+	/** Перемешанный порядок кандидатов (shuffle_portable по индексам). */
+	std::vector<uint32_t> shuffled(std::mt19937& gen) const;
+};
+
+/** Суммы по префиксам занятых (не Empty) клеток: пустота прямоугольника за O(1). */
+struct OccupancySat {
+	size_t width{0};
+	std::vector<uint32_t> sum; // [(y+1)*(width+1) + (x+1)]
+
+	explicit OccupancySat(const LabyrinthMap& m);
+	/** Число занятых клеток в [x, x+w) × [y, y+h). */
+	size_t count(size_t x, size_t y, size_t w, size_t h) const;
+};
 
 // Try to place a cluster of cells of given type using provided patterns.
 // Chooses anchor and opens exactly one entrance so that the maze remains a single component.
@@ -17,7 +43,7 @@ size_t count_components(const LabyrinthMap& m);
 bool pick_and_place_location_cluster(
 	LabyrinthMap& map,
 	CellContent type,
-	const std::vector<std::vector<std::pair<int,int>>>& patterns,
+	const std::vector<Pattern>& patterns,
 	std::mt19937& gen,
 	std::vector<std::pair<size_t,size_t>>& out_cells
 );
@@ -2,10 +2,10 @@
 #include "../game.hpp"
 #include "../map.hpp"
 
-void TreasureLocation::onEnter(Game& game, LabyrinthMap& map, const std::string& playerName, size_t x, size_t y, Outcome& out) {
+void TreasureLocation::onEnter(Game& game, LabyrinthMap& map, PlayerId player, size_t x, size_t y, Outcome& out) {
 	if (map.get_cell(x, y) == CellContent::Treasure) {
 		out.logMessage(Message::TreasureSpotFound);
-		auto& inventory = game.inventories[playerName];
+		auto& inventory = game.players.edit_inventory(player);
 		int currentCharges = inventory.getCharges("treasure");
 		if (currentCharges <= 0) {
 			inventory.setCharges("treasure", 1);
@@ -16,7 +16,7 @@ void TreasureLocation::onEnter(Game& game, LabyrinthMap& map, const std::string&
 	}
 }
 
-void TreasureLocation::onExit(Game& /*game*/, LabyrinthMap& /*map*/, const std::string& /*playerName*/, size_t /*x*/, size_t /*y*/, Outcome& /*out*/) {
+void TreasureLocation::onExit(Game& /*game*/, LabyrinthMap& /*map*/, PlayerId /*player*/, size_t /*x*/, size_t /*y*/, Outcome& /*out*/) {
 }
 
 void TreasureLocation::onPlaced(Game& /*game*/, LabyrinthMap& /*map*/) {
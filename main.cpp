@@ -1,7 +1,11 @@
-#include "generator.hpp"
+#include "alloc.hpp"
+#include "engine.hpp"
+#include "mapstats.hpp"
 #include "message.hpp"
-#include "rng.hpp"
+#include "metrics.hpp"
+#include "snapshot.hpp"
 #include "state.hpp"
+#include "trace.hpp"
 #include "viz.hpp"
 #include "items/Knife.hpp"
 #include "items/Shotgun.hpp"
@@ -11,26 +15,17 @@
 #include "items/LootTreasure.hpp"
 #include <iostream>
 #include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
 #include <filesystem>
 #include <fstream>
 #include <random>
 #include <sstream>
 #include <memory>
+#include <thread>
 #include <vector>
 
-static std::unique_ptr<Item> makeItem(const std::string& id) {
-	if (id == "knife") return std::make_unique<Knife>();
-	if (id == "shotgun") return std::make_unique<Shotgun>();
-	if (id == "rifle") return std::make_unique<Rifle>();
-	if (id == "flashlight") return std::make_unique<Flashlight>();
-	if (id == "armor") return std::make_unique<Armor>();
-	if (id == "treasure") return std::make_unique<LootTreasure>();
-	return nullptr;
-}
-
-/** Реестр id предметов — один источник для CLI, list-items и внешних инструментов. */
-static const char* ITEM_REGISTRY_IDS[] = {"knife", "shotgun", "rifle", "flashlight", "armor", "treasure"};
-static const size_t ITEM_REGISTRY_COUNT = sizeof(ITEM_REGISTRY_IDS) / sizeof(ITEM_REGISTRY_IDS[0]);
 /** Порядок размещения add-item-random при создании комнаты (как цикл на сервере). */
 static const char* ITEM_PLACE_ORDER[] = {"shotgun", "rifle", "flashlight", "armor", "knife"};
 static const size_t ITEM_PLACE_ORDER_COUNT = sizeof(ITEM_PLACE_ORDER) / sizeof(ITEM_PLACE_ORDER[0]);
@@ -38,23 +33,6 @@ static const size_t ITEM_PLACE_ORDER_COUNT = sizeof(ITEM_PLACE_ORDER) / sizeof(I
 static const char* ITEM_LOBBY_WEAPONS[] = {"shotgun", "rifle", "flashlight", "armor"};
 static const size_t ITEM_LOBBY_WEAPONS_COUNT = sizeof(ITEM_LOBBY_WEAPONS) / sizeof(ITEM_LOBBY_WEAPONS[0]);
 
-static bool item_id_is_valid(const std::string& id) {
-	for (size_t i = 0; i < ITEM_REGISTRY_COUNT; ++i)
-		if (id == ITEM_REGISTRY_IDS[i]) return true;
-	return false;
-}
-
-static std::string jsonEscape(const std::string& s) {
-	std::string out;
-	for (char c : s) {
-		if (c == '"') out += "\\\"";
-		else if (c == '\\') out += "\\\\";
-		else if (c == '\n') out += "\\n";
-		else out += c;
-	}
-	return out;
-}
-
 static void emit_list_items_json() {
 	std::ostringstream js;
 	js << "{\"ids\":[";
@@ -76,11 +54,11 @@ static void emit_list_items_json() {
 	bool first = true;
 	for (size_t i = 0; i < ITEM_REGISTRY_COUNT; ++i) {
 		const char* iid = ITEM_REGISTRY_IDS[i];
-		auto it = makeItem(iid);
+		auto it = make_item(iid);
 		if (!it) continue;
 		if (!first) js << ",";
 		first = false;
-		js << "\"" << iid << "\":\"" << jsonEscape(std::string(it->displayName())) << "\"";
+		js << "\"" << iid << "\":\"" << json_escape(std::string(it->displayName())) << "\"";
 	}
 	js << "}}\n";
 	std::cout << js.str();
@@ -115,7 +93,8 @@ static void applyLogEntry(const LogEntry& e, AppState& cur) {
 			else if (e.item == "flashlight") itm = std::make_unique<Flashlight>();
 			if (itm) {
 				Outcome scratch;
-				itm->apply(cur.game, cur.map, e.name, e.dir, scratch);
+				const PlayerId id = cur.game.players.find(e.name);
+				if (id != kNoPlayer) itm->apply(cur.game, cur.map, id, e.dir, scratch);
 			}
 			break;
 		}
@@ -124,7 +103,7 @@ static void applyLogEntry(const LogEntry& e, AppState& cur) {
 			cur.game.bot_y = e.y;
 			break;
 		case LogType::BotKill:
-			cur.game.apply_replay_bot_kill(e.name, cur.map);
+			cur.game.apply_replay_bot_kill(cur.game.players.find(e.name), cur.map);
 			break;
 	}
 	cur.game.enforce_turns = wasEnforced;
@@ -152,57 +131,26 @@ static std::string logEntryDescription(const LogEntry& e) {
 	return "";
 }
 
-// Вывод wire как есть (локализация только в messageParse.js).
-static void print_user_messages(const std::string& player, const Outcome& o) {
+/** Служебные строки (очередь, инвентарь) в том же формате блока, что и сообщения игроку. */
+static void print_user_lines(const std::string& player, const std::vector<std::string>& lines) {
 	std::cout << "[" << player << "]:" << "\n";
-	for (const auto& m : o.messages) {
-		std::cout << "\t" << m << "\n";
+	for (const auto& l : lines) {
+		std::cout << "\t" << l << "\n";
 	}
 }
 
-// Run all consecutive bot turns (same loop as after move/attack/use-item).
-// Needed when the web server has no player action to trigger the CLI (e.g. state file already says "bot" turn).
-// Hard cap: if every human is in hospital, advance_turn can pick "bot" again forever — avoid hanging the process.
-static void run_pending_bot_turns(AppState& st) {
-	const int kMaxBotSteps = 512;
-	for (int step = 0; step < kMaxBotSteps; ++step) {
-		if (!st.game.enforce_turns || !st.game.bot_enabled || st.game.turn_order.empty()) break;
-		if (st.game.turn_index >= st.game.turn_order.size()) break;
-		if (st.game.turn_order[st.game.turn_index] != "bot") break;
-		Outcome botBlog;
-		std::vector<BotReplayStep> bot_replay;
-		st.game.run_bot_turn(st.map, botBlog, &bot_replay);
-		for (const auto& s : bot_replay) {
-			if (s.kind == BotReplayStep::Kind::Move)
-				st.log.push_back(LogEntry{LogType::BotMove, "", Direction::Up, s.x, s.y, {}});
-			else
-				st.log.push_back(LogEntry{LogType::BotKill, s.victim, Direction::Up, 0, 0, {}});
-		}
-		for (const auto& line : botBlog.messages) {
-			if (line.rfind("PLAYER:", 0) == 0) {
-				size_t p = line.find(':', 7);
-				if (p != std::string::npos) {
-					std::string pname = line.substr(7, p - 7);
-					std::string pmsg = line.substr(p + 1);
-					Outcome victimOut;
-					victimOut.messages.push_back(pmsg);
-					print_user_messages(pname, victimOut);
-				}
-			}
-		}
-		// В фиде одна строка на ход бота (без пошаговых координат)
-		for (const auto& line : botBlog.messages) {
-			if (line == messageWire(Message::BotMoved)) {
-				std::cout << line << "\n";
-				break;
-			}
-		}
-	}
-	if (st.game.enforce_turns && st.game.bot_enabled && !st.game.turn_order.empty()
-	    && st.game.turn_index < st.game.turn_order.size()
-	    && st.game.turn_order[st.game.turn_index] == "bot") {
-		log_err("run_pending_bot_turns: iteration cap reached (stuck on bot turn; check hospital/turn logic)");
-	}
+/** move / attack / use-item: действие через engine, затем stderr-строка, блок игрока и фид бота. */
+static int run_player_action(const std::string& state, ActionKind kind, const std::string& name, Direction dir,
+                             const std::string& item) {
+	AppState st; std::string err;
+	if (!AppState::load(st, state, err)) { std::cerr << err << "\n"; return 2; }
+	ActionResult res;
+	if (!apply_player_action(st, state, kind, name, dir, item, res, err)) { std::cerr << err << "\n"; return 2; }
+	log_err(res.detail);
+	write_user_messages(std::cout, name, res.outcome, st.game.players.name);
+	write_bot_feed(std::cout, res.bot_feed, st.game.players.name);
+	if (res.bot_cap_reached) log_err(kBotCapMessage);
+	return 0;
 }
 
 static void usage() {
@@ -211,10 +159,14 @@ R"(labyrinth_cpp commands:
   generate --width W --height H --out state.txt [--openness 0..1] [--seed N]
             [--turns 0|1]
             [--turn-actions N]
-            [--bot-steps N]
-  show --state state.txt [--reveal]
+            [--bot-steps N [--bot-search DEPTH] [--bot-budget-us N(2000)]]
+            [--constraints "treasure_exit>=6,dead_ends<=0.3,…" [--max-seeds N] [--threads N]]
+  map-stats --state state.txt
+  show --state state.txt [--reveal] [--viewport X,Y,W,H]
   status --state state.txt
-  player-status --state state.txt --name NAME
+  turn-info --state state.txt [--snapshot]   (очередь и ростер из сайдкара state.txt.turn, JSON)
+  player-status --state state.txt --name NAME [--snapshot]
+            (--snapshot — только из снимка state.txt.shm, без чтения состояния; нет снимка или он устарел — код 4)
   add-player --state state.txt --name NAME --x X --y Y
   add-player-random --state state.txt --name NAME
   move --state state.txt --name NAME (up|down|left|right)
@@ -229,8 +181,13 @@ R"(labyrinth_cpp commands:
   add-item-random --state state.txt --item (knife|shotgun|rifle|flashlight|armor|treasure) [--charges N]
   give-item --state state.txt --name NAME --item (knife|shotgun|rifle|flashlight|armor|treasure) [--charges N]
   save-as --state state.txt --out other.txt
-  export-svg --state state.txt --out maze.svg [--cell N] [--margin PX]
-  export-html --state state.txt --out maze.html [--cell N] [--margin PX]
+  undo --state state.txt [--steps N]   (откат последних N команд по журналу, без replay)
+  fork --state state.txt --out branch.txt [--steps N]   (ветка «что если»: состояние N команд назад)
+  export-svg --state state.txt --out maze.svg [--cell N] [--margin PX] [--no-labels]
+            [--viewport X,Y,W,H] [--lod auto|0|1|2] [--tile Z/X/Y [--tile-px N]]
+  export-html --state state.txt --out maze.html [--cell N] [--margin PX] [--no-labels]
+            [--viewport X,Y,W,H] [--lod auto|0|1|2] [--tile Z/X/Y [--tile-px N]]
+  svg-patch --state state.txt --prev prev.txt [--out patch.json] [опции вида как у export-svg]
   replay-export --base base.txt --log state_with_log.txt --out-dir frames --cell N --margin PX
   replay-list --state state.txt
   replay-svg --state state.txt --step N
@@ -239,15 +196,13 @@ R"(labyrinth_cpp commands:
   resolve-bots --state state.txt
   replay-export-one --state state.txt --out-dir frames --cell N --margin PX
   list-items   (JSON: реестр id предметов, порядок размещения, имя для UI)
-)";
-}
+  metrics --in metrics.jsonl   (JSON: сводка строк --metrics-out по командам и файлам состояния)
 
-// Deterministic PRNG based on state RNG seed and nonce
-static size_t rng_pick(AppState& st, size_t maxExclusive) {
-	uint64_t key = (static_cast<uint64_t>(st.random_seed) << 32) ^ st.random_nonce;
-	uint64_t r = game_rng::splitmix64(key);
-	st.random_nonce += 1;
-	return static_cast<size_t>(r % static_cast<uint64_t>(maxExclusive));
+Общие опции: --trace FILE (или LABYRINTH_TRACE=FILE) — спаны фаз команды в Chrome trace JSON, дописываются в FILE;
+  --metrics-out FILE (или LABYRINTH_METRICS=FILE) — строка JSON со временем и счётчиками команды, дописывается в FILE;
+  --alloc-report, --alloc-budget N (или LABYRINTH_ALLOC_BUDGET=N) — в сборке с LABYRINTH_ALLOC_ACCOUNTING:
+  отчёт аллокаций по областям в stderr; код выхода 3, если команда сделала больше N аллокаций.
+)";
 }
 
 static bool get_flag(int argc, char** argv, const std::string& key) {
@@ -260,10 +215,92 @@ static bool get_arg(int argc, char** argv, const std::string& key, std::string&
 	}
 	return false;
 }
+/**
+ * Общая опция "key VALUE" (или переменная окружения env) вырезается из argv до разбора команды:
+ * направление и значения команды читаются с конца argv.
+ */
+static bool take_global_flag(int& argc, char** argv, const char* key) {
+	for (int i = 1; i < argc; ++i) {
+		if (std::string(argv[i]) != key) continue;
+		for (int j = i; j + 1 < argc; ++j) argv[j] = argv[j + 1];
+		argc -= 1;
+		return true;
+	}
+	return false;
+}
+static std::string take_global_arg(int& argc, char** argv, const char* key, const char* env) {
+	for (int i = 1; i + 1 < argc; ++i) {
+		if (std::string(argv[i]) != key) continue;
+		std::string value = argv[i + 1];
+		for (int j = i; j + 2 < argc; ++j) argv[j] = argv[j + 2];
+		argc -= 2;
+		return value;
+	}
+	const char* v = std::getenv(env);
+	return v ? std::string(v) : std::string();
+}
 
-int main(int argc, char** argv) {
-	if (argc < 2) { usage(); return 1; }
+/** "X,Y,W,H" в клетках → окно, обрезанное по карте; false — неверный формат или окно целиком вне карты. */
+static bool parse_viewport(const std::string& s, const LabyrinthMap& map, MapRect& out, std::string& err) {
+	MapRect r; char tail = 0;
+	if (std::sscanf(s.c_str(), "%zu,%zu,%zu,%zu%c", &r.x, &r.y, &r.w, &r.h, &tail) != 4) {
+		err = "--viewport ожидает X,Y,W,H"; return false;
+	}
+	out = map.clip_rect(r);
+	if (out.empty()) { err = "--viewport вне карты"; return false; }
+	return true;
+}
+
+/**
+ * Опции вида для export-svg/export-html: --no-labels, --lod auto|0|1|2, --viewport X,Y,W,H
+ * и --tile Z/X/Y [--tile-px N]. Тайл z/x/y — квадрат ceil(max(w,h)/2^z) клеток, вписанный в tile-px
+ * (256 по умолчанию), без полей и панели; детализация по умолчанию для тайла — auto.
+ */
+static bool parse_svg_view(int argc, char** argv, const LabyrinthMap& map, float& cell, float& margin, SvgOptions& opt, std::string& err) {
+	opt.coord_labels = !get_flag(argc, argv, std::string("--no-labels"));
+	std::string sv, stile, slod;
+	if (get_arg(argc, argv, std::string("--viewport"), sv)) {
+		if (!parse_viewport(sv, map, opt.view, err)) return false;
+		opt.has_view = true;
+	}
+	if (get_arg(argc, argv, std::string("--tile"), stile)) {
+		unsigned z = 0; MapRect r; char tail = 0;
+		if (std::sscanf(stile.c_str(), "%u/%zu/%zu%c", &z, &r.x, &r.y, &tail) != 3 || z > 20) {
+			err = "--tile ожидает Z/X/Y"; return false;
+		}
+		std::string spx;
+		float tile_px = 256.0f;
+		if (get_arg(argc, argv, std::string("--tile-px"), spx)) tile_px = std::stof(spx);
+		size_t side = std::max(map.width, map.height);
+		size_t span = std::max<size_t>(1, (side + ((size_t)1 << z) - 1) >> z);
+		r.x *= span; r.y *= span; r.w = span; r.h = span;
+		opt.view = map.clip_rect(r);
+		if (opt.view.empty()) { err = "--tile вне карты"; return false; }
+		opt.has_view = true;
+		opt.panel = false;
+		opt.lod = SvgLod::Auto;
+		cell = tile_px / static_cast<float>(span);
+		margin = 0.0f;
+	}
+	if (get_arg(argc, argv, std::string("--lod"), slod)) {
+		if (slod == "auto") opt.lod = SvgLod::Auto;
+		else if (slod == "0") opt.lod = SvgLod::Full;
+		else if (slod == "1") opt.lod = SvgLod::Lite;
+		else if (slod == "2") opt.lod = SvgLod::Coarse;
+		else { err = "--lod ожидает auto|0|1|2"; return false; }
+	}
+	return true;
+}
+
+static int run_command(int argc, char** argv) {
 	std::string cmd = argv[1];
+	if (cmd == "metrics") {
+		std::string in, js, err;
+		if (!get_arg(argc, argv, std::string("--in"), in)) { usage(); return 1; }
+		if (!metrics::aggregate_json(in, js, err)) { std::cerr << err << "\n"; return 2; }
+		std::cout << js;
+		return 0;
+	}
 	if (cmd == "list-items") {
 		emit_list_items_json();
 		return 0;
@@ -275,60 +312,51 @@ int main(int argc, char** argv) {
 		    !get_arg(argc, argv, std::string("--out"), out)) {
 			usage(); return 1;
 		}
-		size_t w = static_cast<size_t>(std::stoul(sw));
-		size_t h = static_cast<size_t>(std::stoul(sh));
-		float openness = 0.0f;
-		if (get_arg(argc, argv, std::string("--openness"), so)) {
-			openness = std::stof(so);
-			if (openness < 0.0f) openness = 0.0f;
-			if (openness > 1.0f) openness = 1.0f;
-		}
-		unsigned int seed = std::random_device{}();
+		GenerateOptions opt;
+		opt.width = static_cast<size_t>(std::stoul(sw));
+		opt.height = static_cast<size_t>(std::stoul(sh));
+		if (get_arg(argc, argv, std::string("--openness"), so)) opt.openness = std::stof(so);
+		opt.seed = std::random_device{}();
 		if (get_arg(argc, argv, std::string("--seed"), sseed)) {
-			seed = static_cast<unsigned int>(std::stoul(sseed));
+			opt.seed = static_cast<unsigned int>(std::stoul(sseed));
 		}
-		set_rng_seed(seed);
-		AppState st;
-		st.random_seed = seed;
-		st.random_nonce = 0;
-		st.game.turn_rng_state = game_rng::initial_turn_rng_state(seed);
 		// turns enabled by default
-		st.game.enforce_turns = true;
-		if (get_arg(argc, argv, std::string("--turns"), sturns)) {
-			int tv = std::stoi(sturns);
-			st.game.enforce_turns = (tv != 0);
-		}
-		st.game.actions_per_turn = 1;
-		if (get_arg(argc, argv, std::string("--turn-actions"), sactions)) {
-			int av = std::stoi(sactions);
-			if (av < 1) av = 1;
-			st.game.actions_per_turn = av;
-		}
-		st.game.actions_left = st.game.actions_per_turn;
-		st.map = generate_maze_with_items(w, h, openness);
-		// Bot enable and initial placement
-		st.game.bot_enabled = false;
-		if (get_arg(argc, argv, std::string("--bot-steps"), sbot)) {
-			int bs = std::stoi(sbot);
-			if (bs > 0) {
-				st.game.bot_enabled = true;
-				st.game.bot_steps_per_turn = bs;
-				// place bot to random empty cell
-				std::vector<std::pair<size_t,size_t>> spots;
-				for (size_t y = 0; y < st.map.height; ++y)
-					for (size_t x = 0; x < st.map.width; ++x)
-						if (st.map.get_cell(x,y) == CellContent::Empty) spots.emplace_back(x,y);
-				if (!spots.empty()) {
-					auto pos = spots[rng_pick(st, spots.size())];
-					st.game.bot_x = pos.first; st.game.bot_y = pos.second;
-				} else {
-					st.game.bot_x = 0; st.game.bot_y = 0;
-				}
+		if (get_arg(argc, argv, std::string("--turns"), sturns)) opt.turns = std::stoi(sturns) != 0;
+		if (get_arg(argc, argv, std::string("--turn-actions"), sactions)) opt.turn_actions = std::stoi(sactions);
+		if (get_arg(argc, argv, std::string("--bot-steps"), sbot)) opt.bot_steps = std::stoi(sbot);
+		if (get_arg(argc, argv, std::string("--bot-search"), sbot)) opt.bot_search_depth = std::stoi(sbot);
+		if (get_arg(argc, argv, std::string("--bot-budget-us"), sbot))
+			opt.bot_budget_us = static_cast<unsigned>(std::max(1, std::stoi(sbot)));
+		std::string scons, stries, sthreads, err;
+		size_t checked = 0;
+		LabyrinthMap found;
+		if (get_arg(argc, argv, std::string("--constraints"), scons)) {
+			// перебор сидов opt.seed, opt.seed+1, … до первой карты, проходящей условия
+			std::vector<MapConstraint> cs;
+			if (!parse_map_constraints(scons, cs, err)) { std::cerr << err << "\n"; usage(); return 1; }
+			size_t tries = 256;
+			unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+			if (get_arg(argc, argv, std::string("--max-seeds"), stries)) tries = std::max<size_t>(1, std::stoul(stries));
+			if (get_arg(argc, argv, std::string("--threads"), sthreads)) threads = static_cast<unsigned>(std::max(1, std::stoi(sthreads)));
+			const float openness = std::min(1.0f, std::max(0.0f, opt.openness));
+			if (!search_map_seed(opt.width, opt.height, openness, opt.seed, tries, cs, threads, opt.seed, found, checked)) {
+				std::cerr << "Ни одна из " << tries << " карт не прошла условия\n";
+				return 3;
 			}
 		}
-		std::string err;
+		AppState st;
+		generate_state(st, opt, checked ? &found : nullptr);
 		if (!AppState::save(st, out, err)) { std::cerr << err << "\n"; return 2; }
 		std::cout << "Создано: " << out << "\n";
+		if (checked) std::cout << "Сид: " << opt.seed << " (проверено карт: " << checked << ")\n";
+		return 0;
+	}
+	if (cmd == "map-stats") {
+		std::string state;
+		if (!get_arg(argc, argv, std::string("--state"), state)) { usage(); return 1; }
+		AppState st; std::string err;
+		if (!AppState::load(st, state, err, LoadMap)) { std::cerr << err << "\n"; return 2; }
+		std::cout << map_stats_json(compute_map_stats(st.map)) << "\n";
 		return 0;
 	}
 	if (cmd == "show") {
@@ -336,15 +364,21 @@ int main(int argc, char** argv) {
 		if (!get_arg(argc, argv, std::string("--state"), state)) { usage(); return 1; }
 		bool reveal = get_flag(argc, argv, std::string("--reveal"));
 		AppState st; std::string err;
-		if (!AppState::load(st, state, err)) { std::cerr << err << "\n"; return 2; }
-		std::cout << st.map.render_ascii(&st.game.players, reveal, &st.game.loot_treasure) << std::flush;
+		if (!AppState::load(st, state, err, LoadMap | LoadGame)) { std::cerr << err << "\n"; return 2; }
+		std::string sv;
+		MapRect view = st.map.full_rect();
+		if (get_arg(argc, argv, std::string("--viewport"), sv) && !parse_viewport(sv, st.map, view, err)) {
+			std::cerr << err << "\n"; return 1;
+		}
+		st.map.write_ascii(std::cout, &st.game.players, reveal, &st.game.loot_treasure, &view);
+		std::cout << std::flush;
 		return 0;
 	}
 	if (cmd == "status") {
 		std::string state;
 		if (!get_arg(argc, argv, std::string("--state"), state)) { usage(); return 1; }
 		AppState st; std::string err;
-		if (!AppState::load(st, state, err)) { std::cerr << err << "\n"; return 2; }
+		if (!AppState::load(st, state, err, LoadGame)) { std::cerr << err << "\n"; return 2; }
 		// determine next actor
 		std::string nextActor = "-";
 		if (st.game.enforce_turns && !st.game.turn_order.empty()) {
@@ -352,151 +386,98 @@ int main(int argc, char** argv) {
 			// find first present from idx forward circularly
 			for (size_t k = 0; k < st.game.turn_order.size(); ++k) {
 				const std::string& cand = st.game.turn_order[(idx + k) % st.game.turn_order.size()];
-				if (st.game.players.count(cand)) { nextActor = cand; break; }
+				if (st.game.players.contains(cand)) { nextActor = cand; break; }
 			}
 		}
 		// print global turn info
-		Outcome turnOut;
-		turnOut.messages.push_back(std::string("Next: ") + nextActor);
-		print_user_messages("TURN", turnOut);
+		print_user_lines("TURN", {std::string("Next: ") + nextActor});
 		// build player listing order
 		std::vector<std::string> names;
 		if (st.game.enforce_turns && !st.game.turn_order.empty()) {
-			for (const auto& n : st.game.turn_order) if (st.game.players.count(n)) names.push_back(n);
-			for (const auto& kv : st.game.players) {
-				if (std::find(names.begin(), names.end(), kv.first) == names.end()) names.push_back(kv.first);
+			for (const auto& n : st.game.turn_order) if (st.game.players.contains(n)) names.push_back(n);
+			for (const auto& n : st.game.players.name) {
+				if (std::find(names.begin(), names.end(), n) == names.end()) names.push_back(n);
 			}
 		} else {
-			for (const auto& kv : st.game.players) names.push_back(kv.first);
+			names = st.game.players.name;
 			std::sort(names.begin(), names.end());
 		}
 		// per-player inventories
 		for (const auto& name : names) {
 			std::vector<std::string> lines;
-			auto itInv = st.game.inventories.find(name);
-			if (itInv == st.game.inventories.end() || itInv->second.item_charges.empty()) {
+			const PlayerId id = st.game.players.find(name);
+			const Inventory& inv = st.game.players.inventory[id];
+			if (inv.item_charges.empty()) {
 				lines.push_back("Inventory: (empty)");
 			} else {
 				// stable item order
 				static const char* order[] = {"knife","rifle","shotgun","flashlight","armor"};
 				for (const char* iid : order) {
-					auto it = itInv->second.item_charges.find(iid);
-					if (it == itInv->second.item_charges.end()) continue;
+					auto it = inv.item_charges.find(iid);
+					if (it == inv.item_charges.end()) continue;
 					int c = it->second;
 					std::string label = std::string(iid) + ": " + std::to_string(c);
-					if (std::string(iid) == "knife" && st.game.broken_knife.count(name)) label += " [broken]";
+					if (std::string(iid) == "knife" && st.game.players.knife_broken[id]) label += " [broken]";
 					lines.push_back(label);
 				}
 				// any extra items not in predefined order
-				for (const auto& kv : itInv->second.item_charges) {
+				for (const auto& kv : inv.item_charges) {
 					if (kv.first=="knife" || kv.first=="rifle" || kv.first=="shotgun" || kv.first=="flashlight" || kv.first=="armor") continue;
 					lines.push_back(kv.first + ": " + std::to_string(kv.second));
 				}
 				if (lines.empty()) lines.push_back("Inventory: (empty)");
 			}
-			Outcome invOut;
-			invOut.messages = std::move(lines);
-			print_user_messages(name, invOut);
+			print_user_lines(name, lines);
+		}
+		return 0;
+	}
+	if (cmd == "turn-info") {
+		std::string state;
+		if (!get_arg(argc, argv, std::string("--state"), state)) { usage(); return 1; }
+		TurnInfo ti;
+		std::string err;
+		if (get_flag(argc, argv, std::string("--snapshot"))) {
+			RoomSnapshot snap;
+			if (!read_snapshot(state, snap, err)) { std::cerr << err << "\n"; return 4; }
+			ti = std::move(snap.turn);
+		} else if (!read_turn_sidecar(state, ti, err)) {
+			// сайдкара ещё нет (файл от старой версии) — один раз из самого состояния
+			AppState st;
+			if (!AppState::load(st, state, err, LoadGame)) { std::cerr << err << "\n"; return 2; }
+			ti = turn_info_from(st);
 		}
+		std::ostringstream js;
+		js << "{\"version\":" << ti.version << ",\"finished\":" << (ti.finished ? "true" : "false");
+		js << ",\"enforce\":" << (ti.enforce ? "true" : "false") << ",\"index\":" << ti.index;
+		js << ",\"current\":";
+		if (ti.current.empty()) js << "null"; else js << "\"" << json_escape(ti.current) << "\"";
+		js << ",\"order\":[";
+		for (size_t i = 0; i < ti.order.size(); ++i) js << (i ? "," : "") << "\"" << json_escape(ti.order[i]) << "\"";
+		js << "],\"players\":[";
+		for (size_t i = 0; i < ti.players.size(); ++i) js << (i ? "," : "") << "\"" << json_escape(ti.players[i]) << "\"";
+		js << "]}";
+		std::cout << js.str() << "\n";
 		return 0;
 	}
 	if (cmd == "player-status") {
 		std::string state, name;
 		if (!get_arg(argc, argv, std::string("--state"), state) ||
 		    !get_arg(argc, argv, std::string("--name"), name)) { usage(); return 1; }
-		AppState st; std::string err;
-		if (!AppState::load(st, state, err)) { std::cerr << err << "\n"; return 2; }
-		if (!st.game.players.count(name)) { std::cerr << "Игрок не найден\n"; return 3; }
-
-		bool hasTreasure = player_has_treasure(st.game, name);
-
-		std::ostringstream js;
-		js << "{";
-		js << "\"name\":\"" << jsonEscape(name) << "\",";
-		js << "\"hasTreasure\":" << (hasTreasure ? "true" : "false") << ",";
-		js << "\"items\":[";
-
-		static const char* itemOrder[] = {"knife","shotgun","rifle","flashlight","armor","treasure"};
-		auto itInv = st.game.inventories.find(name);
-		bool first = true;
-		for (const char* iid : itemOrder) {
-			int charges = 0;
-			bool has = false;
-			if (itInv != st.game.inventories.end()) {
-				auto it = itInv->second.item_charges.find(iid);
-				if (it != itInv->second.item_charges.end()) {
-					charges = it->second;
-					has = true;
-				}
-			}
-			if (!has) continue;
-			auto item = makeItem(iid);
-			if (!item) continue;
-
-			if (!first) js << ",";
-			first = false;
-			bool broken = (std::string(iid) == "knife" && st.game.broken_knife.count(name));
-			js << "{";
-			js << "\"id\":\"" << iid << "\",";
-			js << "\"displayName\":\"" << jsonEscape(item->displayName()) << "\",";
-			js << "\"description\":\"" << jsonEscape(item->description()) << "\",";
-			js << "\"rechargeHint\":\"" << jsonEscape(item->rechargeHint()) << "\",";
-			js << "\"charges\":" << charges << ",";
-			js << "\"broken\":" << (broken ? "true" : "false");
-			js << "}";
-		}
-		// extra items not in predefined order
-		if (itInv != st.game.inventories.end()) {
-			for (const auto& kv : itInv->second.item_charges) {
-				if (kv.first=="knife"||kv.first=="shotgun"||kv.first=="rifle"||kv.first=="flashlight"||kv.first=="armor"||kv.first=="treasure") continue;
-				auto item = makeItem(kv.first);
-				if (!first) js << ",";
-				first = false;
-				js << "{\"id\":\"" << jsonEscape(kv.first) << "\",";
-				js << "\"displayName\":\"" << jsonEscape(kv.first) << "\",";
-				js << "\"description\":\"\",\"rechargeHint\":\"\",";
-				js << "\"charges\":" << kv.second << ",\"broken\":false}";
-			}
+		std::string js, err;
+		if (get_flag(argc, argv, std::string("--snapshot"))) {
+			// без очереди комнаты: согласованная копия последнего save
+			RoomSnapshot snap;
+			if (!read_snapshot(state, snap, err)) { std::cerr << err << "\n"; return 4; }
+			const PlayerView* v = snap.find(name);
+			if (!v) { std::cerr << "Игрок не найден\n"; return 3; }
+			player_status_json(*v, js);
+			std::cout << js << "\n";
+			return 0;
 		}
-
-		js << "],";
-
-		// Breathing detection
-		auto myPos = st.game.players[name];
-		bool breathing = false;
-		bool meInHospital = st.map.get_cell(myPos.first, myPos.second) == CellContent::Hospital;
-		for (const auto& kv : st.game.players) {
-			if (kv.first == name) continue;
-			if (st.map.get_cell(kv.second.first, kv.second.second) == CellContent::Hospital) continue;
-			size_t dx = (myPos.first > kv.second.first) ? (myPos.first - kv.second.first) : (kv.second.first - myPos.first);
-			size_t dy = (myPos.second > kv.second.second) ? (myPos.second - kv.second.second) : (kv.second.second - myPos.second);
-			if (dx + dy != 1) continue;
-			bool vis = false;
-			if (kv.second.first + 1 == myPos.first && kv.second.second == myPos.second) vis = st.map.can_move_left(myPos.first, myPos.second);
-			else if (kv.second.first == myPos.first + 1 && kv.second.second == myPos.second) vis = st.map.can_move_right(myPos.first, myPos.second);
-			else if (kv.second.second + 1 == myPos.second && kv.second.first == myPos.first) vis = st.map.can_move_up(myPos.first, myPos.second);
-			else if (kv.second.second == myPos.second + 1 && kv.second.first == myPos.first) vis = st.map.can_move_down(myPos.first, myPos.second);
-			if (vis) { breathing = true; break; }
-		}
-		if (meInHospital) breathing = false;
-		if (!breathing && !meInHospital && st.game.bot_enabled) {
-			size_t bx = st.game.bot_x, by = st.game.bot_y;
-			size_t dx = (myPos.first > bx) ? (myPos.first - bx) : (bx - myPos.first);
-			size_t dy = (myPos.second > by) ? (myPos.second - by) : (by - myPos.second);
-			if (dx + dy == 1) {
-				if (bx + 1 == myPos.first && by == myPos.second) breathing = st.map.can_move_left(myPos.first, myPos.second);
-				else if (bx == myPos.first + 1 && by == myPos.second) breathing = st.map.can_move_right(myPos.first, myPos.second);
-				else if (by + 1 == myPos.second && bx == myPos.first) breathing = st.map.can_move_up(myPos.first, myPos.second);
-				else if (by == myPos.second + 1 && bx == myPos.first) breathing = st.map.can_move_down(myPos.first, myPos.second);
-			}
-		}
-		js << "\"nearbyBreathing\":" << (breathing ? "true" : "false") << ",";
-		js << "\"messages\":[";
-		if (breathing) {
-			js << "\"" << jsonEscape(messageWire(Message::Breathe)) << "\"";
-		}
-		js << "]}";
-		std::cout << js.str() << "\n";
+		AppState st;
+		if (!AppState::load(st, state, err, LoadMap | LoadGame)) { std::cerr << err << "\n"; return 2; }
+		if (!player_status_json(st, name, js)) { std::cerr << "Игрок не найден\n"; return 3; }
+		std::cout << js << "\n";
 		return 0;
 	}
 	if (cmd == "add-player") {
@@ -507,11 +488,16 @@ int main(int argc, char** argv) {
 		    !get_arg(argc, argv, std::string("--y"), sy)) { usage(); return 1; }
 		AppState st; std::string err;
 		if (!AppState::load(st, state, err)) { std::cerr << err << "\n"; return 2; }
+		feed_attach(st, state);
+		UndoMark before(st);
 		std::string e;
 		if (!st.game.add_player(name, {static_cast<size_t>(std::stoul(sx)), static_cast<size_t>(std::stoul(sy))}, st.map, e)) {
 			std::cerr << e << "\n"; return 3;
 		}
+		feed_player_added(st, name, static_cast<size_t>(std::stoul(sx)), static_cast<size_t>(std::stoul(sy)));
+		journal_record(st, before);
 		if (!AppState::save(st, state, err)) { std::cerr << err << "\n"; return 2; }
+		feed_flush(st, state);
 		log_err(std::string("Игрок '") + name + "' добавлен");
 		// log
 		st.log.push_back(LogEntry{LogType::AddPlayer, name, Direction::Up, (size_t)std::stoul(sx), (size_t)std::stoul(sy), {}});
@@ -523,38 +509,14 @@ int main(int argc, char** argv) {
 		    !get_arg(argc, argv, std::string("--name"), name)) { usage(); return 1; }
 		AppState st; std::string err;
 		if (!AppState::load(st, state, err)) { std::cerr << err << "\n"; return 2; }
-		// collect empty, unoccupied cells
-		std::unordered_set<long long> occupied;
-		for (const auto& kv : st.game.players) {
-			occupied.insert((long long)kv.second.second * 1000000LL + (long long)kv.second.first);
-		}
-		std::vector<std::pair<size_t,size_t>> spots;
-		for (size_t y = 0; y < st.map.height; ++y) {
-			for (size_t x = 0; x < st.map.width; ++x) {
-				if (st.map.get_cell(x, y) == CellContent::Empty) {
-					long long key = (long long)y * 1000000LL + (long long)x;
-					if (!occupied.count(key)) spots.emplace_back(x, y);
-				}
-			}
-		}
-		if (spots.empty()) { std::cerr << "Нет свободных клеток для размещения\n"; return 3; }
-		// С ботом: не ставить игрока на соседнюю с ботом клетку (манхэттен ≤ 1), иначе при первом же
-		// resolve-bots / ходе бота он может убить сразу — кажется, что «всегда спавн в больнице».
-		if (st.game.bot_enabled) {
-			std::vector<std::pair<size_t,size_t>> far_from_bot;
-			far_from_bot.reserve(spots.size());
-			for (auto [x, y] : spots) {
-				size_t dx = (x > st.game.bot_x) ? (x - st.game.bot_x) : (st.game.bot_x - x);
-				size_t dy = (y > st.game.bot_y) ? (y - st.game.bot_y) : (st.game.bot_y - y);
-				if (dx + dy >= 2) far_from_bot.emplace_back(x, y);
-			}
-			if (!far_from_bot.empty()) spots = std::move(far_from_bot);
-		}
-		auto pos = spots[rng_pick(st, spots.size())];
+		feed_attach(st, state);
+		UndoMark before(st);
+		std::pair<size_t,size_t> pos;
 		std::string e;
-		if (!st.game.add_player(name, pos, st.map, e)) { std::cerr << e << "\n"; return 3; }
-		st.log.push_back(LogEntry{LogType::AddPlayerRandom, name, Direction::Up, pos.first, pos.second, {}});
+		if (!add_player_random(st, name, pos, e)) { std::cerr << e << "\n"; return 3; }
+		journal_record(st, before);
 		if (!AppState::save(st, state, err)) { std::cerr << err << "\n"; return 2; }
+		feed_flush(st, state);
 		log_err(std::string("Игрок '") + name + "' добавлен на " + std::to_string(pos.first) + "," + std::to_string(pos.second));
 		return 0; // no stdout response
 	}
@@ -570,33 +532,7 @@ int main(int argc, char** argv) {
 		else if (sdir == "left") dir = Direction::Left;
 		else if (sdir == "right") dir = Direction::Right;
 		else { usage(); return 1; }
-		AppState st; std::string err;
-		if (!AppState::load(st, state, err)) { std::cerr << err << "\n"; return 2; }
-		// detailed stderr log baseline
-		std::pair<size_t,size_t> oldpos{0,0};
-		bool had_old = false;
-		{
-			auto itp = st.game.players.find(name);
-			if (itp != st.game.players.end()) { oldpos = itp->second; had_old = true; }
-		}
-		auto out = st.game.move_player(name, dir, st.map);
-		st.log.push_back(LogEntry{LogType::Move, name, dir, 0, 0, {}});
-		if (!AppState::save(st, state, err)) { std::cerr << err << "\n"; return 2; }
-		// stderr detailed log
-		if (had_old) {
-			std::ostringstream es;
-			es << "MOVE " << name << " from " << oldpos.first << "," << oldpos.second
-			   << " to " << out.position.first << "," << out.position.second
-			   << (out.moved ? " [moved]" : " [blocked]");
-			log_err(es.str());
-		} else {
-			log_err(std::string("MOVE ") + name + " (no previous position)");
-		}
-		// stdout user messages
-		print_user_messages(name, out);
-		run_pending_bot_turns(st);
-		if (!AppState::save(st, state, err)) { std::cerr << err << "\n"; return 2; }
-		return 0;
+		return run_player_action(state, ActionKind::Move, name, dir, std::string());
 	}
 	if (cmd == "use-item") {
 		std::string state, name, item, sdir;
@@ -611,23 +547,7 @@ int main(int argc, char** argv) {
 		else if (sdir == "left") dir = Direction::Left;
 		else if (sdir == "right") dir = Direction::Right;
 		else { usage(); return 1; }
-		AppState st; std::string err;
-		if (!AppState::load(st, state, err)) { std::cerr << err << "\n"; return 2; }
-		auto out = st.game.use_item(name, item, dir, st.map);
-		st.log.push_back(LogEntry{LogType::UseItem, name, dir, 0, 0, item});
-		if (out.bot_respawn_for_log)
-			st.log.push_back(LogEntry{LogType::BotMove, "", Direction::Up, out.bot_log_x, out.bot_log_y, {}});
-		if (!AppState::save(st, state, err)) { std::cerr << err << "\n"; return 2; }
-		{
-			std::ostringstream es;
-			es << "USE " << name << " item=" << item << " dir=" << sdir << (out.used ? " [applied]" : " [failed]");
-			log_err(es.str());
-		}
-		// stdout user messages
-		print_user_messages(name, out);
-		run_pending_bot_turns(st);
-		if (!AppState::save(st, state, err)) { std::cerr << err << "\n"; return 2; }
-		return 0;
+		return run_player_action(state, ActionKind::UseItem, name, dir, item);
 	}
 	if (cmd == "add-item") {
 		std::string state, item, sx, sy, sch;
@@ -640,12 +560,12 @@ int main(int argc, char** argv) {
 		if (!item_id_is_valid(item)) { usage(); return 1; }
 		AppState st; std::string err;
 		if (!AppState::load(st, state, err)) { std::cerr << err << "\n"; return 2; }
-		size_t x = static_cast<size_t>(std::stoul(sx));
-		size_t y = static_cast<size_t>(std::stoul(sy));
-		if (!st.map.in_bounds((long)x,(long)y)) { std::cerr << "Вне карты\n"; return 3; }
-		if (st.map.get_cell(x,y) != CellContent::Empty) { std::cerr << "Клетка занята не-пустой меткой\n"; return 3; }
-		long long key = (long long)y * 1000000LL + (long long)x;
-		st.game.ground_items[key][item] += std::max(1, charges);
+		UndoMark before(st);
+		std::string e;
+		if (!add_item_at(st, item, static_cast<size_t>(std::stoul(sx)), static_cast<size_t>(std::stoul(sy)), charges, e)) {
+			std::cerr << e << "\n"; return 3;
+		}
+		journal_record(st, before);
 		if (!AppState::save(st, state, err)) { std::cerr << err << "\n"; return 2; }
 		std::cout << "OK\n"; return 0;
 	}
@@ -658,19 +578,11 @@ int main(int argc, char** argv) {
 		if (!item_id_is_valid(item)) { usage(); return 1; }
 		AppState st; std::string err;
 		if (!AppState::load(st, state, err)) { std::cerr << err << "\n"; return 2; }
-		// collect empty cells without existing ground items or special content
-		std::vector<std::pair<size_t,size_t>> spots;
-		for (size_t y = 0; y < st.map.height; ++y) {
-			for (size_t x = 0; x < st.map.width; ++x) {
-				if (st.map.get_cell(x, y) != CellContent::Empty) continue;
-				// allow multiple items per cell; no filter
-				spots.emplace_back(x, y);
-			}
-		}
-		if (spots.empty()) { std::cerr << "Нет пустых клеток для размещения\n"; return 3; }
-		auto pos = spots[rng_pick(st, spots.size())];
-		long long key = (long long)pos.second * 1000000LL + (long long)pos.first;
-		st.game.ground_items[key][item] += std::max(1, charges);
+		UndoMark before(st);
+		std::pair<size_t,size_t> pos;
+		std::string e;
+		if (!add_item_random(st, item, charges, pos, e)) { std::cerr << e << "\n"; return 3; }
+		journal_record(st, before);
 		if (!AppState::save(st, state, err)) { std::cerr << err << "\n"; return 2; }
 		std::cout << "Предмет '" << item << "' добавлен на " << pos.first << "," << pos.second << "\n";
 		return 0;
@@ -685,11 +597,10 @@ int main(int argc, char** argv) {
 		if (!item_id_is_valid(item)) { usage(); return 1; }
 		AppState st; std::string err;
 		if (!AppState::load(st, state, err)) { std::cerr << err << "\n"; return 2; }
-		if (!st.game.players.count(name)) { std::cerr << "Игрок не найден\n"; return 3; }
-		auto& inv = st.game.inventories[name];
-		int cur = inv.getCharges(item);
-		inv.setCharges(item, cur + std::max(1, charges));
-		if (item == "knife" && inv.getCharges("knife") > 0) st.game.broken_knife.erase(name);
+		UndoMark before(st);
+		std::string e;
+		if (!give_item(st, name, item, charges, e)) { std::cerr << e << "\n"; return 3; }
+		journal_record(st, before);
 		if (!AppState::save(st, state, err)) { std::cerr << err << "\n"; return 2; }
 		std::cout << "OK\n"; return 0;
 	}
@@ -705,24 +616,7 @@ int main(int argc, char** argv) {
 		else if (sdir == "left") dir = Direction::Left;
 		else if (sdir == "right") dir = Direction::Right;
 		else { usage(); return 1; }
-		AppState st; std::string err;
-		if (!AppState::load(st, state, err)) { std::cerr << err << "\n"; return 2; }
-		auto out = st.game.attack(name, dir, st.map);
-		st.log.push_back(LogEntry{LogType::Attack, name, dir, 0, 0, {}});
-		if (out.bot_respawn_for_log)
-			st.log.push_back(LogEntry{LogType::BotMove, "", Direction::Up, out.bot_log_x, out.bot_log_y, {}});
-		if (!AppState::save(st, state, err)) { std::cerr << err << "\n"; return 2; }
-		// stderr detailed log
-		{
-			std::ostringstream es;
-			es << "ATTACK " << name << " dir=" << sdir << (out.attacked ? " [done]" : " [failed]");
-			log_err(es.str());
-		}
-		// stdout user messages
-		print_user_messages(name, out);
-		run_pending_bot_turns(st);
-		if (!AppState::save(st, state, err)) { std::cerr << err << "\n"; return 2; }
-		return 0;
+		return run_player_action(state, ActionKind::Attack, name, dir, std::string());
 	}
 	if (cmd == "replay-export") {
 		std::string base, logfile, outdir, scell, smargin;
@@ -771,7 +665,9 @@ int main(int argc, char** argv) {
 		else { usage(); return 1; }
 		AppState st; std::string err;
 		if (!AppState::load(st, state, err)) { std::cerr << err << "\n"; return 2; }
+		UndoMark before(st);
 		st.map.set_cell(static_cast<size_t>(std::stoul(sx)), static_cast<size_t>(std::stoul(sy)), c);
+		journal_record(st, before);
 		if (!AppState::save(st, state, err)) { std::cerr << err << "\n"; return 2; }
 		std::cout << "OK\n"; return 0;
 	}
@@ -783,7 +679,9 @@ int main(int argc, char** argv) {
 		    !get_arg(argc, argv, std::string("--present"), sp)) { usage(); return 1; }
 		AppState st; std::string err;
 		if (!AppState::load(st, state, err)) { std::cerr << err << "\n"; return 2; }
+		UndoMark before(st);
 		st.map.set_vwall(static_cast<size_t>(std::stoul(sy)), static_cast<size_t>(std::stoul(sx)), sp != "0");
+		journal_record(st, before);
 		if (!AppState::save(st, state, err)) { std::cerr << err << "\n"; return 2; }
 		std::cout << "OK\n"; return 0;
 	}
@@ -795,7 +693,9 @@ int main(int argc, char** argv) {
 		    !get_arg(argc, argv, std::string("--present"), sp)) { usage(); return 1; }
 		AppState st; std::string err;
 		if (!AppState::load(st, state, err)) { std::cerr << err << "\n"; return 2; }
+		UndoMark before(st);
 		st.map.set_hwall(static_cast<size_t>(std::stoul(sy)), static_cast<size_t>(std::stoul(sx)), sp != "0");
+		journal_record(st, before);
 		if (!AppState::save(st, state, err)) { std::cerr << err << "\n"; return 2; }
 		std::cout << "OK\n"; return 0;
 	}
@@ -808,6 +708,34 @@ int main(int argc, char** argv) {
 		if (!AppState::save(st, out, err)) { std::cerr << err << "\n"; return 2; }
 		std::cout << "Сохранено как: " << out << "\n"; return 0;
 	}
+	if (cmd == "undo") {
+		std::string state, ssteps;
+		if (!get_arg(argc, argv, std::string("--state"), state)) { usage(); return 1; }
+		size_t steps = 1;
+		if (get_arg(argc, argv, std::string("--steps"), ssteps)) steps = std::stoul(ssteps);
+		AppState st; std::string err;
+		if (!AppState::load(st, state, err)) { std::cerr << err << "\n"; return 2; }
+		size_t done = 0;
+		if (!undo_and_save(st, state, steps, done, err)) { std::cerr << err << "\n"; return 2; }
+		if (done == 0) { std::cerr << "Журнал отката пуст\n"; return 3; }
+		std::cout << "Отменено шагов: " << done << " (осталось в журнале: " << journal_depth(st.journal) << ")\n";
+		return 0;
+	}
+	if (cmd == "fork") {
+		// ветка «что если»: состояние N шагов назад в другой файл, исходный не трогаем
+		std::string state, out, ssteps;
+		if (!get_arg(argc, argv, std::string("--state"), state) ||
+		    !get_arg(argc, argv, std::string("--out"), out)) { usage(); return 1; }
+		size_t steps = 0;
+		if (get_arg(argc, argv, std::string("--steps"), ssteps)) steps = std::stoul(ssteps);
+		AppState st; std::string err;
+		if (!AppState::load(st, state, err)) { std::cerr << err << "\n"; return 2; }
+		const size_t done = undo_steps(st, steps);
+		if (done < steps) { std::cerr << "В журнале только " << done << " шагов\n"; return 3; }
+		if (!AppState::save(st, out, err)) { std::cerr << err << "\n"; return 2; }
+		std::cout << "Ветка: " << out << " (шагов назад: " << done << ")\n";
+		return 0;
+	}
 	if (cmd == "export-svg") {
 		std::string state, out, scell, smargin;
 		if (!get_arg(argc, argv, std::string("--state"), state) ||
@@ -818,13 +746,38 @@ int main(int argc, char** argv) {
 		if (get_arg(argc, argv, std::string("--margin"), smargin)) margin = std::stof(smargin);
 		AppState st; std::string err;
 		if (!AppState::load(st, state, err)) { std::cerr << err << "\n"; return 2; }
-		auto svg = render_svg(st, cell, margin);
+		SvgOptions opt;
+		if (!parse_svg_view(argc, argv, st.map, cell, margin, opt, err)) { std::cerr << err << "\n"; return 1; }
+		auto svg = render_svg(st, cell, margin, opt);
 		std::ofstream f(out);
 		if (!f) { std::cerr << "Не могу записать SVG\n"; return 2; }
 		f << svg;
 		log_err(std::string("SVG сохранён: ") + out);
 		return 0; // no stdout response
 	}
+	if (cmd == "svg-patch") {
+		std::string state, prev, out, scell, smargin;
+		if (!get_arg(argc, argv, std::string("--state"), state) ||
+		    !get_arg(argc, argv, std::string("--prev"), prev)) { usage(); return 1; }
+		float cell = 32.0f;
+		if (get_arg(argc, argv, std::string("--cell"), scell)) cell = std::stof(scell);
+		float margin = cell * 0.5f;
+		if (get_arg(argc, argv, std::string("--margin"), smargin)) margin = std::stof(smargin);
+		AppState st, before; std::string err;
+		if (!AppState::load(st, state, err)) { std::cerr << err << "\n"; return 2; }
+		if (!AppState::load(before, prev, err)) { std::cerr << err << "\n"; return 2; }
+		SvgOptions opt;
+		if (!parse_svg_view(argc, argv, st.map, cell, margin, opt, err)) { std::cerr << err << "\n"; return 1; }
+		auto patch = render_svg_patch(before, st, cell, margin, opt);
+		if (get_arg(argc, argv, std::string("--out"), out)) {
+			std::ofstream f(out);
+			if (!f) { std::cerr << "Не могу записать патч\n"; return 2; }
+			f << patch;
+			return 0;
+		}
+		std::cout << patch;
+		return 0;
+	}
 	if (cmd == "export-html") {
 		std::string state, out, scell, smargin;
 		if (!get_arg(argc, argv, std::string("--state"), state) ||
@@ -835,7 +788,9 @@ int main(int argc, char** argv) {
 		if (get_arg(argc, argv, std::string("--margin"), smargin)) margin = std::stof(smargin);
 		AppState st; std::string err;
 		if (!AppState::load(st, state, err)) { std::cerr << err << "\n"; return 2; }
-		auto html = render_html(st, cell, margin);
+		SvgOptions opt;
+		if (!parse_svg_view(argc, argv, st.map, cell, margin, opt, err)) { std::cerr << err << "\n"; return 1; }
+		auto html = render_html(st, cell, margin, opt);
 		std::ofstream f(out);
 		if (!f) { std::cerr << "Не могу записать HTML\n"; return 2; }
 		f << html;
@@ -847,11 +802,13 @@ int main(int argc, char** argv) {
 		if (!get_arg(argc, argv, std::string("--state"), state)) { usage(); return 1; }
 		AppState st; std::string err;
 		if (!AppState::load(st, state, err)) { std::cerr << err << "\n"; return 2; }
-		// Один и тот же порядок при generate + init-turns из scenario.json и при записи в dev:
-		// перетасовка только от random_seed (RNG файла после сессии не используем).
-		st.game.turn_rng_state = game_rng::initial_turn_rng_state(st.random_seed);
-		st.game.init_turns();
+		feed_attach(st, state);
+		UndoMark before(st);
+		init_turns(st);
+		feed_turn(st, std::string());
+		journal_record(st, before);
 		if (!AppState::save(st, state, err)) { std::cerr << err << "\n"; return 2; }
+		feed_flush(st, state);
 		// Output turn info so callers can read it
 		if (!st.game.turn_order.empty()) {
 			std::string cur = st.game.turn_order[st.game.turn_index % st.game.turn_order.size()];
@@ -866,12 +823,12 @@ int main(int argc, char** argv) {
 		std::string state;
 		if (!get_arg(argc, argv, std::string("--state"), state)) { usage(); return 1; }
 		AppState st; std::string err;
-		if (!AppState::load(st, state, err)) { std::cerr << err << "\n"; return 2; }
+		if (!AppState::load(st, state, err, LoadGame | LoadLog)) { std::cerr << err << "\n"; return 2; }
 		std::ostringstream js;
 		js << "{\"total\":" << st.log.size() << ",\"entries\":[";
 		for (size_t i = 0; i < st.log.size(); ++i) {
 			if (i) js << ",";
-			js << "\"" << jsonEscape(logEntryDescription(st.log[i])) << "\"";
+			js << "\"" << json_escape(logEntryDescription(st.log[i])) << "\"";
 		}
 		js << "]}";
 		std::cout << js.str() << "\n";
@@ -884,7 +841,7 @@ int main(int argc, char** argv) {
 		int target = std::stoi(sstep);
 		AppState st; std::string err;
 		if (!AppState::load(st, state, err)) { std::cerr << err << "\n"; return 2; }
-		AppState cur; cur.map = st.base_map; cur.game = st.base_game;
+		AppState cur; cur.map = st.base_map(); cur.game = st.base_game();
 		int limit = std::min(target, (int)st.log.size());
 		for (int i = 0; i < limit; ++i) applyLogEntry(st.log[i], cur);
 		std::string svg = render_svg(cur, 32.0f, 16.0f);
@@ -897,6 +854,8 @@ int main(int argc, char** argv) {
 		AppState st; std::string err;
 		if (!AppState::load(st, state, err)) { std::cerr << err << "\n"; return 2; }
 		st.set_base_from_current();
+		// дельты журнала считались от прежней базы
+		st.journal.reset();
 		if (!AppState::save(st, state, err)) { std::cerr << err << "\n"; return 2; }
 		std::cout << "Базовое состояние сохранено в файл.\n";
 		return 0;
@@ -906,8 +865,11 @@ int main(int argc, char** argv) {
 		if (!get_arg(argc, argv, std::string("--state"), state)) { usage(); return 1; }
 		AppState st; std::string err;
 		if (!AppState::load(st, state, err)) { std::cerr << err << "\n"; return 2; }
-		run_pending_bot_turns(st);
-		if (!AppState::save(st, state, err)) { std::cerr << err << "\n"; return 2; }
+		std::vector<MessageEvent> feed;
+		bool settled = true;
+		if (!resolve_bots(st, state, feed, settled, err)) { std::cerr << err << "\n"; return 2; }
+		write_bot_feed(std::cout, feed, st.game.players.name);
+		if (!settled) log_err(kBotCapMessage);
 		return 0;
 	}
 	if (cmd == "replay-export-one") {
@@ -920,7 +882,7 @@ int main(int argc, char** argv) {
 		AppState st; std::string err;
 		if (!AppState::load(st, state, err)) { std::cerr << err << "\n"; return 2; }
 		std::filesystem::create_directories(outdir);
-		AppState cur; cur.map = st.base_map; cur.game = st.base_game;
+		AppState cur; cur.map = st.base_map(); cur.game = st.base_game();
 		// frame 0
 		{
 			std::string svg = render_svg(cur, cell, margin);
@@ -945,8 +907,11 @@ int main(int argc, char** argv) {
 		int broken = std::stoi(sbroken);
 		AppState st; std::string err;
 		if (!AppState::load(st, state, err)) { std::cerr << err << "\n"; return 2; }
-		if (broken) st.game.broken_knife.insert(name);
-		else st.game.broken_knife.erase(name);
+		UndoMark before(st);
+		// неизвестное имя — как раньше, без эффекта (флаг сохранялся только для игроков)
+		const PlayerId id = st.game.players.find(name);
+		if (id != kNoPlayer) st.game.players.set_knife_broken(id, broken != 0);
+		journal_record(st, before);
 		if (!AppState::save(st, state, err)) { std::cerr << err << "\n"; return 2; }
 		std::cout << "OK\n"; return 0;
 	}
@@ -957,8 +922,13 @@ int main(int argc, char** argv) {
 		int val = std::stoi(argv[argc - 1]);
 		AppState st; std::string err;
 		if (!AppState::load(st, state, err)) { std::cerr << err << "\n"; return 2; }
+		feed_attach(st, state);
+		UndoMark before(st);
 		st.game.enforce_turns = (val != 0);
+		feed_turn(st, std::string());
+		journal_record(st, before);
 		if (!AppState::save(st, state, err)) { std::cerr << err << "\n"; return 2; }
+		feed_flush(st, state);
 		std::cout << (st.game.enforce_turns ? "Turns ON" : "Turns OFF") << "\n";
 		return 0;
 	}
@@ -966,4 +936,39 @@ int main(int argc, char** argv) {
 	return 1;
 }
 
-
+int main(int argc, char** argv) {
+	const std::string trace_path = take_global_arg(argc, argv, "--trace", "LABYRINTH_TRACE");
+	const std::string metrics_path = take_global_arg(argc, argv, "--metrics-out", "LABYRINTH_METRICS");
+	const std::string alloc_budget = take_global_arg(argc, argv, "--alloc-budget", "LABYRINTH_ALLOC_BUDGET");
+	const bool alloc_report = take_global_flag(argc, argv, "--alloc-report");
+	if (!trace_path.empty()) {
+		std::string terr;
+		if (!trace::open(trace_path, terr)) log_err(terr);
+	}
+	if (argc < 2) { usage(); return 1; }
+	int rc = 0;
+	alloc::Stats used;
+	{
+		const alloc::Stats start = alloc::thread_totals();
+		const std::string cmd = argv[1];
+		const bool plain_cmd = std::all_of(cmd.begin(), cmd.end(), [](char c) { return std::isalnum((unsigned char)c) || c == '-'; });
+		trace::Span cmd_span(plain_cmd ? argv[1] : "command", "cmd");
+		std::string metrics_state;
+		get_arg(argc, argv, std::string("--state"), metrics_state);
+		metrics::CommandScope metrics_scope(metrics_path, cmd, metrics_state);
+		rc = run_command(argc, argv);
+		const alloc::Stats end = alloc::thread_totals();
+		used.count = end.count - start.count;
+		used.bytes = end.bytes - start.bytes;
+	}
+	if (alloc_report) std::cerr << alloc::report_json(used) << "\n";
+	if (!alloc_budget.empty()) {
+		if (!alloc::enabled()) {
+			log_err("--alloc-budget: сборка без LABYRINTH_ALLOC_ACCOUNTING, бюджет не проверяется");
+		} else if (used.count > std::stoull(alloc_budget)) {
+			std::cerr << "Бюджет аллокаций превышен: " << used.count << " > " << alloc_budget << "\n";
+			return 3;
+		}
+	}
+	return rc;
+}
@@ -1,4 +1,9 @@
 #include "map.hpp"
+#include "players.hpp"
+#include "trace.hpp"
+#include "arena.hpp"
+#include "undo.hpp"
+#include <algorithm>
 #include <sstream>
 
 LabyrinthMap::LabyrinthMap(size_t w, size_t h) : width(w), height(h) {
@@ -17,15 +22,80 @@ CellContent LabyrinthMap::get_cell(size_t x, size_t y) const {
 }
 
 void LabyrinthMap::set_cell(size_t x, size_t y, CellContent c) {
+	undo::cell(*this, x, y);
+	const size_t i = y * width + x;
+	if (ContentIndex* idx = content_index.built()) {
+		idx->by_content[static_cast<size_t>(cells[y][x])].erase(i);
+		idx->by_content[static_cast<size_t>(c)].insert(i);
+		idx->free.assign(i, c == CellContent::Empty && (i >= occupants.size() || occupants[i] == 0));
+	}
 	cells[y][x] = c;
 }
 
+void LabyrinthMap::build_content(ContentIndex& idx) const {
+	for (auto& set : idx.by_content) set.reset(width * height);
+	idx.free.reset(width * height);
+	for (size_t y = 0; y < height; ++y)
+		for (size_t x = 0; x < width; ++x) {
+			const size_t i = y * width + x;
+			idx.by_content[static_cast<size_t>(cells[y][x])].insert(i);
+			if (cells[y][x] == CellContent::Empty && (i >= occupants.size() || occupants[i] == 0)) idx.free.insert(i);
+		}
+}
+
+const LabyrinthMap::ContentIndex& LabyrinthMap::content() const {
+	return content_index.get([this](ContentIndex& idx) { build_content(idx); });
+}
+
+const CellSet& LabyrinthMap::cells_of(CellContent c) const {
+	return content().by_content[static_cast<size_t>(c)];
+}
+
+const CellSet& LabyrinthMap::free_cells() const {
+	return content().free;
+}
+
+void LabyrinthMap::occupy(size_t x, size_t y) {
+	if (x >= width || y >= height) return;
+	if (occupants.size() != width * height) occupants.assign(width * height, 0);
+	const size_t i = y * width + x;
+	if (occupants[i]++ == 0)
+		if (ContentIndex* idx = content_index.built()) idx->free.erase(i);
+}
+
+void LabyrinthMap::vacate(size_t x, size_t y) {
+	const size_t i = y * width + x;
+	if (x >= width || y >= height || i >= occupants.size() || occupants[i] == 0) return;
+	if (--occupants[i] == 0 && cells[y][x] == CellContent::Empty)
+		if (ContentIndex* idx = content_index.built()) idx->free.insert(i);
+}
+
+void LabyrinthMap::sync_players(const PlayerTable& players) {
+	occupants.assign(width * height, 0);
+	for (const auto& p : players.pos)
+		if (p.first < width && p.second < height) ++occupants[p.second * width + p.first];
+	content_index.drop();
+}
+
+bool LabyrinthMap::first_cell_of(CellContent c, size_t& x, size_t& y) const {
+	const CellSet& set = cells_of(c);
+	if (set.size() == 0) return false;
+	const size_t i = set.select(0);
+	x = i % width;
+	y = i / width;
+	return true;
+}
+
 void LabyrinthMap::set_vwall(size_t y, size_t x, bool present) {
+	undo::vwall(*this, y, x);
 	v_walls[y][x] = present;
+	if (RunIndex* r = run_index.built()) rebuild_run_row(*r, y);
 }
 
 void LabyrinthMap::set_hwall(size_t y, size_t x, bool present) {
+	undo::hwall(*this, y, x);
 	h_walls[y][x] = present;
+	if (RunIndex* r = run_index.built(); r && x < width) rebuild_run_col(*r, x);
 }
 
 bool LabyrinthMap::can_move_left(size_t x, size_t y) const {
@@ -41,6 +111,54 @@ bool LabyrinthMap::can_move_down(size_t x, size_t y) const {
 	return y + 1 < height && !h_walls[y + 1][x];
 }
 
+// Вертикальная стена влияет только на свою строку (влево/вправо), горизонтальная — на столбец.
+void LabyrinthMap::rebuild_run_row(RunIndex& r, size_t y) const {
+	auto& left = r.runs[static_cast<int>(Direction::Left)];
+	auto& right = r.runs[static_cast<int>(Direction::Right)];
+	const size_t row = y * width;
+	for (size_t x = 0; x < width; ++x)
+		left[row + x] = can_move_left(x, y) ? left[row + x - 1] + 1 : 0;
+	for (size_t x = width; x-- > 0;)
+		right[row + x] = can_move_right(x, y) ? right[row + x + 1] + 1 : 0;
+}
+
+void LabyrinthMap::rebuild_run_col(RunIndex& r, size_t x) const {
+	auto& up = r.runs[static_cast<int>(Direction::Up)];
+	auto& down = r.runs[static_cast<int>(Direction::Down)];
+	for (size_t y = 0; y < height; ++y)
+		up[y * width + x] = can_move_up(x, y) ? up[(y - 1) * width + x] + 1 : 0;
+	for (size_t y = height; y-- > 0;)
+		down[y * width + x] = can_move_down(x, y) ? down[(y + 1) * width + x] + 1 : 0;
+}
+
+void LabyrinthMap::build_runs(RunIndex& r) const {
+	for (auto& dir : r.runs) dir.assign(width * height, 0);
+	for (size_t y = 0; y < height; ++y) rebuild_run_row(r, y);
+	for (size_t x = 0; x < width; ++x) rebuild_run_col(r, x);
+}
+
+const LabyrinthMap::RunIndex& LabyrinthMap::runs() const {
+	return run_index.get([this](RunIndex& r) { build_runs(r); });
+}
+
+size_t LabyrinthMap::run_length(size_t x, size_t y, Direction dir) const {
+	if (x >= width || y >= height) return 0;
+	return runs().runs[static_cast<int>(dir)][y * width + x];
+}
+
+void EmptyCellPicker::exclude_cell(size_t x, size_t y) {
+	if (x >= map.width || y >= map.height) return;
+	const size_t i = y * map.width + x;
+	if (!set.contains(i)) return;
+	auto it = std::lower_bound(exclude.begin(), exclude.end(), i);
+	if (it == exclude.end() || *it != i) exclude.insert(it, i);
+}
+
+std::pair<size_t,size_t> EmptyCellPicker::pick(size_t k) const {
+	const size_t i = set.select_excluding(k, exclude);
+	return {i % map.width, i / map.width};
+}
+
 std::string cell_to_char(CellContent c, bool reveal) {
 	switch (c) {
 		case CellContent::Empty: return reveal ? "." : " ";
@@ -52,53 +170,83 @@ std::string cell_to_char(CellContent c, bool reveal) {
 	return " ";
 }
 
-std::string LabyrinthMap::render_ascii(const std::unordered_map<std::string, std::pair<size_t,size_t>>* players, bool reveal, const std::unordered_map<long long,int>* loot_treasure) const {
-	std::unordered_map<long long, std::vector<char>> pos_to_labels;
+MapRect LabyrinthMap::clip_rect(const MapRect& r) const {
+	MapRect out;
+	if (r.x >= width || r.y >= height) return out;
+	out.x = r.x;
+	out.y = r.y;
+	out.w = std::min(r.w, width - r.x);
+	out.h = std::min(r.h, height - r.y);
+	return out;
+}
+
+std::string LabyrinthMap::render_ascii(const PlayerTable* players, bool reveal, const std::unordered_map<long long,int>* loot_treasure) const {
+	std::ostringstream oss;
+	write_ascii(oss, players, reveal, loot_treasure);
+	return oss.str();
+}
+
+void LabyrinthMap::write_ascii(std::ostream& oss, const PlayerTable* players, bool reveal,
+                               const std::unordered_map<long long,int>* loot_treasure, const MapRect* view) const {
+	LAB_TRACE_SCOPE("render.ascii");
+	const MapRect v = view ? clip_rect(*view) : full_rect();
+	if (v.empty()) return;
+	const size_t x1 = v.x + v.w, y1 = v.y + v.h;
+	// игроки только внутри окна — стоимость не зависит от размера карты; метки — в арене рендера
+	arena::Scope render_arena;
+	std::pmr::unordered_map<long long, std::pmr::vector<char>> pos_to_labels(arena::current());
 	if (players) {
-		for (const auto& kv : *players) {
-			char ch = kv.first.empty() ? 'P' : static_cast<char>(::toupper(kv.first[0]));
-			long long key = static_cast<long long>(kv.second.second) * 1000000LL + static_cast<long long>(kv.second.first);
+		for (PlayerId id = 0; id < players->size(); ++id) {
+			const auto& p = players->pos[id];
+			if (!v.contains(p.first, p.second)) continue;
+			const std::string& name = players->name[id];
+			char ch = name.empty() ? 'P' : static_cast<char>(::toupper(name[0]));
+			long long key = static_cast<long long>(p.second) * 1000000LL + static_cast<long long>(p.first);
 			pos_to_labels[key].push_back(ch);
 		}
 	}
-	std::ostringstream oss;
 	// top edge
-	for (size_t x = 0; x < width; ++x) {
+	for (size_t x = v.x; x < x1; ++x) {
 		oss << "+";
-		if (is_exit_edge_horizontal(0, x)) {
+		if (is_exit_edge_horizontal(v.y, x)) {
 			oss << "E";
 		} else {
-			oss << (h_walls[0][x] ? "-" : " ");
+			oss << (h_walls[v.y][x] ? "-" : " ");
 		}
 	}
 	oss << "+\n";
-	for (size_t y = 0; y < height; ++y) {
-		for (size_t x = 0; x < width; ++x) {
+	for (size_t y = v.y; y < y1; ++y) {
+		for (size_t x = v.x; x < x1; ++x) {
 			if (is_exit_edge_vertical(y, x)) {
 				oss << "E";
 			} else {
 				oss << (v_walls[y][x] ? "|" : " ");
 			}
 			long long key = static_cast<long long>(y) * 1000000LL + static_cast<long long>(x);
-			if (pos_to_labels.count(key)) {
-				if (pos_to_labels[key].size() == 1) {
-					oss << pos_to_labels[key][0];
+			auto itP = pos_to_labels.find(key);
+			if (itP != pos_to_labels.end()) {
+				if (itP->second.size() == 1) {
+					oss << itP->second[0];
 				} else {
 					oss << "*";
 				}
 			} else {
 				// overlay loot treasure always if present
-				bool lootT = loot_treasure && loot_treasure->count(key) && loot_treasure->at(key) > 0;
+				bool lootT = false;
+				if (loot_treasure) {
+					auto itL = loot_treasure->find(key);
+					lootT = itL != loot_treasure->end() && itL->second > 0;
+				}
 				if (lootT) oss << "T";
 				else oss << cell_to_char(get_cell(x, y), reveal);
 			}
 		}
-		if (is_exit_edge_vertical(y, width)) {
+		if (is_exit_edge_vertical(y, x1)) {
 			oss << "E\n";
 		} else {
-			oss << (v_walls[y][width] ? "|\n" : " \n");
+			oss << (v_walls[y][x1] ? "|\n" : " \n");
 		}
-		for (size_t x = 0; x < width; ++x) {
+		for (size_t x = v.x; x < x1; ++x) {
 			oss << "+";
 			if (is_exit_edge_horizontal(y + 1, x)) {
 				oss << "E";
@@ -108,7 +256,4 @@ std::string LabyrinthMap::render_ascii(const std::unordered_map<std::string, std
 		}
 		oss << "+\n";
 	}
-	return oss.str();
 }
-
-
@@ -1,15 +1,30 @@
 #pragma once
+#include "cellset.hpp"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
 #include <string>
 #include <vector>
 #include <unordered_map>
 
+struct PlayerTable;
+
 enum class CellContent { Empty, Treasure, Hospital, Arsenal, Exit };
+enum class Direction { Up, Down, Left, Right };
+
+/** Прямоугольник клеток [x, x+w) × [y, y+h) — окно просмотра для рендеров. */
+struct MapRect {
+	size_t x{0}, y{0}, w{0}, h{0};
+	bool empty() const { return w == 0 || h == 0; }
+	bool contains(size_t cx, size_t cy) const { return cx >= x && cy >= y && cx - x < w && cy - y < h; }
+};
 
 struct LabyrinthMap {
 	size_t width{0}, height{0};
 	std::vector<std::vector<CellContent>> cells;   // [h][w]
-	std::vector<std::vector<bool>> v_walls;        // [h][w+1]
-	std::vector<std::vector<bool>> h_walls;        // [h+1][w]
+	std::vector<std::vector<bool>> v_walls;        // [h][w+1], запись — только set_vwall
+	std::vector<std::vector<bool>> h_walls;        // [h+1][w], запись — только set_hwall
 	// Exit edge on outer border
 	bool has_exit{false};
 	bool exit_vertical{false}; // true: vertical edge (x==0 or x==width), false: horizontal (y==0 or y==height)
@@ -30,10 +45,115 @@ struct LabyrinthMap {
 	bool can_move_right(size_t x, size_t y) const;
 	bool can_move_up(size_t x, size_t y) const;
 	bool can_move_down(size_t x, size_t y) const;
+	/**
+	 * Сколько шагов подряд можно сделать из (x, y) в сторону dir, не упираясь в стену (O(1)).
+	 * Индекс строится при первом запросе и поправляется в set_vwall/set_hwall (строка/столбец),
+	 * поэтому стены меняются только через них.
+	 */
+	size_t run_length(size_t x, size_t y, Direction dir) const;
+	/**
+	 * Клетки с содержимым c (индекс y*width + x) в порядке обхода строк. Индекс строится при первом
+	 * запросе (после загрузки/генерации) и дальше поддерживается в set_cell.
+	 */
+	const CellSet& cells_of(CellContent c) const;
+	const CellSet& empty_cells() const { return cells_of(CellContent::Empty); }
+	/** Первая по обходу строк клетка с содержимым c; false — таких нет. */
+	bool first_cell_of(CellContent c, size_t& x, size_t& y) const;
+	/**
+	 * Игроки на клетках: occupy/vacate зовут Game::add_player, move_player и teleportToHospital
+	 * (и откат), sync_players — загрузка. free_cells() — пустые клетки, где никто не стоит,
+	 * поддерживается вместе с cells_of без обхода игроков.
+	 */
+	void occupy(size_t x, size_t y);
+	void vacate(size_t x, size_t y);
+	void sync_players(const PlayerTable& players);
+	const CellSet& free_cells() const;
 
-	std::string render_ascii(const std::unordered_map<std::string, std::pair<size_t,size_t>>* players, bool reveal, const std::unordered_map<long long,int>* loot_treasure = nullptr) const;
+	MapRect full_rect() const { return MapRect{0, 0, width, height}; }
+	/** Пересечение r с картой (может оказаться пустым). */
+	MapRect clip_rect(const MapRect& r) const;
+
+	std::string render_ascii(const PlayerTable* players, bool reveal, const std::unordered_map<long long,int>* loot_treasure = nullptr) const;
+	/** Потоковый ASCII-рендер окна view (nullptr — вся карта) прямо в os, без сборки всей строки. */
+	void write_ascii(std::ostream& os, const PlayerTable* players, bool reveal,
+	                 const std::unordered_map<long long,int>* loot_treasure = nullptr, const MapRect* view = nullptr) const;
 	bool is_exit_edge_vertical(size_t y, size_t x) const { return has_exit && exit_vertical && exit_y == y && exit_x == x; }
 	bool is_exit_edge_horizontal(size_t y, size_t x) const { return has_exit && !exit_vertical && exit_y == y && exit_x == x; }
+
+private:
+	/**
+	 * Индекс, который строится по первому const-запросу: двойная проверка ready под мьютексом,
+	 * так что параллельные читатели одной карты строят его один раз. Мутаторы карты (они не
+	 * параллельны чтению) правят построенный индекс на месте. Копия карты индекс не наследует —
+	 * построит заново, если её спросят; перемещение забирает готовый.
+	 */
+	template <class T>
+	struct LazyIndex {
+		T data;
+		std::atomic<bool> ready{false};
+		std::mutex mu;
+
+		LazyIndex() = default;
+		LazyIndex(const LazyIndex&) {}
+		LazyIndex(LazyIndex&& o) noexcept : data(std::move(o.data)), ready(o.ready.load()) { o.ready = false; }
+		LazyIndex& operator=(const LazyIndex&) { drop(); return *this; }
+		LazyIndex& operator=(LazyIndex&& o) noexcept {
+			data = std::move(o.data);
+			ready = o.ready.load();
+			o.ready = false;
+			return *this;
+		}
+
+		template <class Build>
+		T& get(Build&& build) {
+			if (!ready.load(std::memory_order_acquire)) {
+				std::lock_guard<std::mutex> lk(mu);
+				if (!ready.load(std::memory_order_relaxed)) {
+					build(data);
+					ready.store(true, std::memory_order_release);
+				}
+			}
+			return data;
+		}
+		/** Построенный индекс для правки мутатором; nullptr — ещё не строился. */
+		T* built() { return ready.load(std::memory_order_relaxed) ? &data : nullptr; }
+		void drop() { ready = false; data = T{}; }
+	};
+
+	// длины коридоров [Direction][y*w+x]
+	struct RunIndex { std::vector<uint32_t> runs[4]; };
+	static constexpr size_t kContentKinds = 5;
+	struct ContentIndex {
+		CellSet by_content[kContentKinds];
+		CellSet free; // пустые без игроков
+	};
+	mutable LazyIndex<RunIndex> run_index;
+	mutable LazyIndex<ContentIndex> content_index;
+	std::vector<uint32_t> occupants; // [y*w+x] — сколько игроков в клетке; не кэш, копируется
+
+	const RunIndex& runs() const;
+	const ContentIndex& content() const;
+	void build_runs(RunIndex& r) const;
+	void build_content(ContentIndex& c) const;
+	void rebuild_run_row(RunIndex& r, size_t y) const;
+	void rebuild_run_col(RunIndex& r, size_t x) const;
+};
+
+/**
+ * Случайная пустая клетка без исключённых: count() кандидатов, pick(k) — k-й по обходу строк
+ * (как элемент k прежнего списка spots), за O(log n) без сканирования карты. without_players —
+ * выбор из free_cells(): клетки с игроками отсеяны индексом карты, а не обходом игроков.
+ */
+struct EmptyCellPicker {
+	const LabyrinthMap& map;
+	const CellSet& set;
+	std::vector<size_t> exclude; // отсортированные индексы клеток из set, без повторов
+
+	explicit EmptyCellPicker(const LabyrinthMap& m, bool without_players = false)
+		: map(m), set(without_players ? m.free_cells() : m.empty_cells()) {}
+	void exclude_cell(size_t x, size_t y);
+	size_t count() const { return set.size() - exclude.size(); }
+	std::pair<size_t,size_t> pick(size_t k) const;
 };
 
 std::string cell_to_char(CellContent c, bool reveal);
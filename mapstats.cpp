@@ -0,0 +1,271 @@
+#include "mapstats.hpp"
+#include "flood.hpp"
+#include "generator.hpp"
+#include "metrics.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iterator>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+namespace {
+
+const char* const kStatNames[] = {
+#define MAP_STAT_NAME(id, name) name,
+	MAP_STAT_LIST(MAP_STAT_NAME)
+#undef MAP_STAT_NAME
+};
+
+constexpr size_t kStatCount = static_cast<size_t>(MapStat::Count);
+
+/** Пара ориентиров для метрики-расстояния; false — метрика не расстояние. */
+bool stat_pair(MapStat s, Landmark& a, Landmark& b) {
+	switch (s) {
+		case MapStat::TreasureExit: a = Landmark::Treasure; b = Landmark::Exit; return true;
+		case MapStat::TreasureHospital: a = Landmark::Treasure; b = Landmark::Hospital; return true;
+		case MapStat::TreasureArsenal: a = Landmark::Treasure; b = Landmark::Arsenal; return true;
+		case MapStat::ExitHospital: a = Landmark::Exit; b = Landmark::Hospital; return true;
+		case MapStat::ExitArsenal: a = Landmark::Exit; b = Landmark::Arsenal; return true;
+		case MapStat::HospitalArsenal: a = Landmark::Hospital; b = Landmark::Arsenal; return true;
+		default: return false;
+	}
+}
+
+inline bool bit(const std::pmr::vector<uint64_t>& rows, const flood::Grid& g, size_t x, size_t y) {
+	return (rows[y * g.words + (x >> 6)] >> (x & 63)) & 1u;
+}
+
+/** Проходы из клетки i: до четырёх соседей. */
+size_t neighbours(const flood::Grid& g, size_t i, size_t out[4]) {
+	const size_t x = i % g.width, y = i / g.width;
+	size_t n = 0;
+	if (bit(g.right, g, x, y)) out[n++] = i + 1;
+	if (x > 0 && bit(g.right, g, x - 1, y)) out[n++] = i - 1;
+	if (bit(g.down, g, x, y)) out[n++] = i + g.width;
+	if (y > 0 && bit(g.down, g, x, y - 1)) out[n++] = i - g.width;
+	return n;
+}
+
+/**
+ * Многоисточниковый BFS по слоям: у клетки маска видов ориентиров, чьи волны до неё дошли.
+ * Волна каждого вида точна сама по себе (как отдельный BFS), но все виды идут одним фронтом:
+ * клетка попадает во фронт один раз за слой с объединённой маской новых бит.
+ */
+void landmark_distances(const flood::Grid& g, const std::vector<uint8_t>& kind, MapStats& s) {
+	const size_t n = g.width * g.height;
+	std::vector<uint8_t> seen(kind), fresh(n, 0), incoming(n, 0);
+	std::vector<size_t> front, next;
+	for (size_t i = 0; i < n; ++i) {
+		if (!kind[i]) continue;
+		fresh[i] = kind[i];
+		front.push_back(i);
+	}
+	auto arrive = [&](size_t i, uint8_t bits, uint32_t layer) {
+		for (size_t a = 0; a < kLandmarkCount; ++a) {
+			if (!(bits >> a & 1u)) continue;
+			for (size_t b = 0; b < kLandmarkCount; ++b)
+				if ((kind[i] >> b & 1u) && s.dist[a][b] > layer) s.dist[a][b] = s.dist[b][a] = layer;
+		}
+	};
+	for (size_t i : front) arrive(i, kind[i], 0);
+	size_t nodes = front.size();
+	size_t nb[4];
+	for (uint32_t layer = 1; !front.empty(); ++layer) {
+		for (size_t i : front) {
+			const uint8_t bits = fresh[i];
+			fresh[i] = 0;
+			for (size_t k = 0, c = neighbours(g, i, nb); k < c; ++k) {
+				const uint8_t add = static_cast<uint8_t>(bits & ~seen[nb[k]]);
+				if (!add) continue;
+				if (!incoming[nb[k]]) next.push_back(nb[k]);
+				incoming[nb[k]] |= add;
+				seen[nb[k]] |= add;
+			}
+		}
+		for (size_t i : next) {
+			fresh[i] = incoming[i];
+			incoming[i] = 0;
+			arrive(i, fresh[i], layer);
+		}
+		nodes += next.size();
+		front.swap(next);
+		next.clear();
+	}
+	metrics::add(metrics::Counter::BfsNodes, nodes);
+}
+
+/** Клетка за проёмом выхода. */
+bool exit_cell(const LabyrinthMap& m, size_t& x, size_t& y) {
+	if (!m.has_exit || m.width == 0 || m.height == 0) return false;
+	if (m.exit_vertical) {
+		x = m.exit_x == 0 ? 0 : m.exit_x - 1;
+		y = m.exit_y;
+	} else {
+		x = m.exit_x;
+		y = m.exit_y == 0 ? 0 : m.exit_y - 1;
+	}
+	return x < m.width && y < m.height;
+}
+
+} // namespace
+
+bool MapStats::value(MapStat s, double& v) const {
+	Landmark a, b;
+	if (stat_pair(s, a, b)) {
+		const uint32_t d = dist[static_cast<size_t>(a)][static_cast<size_t>(b)];
+		if (d == flood::kUnreached) return false;
+		v = d;
+		return true;
+	}
+	switch (s) {
+		case MapStat::DeadEnds: v = cells ? static_cast<double>(dead_ends) / static_cast<double>(cells) : 0.0; break;
+		case MapStat::Corridors: v = static_cast<double>(corridors); break;
+		case MapStat::CorridorMax: v = static_cast<double>(corridor_max); break;
+		case MapStat::CorridorMean: v = corridors ? static_cast<double>(corridor_cells) / static_cast<double>(corridors) : 0.0; break;
+		case MapStat::Components: v = static_cast<double>(components); break;
+		default: return false;
+	}
+	return true;
+}
+
+MapStats compute_map_stats(const LabyrinthMap& map) {
+	LAB_TRACE_SCOPE("map_stats");
+	MapStats s;
+	for (auto& row : s.dist) std::fill(std::begin(row), std::end(row), flood::kUnreached);
+	const flood::Grid g(map);
+	const size_t n = g.width * g.height;
+	s.cells = n;
+	if (n == 0) return s;
+
+	std::vector<uint8_t> kind(n, 0);
+	for (size_t y = 0; y < g.height; ++y) {
+		for (size_t x = 0; x < g.width; ++x) {
+			Landmark l;
+			switch (map.cells[y][x]) {
+				case CellContent::Treasure: l = Landmark::Treasure; break;
+				case CellContent::Hospital: l = Landmark::Hospital; break;
+				case CellContent::Arsenal: l = Landmark::Arsenal; break;
+				default: continue;
+			}
+			kind[y * g.width + x] = static_cast<uint8_t>(1u << static_cast<size_t>(l));
+		}
+	}
+	size_t ex = 0, ey = 0;
+	if (exit_cell(map, ex, ey)) kind[ey * g.width + ex] |= 1u << static_cast<size_t>(Landmark::Exit);
+	landmark_distances(g, kind, s);
+
+	// степени клеток; цепочки степени 2 — коридоры
+	std::vector<uint8_t> degree(n);
+	size_t nb[4];
+	for (size_t i = 0; i < n; ++i) {
+		degree[i] = static_cast<uint8_t>(neighbours(g, i, nb));
+		if (degree[i] == 1) s.dead_ends++;
+	}
+	std::vector<uint8_t> visited(n, 0);
+	std::vector<size_t> stack;
+	for (size_t i = 0; i < n; ++i) {
+		if (degree[i] != 2 || visited[i]) continue;
+		size_t len = 0;
+		visited[i] = 1;
+		stack.push_back(i);
+		while (!stack.empty()) {
+			const size_t c = stack.back();
+			stack.pop_back();
+			len++;
+			for (size_t k = 0, cnt = neighbours(g, c, nb); k < cnt; ++k) {
+				if (degree[nb[k]] != 2 || visited[nb[k]]) continue;
+				visited[nb[k]] = 1;
+				stack.push_back(nb[k]);
+			}
+		}
+		s.corridors++;
+		s.corridor_cells += len;
+		s.corridor_max = std::max(s.corridor_max, len);
+	}
+	s.components = flood::count_components(g);
+	return s;
+}
+
+std::string map_stats_json(const MapStats& s) {
+	std::ostringstream js;
+	js << "{";
+	for (size_t k = 0; k < kStatCount; ++k) {
+		if (k) js << ",";
+		js << "\"" << kStatNames[k] << "\":";
+		double v = 0;
+		if (s.value(static_cast<MapStat>(k), v)) js << v;
+		else js << "null";
+	}
+	js << "}";
+	return js.str();
+}
+
+bool parse_map_constraints(const std::string& spec, std::vector<MapConstraint>& out, std::string& err) {
+	out.clear();
+	std::istringstream is(spec);
+	std::string item;
+	while (std::getline(is, item, ',')) {
+		if (item.empty()) continue;
+		size_t op = item.find(">=");
+		const bool at_least = op != std::string::npos;
+		if (!at_least) op = item.find("<=");
+		if (op == std::string::npos) { err = "Условие без >= или <=: " + item; return false; }
+		const std::string name = item.substr(0, op), num = item.substr(op + 2);
+		size_t k = 0;
+		while (k < kStatCount && name != kStatNames[k]) ++k;
+		if (k == kStatCount) { err = "Неизвестная метрика: " + name; return false; }
+		char* end = nullptr;
+		const double bound = std::strtod(num.c_str(), &end);
+		if (num.empty() || *end != '\0') { err = "Не число в условии: " + item; return false; }
+		out.push_back(MapConstraint{static_cast<MapStat>(k), at_least, bound});
+	}
+	if (out.empty()) { err = "Пустой список условий"; return false; }
+	return true;
+}
+
+bool map_constraints_hold(const MapStats& s, const std::vector<MapConstraint>& cs) {
+	for (const auto& c : cs) {
+		double v = 0;
+		if (!s.value(c.stat, v)) return false;
+		if (c.at_least ? v < c.bound : v > c.bound) return false;
+	}
+	return true;
+}
+
+bool search_map_seed(size_t width, size_t height, float openness, unsigned int first, size_t tries,
+                     const std::vector<MapConstraint>& cs, unsigned threads, unsigned int& seed, LabyrinthMap& map,
+                     size_t& checked) {
+	LAB_TRACE_SCOPE("seed_search");
+	// индексы раздаются по возрастанию: найдя i, поток больше не берёт индексов > best,
+	// а меньшие доделываются — ответ тот же, что у последовательного перебора
+	std::atomic<size_t> next{0};
+	std::atomic<size_t> best{tries};
+	std::mutex mu;
+	auto worker = [&]() {
+		for (;;) {
+			const size_t i = next.fetch_add(1, std::memory_order_relaxed);
+			if (i >= best.load(std::memory_order_relaxed)) return;
+			set_rng_seed(first + static_cast<unsigned int>(i));
+			LabyrinthMap m = generate_maze_with_items(width, height, openness);
+			if (!map_constraints_hold(compute_map_stats(m), cs)) continue;
+			size_t cur = best.load(std::memory_order_relaxed);
+			while (i < cur && !best.compare_exchange_weak(cur, i, std::memory_order_relaxed)) {}
+			std::lock_guard<std::mutex> lk(mu);
+			if (best.load(std::memory_order_relaxed) == i) map = std::move(m);
+		}
+	};
+	threads = std::max(1u, std::min<unsigned>(threads, static_cast<unsigned>(std::min<size_t>(tries, 256))));
+	std::vector<std::thread> pool;
+	for (unsigned t = 1; t < threads; ++t) pool.emplace_back(worker);
+	worker();
+	for (auto& th : pool) th.join();
+	const size_t found = best.load();
+	checked = found < tries ? found + 1 : tries;
+	if (found >= tries) return false;
+	seed = first + static_cast<unsigned int>(found);
+	return true;
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include "map.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/** Ориентиры карты, между которыми меряются расстояния; выход — клетка у проёма. */
+enum class Landmark : uint8_t { Treasure, Exit, Hospital, Arsenal, Count };
+constexpr size_t kLandmarkCount = static_cast<size_t>(Landmark::Count);
+
+/**
+ * Метрики качества карты: X(Id, "имя"). Имя — ключ в map-stats и в generate --constraints.
+ * Расстояния — в шагах между ближайшими клетками ориентиров.
+ */
+#define MAP_STAT_LIST(X) \
+	X(TreasureExit, "treasure_exit") \
+	X(TreasureHospital, "treasure_hospital") \
+	X(TreasureArsenal, "treasure_arsenal") \
+	X(ExitHospital, "exit_hospital") \
+	X(ExitArsenal, "exit_arsenal") \
+	X(HospitalArsenal, "hospital_arsenal") \
+	X(DeadEnds, "dead_ends") \
+	X(Corridors, "corridors") \
+	X(CorridorMax, "corridor_max") \
+	X(CorridorMean, "corridor_mean") \
+	X(Components, "components")
+
+enum class MapStat {
+#define MAP_STAT_ENUM(id, name) id,
+	MAP_STAT_LIST(MAP_STAT_ENUM)
+#undef MAP_STAT_ENUM
+	Count
+};
+
+struct MapStats {
+	/** dist[a][b] — кратчайший путь между ориентирами; kUnreached — нет пути или ориентира. */
+	uint32_t dist[kLandmarkCount][kLandmarkCount];
+	size_t cells{0};
+	size_t dead_ends{0};   // клетки с единственным проходом
+	size_t corridors{0};   // цепочки клеток ровно с двумя проходами
+	size_t corridor_cells{0};
+	size_t corridor_max{0};
+	size_t components{0};
+
+	/** Значение метрики; false — расстояние до недостижимого ориентира. Тупики — доля клеток. */
+	bool value(MapStat s, double& v) const;
+};
+
+/** Все метрики за один проход: расстояния — один BFS из всех ориентиров сразу (по биту на вид). */
+MapStats compute_map_stats(const LabyrinthMap& map);
+std::string map_stats_json(const MapStats& s);
+
+/** Условие generate --constraints: метрика op число. */
+struct MapConstraint {
+	MapStat stat{MapStat::TreasureExit};
+	bool at_least{true}; // >= иначе <=
+	double bound{0};
+};
+
+/** "treasure_exit>=6,dead_ends<=0.3,…" → список условий. */
+bool parse_map_constraints(const std::string& spec, std::vector<MapConstraint>& out, std::string& err);
+/** Все условия выполнены; метрика до недостижимого ориентира не проходит ни одно условие. */
+bool map_constraints_hold(const MapStats& s, const std::vector<MapConstraint>& cs);
+
+/**
+ * Первый по порядку сид из first, first+1, … (не больше tries штук), чья карта
+ * generate_maze_with_items(width, height, openness) проходит условия. Сиды проверяются
+ * в threads потоках, но ответ тот же, что при переборе по одному. map — карта найденного сида,
+ * checked — сколько сидов по порядку пришлось проверить. false — подходящего нет.
+ */
+bool search_map_seed(size_t width, size_t height, float openness, unsigned int first, size_t tries,
+                     const std::vector<MapConstraint>& cs, unsigned threads, unsigned int& seed, LabyrinthMap& map,
+                     size_t& checked);
@@ -1,7 +1,13 @@
 #pragma once
+#include "players.hpp"
 
+#include <cassert>
 #include <initializer_list>
+#include <mutex>
+#include <ostream>
 #include <string>
+#include <unordered_set>
+#include <vector>
 
 #define MESSAGE_CODE_LIST(X) \
 	X(InvalidTargetPlayer, "INVALID_TARGET_PLAYER") \
@@ -64,23 +70,113 @@ enum class Message {
 #undef X
 };
 
-/** Wire: `CODE` или `CODE:arg1:arg2…` (аргументы — нейтральные токены, без локализации в C++). */
-inline std::string messageWire(Message m, std::initializer_list<std::string> args = {}) {
-	std::string s;
+/** Код сообщения в wire-формате ("MOVED", "KILLED_BY_BOT", …); для неизвестного — "". */
+inline const char* messageCode(Message m) {
 	switch (m) {
 #define X(name, str) \
 	case Message::name: \
-		s = str; \
-		break;
+		return str;
 		MESSAGE_CODE_LIST(X)
 #undef X
 	default:
 		return "";
 	}
-	if (args.size() == 0) return s;
+}
+
+/** Wire: `CODE` или `CODE:arg1:arg2…` (аргументы — нейтральные токены, без локализации в C++). */
+inline std::string messageWire(Message m, std::initializer_list<std::string> args = {}) {
+	std::string s = messageCode(m);
+	if (s.empty()) return s;
 	for (const auto& a : args) {
 		s += ':';
 		s += a;
 	}
 	return s;
 }
+
+/**
+ * Токен со временем жизни процесса для произвольной строки (id нестандартного предмета).
+ * Путь редкий, поэтому пул общий на процесс и под мьютексом (аддон и раннер сценариев многопоточны).
+ */
+inline const char* messageToken(const std::string& s) {
+	static std::mutex mu;
+	static std::unordered_set<std::string> pool;
+	std::lock_guard<std::mutex> lock(mu);
+	return pool.insert(s).first->c_str();
+}
+
+/**
+ * Аргумент события — маленький tagged union: статический токен (направление, тип клетки, id предмета),
+ * число или PlayerId. Имя игрока подставляется только при печати, по таблице имён.
+ */
+struct MessageArg {
+	enum class Kind : unsigned char { Token, Int, Player };
+	Kind kind{Kind::Token};
+	union {
+		const char* token;
+		long long num;
+		PlayerId player;
+	};
+
+	MessageArg() : token("") {}
+	MessageArg(const char* t) : kind(Kind::Token), token(t) {}
+	MessageArg(long long n) : kind(Kind::Int), num(n) {}
+	static MessageArg of(PlayerId id) {
+		MessageArg a;
+		a.kind = Kind::Player;
+		a.player = id;
+		return a;
+	}
+
+	/** names — PlayerTable::name на момент события. */
+	void appendTo(std::string& out, const std::vector<std::string>& names) const {
+		if (kind == Kind::Token) out += token;
+		else if (kind == Kind::Int) out += std::to_string(num);
+		else if (player < names.size()) out += names[player];
+	}
+	void writeTo(std::ostream& os, const std::vector<std::string>& names) const {
+		if (kind == Kind::Token) os << token;
+		else if (kind == Kind::Int) os << num;
+		else if (player < names.size()) os << names[player];
+	}
+};
+
+/**
+ * Событие исхода: код, адресат (kNoPlayer — автору действия; иначе жертве, как `PLAYER:имя:` в wire)
+ * и до kMaxArgs аргументов. Строка wire собирается только при печати.
+ */
+struct MessageEvent {
+	static constexpr size_t kMaxArgs = 4;
+	Message code{};
+	PlayerId recipient{kNoPlayer};
+	MessageArg args[kMaxArgs];
+	unsigned char argc{0};
+
+	MessageEvent() = default;
+	MessageEvent(Message m, std::initializer_list<MessageArg> a) : code(m) {
+		assert(a.size() <= kMaxArgs && "MessageEvent: слишком много аргументов");
+		for (const auto& x : a) {
+			if (argc == kMaxArgs) break;
+			args[argc++] = x;
+		}
+	}
+
+	bool addressed() const { return recipient != kNoPlayer; }
+
+	/** `CODE:arg…` без префикса адресата. */
+	std::string wire(const std::vector<std::string>& names) const {
+		std::string s = messageCode(code);
+		for (unsigned char i = 0; i < argc; ++i) {
+			s += ':';
+			args[i].appendTo(s, names);
+		}
+		return s;
+	}
+	void writeWire(std::ostream& os, const std::vector<std::string>& names) const {
+		os << messageCode(code);
+		for (unsigned char i = 0; i < argc; ++i) {
+			os << ':';
+			args[i].writeTo(os, names);
+		}
+	}
+};
@@ -0,0 +1,161 @@
+#include "metrics.hpp"
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <vector>
+#include <unistd.h>
+
+namespace metrics {
+
+std::atomic<uint64_t> g_counters[kCounterCount];
+
+static const char* const kCounterNames[] = {
+#define METRIC_NAME(id, name) name,
+	METRIC_COUNTER_LIST(METRIC_NAME)
+#undef METRIC_NAME
+};
+
+const char* counter_name(Counter c) {
+	return kCounterNames[static_cast<size_t>(c)];
+}
+
+size_t latency_bucket(uint64_t us) {
+	size_t b = 0;
+	while (us > 1 && b + 1 < kLatencyBuckets) { us >>= 1; ++b; }
+	return b;
+}
+
+static long long now_us() {
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+static std::string json_escape(const std::string& s) {
+	std::string out;
+	for (char c : s) {
+		if (c == '"') out += "\\\"";
+		else if (c == '\\') out += "\\\\";
+		else if (c == '\n') out += "\\n";
+		else out += c;
+	}
+	return out;
+}
+
+CommandScope::CommandScope(std::string path, std::string cmd, std::string state)
+	: path_(std::move(path)), cmd_(std::move(cmd)), state_(std::move(state)), start_us_(now_us()) {}
+
+CommandScope::~CommandScope() {
+	if (path_.empty()) return;
+	long long end = now_us();
+	std::ostringstream js;
+	js << "{\"cmd\":\"" << json_escape(cmd_) << "\",\"state\":\"" << json_escape(state_)
+	   << "\",\"pid\":" << ::getpid() << ",\"ts\":" << start_us_ << ",\"latency_us\":" << (end - start_us_)
+	   << ",\"counters\":{";
+	for (size_t i = 0; i < kCounterCount; ++i) {
+		if (i) js << ",";
+		js << "\"" << kCounterNames[i] << "\":" << g_counters[i].load(std::memory_order_relaxed);
+	}
+	js << "}}\n";
+	// одна короткая запись в режиме append — строки параллельных процессов не перемешиваются
+	std::ofstream f(path_, std::ios::app);
+	if (f) f << js.str() << std::flush;
+}
+
+/** Значение "key":"..." или "key":N из нашей же строки; false — ключа нет. */
+static bool find_str(const std::string& line, const std::string& key, std::string& out) {
+	std::string pat = "\"" + key + "\":\"";
+	size_t p = line.find(pat);
+	if (p == std::string::npos) return false;
+	p += pat.size();
+	out.clear();
+	for (; p < line.size() && line[p] != '"'; ++p) {
+		if (line[p] == '\\' && p + 1 < line.size()) ++p;
+		out.push_back(line[p]);
+	}
+	return true;
+}
+static bool find_num(const std::string& line, const std::string& key, uint64_t& out) {
+	std::string pat = "\"" + key + "\":";
+	size_t p = line.find(pat);
+	if (p == std::string::npos) return false;
+	p += pat.size();
+	if (p >= line.size() || line[p] < '0' || line[p] > '9') return false;
+	out = 0;
+	for (; p < line.size() && line[p] >= '0' && line[p] <= '9'; ++p) out = out * 10 + static_cast<uint64_t>(line[p] - '0');
+	return true;
+}
+
+struct CommandAgg {
+	uint64_t count{0}, sum_us{0}, max_us{0};
+	uint64_t buckets[kLatencyBuckets]{};
+	uint64_t counters[kCounterCount]{};
+};
+
+static void write_counters(std::ostringstream& js, const uint64_t* c) {
+	js << "{";
+	for (size_t i = 0; i < kCounterCount; ++i) {
+		if (i) js << ",";
+		js << "\"" << kCounterNames[i] << "\":" << c[i];
+	}
+	js << "}";
+}
+
+bool aggregate_json(const std::string& path, std::string& out, std::string& err) {
+	std::ifstream f(path);
+	if (!f) { err = "Не могу открыть файл метрик"; return false; }
+	std::map<std::string, CommandAgg> by_cmd;
+	std::map<std::string, std::vector<uint64_t>> by_state;
+	std::string line;
+	size_t lines = 0;
+	while (std::getline(f, line)) {
+		std::string cmd, state;
+		uint64_t lat = 0;
+		if (!find_str(line, "cmd", cmd) || !find_num(line, "latency_us", lat)) continue;
+		find_str(line, "state", state);
+		++lines;
+		CommandAgg& a = by_cmd[cmd];
+		a.count++;
+		a.sum_us += lat;
+		if (lat > a.max_us) a.max_us = lat;
+		a.buckets[latency_bucket(lat)]++;
+		auto& sc = by_state[state];
+		sc.resize(kCounterCount, 0);
+		for (size_t i = 0; i < kCounterCount; ++i) {
+			uint64_t v = 0;
+			if (!find_num(line, kCounterNames[i], v)) continue;
+			a.counters[i] += v;
+			sc[i] += v;
+		}
+	}
+	std::ostringstream js;
+	js << "{\"lines\":" << lines << ",\"commands\":{";
+	bool first = true;
+	for (const auto& kv : by_cmd) {
+		const CommandAgg& a = kv.second;
+		if (!first) js << ",";
+		first = false;
+		js << "\"" << json_escape(kv.first) << "\":{\"count\":" << a.count << ",\"sum_us\":" << a.sum_us
+		   << ",\"max_us\":" << a.max_us << ",\"log2_us\":[";
+		size_t top = kLatencyBuckets;
+		while (top > 0 && a.buckets[top - 1] == 0) --top;
+		for (size_t i = 0; i < top; ++i) js << (i ? "," : "") << a.buckets[i];
+		js << "],\"counters\":";
+		write_counters(js, a.counters);
+		js << "}";
+	}
+	js << "},\"states\":{";
+	first = true;
+	for (const auto& kv : by_state) {
+		if (kv.first.empty()) continue;
+		if (!first) js << ",";
+		first = false;
+		js << "\"" << json_escape(kv.first) << "\":";
+		write_counters(js, kv.second.data());
+	}
+	js << "}}\n";
+	out = js.str();
+	return true;
+}
+
+} // namespace metrics
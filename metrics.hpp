@@ -0,0 +1,68 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+/**
+ * Счётчики горячих путей движка: X(Id, "json_name").
+ * Всегда включены: одно relaxed-сложение на событие, без блокировок.
+ * allocations/alloc_bytes растут только в сборке с LABYRINTH_ALLOC_ACCOUNTING.
+ */
+#define METRIC_COUNTER_LIST(X) \
+	X(BfsNodes, "bfs_nodes") \
+	X(HospitalCellsScanned, "hospital_cells_scanned") \
+	X(StateBytesRead, "state_bytes_read") \
+	X(StateBytesWritten, "state_bytes_written") \
+	X(ItemsUsed, "items_used") \
+	X(BotTurns, "bot_turns") \
+	X(BotSearchWork, "bot_search_work") \
+	X(BotSearchTimeouts, "bot_search_timeouts") \
+	X(Allocations, "allocations") \
+	X(AllocBytes, "alloc_bytes")
+
+namespace metrics {
+
+enum class Counter {
+#define METRIC_ENUM(id, name) id,
+	METRIC_COUNTER_LIST(METRIC_ENUM)
+#undef METRIC_ENUM
+	Count
+};
+
+constexpr size_t kCounterCount = static_cast<size_t>(Counter::Count);
+/** Корзины латентности: i-я — [2^i, 2^(i+1)) мкс, нулевая включает 0. */
+constexpr size_t kLatencyBuckets = 32;
+
+extern std::atomic<uint64_t> g_counters[kCounterCount];
+
+inline void add(Counter c, uint64_t n = 1) {
+	g_counters[static_cast<size_t>(c)].fetch_add(n, std::memory_order_relaxed);
+}
+inline uint64_t get(Counter c) {
+	return g_counters[static_cast<size_t>(c)].load(std::memory_order_relaxed);
+}
+const char* counter_name(Counter c);
+size_t latency_bucket(uint64_t us);
+
+/**
+ * Отчёт одной команды: конструктор засекает время, деструктор дописывает в path строку JSON
+ * {"cmd","state","pid","ts","latency_us","counters":{...}}. Пустой path — ничего не пишет.
+ */
+class CommandScope {
+public:
+	CommandScope(std::string path, std::string cmd, std::string state);
+	~CommandScope();
+	CommandScope(const CommandScope&) = delete;
+	CommandScope& operator=(const CommandScope&) = delete;
+private:
+	std::string path_, cmd_, state_;
+	long long start_us_{0};
+};
+
+/**
+ * Сводка файла строк CommandScope: по командам — число запусков, сумма/максимум латентности,
+ * log2-гистограмма и суммы счётчиков; по файлам состояния — суммы счётчиков (где «горячие» комнаты).
+ */
+bool aggregate_json(const std::string& path, std::string& out, std::string& err);
+
+} // namespace metrics
@@ -0,0 +1,407 @@
+#include "../engine.hpp"
+#include "../snapshot.hpp"
+#include "../viz.hpp"
+
+#include <node_api.h>
+
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * N-API аддон движка: те же действия, что у CLI (engine.hpp), но внутри процесса node.
+ * Каждый вызов возвращает Promise; загрузка, действие и сохранение идут в пуле потоков libuv,
+ * в главном потоке только сборка JS-объекта. Результат всегда содержит {code, out, err} —
+ * ровно то, что напечатал бы CLI, — плюс структурированные поля конкретного вызова.
+ */
+
+namespace {
+
+/** Задание для пула: execute() без обращений к JS, fill() — в главном потоке. */
+struct Job {
+	virtual ~Job() = default;
+	virtual void execute() = 0;
+	virtual void fill(napi_env /*env*/, napi_value /*obj*/) {}
+
+	napi_async_work work{nullptr};
+	napi_deferred deferred{nullptr};
+	int code{0};
+	std::string out, err;
+
+	void fail(int c, const std::string& e) { code = c; err = e; }
+};
+
+napi_value str(napi_env env, const std::string& s) {
+	napi_value v;
+	napi_create_string_utf8(env, s.data(), s.size(), &v);
+	return v;
+}
+napi_value num(napi_env env, double d) {
+	napi_value v;
+	napi_create_double(env, d, &v);
+	return v;
+}
+napi_value boolean(napi_env env, bool b) {
+	napi_value v;
+	napi_get_boolean(env, b, &v);
+	return v;
+}
+void set(napi_env env, napi_value obj, const char* key, napi_value v) {
+	napi_set_named_property(env, obj, key, v);
+}
+
+/** Событие как объект: {code, recipient?, args, wire}; Int-аргументы — числа, PlayerId — имена. */
+napi_value event_object(napi_env env, const MessageEvent& ev, const std::vector<std::string>& names) {
+	napi_value o, args;
+	napi_create_object(env, &o);
+	set(env, o, "code", str(env, messageCode(ev.code)));
+	if (ev.addressed()) set(env, o, "recipient", str(env, names[ev.recipient]));
+	napi_create_array_with_length(env, ev.argc, &args);
+	for (unsigned char i = 0; i < ev.argc; ++i) {
+		const MessageArg& a = ev.args[i];
+		napi_value v;
+		if (a.kind == MessageArg::Kind::Int) v = num(env, static_cast<double>(a.num));
+		else {
+			std::string s;
+			a.appendTo(s, names);
+			v = str(env, s);
+		}
+		napi_set_element(env, args, i, v);
+	}
+	set(env, o, "args", args);
+	set(env, o, "wire", str(env, ev.wire(names)));
+	return o;
+}
+napi_value event_array(napi_env env, const std::vector<MessageEvent>& evs, const std::vector<std::string>& names) {
+	napi_value arr;
+	napi_create_array_with_length(env, evs.size(), &arr);
+	for (size_t i = 0; i < evs.size(); ++i)
+		napi_set_element(env, arr, static_cast<uint32_t>(i), event_object(env, evs[i], names));
+	return arr;
+}
+
+void execute_cb(napi_env /*env*/, void* data) {
+	static_cast<Job*>(data)->execute();
+}
+void complete_cb(napi_env env, napi_status status, void* data) {
+	std::unique_ptr<Job> job(static_cast<Job*>(data));
+	napi_value obj;
+	napi_create_object(env, &obj);
+	if (status != napi_ok) job->fail(2, "async work cancelled");
+	set(env, obj, "code", num(env, job->code));
+	set(env, obj, "out", str(env, job->out));
+	set(env, obj, "err", str(env, job->err));
+	if (job->code == 0) job->fill(env, obj);
+	napi_resolve_deferred(env, job->deferred, obj);
+	napi_delete_async_work(env, job->work);
+}
+
+napi_value queue(napi_env env, Job* job, const char* name) {
+	napi_value promise, resource_name;
+	napi_create_promise(env, &job->deferred, &promise);
+	napi_create_string_utf8(env, name, NAPI_AUTO_LENGTH, &resource_name);
+	napi_create_async_work(env, nullptr, resource_name, execute_cb, complete_cb, job, &job->work);
+	napi_queue_async_work(env, job->work);
+	return promise;
+}
+
+/** Аргументы вызова; строки и числа читаются по позиции, ошибки типа — исключением JS. */
+struct Args {
+	napi_env env;
+	size_t argc{8};
+	napi_value argv[8];
+	bool ok{true};
+
+	Args(napi_env e, napi_callback_info info) : env(e) {
+		napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr);
+	}
+	std::string string(size_t i, const char* what) {
+		napi_valuetype t = napi_undefined;
+		if (i < argc) napi_typeof(env, argv[i], &t);
+		if (t != napi_string) {
+			if (ok) napi_throw_type_error(env, nullptr, (std::string(what) + " must be a string").c_str());
+			ok = false;
+			return std::string();
+		}
+		size_t len = 0;
+		napi_get_value_string_utf8(env, argv[i], nullptr, 0, &len);
+		std::string s(len, '\0');
+		napi_get_value_string_utf8(env, argv[i], &s[0], len + 1, &len);
+		return s;
+	}
+	bool has(size_t i) {
+		napi_valuetype t = napi_undefined;
+		if (i < argc) napi_typeof(env, argv[i], &t);
+		return t != napi_undefined && t != napi_null;
+	}
+	/** Необязательный флаг: true только для JS true. */
+	bool flag(size_t i) {
+		bool v = false;
+		if (has(i)) napi_get_value_bool(env, argv[i], &v);
+		return v;
+	}
+	/** Числовое поле key объекта i (если есть). */
+	bool number_field(size_t i, const char* key, double& out) {
+		if (!has(i)) return false;
+		bool present = false;
+		napi_has_named_property(env, argv[i], key, &present);
+		if (!present) return false;
+		napi_value v;
+		napi_get_named_property(env, argv[i], key, &v);
+		return napi_get_value_double(env, v, &out) == napi_ok;
+	}
+	bool direction(size_t i, Direction& dir) {
+		const std::string s = string(i, "direction");
+		if (!ok) return false;
+		if (s == "up") dir = Direction::Up;
+		else if (s == "down") dir = Direction::Down;
+		else if (s == "left") dir = Direction::Left;
+		else if (s == "right") dir = Direction::Right;
+		else {
+			napi_throw_range_error(env, nullptr, "direction must be up|down|left|right");
+			ok = false;
+		}
+		return ok;
+	}
+};
+
+struct LoadJob : Job {
+	std::string path;
+	AppState st;
+	void execute() override {
+		if (!AppState::load(st, path, err, LoadMap | LoadGame)) fail(2, err);
+	}
+	void fill(napi_env env, napi_value obj) override {
+		const Game& g = st.game;
+		set(env, obj, "width", num(env, static_cast<double>(st.map.width)));
+		set(env, obj, "height", num(env, static_cast<double>(st.map.height)));
+		set(env, obj, "finished", boolean(env, g.finished));
+		napi_value turn, order;
+		napi_create_object(env, &turn);
+		set(env, turn, "enforce", boolean(env, g.enforce_turns));
+		set(env, turn, "index", num(env, static_cast<double>(g.turn_index)));
+		set(env, turn, "actionsLeft", num(env, g.actions_left));
+		napi_create_array_with_length(env, g.turn_order.size(), &order);
+		for (size_t i = 0; i < g.turn_order.size(); ++i) napi_set_element(env, order, static_cast<uint32_t>(i), str(env, g.turn_order[i]));
+		set(env, turn, "order", order);
+		set(env, obj, "turn", turn);
+		napi_value bot;
+		napi_create_object(env, &bot);
+		set(env, bot, "enabled", boolean(env, g.bot_enabled));
+		set(env, bot, "x", num(env, static_cast<double>(g.bot_x)));
+		set(env, bot, "y", num(env, static_cast<double>(g.bot_y)));
+		set(env, obj, "bot", bot);
+		napi_value players;
+		napi_create_array_with_length(env, g.players.size(), &players);
+		for (PlayerId id = 0; id < g.players.size(); ++id) {
+			napi_value p, items;
+			napi_create_object(env, &p);
+			set(env, p, "name", str(env, g.players.name[id]));
+			set(env, p, "x", num(env, static_cast<double>(g.players.pos[id].first)));
+			set(env, p, "y", num(env, static_cast<double>(g.players.pos[id].second)));
+			set(env, p, "color", str(env, g.players.color[id]));
+			set(env, p, "knifeBroken", boolean(env, g.players.knife_broken[id] != 0));
+			napi_create_object(env, &items);
+			for (const auto& kv : g.players.inventory[id].item_charges) set(env, items, kv.first.c_str(), num(env, kv.second));
+			set(env, p, "items", items);
+			napi_set_element(env, players, id, p);
+		}
+		set(env, obj, "players", players);
+	}
+};
+
+struct ActionJob : Job {
+	std::string path, name, item;
+	ActionKind kind{ActionKind::Move};
+	Direction dir{Direction::Up};
+	ActionResult res;
+	std::vector<std::string> names; // имена по PlayerId для событий: st живёт только в execute
+	void execute() override {
+		AppState st;
+		if (!AppState::load(st, path, err)) { fail(2, err); return; }
+		if (!apply_player_action(st, path, kind, name, dir, item, res, err)) { fail(2, err); return; }
+		names = st.game.players.name;
+		std::ostringstream os;
+		write_user_messages(os, name, res.outcome, names);
+		write_bot_feed(os, res.bot_feed, names);
+		out = os.str();
+		err = res.detail;
+		if (res.bot_cap_reached) err += std::string("\n") + kBotCapMessage;
+	}
+	void fill(napi_env env, napi_value obj) override {
+		set(env, obj, "player", str(env, name));
+		set(env, obj, "events", event_array(env, res.outcome.events, names));
+		set(env, obj, "botFeed", event_array(env, res.bot_feed, names));
+	}
+};
+
+struct ResolveBotsJob : Job {
+	std::string path;
+	std::vector<MessageEvent> feed;
+	std::vector<std::string> names;
+	void execute() override {
+		AppState st;
+		if (!AppState::load(st, path, err)) { fail(2, err); return; }
+		bool settled = true;
+		if (!resolve_bots(st, path, feed, settled, err)) { fail(2, err); return; }
+		if (!settled) err = kBotCapMessage;
+		names = st.game.players.name;
+		std::ostringstream os;
+		write_bot_feed(os, feed, names);
+		out = os.str();
+	}
+	void fill(napi_env env, napi_value obj) override {
+		set(env, obj, "botFeed", event_array(env, feed, names));
+	}
+};
+
+struct UndoJob : Job {
+	std::string path;
+	size_t steps{1};
+	size_t done{0}, left{0};
+	void execute() override {
+		AppState st;
+		if (!AppState::load(st, path, err)) { fail(2, err); return; }
+		if (!undo_and_save(st, path, steps, done, err)) { fail(2, err); return; }
+		if (done == 0) { fail(3, "Журнал отката пуст"); return; }
+		left = journal_depth(st.journal);
+		out = "Отменено шагов: " + std::to_string(done) + " (осталось в журнале: " + std::to_string(left) + ")\n";
+	}
+	void fill(napi_env env, napi_value obj) override {
+		set(env, obj, "undone", num(env, static_cast<double>(done)));
+		set(env, obj, "left", num(env, static_cast<double>(left)));
+	}
+};
+
+struct PlayerStatusJob : Job {
+	std::string path, name;
+	bool snapshot{false};
+	void execute() override {
+		if (snapshot) {
+			RoomSnapshot snap;
+			if (!read_snapshot(path, snap, err)) { fail(4, err); return; }
+			const PlayerView* v = snap.find(name);
+			if (!v) { fail(3, "Игрок не найден"); return; }
+			player_status_json(*v, out);
+			out += "\n";
+			return;
+		}
+		AppState st;
+		if (!AppState::load(st, path, err, LoadMap | LoadGame)) { fail(2, err); return; }
+		if (!player_status_json(st, name, out)) { fail(3, "Игрок не найден"); return; }
+		out += "\n";
+	}
+};
+
+struct ExportSvgJob : Job {
+	std::string path, out_path;
+	float cell{32.0f}, margin{16.0f};
+	std::string svg;
+	void execute() override {
+		AppState st;
+		if (!AppState::load(st, path, err)) { fail(2, err); return; }
+		svg = render_svg(st, cell, margin);
+		if (out_path.empty()) return;
+		std::ofstream f(out_path);
+		if (!f) { fail(2, "Не могу записать SVG"); return; }
+		f << svg;
+		err = "SVG сохранён: " + out_path;
+		svg.clear();
+	}
+	void fill(napi_env env, napi_value obj) override {
+		if (out_path.empty()) set(env, obj, "svg", str(env, svg));
+	}
+};
+
+/** load(statePath) → {code, out, err, width, height, finished, turn, bot, players} */
+napi_value Load(napi_env env, napi_callback_info info) {
+	Args a(env, info);
+	auto job = std::make_unique<LoadJob>();
+	job->path = a.string(0, "statePath");
+	if (!a.ok) return nullptr;
+	return queue(env, job.release(), "labyrinth.load");
+}
+
+napi_value queue_action(napi_env env, napi_callback_info info, ActionKind kind) {
+	Args a(env, info);
+	auto job = std::make_unique<ActionJob>();
+	job->kind = kind;
+	job->path = a.string(0, "statePath");
+	job->name = a.string(1, "name");
+	size_t dir_at = 2;
+	if (kind == ActionKind::UseItem) { job->item = a.string(2, "item"); dir_at = 3; }
+	if (!a.ok || !a.direction(dir_at, job->dir)) return nullptr;
+	return queue(env, job.release(), "labyrinth.action");
+}
+/** move / attack (statePath, name, dir), useItem(statePath, name, item, dir) → {…, player, events, botFeed} */
+napi_value Move(napi_env env, napi_callback_info info) { return queue_action(env, info, ActionKind::Move); }
+napi_value Attack(napi_env env, napi_callback_info info) { return queue_action(env, info, ActionKind::Attack); }
+napi_value UseItem(napi_env env, napi_callback_info info) { return queue_action(env, info, ActionKind::UseItem); }
+
+/** resolveBots(statePath) → {…, botFeed} */
+napi_value ResolveBots(napi_env env, napi_callback_info info) {
+	Args a(env, info);
+	auto job = std::make_unique<ResolveBotsJob>();
+	job->path = a.string(0, "statePath");
+	if (!a.ok) return nullptr;
+	return queue(env, job.release(), "labyrinth.resolveBots");
+}
+
+/** undo(statePath, steps = 1) → {…, undone, left} */
+napi_value Undo(napi_env env, napi_callback_info info) {
+	Args a(env, info);
+	auto job = std::make_unique<UndoJob>();
+	job->path = a.string(0, "statePath");
+	if (!a.ok) return nullptr;
+	double v = 1;
+	if (a.has(1) && napi_get_value_double(env, a.argv[1], &v) != napi_ok) {
+		napi_throw_type_error(env, nullptr, "steps must be a number");
+		return nullptr;
+	}
+	job->steps = v < 1 ? 1 : static_cast<size_t>(v);
+	return queue(env, job.release(), "labyrinth.undo");
+}
+
+/** playerStatus(statePath, name, fromSnapshot?) → {code, out: JSON player-status, err}; снимка нет — code 4 */
+napi_value PlayerStatus(napi_env env, napi_callback_info info) {
+	Args a(env, info);
+	auto job = std::make_unique<PlayerStatusJob>();
+	job->path = a.string(0, "statePath");
+	job->name = a.string(1, "name");
+	if (!a.ok) return nullptr;
+	job->snapshot = a.flag(2);
+	return queue(env, job.release(), "labyrinth.playerStatus");
+}
+
+/** exportSvg(statePath, outPath|null, {cell, margin}?) → {…, svg} (svg — только без outPath) */
+napi_value ExportSvg(napi_env env, napi_callback_info info) {
+	Args a(env, info);
+	auto job = std::make_unique<ExportSvgJob>();
+	job->path = a.string(0, "statePath");
+	if (a.ok && a.has(1)) job->out_path = a.string(1, "outPath");
+	if (!a.ok) return nullptr;
+	double v = 0;
+	if (a.number_field(2, "cell", v)) job->cell = static_cast<float>(v);
+	job->margin = job->cell * 0.5f;
+	if (a.number_field(2, "margin", v)) job->margin = static_cast<float>(v);
+	return queue(env, job.release(), "labyrinth.exportSvg");
+}
+
+} // namespace
+
+NAPI_MODULE_INIT() {
+	const napi_property_descriptor props[] = {
+		{"load", nullptr, Load, nullptr, nullptr, nullptr, napi_enumerable, nullptr},
+		{"move", nullptr, Move, nullptr, nullptr, nullptr, napi_enumerable, nullptr},
+		{"attack", nullptr, Attack, nullptr, nullptr, nullptr, napi_enumerable, nullptr},
+		{"useItem", nullptr, UseItem, nullptr, nullptr, nullptr, napi_enumerable, nullptr},
+		{"resolveBots", nullptr, ResolveBots, nullptr, nullptr, nullptr, napi_enumerable, nullptr},
+		{"undo", nullptr, Undo, nullptr, nullptr, nullptr, napi_enumerable, nullptr},
+		{"playerStatus", nullptr, PlayerStatus, nullptr, nullptr, nullptr, napi_enumerable, nullptr},
+		{"exportSvg", nullptr, ExportSvg, nullptr, nullptr, nullptr, napi_enumerable, nullptr},
+	};
+	napi_define_properties(env, exports, sizeof(props) / sizeof(props[0]), props);
+	return exports;
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include "items.hpp"
+#include "undo.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/** Плотный дескриптор игрока — индекс в параллельных массивах PlayerTable. */
+using PlayerId = uint32_t;
+constexpr PlayerId kNoPlayer = UINT32_MAX;
+
+/**
+ * Игроки как struct-of-arrays: id выдаётся при первом добавлении и больше не меняется,
+ * имя → id разрешается только на границе (CLI, wire, файл состояния).
+ * Обход — `for (PlayerId id = 0; id < size(); ++id)`, в порядке добавления.
+ * Поля читаются напрямую, а пишутся через set_pos, set_knife_broken, set_color и edit_inventory — их видит журнал отката
+ * (undo.hpp); напрямую пишут только загрузка состояния и сам откат.
+ */
+struct PlayerTable {
+	std::vector<std::string> name;
+	std::vector<std::pair<size_t,size_t>> pos;
+	std::vector<uint8_t> knife_broken;
+	std::vector<std::string> color; // "" — цвет ещё не назначен
+	std::vector<Inventory> inventory;
+
+	size_t size() const { return name.size(); }
+	bool empty() const { return name.empty(); }
+	void clear() {
+		name.clear(); pos.clear(); knife_broken.clear(); color.clear(); inventory.clear();
+		ids.clear();
+	}
+	/** id по имени; kNoPlayer — такого игрока нет. */
+	PlayerId find(const std::string& n) const {
+		auto it = ids.find(n);
+		return it == ids.end() ? kNoPlayer : it->second;
+	}
+	bool contains(const std::string& n) const { return ids.count(n) > 0; }
+	/** id игрока n; нового добавляет в конец с позицией at. */
+	PlayerId intern(const std::string& n, std::pair<size_t,size_t> at = {0, 0}) {
+		auto [it, added] = ids.emplace(n, static_cast<PlayerId>(name.size()));
+		if (added) {
+			name.push_back(n);
+			pos.push_back(at);
+			knife_broken.push_back(0);
+			color.emplace_back();
+			inventory.emplace_back();
+		}
+		return it->second;
+	}
+	void set_pos(PlayerId id, std::pair<size_t,size_t> p) { undo::player(*this, id); pos[id] = p; }
+	void set_knife_broken(PlayerId id, bool broken) { undo::player(*this, id); knife_broken[id] = broken ? 1 : 0; }
+	void set_color(PlayerId id, const std::string& c) { undo::player(*this, id); color[id] = c; }
+	/** Инвентарь для записи; ссылка живёт до следующего добавления игрока. */
+	Inventory& edit_inventory(PlayerId id) { undo::player(*this, id); return inventory[id]; }
+	/** Оставить первых n игроков (откат добавления); id оставшихся не меняются. */
+	void truncate(size_t n) {
+		for (size_t id = n; id < name.size(); ++id) ids.erase(name[id]);
+		if (n >= name.size()) return;
+		name.resize(n); pos.resize(n); knife_broken.resize(n); color.resize(n); inventory.resize(n);
+	}
+	/** Первый по id игрок на клетке (x,y), кроме skip; kNoPlayer — никого. */
+	PlayerId at(size_t x, size_t y, PlayerId skip = kNoPlayer) const {
+		for (PlayerId id = 0; id < pos.size(); ++id)
+			if (id != skip && pos[id].first == x && pos[id].second == y) return id;
+		return kNoPlayer;
+	}
+
+private:
+	std::unordered_map<std::string, PlayerId> ids;
+};
@@ -0,0 +1,42 @@
+#include "raycast.hpp"
+#include "game.hpp"
+
+#include <algorithm>
+
+std::pair<size_t,size_t> ray_cell(size_t x, size_t y, Direction dir, size_t dist) {
+	switch (dir) {
+		case Direction::Left:  return {x - dist, y};
+		case Direction::Right: return {x + dist, y};
+		case Direction::Up:    return {x, y - dist};
+		case Direction::Down:  return {x, y + dist};
+	}
+	return {x, y};
+}
+
+// Расстояние от (x, y) до (px, py) вдоль dir; 0 — не на луче.
+static size_t along_ray(size_t x, size_t y, size_t px, size_t py, Direction dir) {
+	switch (dir) {
+		case Direction::Left:  return (py == y && px < x) ? x - px : 0;
+		case Direction::Right: return (py == y && px > x) ? px - x : 0;
+		case Direction::Up:    return (px == x && py < y) ? y - py : 0;
+		case Direction::Down:  return (px == x && py > y) ? py - y : 0;
+	}
+	return 0;
+}
+
+RayCast cast_ray(const Game& game, const LabyrinthMap& map, size_t x, size_t y, Direction dir, size_t max_range,
+                 PlayerId exclude) {
+	RayCast ray;
+	ray.span = std::min(map.run_length(x, y, dir), max_range);
+	if (ray.span == 0) return ray;
+	const auto& pos = game.players.pos;
+	for (PlayerId id = 0; id < pos.size(); ++id) {
+		if (id == exclude) continue;
+		const size_t d = along_ray(x, y, pos[id].first, pos[id].second, dir);
+		if (d == 0 || d > ray.span) continue;
+		ray.occupants.push_back(RayOccupant{d, id});
+	}
+	std::stable_sort(ray.occupants.begin(), ray.occupants.end(),
+	                 [](const RayOccupant& a, const RayOccupant& b) { return a.dist < b.dist; });
+	return ray;
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include "map.hpp"
+#include "players.hpp"
+
+#include <vector>
+
+struct Game;
+
+/** Игрок на линии луча: расстояние в шагах (1..span) и id. */
+struct RayOccupant {
+	size_t dist{0};
+	PlayerId id{kNoPlayer};
+};
+
+/**
+ * Результат луча из клетки стрелка: span — сколько клеток пройдено до стены или предела дальности,
+ * occupants — игроки на этих клетках по возрастанию dist (внутри клетки — по возрастанию id).
+ */
+struct RayCast {
+	size_t span{0};
+	std::vector<RayOccupant> occupants;
+};
+
+/** Клетка на расстоянии dist от (x, y) в сторону dir (без проверки стен). */
+std::pair<size_t,size_t> ray_cell(size_t x, size_t y, Direction dir, size_t dist);
+
+/**
+ * Общий кернел для стрелкового оружия и фонаря: длина коридора берётся из индекса карты (O(1)),
+ * игроки раскладываются по дистанции за один проход. Стрелок exclude в occupants не попадает.
+ */
+RayCast cast_ray(const Game& game, const LabyrinthMap& map, size_t x, size_t y, Direction dir, size_t max_range,
+                 PlayerId exclude);
@@ -0,0 +1,201 @@
+#include "snapshot.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <sched.h>
+#include <sstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr char kMagic[8] = {'L', 'A', 'B', 'S', 'N', 'A', 'P', '1'};
+constexpr int kReadAttempts = 4096;
+
+/** Заголовок файла; данные текущей версии — сразу за ним. */
+struct Header {
+	char magic[8];
+	uint64_t seq;      // нечётный — идёт запись
+	uint64_t capacity; // байт под данные (размер файла минус заголовок)
+	uint64_t size;     // длина данных текущей версии
+};
+
+/** Отображение файла целиком; munmap в деструкторе. */
+struct Mapping {
+	void* addr{MAP_FAILED};
+	size_t len{0};
+	~Mapping() { reset(); }
+	void reset() {
+		if (addr != MAP_FAILED) ::munmap(addr, len);
+		addr = MAP_FAILED;
+		len = 0;
+	}
+	bool map(int fd, size_t n, int prot) {
+		reset();
+		addr = ::mmap(nullptr, n, prot, MAP_SHARED, fd, 0);
+		if (addr == MAP_FAILED) return false;
+		len = n;
+		return true;
+	}
+	Header* header() const { return static_cast<Header*>(addr); }
+	char* data() const { return static_cast<char*>(addr) + sizeof(Header); }
+};
+
+/** Отпечаток файла состояния: снимок верен, пока файл тот же — его не подменили и не переписали в обход save. */
+struct FileStamp {
+	uint64_t ino{0}, size{0}, mtime_ns{0};
+	bool operator==(const FileStamp& o) const { return ino == o.ino && size == o.size && mtime_ns == o.mtime_ns; }
+};
+
+bool stamp_of(const std::string& path, FileStamp& out) {
+	struct stat sb;
+	if (::stat(path.c_str(), &sb) != 0) return false;
+	out.ino = static_cast<uint64_t>(sb.st_ino);
+	out.size = static_cast<uint64_t>(sb.st_size);
+	out.mtime_ns = static_cast<uint64_t>(sb.st_mtim.tv_sec) * 1000000000ull + static_cast<uint64_t>(sb.st_mtim.tv_nsec);
+	return true;
+}
+
+std::string encode(const AppState& st, const TurnInfo& ti, const FileStamp& stamp) {
+	std::ostringstream os;
+	os << "VERSION " << ti.version << "\n";
+	os << "FILE " << stamp.ino << " " << stamp.size << " " << stamp.mtime_ns << "\n";
+	os << "FINISHED " << (ti.finished ? 1 : 0) << "\n";
+	os << "TURNS " << (ti.enforce ? 1 : 0) << " " << ti.index << " " << ti.order.size() << "\n";
+	for (const auto& n : ti.order) os << n << "\n";
+	os << "PLAYERS " << st.game.players.size() << "\n";
+	for (PlayerId id = 0; id < st.game.players.size(); ++id) {
+		const PlayerView v = player_view(st, id);
+		os << v.name << " " << v.x << " " << v.y << " " << (v.knife_broken ? 1 : 0) << " " << (v.breathing ? 1 : 0)
+		   << " " << v.items.size();
+		for (const auto& kv : v.items) os << " " << kv.first << " " << kv.second;
+		os << "\n";
+	}
+	return os.str();
+}
+
+bool decode(const std::string& text, RoomSnapshot& out, FileStamp& stamp, std::string& err) {
+	std::istringstream is(text);
+	std::string token;
+	int fin = 0, enf = 0;
+	size_t cnt = 0;
+	TurnInfo& ti = out.turn;
+	if (!(is >> token >> ti.version) || token != "VERSION") { err = "Снимок: ожидался VERSION"; return false; }
+	if (!(is >> token >> stamp.ino >> stamp.size >> stamp.mtime_ns) || token != "FILE") { err = "Снимок: ожидался FILE"; return false; }
+	if (!(is >> token >> fin) || token != "FINISHED") { err = "Снимок: ожидался FINISHED"; return false; }
+	if (!(is >> token >> enf >> ti.index >> cnt) || token != "TURNS") { err = "Снимок: ожидался TURNS"; return false; }
+	ti.finished = fin != 0;
+	ti.enforce = enf != 0;
+	ti.order.resize(cnt);
+	for (auto& n : ti.order)
+		if (!(is >> n)) { err = "Снимок: некорректный TURNS"; return false; }
+	if (!ti.order.empty()) ti.current = ti.order[ti.index % ti.order.size()];
+	if (!(is >> token >> cnt) || token != "PLAYERS") { err = "Снимок: ожидался PLAYERS"; return false; }
+	out.players.resize(cnt);
+	for (auto& v : out.players) {
+		int broken = 0, breathing = 0;
+		size_t k = 0;
+		if (!(is >> v.name >> v.x >> v.y >> broken >> breathing >> k)) { err = "Снимок: некорректный игрок"; return false; }
+		v.knife_broken = broken != 0;
+		v.breathing = breathing != 0;
+		v.items.resize(k);
+		for (auto& kv : v.items)
+			if (!(is >> kv.first >> kv.second)) { err = "Снимок: некорректный инвентарь"; return false; }
+		ti.players.push_back(v.name);
+	}
+	return true;
+}
+
+} // namespace
+
+const PlayerView* RoomSnapshot::find(const std::string& name) const {
+	for (const auto& v : players)
+		if (v.name == name) return &v;
+	return nullptr;
+}
+
+std::string snapshot_path(const std::string& state_path) {
+	return state_path + ".shm";
+}
+
+bool publish_snapshot(const AppState& st, const TurnInfo& ti, const std::string& state_path, std::string& err) {
+	LAB_TRACE_SCOPE("snapshot.publish");
+	FileStamp stamp;
+	if (!stamp_of(state_path, stamp)) { err = "Не могу прочитать файл состояния для снимка"; return false; }
+	const std::string payload = encode(st, ti, stamp);
+	const int fd = ::open(snapshot_path(state_path).c_str(), O_RDWR | O_CREAT, 0644);
+	if (fd < 0) { err = "Не могу открыть файл снимка"; return false; }
+	struct stat sb;
+	if (::fstat(fd, &sb) != 0) { ::close(fd); err = "Не могу прочитать размер файла снимка"; return false; }
+	size_t len = static_cast<size_t>(sb.st_size);
+	if (len < sizeof(Header) + payload.size()) {
+		// рост с запасом: читатели со старым отображением видят capacity больше своего и переотображают
+		size_t cap = len > sizeof(Header) ? len - sizeof(Header) : 0;
+		cap = std::max<size_t>({cap * 2, payload.size(), 4096 - sizeof(Header)});
+		len = sizeof(Header) + cap;
+		if (::ftruncate(fd, static_cast<off_t>(len)) != 0) { ::close(fd); err = "Не могу увеличить файл снимка"; return false; }
+	}
+	Mapping m;
+	const bool mapped = m.map(fd, len, PROT_READ | PROT_WRITE);
+	::close(fd);
+	if (!mapped) { err = "Не могу отобразить файл снимка"; return false; }
+	Header* h = m.header();
+	if (std::memcmp(h->magic, kMagic, sizeof(kMagic)) != 0) {
+		h->seq = 0;
+		std::memcpy(h->magic, kMagic, sizeof(kMagic));
+	}
+	// нечётный счётчик от упавшего писателя перескакиваем на следующий нечётный
+	const uint64_t prev = __atomic_load_n(&h->seq, __ATOMIC_RELAXED);
+	const uint64_t odd = (prev & 1) ? prev + 2 : prev + 1;
+	__atomic_store_n(&h->seq, odd, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	__atomic_store_n(&h->capacity, static_cast<uint64_t>(len - sizeof(Header)), __ATOMIC_RELAXED);
+	__atomic_store_n(&h->size, static_cast<uint64_t>(payload.size()), __ATOMIC_RELAXED);
+	std::memcpy(m.data(), payload.data(), payload.size());
+	__atomic_store_n(&h->seq, odd + 1, __ATOMIC_RELEASE);
+	return true;
+}
+
+bool read_snapshot(const std::string& state_path, RoomSnapshot& out, std::string& err) {
+	const int fd = ::open(snapshot_path(state_path).c_str(), O_RDONLY);
+	if (fd < 0) { err = "Нет снимка комнаты"; return false; }
+	Mapping m;
+	std::string buf;
+	uint64_t seq = 0;
+	bool ok = false;
+	for (int attempt = 0; attempt < kReadAttempts && !ok; ++attempt) {
+		if (attempt >= 16) ::sched_yield();
+		if (m.len == 0) {
+			struct stat sb;
+			if (::fstat(fd, &sb) != 0 || static_cast<size_t>(sb.st_size) < sizeof(Header)) break;
+			if (!m.map(fd, static_cast<size_t>(sb.st_size), PROT_READ)) break;
+			if (std::memcmp(m.header()->magic, kMagic, sizeof(kMagic)) != 0) break;
+		}
+		const Header* h = m.header();
+		seq = __atomic_load_n(&h->seq, __ATOMIC_ACQUIRE);
+		if (seq == 0) break;
+		if (seq & 1) continue;
+		const uint64_t size = __atomic_load_n(&h->size, __ATOMIC_RELAXED);
+		if (sizeof(Header) + size > m.len) {
+			m.reset(); // файл вырос после нашего mmap
+			continue;
+		}
+		buf.assign(m.data(), static_cast<size_t>(size));
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		ok = __atomic_load_n(&h->seq, __ATOMIC_RELAXED) == seq;
+	}
+	::close(fd);
+	if (!ok) { err = "Снимок комнаты недоступен"; return false; }
+	RoomSnapshot snap;
+	snap.seq = seq;
+	FileStamp stamp, now;
+	if (!decode(buf, snap, stamp, err)) return false;
+	if (!stamp_of(state_path, now) || !(now == stamp)) { err = "Снимок комнаты устарел: файл состояния изменён"; return false; }
+	out = std::move(snap);
+	return true;
+}
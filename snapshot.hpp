@@ -0,0 +1,29 @@
+#pragma once
+#include "engine.hpp"
+#include "state.hpp"
+
+#include <string>
+#include <vector>
+
+/**
+ * Снимок комнаты для читателей в разделяемой памяти: `<state>.shm`, отображается mmap.
+ * Пишет его AppState::save (после сайдкара .turn), читают player-status и turn-info без
+ * очереди комнаты. Защита — seqlock: писатель делает счётчик нечётным, пишет данные и делает
+ * чётным; читатель копирует данные и повторяет, если счётчик изменился или был нечётным.
+ * Писатель никого не ждёт, читателей сколько угодно. Файл только растёт.
+ * В снимке — отпечаток файла состояния (inode, размер, mtime): если файл с тех пор подменили
+ * или переписали без save, снимок считается отсутствующим.
+ */
+struct RoomSnapshot {
+	unsigned long long seq{0}; // чётный счётчик seqlock: растёт на 2 с каждой публикацией
+	TurnInfo turn;
+	std::vector<PlayerView> players;
+
+	const PlayerView* find(const std::string& name) const;
+};
+
+std::string snapshot_path(const std::string& state_path);
+/** Опубликовать снимок; ti — то, что только что записано в сайдкар (та же версия). */
+bool publish_snapshot(const AppState& st, const TurnInfo& ti, const std::string& state_path, std::string& err);
+/** Согласованная копия последнего снимка; false — снимка нет, он устарел или писатель не отпускает его слишком долго. */
+bool read_snapshot(const std::string& state_path, RoomSnapshot& out, std::string& err);
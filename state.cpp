@@ -1,6 +1,13 @@
 #include "state.hpp"
+#include "snapshot.hpp"
+#include "metrics.hpp"
 #include "rng.hpp"
+#include "alloc.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <cstdio>
 #include <fstream>
+#include <limits>
 #include <sstream>
 #include <random>
 #include <unordered_map>
@@ -42,15 +49,33 @@ static CellContent from_cell_char(char c) {
 		default: return CellContent::Empty;
 	}
 }
+static size_t count_colored(const PlayerTable& pl) {
+	return static_cast<size_t>(std::count_if(pl.color.begin(), pl.color.end(), [](const std::string& c) { return !c.empty(); }));
+}
+// Записи ITEMS для имён не из PLAYERS — сироты старых сохранений, пропускаем.
+static Inventory* inventory_of(PlayerTable& pl, const std::string& name) {
+	const PlayerId id = pl.find(name);
+	return id == kNoPlayer ? nullptr : &pl.inventory[id];
+}
 
 bool AppState::save(const AppState& st, const std::string& path, std::string& err) {
+	LAB_TRACE_SCOPE("save");
+	LAB_ALLOC_SCOPE("save");
 	std::ofstream f(path);
 	if (!f) { err = "Не могу открыть файл для записи"; return false; }
-	// ensure base exists
-	AppState copy = st;
-	if (copy.base_map.width == 0 || copy.base_map.height == 0) {
-		copy.set_base_from_current();
-	}
+	if (!save(st, f, err)) return false;
+	metrics::add(metrics::Counter::StateBytesWritten, static_cast<uint64_t>(std::max<std::streamoff>(0, f.tellp())));
+	f.close();
+	TurnInfo ti;
+	if (!write_turn_sidecar(st, path, err, &ti)) return false;
+	return publish_snapshot(st, ti, path, err);
+}
+
+bool AppState::save(const AppState& st, std::ostream& f, std::string& err) {
+	// base пишется из общего снимка (или из текущего состояния, если базы нет) — без копии AppState
+	const bool own_base = st.base && st.base->map.width != 0 && st.base->map.height != 0;
+	const LabyrinthMap& base_map = own_base ? st.base->map : st.map;
+	const Game& base_game = own_base ? st.base->game : st.game;
 	f << st.map.width << " " << st.map.height << "\n";
 	f << "VWALLS\n";
 	for (size_t y = 0; y < st.map.height; ++y) {
@@ -85,10 +110,10 @@ bool AppState::save(const AppState& st, const std::string& path, std::string& er
 	// RNG state
 	f << "RNG " << st.random_seed << " " << st.random_nonce << "\n";
 	f << "PLAYERS " << st.game.players.size() << "\n";
-	for (const auto& kv : st.game.players) {
-		int has_t = player_has_treasure(st.game, kv.first) ? 1 : 0;
-		int broken = st.game.broken_knife.count(kv.first) ? 1 : 0;
-		f << kv.first << " " << kv.second.first << " " << kv.second.second << " " << has_t << " " << broken << "\n";
+	const PlayerTable& pl = st.game.players;
+	for (PlayerId id = 0; id < pl.size(); ++id) {
+		int has_t = player_has_treasure(st.game, id) ? 1 : 0;
+		f << pl.name[id] << " " << pl.pos[id].first << " " << pl.pos[id].second << " " << has_t << " " << int(pl.knife_broken[id]) << "\n";
 	}
 	// Turns
 	f << "TURNS " << (st.game.enforce_turns ? 1 : 0) << " " << st.game.turn_index << " " << st.game.turn_order.size() << "\n";
@@ -98,18 +123,20 @@ bool AppState::save(const AppState& st, const std::string& path, std::string& er
 	f << "ACTIONS " << st.game.actions_per_turn << " " << st.game.actions_left << "\n";
 	// Bot
 	f << "BOT " << (st.game.bot_enabled?1:0) << " " << st.game.bot_x << " " << st.game.bot_y << " " << st.game.bot_steps_per_turn << "\n";
+	if (st.game.bot_search_depth > 0)
+		f << "BOTSEARCH " << st.game.bot_search_depth << " " << st.game.bot_search_budget_us << "\n";
 	// per-player item charges
 	size_t total_items = 0;
-	for (const auto& pkv : st.game.inventories) total_items += pkv.second.item_charges.size();
+	for (const auto& inv : pl.inventory) total_items += inv.item_charges.size();
 	f << "ITEMS " << total_items << "\n";
-	for (const auto& pkv : st.game.inventories) {
-		for (const auto& iv : pkv.second.item_charges) {
-			f << pkv.first << " " << iv.first << " " << iv.second << "\n";
+	for (PlayerId id = 0; id < pl.size(); ++id) {
+		for (const auto& iv : pl.inventory[id].item_charges) {
+			f << pl.name[id] << " " << iv.first << " " << iv.second << "\n";
 		}
 	}
-	f << "PCOLORS " << st.game.player_color.size() << "\n";
-	for (const auto& kv : st.game.player_color) {
-		f << kv.first << " " << kv.second << "\n";
+	f << "PCOLORS " << count_colored(pl) << "\n";
+	for (PlayerId id = 0; id < pl.size(); ++id) {
+		if (!pl.color[id].empty()) f << pl.name[id] << " " << pl.color[id] << "\n";
 	}
 	f << "LOOT_T " << st.game.loot_treasure.size() << "\n";
 	for (const auto& kv : st.game.loot_treasure) {
@@ -131,85 +158,88 @@ bool AppState::save(const AppState& st, const std::string& path, std::string& er
 			}
 		}
 	}
-	f << "LOG " << st.log.size() << "\n";
+	// LOG n bytes: длина тела в байтах — чтобы загрузчик мог перескочить лог без разбора
+	std::ostringstream lg;
 	for (const auto& e : st.log) {
 		switch (e.type) {
 			case LogType::Move:
-				f << "MOVE " << e.name << " " << dir_to_cstr(e.dir) << "\n"; break;
+				lg << "MOVE " << e.name << " " << dir_to_cstr(e.dir) << "\n"; break;
 			case LogType::Attack:
-				f << "ATTACK " << e.name << " " << dir_to_cstr(e.dir) << "\n"; break;
+				lg << "ATTACK " << e.name << " " << dir_to_cstr(e.dir) << "\n"; break;
 			case LogType::UseItem:
-				f << "USE " << e.name << " " << e.item << " " << dir_to_cstr(e.dir) << "\n"; break;
+				lg << "USE " << e.name << " " << e.item << " " << dir_to_cstr(e.dir) << "\n"; break;
 			case LogType::AddPlayer:
-				f << "ADD " << e.name << " " << e.x << " " << e.y << "\n"; break;
+				lg << "ADD " << e.name << " " << e.x << " " << e.y << "\n"; break;
 			case LogType::AddPlayerRandom:
-				f << "ADDR " << e.name << " " << e.x << " " << e.y << "\n"; break;
+				lg << "ADDR " << e.name << " " << e.x << " " << e.y << "\n"; break;
 			case LogType::BotMove:
-				f << "BOTMOVE " << e.x << " " << e.y << "\n"; break;
+				lg << "BOTMOVE " << e.x << " " << e.y << "\n"; break;
 			case LogType::BotKill:
-				f << "BOTKILL " << e.name << "\n"; break;
+				lg << "BOTKILL " << e.name << "\n"; break;
 		}
 	}
+	const std::string log_body = lg.str();
+	f << "LOG " << st.log.size() << " " << log_body.size() << "\n" << log_body;
 	f << "FINISHED " << (st.game.finished ? 1 : 0) << "\n";
 	// BASE block appended at end (always present)
 		f << "BASE\n";
-		f << "BWH " << copy.base_map.width << " " << copy.base_map.height << "\n";
+		f << "BWH " << base_map.width << " " << base_map.height << "\n";
 		f << "BVWALLS\n";
-		for (size_t y = 0; y < copy.base_map.height; ++y) {
-			for (size_t x = 0; x <= copy.base_map.width; ++x) {
-				f << (copy.base_map.v_walls[y][x] ? '1' : '0');
-				if (x < copy.base_map.width) f << " ";
+		for (size_t y = 0; y < base_map.height; ++y) {
+			for (size_t x = 0; x <= base_map.width; ++x) {
+				f << (base_map.v_walls[y][x] ? '1' : '0');
+				if (x < base_map.width) f << " ";
 			}
 			f << "\n";
 		}
 		f << "BHWALLS\n";
-		for (size_t y = 0; y <= copy.base_map.height; ++y) {
-			for (size_t x = 0; x < copy.base_map.width; ++x) {
-				f << (copy.base_map.h_walls[y][x] ? '1' : '0');
-				if (x + 1 < copy.base_map.width) f << " ";
+		for (size_t y = 0; y <= base_map.height; ++y) {
+			for (size_t x = 0; x < base_map.width; ++x) {
+				f << (base_map.h_walls[y][x] ? '1' : '0');
+				if (x + 1 < base_map.width) f << " ";
 			}
 			f << "\n";
 		}
 		f << "BCELLS\n";
-		for (size_t y = 0; y < copy.base_map.height; ++y) {
-			for (size_t x = 0; x < copy.base_map.width; ++x) {
-				f << cell_char(copy.base_map.get_cell(x, y));
-				if (x + 1 < copy.base_map.width) f << " ";
+		for (size_t y = 0; y < base_map.height; ++y) {
+			for (size_t x = 0; x < base_map.width; ++x) {
+				f << cell_char(base_map.get_cell(x, y));
+				if (x + 1 < base_map.width) f << " ";
 			}
 			f << "\n";
 		}
 		f << "BEXIT ";
-		if (copy.base_map.has_exit) {
-			f << (copy.base_map.exit_vertical ? "V " : "H ") << copy.base_map.exit_y << " " << copy.base_map.exit_x << "\n";
+		if (base_map.has_exit) {
+			f << (base_map.exit_vertical ? "V " : "H ") << base_map.exit_y << " " << base_map.exit_x << "\n";
 		} else {
 			f << "NONE\n";
 		}
-		f << "BPLAYERS " << copy.base_game.players.size() << "\n";
-		for (const auto& kv : copy.base_game.players) {
-			int has_t = player_has_treasure(copy.base_game, kv.first) ? 1 : 0;
-			int broken = copy.base_game.broken_knife.count(kv.first) ? 1 : 0;
-			f << kv.first << " " << kv.second.first << " " << kv.second.second << " " << has_t << " " << broken << "\n";
+		const PlayerTable& bpl = base_game.players;
+		f << "BPLAYERS " << bpl.size() << "\n";
+		for (PlayerId id = 0; id < bpl.size(); ++id) {
+			int has_t = player_has_treasure(base_game, id) ? 1 : 0;
+			f << bpl.name[id] << " " << bpl.pos[id].first << " " << bpl.pos[id].second << " " << has_t << " " << int(bpl.knife_broken[id]) << "\n";
 		}
-		f << "BTURNS " << (copy.base_game.enforce_turns ? 1 : 0) << " " << copy.base_game.turn_index << " " << copy.base_game.turn_order.size() << "\n";
-		for (const auto& n : copy.base_game.turn_order) f << n << "\n";
-		f << "BTURNRNG " << copy.base_game.turn_rng_state << "\n";
-		f << "BACTIONS " << copy.base_game.actions_per_turn << " " << copy.base_game.actions_left << "\n";
-		f << "BBOT " << (copy.base_game.bot_enabled?1:0) << " " << copy.base_game.bot_x << " " << copy.base_game.bot_y << " " << copy.base_game.bot_steps_per_turn << "\n";
-		f << "BPCOLORS " << copy.base_game.player_color.size() << "\n";
-		for (const auto& kv : copy.base_game.player_color) {
-			f << kv.first << " " << kv.second << "\n";
+		f << "BTURNS " << (base_game.enforce_turns ? 1 : 0) << " " << base_game.turn_index << " " << base_game.turn_order.size() << "\n";
+		for (const auto& n : base_game.turn_order) f << n << "\n";
+		f << "BTURNRNG " << base_game.turn_rng_state << "\n";
+		f << "BACTIONS " << base_game.actions_per_turn << " " << base_game.actions_left << "\n";
+		f << "BBOT " << (base_game.bot_enabled?1:0) << " " << base_game.bot_x << " " << base_game.bot_y << " " << base_game.bot_steps_per_turn << "\n";
+		f << "BPCOLORS " << count_colored(bpl) << "\n";
+		for (PlayerId id = 0; id < bpl.size(); ++id) {
+			if (!bpl.color[id].empty()) f << bpl.name[id] << " " << bpl.color[id] << "\n";
 		}
 		// base per-player items
 		size_t b_total_items = 0;
-		for (const auto& pkv : copy.base_game.inventories) b_total_items += pkv.second.item_charges.size();
+		for (const auto& inv : bpl.inventory) b_total_items += inv.item_charges.size();
 		f << "BITEMS " << b_total_items << "\n";
-		for (const auto& pkv : copy.base_game.inventories) {
-			for (const auto& iv : pkv.second.item_charges) {
-				f << pkv.first << " " << iv.first << " " << iv.second << "\n";
+		for (PlayerId id = 0; id < bpl.size(); ++id) {
+			for (const auto& iv : bpl.inventory[id].item_charges) {
+				f << bpl.name[id] << " " << iv.first << " " << iv.second << "\n";
 			}
 		}
-		f << "BLOOT_T " << copy.base_game.loot_treasure.size() << "\n";
-		for (const auto& kv : copy.base_game.loot_treasure) {
+		f << "BLOOT_T " << base_game.loot_treasure.size() << "\n";
+		for (const auto& kv : base_game.loot_treasure) {
 			long long key = kv.first; int c = kv.second;
 			size_t y = (size_t)(key / 1000000LL);
 			size_t x = (size_t)(key % 1000000LL);
@@ -217,9 +247,9 @@ bool AppState::save(const AppState& st, const std::string& path, std::string& er
 		}
 		// base ground items
 		{
-			size_t bgi = 0; for (const auto& kv : copy.base_game.ground_items) bgi += kv.second.size();
+			size_t bgi = 0; for (const auto& kv : base_game.ground_items) bgi += kv.second.size();
 			f << "BLOOT_I " << bgi << "\n";
-			for (const auto& kv : copy.base_game.ground_items) {
+			for (const auto& kv : base_game.ground_items) {
 				size_t y = (size_t)(kv.first / 1000000LL);
 				size_t x = (size_t)(kv.first % 1000000LL);
 				for (const auto& iv : kv.second) {
@@ -228,38 +258,142 @@ bool AppState::save(const AppState& st, const std::string& path, std::string& er
 			}
 		}
 		f << "BASE_END\n";
+	if (st.event_seq) f << "EVSEQ " << st.event_seq << "\n";
+	write_journal(f, st.journal);
+	if (!f) { err = "Ошибка записи состояния"; return false; }
 	return true;
 }
 
-bool AppState::load(AppState& st, const std::string& path, std::string& err) {
-	std::ifstream f(path);
-	if (!f) { err = "Не могу открыть файл для чтения"; return false; }
-	size_t w, h;
-	if (!(f >> w >> h)) { err = "Некорректный заголовок"; return false; }
-	st.map = LabyrinthMap(w, h);
+std::string turn_sidecar_path(const std::string& state_path) {
+	return state_path + ".turn";
+}
+
+TurnInfo turn_info_from(const AppState& st) {
+	TurnInfo ti;
+	ti.finished = st.game.finished;
+	ti.enforce = st.game.enforce_turns;
+	ti.order = st.game.turn_order;
+	// как parseTurnInfo во фронтенде: индекс по модулю длины очереди
+	ti.index = ti.order.empty() ? 0 : st.game.turn_index % ti.order.size();
+	if (!ti.order.empty()) ti.current = ti.order[ti.index];
+	ti.players = st.game.players.name;
+	return ti;
+}
+
+bool write_turn_sidecar(const AppState& st, const std::string& state_path, std::string& err, TurnInfo* written) {
+	const std::string path = turn_sidecar_path(state_path);
+	TurnInfo ti = turn_info_from(st);
+	TurnInfo prev;
+	std::string ignored;
+	if (read_turn_sidecar(state_path, prev, ignored)) ti.version = prev.version + 1;
+	const std::string tmp = path + ".tmp";
+	{
+		std::ofstream f(tmp);
+		if (!f) { err = "Не могу открыть файл очереди для записи"; return false; }
+		f << "TURNINFO 1\n";
+		f << "VERSION " << ti.version << "\n";
+		f << "FINISHED " << (ti.finished ? 1 : 0) << "\n";
+		f << "TURNS " << (ti.enforce ? 1 : 0) << " " << ti.index << " " << ti.order.size() << "\n";
+		for (const auto& n : ti.order) f << n << "\n";
+		f << "PLAYERS " << ti.players.size() << "\n";
+		for (const auto& n : ti.players) f << n << "\n";
+		if (!f) { err = "Ошибка записи файла очереди"; return false; }
+	}
+	if (std::rename(tmp.c_str(), path.c_str()) != 0) { err = "Не могу заменить файл очереди"; return false; }
+	if (written) *written = std::move(ti);
+	return true;
+}
+
+bool read_turn_sidecar(const std::string& state_path, TurnInfo& out, std::string& err) {
+	std::ifstream f(turn_sidecar_path(state_path));
+	if (!f) { err = "Нет файла очереди"; return false; }
+	std::string token;
+	int fmt = 0;
+	if (!(f >> token >> fmt) || token != "TURNINFO" || fmt != 1) { err = "Некорректный заголовок файла очереди"; return false; }
+	TurnInfo ti;
+	int fin = 0, enf = 0;
+	size_t cnt = 0;
+	if (!(f >> token >> ti.version) || token != "VERSION") { err = "Ожидался VERSION"; return false; }
+	if (!(f >> token >> fin) || token != "FINISHED") { err = "Ожидался FINISHED"; return false; }
+	if (!(f >> token >> enf >> ti.index >> cnt) || token != "TURNS") { err = "Ожидался TURNS"; return false; }
+	ti.finished = fin != 0;
+	ti.enforce = enf != 0;
+	for (size_t i = 0; i < cnt; ++i) { std::string n; if (!(f >> n)) { err = "Некорректный TURNS"; return false; } ti.order.push_back(n); }
+	if (!(f >> token >> cnt) || token != "PLAYERS") { err = "Ожидался PLAYERS"; return false; }
+	for (size_t i = 0; i < cnt; ++i) { std::string n; if (!(f >> n)) { err = "Некорректный PLAYERS"; return false; } ti.players.push_back(n); }
+	if (!ti.order.empty()) ti.current = ti.order[ti.index % ti.order.size()];
+	out = std::move(ti);
+	return true;
+}
+
+// Размер секций VWALLS/HWALLS/CELLS в том виде, как их пишет save (для перескока без разбора).
+static std::streamoff map_sections_bytes(size_t w, size_t h) {
+	const std::streamoff W = static_cast<std::streamoff>(w), H = static_cast<std::streamoff>(h);
+	return 7 + H * (2 * W + 2) + 7 + (H + 1) * (2 * W) + 6 + H * (2 * W);
+}
+
+static bool read_map_sections(std::istream& f, LabyrinthMap& m, size_t w, size_t h, std::string& err) {
 	std::string token;
+	m = LabyrinthMap(w, h);
 	if (!(f >> token) || token != "VWALLS") { err = "Ожидался VWALLS"; return false; }
 	for (size_t y = 0; y < h; ++y) {
 		for (size_t x = 0; x <= w; ++x) {
 			char c; f >> c;
-			st.map.v_walls[y][x] = (c == '1');
+			m.set_vwall(y, x, c == '1');
 		}
 	}
 	if (!(f >> token) || token != "HWALLS") { err = "Ожидался HWALLS"; return false; }
 	for (size_t y = 0; y <= h; ++y) {
 		for (size_t x = 0; x < w; ++x) {
 			char c; f >> c;
-			st.map.h_walls[y][x] = (c == '1');
+			m.set_hwall(y, x, c == '1');
 		}
 	}
 	if (!(f >> token) || token != "CELLS") { err = "Ожидался CELLS"; return false; }
 	for (size_t y = 0; y < h; ++y) {
 		for (size_t x = 0; x < w; ++x) {
 			std::string s; f >> s;
-			st.map.set_cell(x, y, s.empty() ? CellContent::Empty : from_cell_char(s[0]));
+			m.set_cell(x, y, s.empty() ? CellContent::Empty : from_cell_char(s[0]));
 		}
 	}
-	if (!(f >> token) || token != "EXIT") { err = "Ожидался EXIT"; return false; }
+	return true;
+}
+
+bool AppState::load(AppState& st, const std::string& path, std::string& err, unsigned sections) {
+	LAB_TRACE_SCOPE("load");
+	LAB_ALLOC_SCOPE("load");
+	std::ifstream f(path);
+	if (!f) { err = "Не могу открыть файл для чтения"; return false; }
+	f.seekg(0, std::ios::end);
+	metrics::add(metrics::Counter::StateBytesRead, static_cast<uint64_t>(std::max<std::streamoff>(0, f.tellg())));
+	f.seekg(0, std::ios::beg);
+	return load(st, f, err, sections);
+}
+
+bool AppState::load(AppState& st, std::istream& f, std::string& err, unsigned sections) {
+	trace::Span section("load.map");
+	size_t w, h;
+	if (!(f >> w >> h)) { err = "Некорректный заголовок"; return false; }
+	std::string token;
+	bool map_skipped = false;
+	if (!(sections & LoadMap) && w > 0) {
+		// перескок по известной длине; если формат не тот (ручная правка) — разбираем как обычно
+		f.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+		const std::streampos at = f.tellg();
+		f.seekg(map_sections_bytes(w, h), std::ios::cur);
+		std::string probe;
+		if (f >> probe && probe == "EXIT") {
+			map_skipped = true;
+			st.map = LabyrinthMap();
+		} else {
+			f.clear();
+			f.seekg(at);
+		}
+	}
+	if (!map_skipped) {
+		if (!read_map_sections(f, st.map, w, h, err)) return false;
+		if (!(f >> token) || token != "EXIT") { err = "Ожидался EXIT"; return false; }
+	}
 	std::string ex;
 	if (!(f >> ex)) { err = "Некорректный EXIT"; return false; }
 	if (ex == "NONE") {
@@ -269,6 +403,16 @@ bool AppState::load(AppState& st, const std::string& path, std::string& err) {
 		if (ex == "V") st.map.exit_vertical = true; else if (ex == "H") st.map.exit_vertical = false; else { err = "Некорректный тип EXIT"; return false; }
 		if (!(f >> st.map.exit_y >> st.map.exit_x)) { err = "Некорректные координаты EXIT"; return false; }
 	}
+	section.end();
+	if (!(sections & (LoadGame | LoadLog | LoadBase))) {
+		// дальше только игра, лог и база — не читаем их вовсе
+		st.game = Game{};
+		st.log.clear();
+		st.base.reset();
+		st.journal.reset();
+		return true;
+	}
+	trace::Span game_section("load.game");
 	// Optional RNG
 	if (!(f >> token)) { err = "Ожидался PLAYERS или RNG"; return false; }
 	if (token == "RNG") {
@@ -290,22 +434,22 @@ bool AppState::load(AppState& st, const std::string& path, std::string& err) {
 		st.game.turn_rng_state = game_rng::initial_turn_rng_state(st.random_seed);
 	}
 	/** Флаг has_t из старых сохранений; после ITEMS мигрируем в charges предмета `treasure`. */
-	std::unordered_map<std::string, bool> legacy_player_treasure;
-	std::unordered_map<std::string, bool> legacy_base_treasure;
+	std::vector<PlayerId> legacy_player_treasure;
+	std::vector<PlayerId> legacy_base_treasure;
 	size_t nplayers = 0;
 	if (token != "PLAYERS") { err = "Ожидался PLAYERS"; return false; }
 	if (!(f >> nplayers)) { err = "Некорректное число игроков"; return false; }
+	// Инвентари и цвета очищаются вместе с таблицей — до optional-секций и миграции legacy has_t.
 	st.game.players.clear();
-	st.game.broken_knife.clear();
 	for (size_t i = 0; i < nplayers; ++i) {
 		std::string name; size_t px, py; int has_t; int broken = 0;
 		f >> name >> px >> py >> has_t >> broken;
-		st.game.players[name] = {px, py};
-		legacy_player_treasure[name] = (has_t != 0);
-		if (broken) st.game.broken_knife.insert(name);
+		const PlayerId id = st.game.players.intern(name);
+		st.game.players.pos[id] = {px, py};
+		if (has_t) legacy_player_treasure.push_back(id);
+		st.game.players.knife_broken[id] = broken != 0;
 	}
-	// Очистить инвентари перед разбором optional-секций и миграцией legacy has_t.
-	st.game.inventories.clear();
+	st.map.sync_players(st.game.players);
 	// Optional turns/actions/items/colors sections
 	if (!(f >> token)) { err = "Ожидался FINISHED или PCOLORS/ITEMS"; return false; }
 	if (token == "TURNS") {
@@ -337,26 +481,31 @@ bool AppState::load(AppState& st, const std::string& path, std::string& err) {
 		st.game.bot_x = bx; st.game.bot_y = by; st.game.bot_steps_per_turn = steps;
 		if (!(f >> token)) { err = "Ожидался FINISHED или PCOLORS/ITEMS"; return false; }
 	}
+	st.game.bot_search_depth = 0;
+	if (token == "BOTSEARCH") {
+		if (!(f >> st.game.bot_search_depth >> st.game.bot_search_budget_us)) { err = "Некорректный BOTSEARCH"; return false; }
+		if (!(f >> token)) { err = "Ожидался FINISHED или PCOLORS/ITEMS"; return false; }
+	}
 	if (token == "ITEMS") {
 		size_t k = 0; if (!(f >> k)) { err = "Некорректный ITEMS"; return false; }
-		st.game.inventories.clear();
+		for (auto& inv : st.game.players.inventory) inv = Inventory{};
 		for (size_t i = 0; i < k; ++i) {
 			std::string pname, item; int c; f >> pname >> item >> c;
-			st.game.inventories[pname].setCharges(item, c);
+			if (Inventory* inv = inventory_of(st.game.players, pname)) inv->setCharges(item, c);
 		}
 		if (!(f >> token)) { err = "Ожидался FINISHED или PCOLORS/LOOT_T"; return false; }
 	}
-	for (const auto& kv : legacy_player_treasure) {
-		if (!kv.second) continue;
-		auto& inv = st.game.inventories[kv.first];
+	for (PlayerId id : legacy_player_treasure) {
+		auto& inv = st.game.players.inventory[id];
 		if (inv.getCharges("treasure") <= 0) inv.setCharges("treasure", 1);
 	}
 	if (token == "PCOLORS") {
 		size_t m = 0; if (!(f >> m)) { err = "Некорректный PCOLORS"; return false; }
-		st.game.player_color.clear();
+		for (auto& c : st.game.players.color) c.clear();
 		for (size_t i = 0; i < m; ++i) {
 			std::string name, color; f >> name >> color;
-			st.game.player_color[name] = color;
+			const PlayerId id = st.game.players.find(name);
+			if (id != kNoPlayer) st.game.players.color[id] = color;
 		}
 		if (!(f >> token)) { err = "Ожидался FINISHED или LOOT_T"; return false; }
 	}
@@ -382,9 +531,21 @@ bool AppState::load(AppState& st, const std::string& path, std::string& err) {
 		}
 		if (!(f >> token)) { err = "Ожидался FINISHED или LOG"; return false; }
 	}
+	game_section.end();
+	trace::Span log_section("load.log");
 	if (token == "LOG") {
 		size_t n = 0; if (!(f >> n)) { err = "Некорректный LOG"; return false; }
+		// необязательная длина тела в байтах (старые файлы — только n)
+		std::string rest;
+		std::getline(f, rest);
+		std::istringstream rs(rest);
+		long long log_bytes = -1;
+		if (!(rs >> log_bytes)) log_bytes = -1;
 		st.log.clear();
+		if (!(sections & LoadLog) && log_bytes >= 0) {
+			f.seekg(log_bytes, std::ios::cur);
+			n = 0;
+		}
 		for (size_t i = 0; i < n; ++i) {
 			std::string kind; f >> kind;
 			if (kind == "MOVE" || kind == "ATTACK") {
@@ -411,10 +572,19 @@ bool AppState::load(AppState& st, const std::string& path, std::string& err) {
 				err = "Неизвестная запись лога"; return false;
 			}
 		}
+		if (!(sections & LoadLog)) st.log.clear();
 		if (!(f >> token)) { err = "Ожидался FINISHED"; return false; }
 	}
 	if (token != "FINISHED") { err = "Ожидался FINISHED"; return false; }
 	int fin; f >> fin; st.game.finished = (fin != 0);
+	log_section.end();
+	if (!(sections & LoadBase)) {
+		st.base.reset();
+		st.journal.reset();
+		st.game.canonicalize_turn_order();
+		return true;
+	}
+	trace::Span base_section("load.base");
 	// BASE block after FINISHED (if none, base = current)
 	std::string t2;
 	if (f >> t2) {
@@ -423,98 +593,114 @@ bool AppState::load(AppState& st, const std::string& path, std::string& err) {
 			size_t bw = 0, bh = 0;
 			if (!(f >> btoken) || btoken != "BWH") { err = "Ожидался BWH"; return false; }
 			if (!(f >> bw >> bh)) { err = "Некорректный BWH"; return false; }
-			st.base_map = LabyrinthMap(bw, bh);
+			auto snap = std::make_shared<BaseSnapshot>();
+			LabyrinthMap& base_map = snap->map;
+			Game& base_game = snap->game;
+			base_map = LabyrinthMap(bw, bh);
 			if (!(f >> btoken) || btoken != "BVWALLS") { err = "Ожидался BVWALLS"; return false; }
-			for (size_t y = 0; y < bh; ++y) for (size_t x = 0; x <= bw; ++x) { char c; f >> c; st.base_map.v_walls[y][x] = (c=='1'); }
+			for (size_t y = 0; y < bh; ++y) for (size_t x = 0; x <= bw; ++x) { char c; f >> c; base_map.set_vwall(y, x, c=='1'); }
 			if (!(f >> btoken) || btoken != "BHWALLS") { err = "Ожидался BHWALLS"; return false; }
-			for (size_t y = 0; y <= bh; ++y) for (size_t x = 0; x < bw; ++x) { char c; f >> c; st.base_map.h_walls[y][x] = (c=='1'); }
+			for (size_t y = 0; y <= bh; ++y) for (size_t x = 0; x < bw; ++x) { char c; f >> c; base_map.set_hwall(y, x, c=='1'); }
 			if (!(f >> btoken) || btoken != "BCELLS") { err = "Ожидался BCELLS"; return false; }
-			for (size_t y = 0; y < bh; ++y) for (size_t x = 0; x < bw; ++x) { std::string s; f >> s; st.base_map.set_cell(x, y, s.empty()?CellContent::Empty:from_cell_char(s[0])); }
+			for (size_t y = 0; y < bh; ++y) for (size_t x = 0; x < bw; ++x) { std::string s; f >> s; base_map.set_cell(x, y, s.empty()?CellContent::Empty:from_cell_char(s[0])); }
 			if (!(f >> btoken) || btoken != "BEXIT") { err = "Ожидался BEXIT"; return false; }
 			std::string bex; if (!(f >> bex)) { err = "Некорректный BEXIT"; return false; }
-			if (bex == "NONE") { st.base_map.has_exit = false; }
-			else { st.base_map.has_exit = true; st.base_map.exit_vertical = (bex=="V"); if (!(f >> st.base_map.exit_y >> st.base_map.exit_x)) { err = "Некорректные BEXIT координаты"; return false; } }
+			if (bex == "NONE") { base_map.has_exit = false; }
+			else { base_map.has_exit = true; base_map.exit_vertical = (bex=="V"); if (!(f >> base_map.exit_y >> base_map.exit_x)) { err = "Некорректные BEXIT координаты"; return false; } }
 			size_t bn = 0;
 			if (!(f >> btoken) || btoken != "BPLAYERS") { err = "Ожидался BPLAYERS"; return false; }
 			if (!(f >> bn)) { err = "Некорректный BPLAYERS"; return false; }
-			st.base_game = Game{};
 			for (size_t i = 0; i < bn; ++i) {
 				std::string name; size_t px, py; int ht, br;
 				f >> name >> px >> py >> ht >> br;
-				st.base_game.players[name] = {px, py};
-				legacy_base_treasure[name] = (ht != 0);
-				if (br) st.base_game.broken_knife.insert(name);
+				const PlayerId id = base_game.players.intern(name);
+				base_game.players.pos[id] = {px, py};
+				if (ht) legacy_base_treasure.push_back(id);
+				base_game.players.knife_broken[id] = br != 0;
 			}
+			base_map.sync_players(base_game.players);
 			if (!(f >> btoken)) { err = "Ожидался BTURNS или BPCOLORS"; return false; }
 			if (btoken == "BTURNS") {
 				int enf=0; size_t idx=0, cnt=0; if (!(f >> enf >> idx >> cnt)) { err = "Некорректный BTURNS"; return false; }
-				st.base_game.enforce_turns = (enf!=0);
-				st.base_game.turn_index = idx;
-				st.base_game.turn_rng_state = game_rng::initial_turn_rng_state(st.random_seed);
-				for (size_t i=0;i<cnt;++i) { std::string n; f >> n; st.base_game.turn_order.push_back(n); }
+				base_game.enforce_turns = (enf!=0);
+				base_game.turn_index = idx;
+				base_game.turn_rng_state = game_rng::initial_turn_rng_state(st.random_seed);
+				for (size_t i=0;i<cnt;++i) { std::string n; f >> n; base_game.turn_order.push_back(n); }
 				if (!(f >> btoken)) { err = "Ожидался BTURNRNG или BACTIONS или BPCOLORS"; return false; }
 				if (btoken == "BTURNRNG") {
 					unsigned long long btr = 0;
 					if (!(f >> btr)) { err = "Некорректный BTURNRNG"; return false; }
-					st.base_game.turn_rng_state = btr;
+					base_game.turn_rng_state = btr;
 					if (!(f >> btoken)) { err = "Ожидался BACTIONS или BPCOLORS"; return false; }
 				}
 			}
 			if (btoken == "BACTIONS") {
 				int per=1, left=1; if (!(f >> per >> left)) { err = "Некорректный BACTIONS"; return false; }
-				st.base_game.actions_per_turn = per;
-				st.base_game.actions_left = left;
+				base_game.actions_per_turn = per;
+				base_game.actions_left = left;
 				if (!(f >> btoken)) { err = "Ожидался BBOT или BPCOLORS"; return false; }
 			}
 			if (btoken == "BBOT") {
 				int en=0; size_t bx=0, by=0; int steps=1;
 				if (!(f >> en >> bx >> by >> steps)) { err = "Некорректный BBOT"; return false; }
-				st.base_game.bot_enabled = (en!=0);
-				st.base_game.bot_x = bx; st.base_game.bot_y = by; st.base_game.bot_steps_per_turn = steps;
+				base_game.bot_enabled = (en!=0);
+				base_game.bot_x = bx; base_game.bot_y = by; base_game.bot_steps_per_turn = steps;
 				if (!(f >> btoken)) { err = "Ожидался BPCOLORS"; return false; }
 			}
 			size_t bm=0;
 			if (btoken != "BPCOLORS") { err = "Ожидался BPCOLORS"; return false; }
 			if (!(f >> bm)) { err = "Некорректный BPCOLORS"; return false; }
-			for (size_t i = 0; i < bm; ++i) { std::string name, color; f >> name >> color; st.base_game.player_color[name]=color; }
+			for (size_t i = 0; i < bm; ++i) {
+				std::string name, color; f >> name >> color;
+				const PlayerId id = base_game.players.find(name);
+				if (id != kNoPlayer) base_game.players.color[id] = color;
+			}
 			// optional base items
 			if (!(f >> btoken)) { err = "Ожидался BITEMS или BLOOT_T"; return false; }
 			if (btoken == "BITEMS") {
 				size_t bi=0; if (!(f >> bi)) { err = "Некорректный BITEMS"; return false; }
 				for (size_t i = 0; i < bi; ++i) {
-					std::string pname, item; int c; f >> pname >> item >> c; st.base_game.inventories[pname].setCharges(item, c);
+					std::string pname, item; int c; f >> pname >> item >> c;
+					if (Inventory* inv = inventory_of(base_game.players, pname)) inv->setCharges(item, c);
 				}
 				if (!(f >> btoken)) { err = "Ожидался BLOOT_T"; return false; }
 			}
-			for (const auto& kv : legacy_base_treasure) {
-				if (!kv.second) continue;
-				auto& inv = st.base_game.inventories[kv.first];
+			for (PlayerId id : legacy_base_treasure) {
+				auto& inv = base_game.players.inventory[id];
 				if (inv.getCharges("treasure") <= 0) inv.setCharges("treasure", 1);
 			}
 			size_t bk=0;
 			if (btoken != "BLOOT_T") { err = "Ожидался BLOOT_T"; return false; }
 			if (!(f >> bk)) { err = "Некорректный BLOOT_T"; return false; }
-			for (size_t i = 0; i < bk; ++i) { size_t x,y; int c; f >> x >> y >> c; long long key=(long long)y*1000000LL+(long long)x; st.base_game.loot_treasure[key]=c; }
+			for (size_t i = 0; i < bk; ++i) { size_t x,y; int c; f >> x >> y >> c; long long key=(long long)y*1000000LL+(long long)x; base_game.loot_treasure[key]=c; }
 			if (!(f >> btoken)) { err = "Ожидался BLOOT_I или BASE_END"; return false; }
 			if (btoken == "BLOOT_I") {
 				size_t bi=0; if (!(f >> bi)) { err = "Некорректный BLOOT_I"; return false; }
 				for (size_t i = 0; i < bi; ++i) {
 					size_t x,y; std::string item; int c; f >> x >> y >> item >> c;
-					long long key=(long long)y*1000000LL+(long long)x; st.base_game.ground_items[key][item]=c;
+					long long key=(long long)y*1000000LL+(long long)x; base_game.ground_items[key][item]=c;
 				}
 				if (!(f >> btoken)) { err = "Ожидался BASE_END"; return false; }
 			}
 			if (btoken != "BASE_END") { err = "Ожидался BASE_END"; return false; }
+			st.base = std::move(snap);
 		} else {
 			// token read but not BASE: ignore and set base = current
-			st.base_map = st.map;
-			st.base_game = st.game;
+			st.set_base_from_current();
 		}
 	} else {
 		// no token: set base = current
-		st.base_map = st.map;
-		st.base_game = st.game;
+		st.set_base_from_current();
+	}
+	// Счётчик ленты и журнал отката после BASE_END (старые файлы — без них)
+	std::string t3;
+	st.journal.reset();
+	st.event_seq = 0;
+	if (f >> t3 && t3 == "EVSEQ") {
+		if (!(f >> st.event_seq)) { err = "Некорректный EVSEQ"; return false; }
+		if (!(f >> t3)) t3.clear();
 	}
+	if (t3 == "UNDO" && !read_journal(f, st.journal, err)) return false;
 	// Очередь всегда [игроки…, bot]; иначе в файле могло остаться [bot, игрок] → в UI «всегда ходит бот»
 	st.game.canonicalize_turn_order();
 	return true;
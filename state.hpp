@@ -1,6 +1,10 @@
 #pragma once
 #include "map.hpp"
 #include "game.hpp"
+#include "journal.hpp"
+#include "events.hpp"
+#include <iosfwd>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -13,22 +17,74 @@ struct LogEntry {
 	std::string item;             // for UseItem
 };
 
+/**
+ * Секции файла состояния для AppState::load. Команды только для чтения поднимают то, что печатают:
+ * пропущенная карта остаётся пустой (0×0), игра — пустой Game, лог — пустым, база — nullptr
+ * (base_map() = текущая). Журнал отката читается вместе с базой. Секция игры идёт в файле перед
+ * логом и базой, поэтому без LoadGame чтение кончается на EXIT только если не нужны и они.
+ * Сохранять состояние, загруженное не целиком, нельзя.
+ */
+enum LoadSection : unsigned {
+	LoadMap = 1u << 0,  // стены и клетки (EXIT читается всегда)
+	LoadGame = 1u << 1, // RNG, игроки, очередь, инвентари, лут
+	LoadLog = 1u << 2,
+	LoadBase = 1u << 3,
+	LoadAll = LoadMap | LoadGame | LoadLog | LoadBase,
+};
+
+/** Базовое состояние (начало партии) для replay: неизменяемый снимок, общий для копий AppState. */
+struct BaseSnapshot {
+	LabyrinthMap map;
+	Game game;
+};
+
 struct AppState {
 	LabyrinthMap map;
 	Game game;
 	std::vector<LogEntry> log;
-	LabyrinthMap base_map;
-	Game base_game;
+	/** Копирование AppState делит снимок; замена — только целиком (set_base_from_current). nullptr — база = текущее. */
+	std::shared_ptr<const BaseSnapshot> base;
+	/** Журнал отката (секция UNDO); копия AppState делит его — ветки «что если» дёшевы. */
+	UndoJournal journal;
 	// RNG state: seed is set once at generate; nonce increments on each random draw
 	unsigned int random_seed{0};
 	unsigned long long random_nonce{0};
+	/** Последний выданный seq ленты событий (секция EVSEQ, только у комнат с лентой); откат его не трогает. */
+	unsigned long long event_seq{0};
+	/** Лента текущей команды (feed_attach); в файл состояния не попадает. */
+	EventFeed feed;
 
 	static bool save(const AppState& st, const std::string& path, std::string& err);
-	static bool load(AppState& st, const std::string& path, std::string& err);
+	static bool load(AppState& st, const std::string& path, std::string& err, unsigned sections = LoadAll);
+	/** То же без файла (сайдкар .turn не пишется): состояние в памяти, например у labyrinth_scenarios. */
+	static bool save(const AppState& st, std::ostream& os, std::string& err);
+	static bool load(AppState& st, std::istream& is, std::string& err, unsigned sections = LoadAll);
+	const LabyrinthMap& base_map() const { return base ? base->map : map; }
+	const Game& base_game() const { return base ? base->game : game; }
 	void set_base_from_current() {
-		base_map = map;
-		base_game = game;
+		base = std::make_shared<const BaseSnapshot>(BaseSnapshot{map, game});
 	}
 };
 
 
+
+/**
+ * Сайдкар `<state>.turn` — крошечный снимок очереди для веба: текущий ход, очередь, ростер,
+ * finished и счётчик версий. Пишется атомарно (tmp + rename) при каждом AppState::save,
+ * следом — снимок комнаты `<state>.shm` (snapshot.hpp) с той же версией.
+ */
+struct TurnInfo {
+	unsigned long long version{0};
+	bool finished{false};
+	bool enforce{false};
+	size_t index{0};
+	std::string current; // "" — очереди нет
+	std::vector<std::string> order;
+	std::vector<std::string> players; // в порядке секции PLAYERS
+};
+
+std::string turn_sidecar_path(const std::string& state_path);
+TurnInfo turn_info_from(const AppState& st);
+/** written — записанный снимок очереди (с новой версией), для снимка комнаты. */
+bool write_turn_sidecar(const AppState& st, const std::string& state_path, std::string& err, TurnInfo* written = nullptr);
+bool read_turn_sidecar(const std::string& state_path, TurnInfo& out, std::string& err);
@@ -0,0 +1,124 @@
+#include "../arena.hpp"
+#include "../board256.hpp"
+#include "../flood.hpp"
+#include "../generator.hpp"
+#include "../map.hpp"
+#include "../metrics.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * labyrinth_board256_check — Board256 против общего flood::Grid на всех размерах до 16×16:
+ * лабиринты генератора (с проёмами openness) и карты со случайными стенами (несколько компонент).
+ * Сверяются число компонент, BFS-расстояния от клеток-источников и счётчик bfs_nodes; расстояния —
+ * ещё и с наивным BFS по can_move_*.
+ *
+ *   labyrinth_board256_check
+ *
+ * Код выхода: 0 — всё совпало, 1 — есть расхождения (первые печатаются).
+ */
+
+namespace {
+
+/** Эталон: BFS очередью по can_move_*, без битовых строк. */
+std::vector<uint32_t> naive_distances(const LabyrinthMap& m, size_t sx, size_t sy) {
+	std::vector<uint32_t> dist(m.width * m.height, flood::kUnreached);
+	std::vector<size_t> queue{sy * m.width + sx};
+	dist[queue[0]] = 0;
+	for (size_t head = 0; head < queue.size(); ++head) {
+		const size_t x = queue[head] % m.width, y = queue[head] / m.width;
+		const uint32_t d = dist[queue[head]] + 1;
+		auto relax = [&](bool open, size_t i) {
+			if (open && dist[i] == flood::kUnreached) { dist[i] = d; queue.push_back(i); }
+		};
+		relax(m.can_move_left(x, y), queue[head] - 1);
+		relax(m.can_move_right(x, y), queue[head] + 1);
+		relax(m.can_move_up(x, y), queue[head] - m.width);
+		relax(m.can_move_down(x, y), queue[head] + m.width);
+	}
+	return dist;
+}
+
+/** Все стены стоят, каждая внутренняя открыта с вероятностью open. */
+LabyrinthMap random_walls(size_t w, size_t h, double open, std::mt19937& rng) {
+	LabyrinthMap m(w, h);
+	std::bernoulli_distribution coin(open);
+	for (size_t y = 0; y < h; ++y)
+		for (size_t x = 1; x < w; ++x)
+			if (coin(rng)) m.set_vwall(y, x, false);
+	for (size_t y = 1; y < h; ++y)
+		for (size_t x = 0; x < w; ++x)
+			if (coin(rng)) m.set_hwall(y, x, false);
+	return m;
+}
+
+struct Checker {
+	size_t maps{0}, failures{0};
+
+	void fail(const std::string& where, const std::string& what) {
+		if (++failures <= 20) std::cout << "FAIL " << where << ": " << what << "\n";
+	}
+
+	void check(const LabyrinthMap& m, const std::string& where) {
+		++maps;
+		arena::Scope scratch;
+		const Board256 board(m);
+		const flood::Grid grid(m);
+
+		size_t board_nodes = 0;
+		const size_t board_comps = board.count_components(board_nodes);
+		const uint64_t before = metrics::get(metrics::Counter::BfsNodes);
+		const size_t grid_comps = flood::count_components(grid);
+		const uint64_t grid_nodes = metrics::get(metrics::Counter::BfsNodes) - before;
+		if (board_comps != grid_comps)
+			fail(where, "компонент " + std::to_string(board_comps) + " против " + std::to_string(grid_comps));
+		if (board_nodes != grid_nodes)
+			fail(where, "bfs_nodes компонент " + std::to_string(board_nodes) + " против " + std::to_string(grid_nodes));
+
+		// до 17 источников на карту: через равный шаг и последняя клетка
+		const size_t cells = m.width * m.height;
+		std::vector<size_t> sources;
+		for (size_t i = 0; i < cells; i += std::max<size_t>(1, cells / 16)) sources.push_back(i);
+		if (sources.back() != cells - 1) sources.push_back(cells - 1);
+		for (size_t i : sources) {
+			const size_t sx = i % m.width, sy = i / m.width;
+			const auto b = flood::distances(board, sx, sy);
+			const auto g = flood::distances(grid, sx, sy);
+			const auto n = naive_distances(m, sx, sy);
+			const bool board_ok = std::equal(b.begin(), b.end(), g.begin(), g.end());
+			const bool grid_ok = std::equal(g.begin(), g.end(), n.begin(), n.end());
+			if (board_ok && grid_ok) continue;
+			const std::string from = where + " от (" + std::to_string(sx) + "," + std::to_string(sy) + ")";
+			if (!board_ok) fail(from, "расстояния Board256 и Grid разные");
+			if (!grid_ok) fail(from, "расстояния Grid и наивного BFS разные");
+		}
+	}
+};
+
+} // namespace
+
+int main() {
+	Checker c;
+	std::mt19937 rng(20240517);
+	for (size_t h = 1; h <= Board256::kSide; ++h) {
+		for (size_t w = 1; w <= Board256::kSide; ++w) {
+			const std::string size = std::to_string(w) + "x" + std::to_string(h);
+			for (unsigned seed = 1; seed <= 2; ++seed) {
+				set_rng_seed(seed * 1000 + static_cast<unsigned>(w * 16 + h));
+				LabyrinthMap maze(w, h);
+				carve_maze(maze);
+				remove_extra_walls(maze, seed == 1 ? 0.0f : 0.4f);
+				c.check(maze, "лабиринт " + size + " seed " + std::to_string(seed));
+			}
+			for (double open : {0.2, 0.5, 0.8})
+				c.check(random_walls(w, h, open, rng), "стены " + size + " open " + std::to_string(open));
+		}
+	}
+	std::cout << c.maps << " карт, расхождений: " << c.failures << "\n";
+	return c.failures == 0 ? 0 : 1;
+}
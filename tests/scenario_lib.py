@@ -15,6 +15,8 @@ from pathlib import Path
 from typing import Any
 
 SCENARIO_FILE = "scenario.json"
+# Сайдкары, которые движок пишет рядом с состоянием при каждом save.
+STATE_SIDECARS = (".turn", ".shm")
 
 
 def repo_root() -> Path:
@@ -123,6 +125,10 @@ def build_setup_argv(state_path: str, action: dict[str, Any]) -> list[str]:
             args += ["--turn-actions", str(int(action["turn_actions"]))]
         if action.get("bot_steps"):
             args += ["--bot-steps", str(int(action["bot_steps"]))]
+            if action.get("bot_search"):
+                args += ["--bot-search", str(int(action["bot_search"]))]
+            if "bot_budget_us" in action:
+                args += ["--bot-budget-us", str(int(action["bot_budget_us"]))]
         return args
     if t == "add-player":
         return [
@@ -412,8 +418,14 @@ def run_scenario(lab: Path, scenario_dir: Path, *, canonize: bool = False) -> di
             "results": script_results,
         }
     finally:
+        remove_state_files(tmp)
+
+
+def remove_state_files(state_path: str) -> None:
+    """Удалить временное состояние вместе с его сайдкарами."""
+    for p in (state_path, *(state_path + s for s in STATE_SIDECARS)):
         try:
-            os.unlink(tmp)
+            os.unlink(p)
         except OSError:
             pass
 
@@ -0,0 +1,620 @@
+#include "../engine.hpp"
+#include "../state.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * labyrinth_scenarios — прогон tests/scenarios/<…>/scenario.json внутри одного процесса. Шаги и проверки —
+ * как у tests/scenario_lib.py (setup, script, resolve-bots после хода, склеенный expect_stdout),
+ * только без subprocess: файл состояния живёт строкой в памяти, а каждая «команда CLI» — это
+ * load → вызов движка → save. Сценарии раскидываются по потокам.
+ *
+ *   labyrinth_scenarios [DIR] [-k ПОДСТРОКА] [-j N]
+ *
+ * Код выхода: 0 — всё прошло, 1 — есть упавшие, 2 — ошибка запуска (нет сценариев, неверные аргументы).
+ * Канонизация эталонов (--canonize) остаётся за pytest.
+ */
+
+namespace fs = std::filesystem;
+
+namespace {
+
+/** Разобранный JSON: ровно то, что пишет save-scenario (объекты, массивы, строки, числа, bool, null). */
+struct Json {
+	enum class Kind { Null, Bool, Number, String, Array, Object } kind{Kind::Null};
+	bool flag{false};
+	double num{0};
+	std::string str;
+	std::vector<Json> items;
+	std::vector<std::pair<std::string, Json>> fields;
+
+	const Json* get(const std::string& key) const {
+		for (const auto& kv : fields)
+			if (kv.first == key) return &kv.second;
+		return nullptr;
+	}
+	bool is(Kind k) const { return kind == k; }
+};
+
+class JsonParser {
+public:
+	explicit JsonParser(const std::string& text) : s(text) {}
+
+	bool parse(Json& out, std::string& err) {
+		skip_ws();
+		if (!value(out)) { err = error + " (позиция " + std::to_string(i) + ")"; return false; }
+		skip_ws();
+		if (i != s.size()) { err = "лишние символы после JSON (позиция " + std::to_string(i) + ")"; return false; }
+		return true;
+	}
+
+private:
+	const std::string& s;
+	size_t i{0};
+	std::string error;
+
+	bool fail(const char* what) { error = what; return false; }
+	void skip_ws() {
+		while (i < s.size() && (s[i] == ' ' || s[i] == '\t' || s[i] == '\n' || s[i] == '\r')) ++i;
+	}
+	bool literal(const char* word) {
+		const size_t n = std::char_traits<char>::length(word);
+		if (s.compare(i, n, word) != 0) return fail("неизвестный литерал");
+		i += n;
+		return true;
+	}
+	bool value(Json& v) {
+		if (i >= s.size()) return fail("неожиданный конец JSON");
+		switch (s[i]) {
+			case '{': return object(v);
+			case '[': return array(v);
+			case '"': v.kind = Json::Kind::String; return string(v.str);
+			case 't': v.kind = Json::Kind::Bool; v.flag = true; return literal("true");
+			case 'f': v.kind = Json::Kind::Bool; v.flag = false; return literal("false");
+			case 'n': v.kind = Json::Kind::Null; return literal("null");
+			default: return number(v);
+		}
+	}
+	bool object(Json& v) {
+		v.kind = Json::Kind::Object;
+		++i;
+		skip_ws();
+		if (i < s.size() && s[i] == '}') { ++i; return true; }
+		for (;;) {
+			skip_ws();
+			std::string key;
+			if (i >= s.size() || s[i] != '"' || !string(key)) return fail("ожидался ключ объекта");
+			skip_ws();
+			if (i >= s.size() || s[i] != ':') return fail("ожидалось ':'");
+			++i;
+			skip_ws();
+			v.fields.emplace_back(std::move(key), Json{});
+			if (!value(v.fields.back().second)) return false;
+			skip_ws();
+			if (i < s.size() && s[i] == ',') { ++i; continue; }
+			if (i < s.size() && s[i] == '}') { ++i; return true; }
+			return fail("ожидалось ',' или '}'");
+		}
+	}
+	bool array(Json& v) {
+		v.kind = Json::Kind::Array;
+		++i;
+		skip_ws();
+		if (i < s.size() && s[i] == ']') { ++i; return true; }
+		for (;;) {
+			skip_ws();
+			v.items.emplace_back();
+			if (!value(v.items.back())) return false;
+			skip_ws();
+			if (i < s.size() && s[i] == ',') { ++i; continue; }
+			if (i < s.size() && s[i] == ']') { ++i; return true; }
+			return fail("ожидалось ',' или ']'");
+		}
+	}
+	bool number(Json& v) {
+		const char* begin = s.c_str() + i;
+		char* end = nullptr;
+		v.num = std::strtod(begin, &end);
+		if (end == begin) return fail("ожидалось значение");
+		v.kind = Json::Kind::Number;
+		i += static_cast<size_t>(end - begin);
+		return true;
+	}
+	bool hex4(uint32_t& cp) {
+		if (i + 4 > s.size()) return fail("обрезанный \\u");
+		cp = 0;
+		for (int k = 0; k < 4; ++k) {
+			const char c = s[i++];
+			cp <<= 4;
+			if (c >= '0' && c <= '9') cp |= static_cast<uint32_t>(c - '0');
+			else if (c >= 'a' && c <= 'f') cp |= static_cast<uint32_t>(c - 'a' + 10);
+			else if (c >= 'A' && c <= 'F') cp |= static_cast<uint32_t>(c - 'A' + 10);
+			else return fail("неверный \\u");
+		}
+		return true;
+	}
+	static void put_utf8(std::string& out, uint32_t cp) {
+		if (cp < 0x80) out += static_cast<char>(cp);
+		else if (cp < 0x800) { out += static_cast<char>(0xC0 | (cp >> 6)); out += static_cast<char>(0x80 | (cp & 0x3F)); }
+		else if (cp < 0x10000) {
+			out += static_cast<char>(0xE0 | (cp >> 12));
+			out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+			out += static_cast<char>(0x80 | (cp & 0x3F));
+		} else {
+			out += static_cast<char>(0xF0 | (cp >> 18));
+			out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+			out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+			out += static_cast<char>(0x80 | (cp & 0x3F));
+		}
+	}
+	bool string(std::string& out) {
+		++i; // открывающая кавычка
+		while (i < s.size()) {
+			const char c = s[i++];
+			if (c == '"') return true;
+			if (c != '\\') { out += c; continue; }
+			if (i >= s.size()) break;
+			const char e = s[i++];
+			switch (e) {
+				case '"': out += '"'; break;
+				case '\\': out += '\\'; break;
+				case '/': out += '/'; break;
+				case 'b': out += '\b'; break;
+				case 'f': out += '\f'; break;
+				case 'n': out += '\n'; break;
+				case 'r': out += '\r'; break;
+				case 't': out += '\t'; break;
+				case 'u': {
+					uint32_t cp = 0;
+					if (!hex4(cp)) return false;
+					if (cp >= 0xD800 && cp < 0xDC00 && i + 6 <= s.size() && s[i] == '\\' && s[i + 1] == 'u') {
+						i += 2;
+						uint32_t lo = 0;
+						if (!hex4(lo)) return false;
+						cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+					}
+					put_utf8(out, cp);
+					break;
+				}
+				default: return fail("неизвестная escape-последовательность");
+			}
+		}
+		return fail("незакрытая строка");
+	}
+};
+
+// --- текст как в scenario_lib.py ---
+
+/** str.strip() питона. */
+std::string strip(const std::string& t) {
+	const char* ws = " \t\n\r\f\v";
+	const size_t b = t.find_first_not_of(ws);
+	if (b == std::string::npos) return std::string();
+	return t.substr(b, t.find_last_not_of(ws) - b + 1);
+}
+
+/** norm_text: \r\n → \n, хвостовые пробелы строк, strip всего. */
+std::string norm_text(const std::string& s) {
+	std::string t;
+	t.reserve(s.size());
+	for (size_t k = 0; k < s.size(); ++k) {
+		if (s[k] == '\r') {
+			t += '\n';
+			if (k + 1 < s.size() && s[k + 1] == '\n') ++k;
+		} else {
+			t += s[k];
+		}
+	}
+	std::string out;
+	std::istringstream is(t);
+	std::string line;
+	bool first = true;
+	while (std::getline(is, line)) {
+		const size_t e = line.find_last_not_of(" \t\f\v");
+		if (!first) out += '\n';
+		first = false;
+		out += e == std::string::npos ? std::string() : line.substr(0, e + 1);
+	}
+	return strip(out);
+}
+
+/** _append_step_output: склейка вывода шагов через \n, пустые куски пропускаются. */
+std::string append_output(const std::string& acc, const std::string& piece) {
+	const std::string p = strip(piece);
+	if (p.empty()) return acc;
+	return acc + (acc.empty() ? "" : "\n") + p;
+}
+
+std::string short_text(const std::string& s, size_t limit = 2000) {
+	if (s.size() <= limit) return s;
+	return s.substr(0, limit) + "\n… (обрезано, всего " + std::to_string(s.size()) + " символов)";
+}
+
+// --- одна «команда CLI» над состоянием в памяти ---
+
+/** Итог команды, как его видит scenario_lib.run_lab: код и обрезанные stdout/stderr. */
+struct CommandResult {
+	int code{0};
+	std::string out, err;
+};
+
+/** Файл состояния сценария: текст, который CLI оставил бы на диске между вызовами. */
+struct Session {
+	std::string text;
+	bool exists{false};
+
+	bool load(AppState& st, std::string& err, unsigned sections = LoadAll) const {
+		if (!exists) { err = "Не могу открыть файл для чтения"; return false; }
+		std::istringstream is(text);
+		return AppState::load(st, is, err, sections);
+	}
+	bool save(const AppState& st, std::string& err) {
+		std::ostringstream os;
+		if (!AppState::save(st, os, err)) return false;
+		text = os.str();
+		exists = true;
+		return true;
+	}
+};
+
+CommandResult finish(int code, const std::ostringstream& out, const std::ostringstream& err) {
+	return CommandResult{code, strip(out.str()), strip(err.str())};
+}
+CommandResult failed(int code, const std::string& err) {
+	return CommandResult{code, std::string(), strip(err)};
+}
+
+bool field_string(const Json& step, const char* key, std::string& out) {
+	const Json* v = step.get(key);
+	if (!v) return false;
+	if (v->is(Json::Kind::String)) out = v->str;
+	else if (v->is(Json::Kind::Number)) out = std::to_string(static_cast<long long>(v->num));
+	else return false;
+	return true;
+}
+bool field_int(const Json& step, const char* key, long long& out) {
+	const Json* v = step.get(key);
+	if (!v || !v->is(Json::Kind::Number)) return false;
+	out = static_cast<long long>(v->num);
+	return true;
+}
+/** Истинность значения по правилам питона (для "turns", "on", "bot_steps", "bot_search"). */
+bool truthy(const Json* v, bool dflt) {
+	if (!v) return dflt;
+	switch (v->kind) {
+		case Json::Kind::Null: return false;
+		case Json::Kind::Bool: return v->flag;
+		case Json::Kind::Number: return v->num != 0;
+		case Json::Kind::String: return !v->str.empty();
+		case Json::Kind::Array: return !v->items.empty();
+		case Json::Kind::Object: return !v->fields.empty();
+	}
+	return dflt;
+}
+
+bool parse_direction(const std::string& s, Direction& d) {
+	if (s == "up") d = Direction::Up;
+	else if (s == "down") d = Direction::Down;
+	else if (s == "left") d = Direction::Left;
+	else if (s == "right") d = Direction::Right;
+	else return false;
+	return true;
+}
+
+/** Команды из build_setup_argv; false и err — шаг не распознан (как ValueError/KeyError в питоне). */
+bool run_setup(Session& ses, const Json& step, CommandResult& res, std::string& err) {
+	std::string type;
+	field_string(step, "type", type);
+	AppState st;
+	std::string e;
+	if (type == "generate") {
+		long long w = 0, h = 0, v = 0;
+		if (!field_int(step, "width", w) || !field_int(step, "height", h)) { err = "generate: нужны width и height"; return false; }
+		GenerateOptions opt;
+		opt.width = static_cast<size_t>(w);
+		opt.height = static_cast<size_t>(h);
+		if (const Json* o = step.get("openness"); o && o->is(Json::Kind::Number)) opt.openness = static_cast<float>(o->num);
+		opt.seed = field_int(step, "seed", v) ? static_cast<unsigned int>(v) : std::random_device{}();
+		if (step.get("turns")) opt.turns = truthy(step.get("turns"), true);
+		if (field_int(step, "turn_actions", v)) opt.turn_actions = static_cast<int>(v);
+		if (truthy(step.get("bot_steps"), false) && field_int(step, "bot_steps", v)) {
+			opt.bot_steps = static_cast<int>(v);
+			if (truthy(step.get("bot_search"), false) && field_int(step, "bot_search", v)) opt.bot_search_depth = static_cast<int>(v);
+			if (field_int(step, "bot_budget_us", v)) opt.bot_budget_us = static_cast<unsigned>(std::max<long long>(1, v));
+		}
+		generate_state(st, opt);
+		if (!ses.save(st, e)) { res = failed(2, e); return true; }
+		res = CommandResult{0, "Создано: scenario", std::string()};
+		return true;
+	}
+	if (type == "add-player" || type == "add-player-random" || type == "set-turns" || type == "init-turns" ||
+	    type == "init-base" || type == "give-item" || type == "give-treasure" || type == "add-item" ||
+	    type == "add-item-random" || type == "set-cell") {
+		// аргументы проверяются до загрузки — как при сборке argv
+		std::string name, item, cell;
+		long long x = 0, y = 0, charges = 1;
+		const bool has_charges = step.get("charges") && !step.get("charges")->is(Json::Kind::Null);
+		if ((type == "add-player" || type == "add-player-random" || type == "give-item" || type == "give-treasure") &&
+		    !field_string(step, "name", name)) { err = type + ": нужен name"; return false; }
+		if ((type == "add-player" || type == "add-item" || type == "set-cell") &&
+		    (!field_int(step, "x", x) || !field_int(step, "y", y))) { err = type + ": нужны x и y"; return false; }
+		if ((type == "give-item" || type == "add-item" || type == "add-item-random") && !field_string(step, "item", item)) {
+			err = type + ": нужен item"; return false;
+		}
+		if (type == "set-cell" && !field_string(step, "cell", cell)) { err = "set-cell: нужен cell"; return false; }
+		if (has_charges && !field_int(step, "charges", charges)) { err = type + ": charges — число"; return false; }
+		if (type == "give-treasure") { item = "treasure"; charges = 1; }
+		if (!item.empty() && !item_id_is_valid(item)) { res = failed(1, "usage: неизвестный предмет " + item); return true; }
+		CellContent content = CellContent::Empty;
+		if (type == "set-cell") {
+			if (cell == "empty") content = CellContent::Empty;
+			else if (cell == "treasure") content = CellContent::Treasure;
+			else if (cell == "hospital") content = CellContent::Hospital;
+			else if (cell == "arsenal") content = CellContent::Arsenal;
+			else if (cell == "exit") content = CellContent::Exit;
+			else { res = failed(1, "usage: неизвестная клетка " + cell); return true; }
+		}
+
+		if (!ses.load(st, e)) { res = failed(2, e); return true; }
+		std::pair<size_t,size_t> pos;
+		bool ok = true;
+		if (type == "add-player") ok = st.game.add_player(name, {static_cast<size_t>(x), static_cast<size_t>(y)}, st.map, e);
+		else if (type == "add-player-random") ok = add_player_random(st, name, pos, e);
+		else if (type == "set-turns") st.game.enforce_turns = truthy(step.get("on"), true);
+		else if (type == "init-turns") init_turns(st);
+		else if (type == "init-base") { st.set_base_from_current(); st.journal.reset(); }
+		else if (type == "give-item" || type == "give-treasure") ok = give_item(st, name, item, static_cast<int>(charges), e);
+		else if (type == "add-item") ok = add_item_at(st, item, static_cast<size_t>(x), static_cast<size_t>(y), static_cast<int>(charges), e);
+		else if (type == "add-item-random") ok = add_item_random(st, item, static_cast<int>(charges), pos, e);
+		else st.map.set_cell(static_cast<size_t>(x), static_cast<size_t>(y), content);
+		if (!ok) { res = failed(3, e); return true; }
+		if (!ses.save(st, e)) { res = failed(2, e); return true; }
+		res = CommandResult{};
+		return true;
+	}
+	err = "unknown setup type: " + type;
+	return false;
+}
+
+/** Ход из build_game_argv (move/attack/use-item/player-status) — вывод как у CLI. */
+bool run_game_step(Session& ses, const Json& step, CommandResult& res, std::string& err) {
+	std::string type, name, item, sdir;
+	field_string(step, "type", type);
+	if (type != "move" && type != "attack" && type != "use-item" && type != "player-status") {
+		err = "unknown game action type: " + type;
+		return false;
+	}
+	if (!field_string(step, "name", name)) { err = type + ": нужен name"; return false; }
+	AppState st;
+	std::string e;
+	if (type == "player-status") {
+		if (!ses.load(st, e, LoadMap | LoadGame)) { res = failed(2, e); return true; }
+		std::string js;
+		if (!player_status_json(st, name, js)) { res = failed(3, "Игрок не найден"); return true; }
+		res = CommandResult{0, strip(js), std::string()};
+		return true;
+	}
+	if (type == "use-item" && !field_string(step, "item", item)) { err = "use-item: нужен item"; return false; }
+	if (!field_string(step, "dir", sdir)) { err = type + ": нужен dir"; return false; }
+	Direction dir;
+	if (!parse_direction(sdir, dir)) { res = failed(1, "usage: неизвестное направление " + sdir); return true; }
+	const ActionKind kind = type == "move" ? ActionKind::Move : type == "attack" ? ActionKind::Attack : ActionKind::UseItem;
+	if (!ses.load(st, e)) { res = failed(2, e); return true; }
+	ActionResult ar;
+	if (!apply_player_action(st, std::string(), kind, name, dir, item, ar, e)) { res = failed(2, e); return true; }
+	std::ostringstream out, log;
+	log << ar.detail << "\n";
+	write_user_messages(out, name, ar.outcome, st.game.players.name);
+	write_bot_feed(out, ar.bot_feed, st.game.players.name);
+	if (ar.bot_cap_reached) log << kBotCapMessage << "\n";
+	if (!ses.save(st, e)) { res = failed(2, e); return true; }
+	res = finish(0, out, log);
+	return true;
+}
+
+CommandResult run_resolve_bots(Session& ses) {
+	AppState st;
+	std::string e;
+	if (!ses.load(st, e)) return failed(2, e);
+	std::vector<MessageEvent> feed;
+	bool settled = true;
+	resolve_bots(st, std::string(), feed, settled, e);
+	if (!ses.save(st, e)) return failed(2, e);
+	std::ostringstream out, log;
+	write_bot_feed(out, feed, st.game.players.name);
+	if (!settled) log << kBotCapMessage << "\n";
+	return finish(0, out, log);
+}
+
+std::string cli_failure(const std::string& title, const CommandResult& r) {
+	std::string msg = title + ": процесс завершился с кодом " + std::to_string(r.code) + ".";
+	if (!r.err.empty()) msg += "\n\nstderr:\n" + short_text(r.err, 1500);
+	if (!r.out.empty() && r.out != r.err) msg += "\n\nstdout:\n" + short_text(r.out, 1500);
+	if (r.err.empty() && r.out.empty()) msg += "\n\n(нет вывода в stdout/stderr)";
+	return msg;
+}
+
+bool has_stdout_expect(const Json& step) {
+	const Json* e = step.get("expect_stdout");
+	if (e && !e->is(Json::Kind::Null)) return true;
+	const Json* subs = step.get("expect_stdout_contains");
+	return subs && subs->is(Json::Kind::Array) && !subs->items.empty();
+}
+
+/** _check_expect: точный expect_stdout или подстроки; подстроки stderr — по выводу шага. */
+bool check_expect(const std::string& out, const std::string& err, const Json& step, std::vector<std::string>& checks) {
+	bool ok = true;
+	const Json* exp = step.get("expect_stdout");
+	if (exp && !exp->is(Json::Kind::Null)) {
+		const std::string e = norm_text(exp->str);
+		const std::string a = norm_text(out);
+		if (e != a) {
+			checks.push_back("Несовпадение expect_stdout.\nОжидалось:\n" + short_text(e) +
+			                 "\n\nФактически (stdout за шаг, после resolve-bots):\n" + short_text(a));
+			ok = false;
+		}
+	} else if (const Json* subs = step.get("expect_stdout_contains"); subs && subs->is(Json::Kind::Array)) {
+		for (const Json& sub : subs->items) {
+			if (!sub.is(Json::Kind::String) || sub.str.empty() || out.find(sub.str) != std::string::npos) continue;
+			checks.push_back("В stdout нет ожидаемой подстроки '" + sub.str + "'.\nФактический stdout:\n" + short_text(out));
+			ok = false;
+		}
+	}
+	if (const Json* esubs = step.get("expect_stderr_contains"); esubs && esubs->is(Json::Kind::Array)) {
+		for (const Json& sub : esubs->items) {
+			if (!sub.is(Json::Kind::String) || sub.str.empty() || err.find(sub.str) != std::string::npos) continue;
+			checks.push_back("В stderr нет ожидаемой подстроки '" + sub.str + "'.\nФактический stderr:\n" + short_text(err));
+			ok = false;
+		}
+	}
+	return ok;
+}
+
+struct ScenarioReport {
+	std::string id;
+	std::string description;
+	bool ok{false};
+	std::string error;
+};
+
+/** run_scenario из scenario_lib.py без канонизации. */
+void run_scenario(const fs::path& file, ScenarioReport& rep) {
+	std::ifstream f(file);
+	if (!f) { rep.error = "Не могу открыть " + file.string(); return; }
+	std::stringstream buf;
+	buf << f.rdbuf();
+	const std::string text = buf.str();
+	Json data;
+	std::string err;
+	if (!JsonParser(text).parse(data, err)) { rep.error = "scenario.json: " + err; return; }
+	if (!data.is(Json::Kind::Object)) { rep.error = "scenario.json: ожидался объект"; return; }
+	if (!field_string(data, "description", rep.description)) field_string(data, "title", rep.description);
+	const Json* setup = data.get("setup");
+	const Json* script = data.get("script");
+	static const Json kEmpty{Json::Kind::Array, false, 0, {}, {}, {}};
+	if (!setup || setup->is(Json::Kind::Null)) setup = &kEmpty;
+	if (!script || script->is(Json::Kind::Null)) script = &kEmpty;
+	if (!setup->is(Json::Kind::Array)) { rep.error = "setup must be a list"; return; }
+	if (!script->is(Json::Kind::Array)) { rep.error = "script must be a list"; return; }
+
+	Session ses;
+	for (size_t i = 0; i < setup->items.size(); ++i) {
+		const Json& cmd = setup->items[i];
+		if (!cmd.is(Json::Kind::Object)) { rep.error = "setup[" + std::to_string(i) + "] is not an object"; return; }
+		CommandResult r;
+		if (!run_setup(ses, cmd, r, err)) { rep.error = err; return; }
+		if (r.code != 0) { rep.error = cli_failure("setup[" + std::to_string(i) + "]", r); return; }
+	}
+
+	std::string stdout_acc;
+	for (size_t j = 0; j < script->items.size(); ++j) {
+		const Json& step = script->items[j];
+		const std::string where = "script[" + std::to_string(j) + "]";
+		if (!step.is(Json::Kind::Object)) { rep.error = where + " is not an object"; return; }
+		CommandResult r;
+		if (!run_game_step(ses, step, r, err)) { rep.error = err; return; }
+		if (r.code != 0) { rep.error = cli_failure(where, r); return; }
+		std::string acc_out = r.out, acc_err = r.err;
+		std::string type;
+		field_string(step, "type", type);
+		if (type != "player-status") {
+			const CommandResult b = run_resolve_bots(ses);
+			if (b.code != 0) { rep.error = cli_failure("resolve-bots после " + where, b); return; }
+			if (!b.out.empty()) acc_out += (acc_out.empty() ? "" : "\n") + b.out;
+			if (!b.err.empty()) acc_err += (acc_err.empty() ? "" : "\n") + b.err;
+		}
+		stdout_acc = append_output(stdout_acc, acc_out);
+		std::vector<std::string> checks;
+		if (!check_expect(has_stdout_expect(step) ? stdout_acc : acc_out, acc_err, step, checks)) {
+			rep.error = where + ":\n";
+			for (size_t k = 0; k < checks.size(); ++k) rep.error += (k ? "\n\n" : "") + checks[k];
+			return;
+		}
+	}
+	rep.ok = true;
+}
+
+/** discover_scenario_dirs: все scenario.json под DIR, кроме лежащего прямо в корне; по пути. */
+std::vector<fs::path> discover(const fs::path& root) {
+	std::vector<fs::path> out;
+	std::error_code ec;
+	for (fs::recursive_directory_iterator it(root, ec), end; !ec && it != end; it.increment(ec)) {
+		if (!it->is_regular_file() || it->path().filename() != "scenario.json") continue;
+		if (it->path().parent_path() == root) continue;
+		out.push_back(it->path());
+	}
+	std::sort(out.begin(), out.end());
+	return out;
+}
+
+int usage() {
+	std::cerr << "labyrinth_scenarios [DIR] [-k ПОДСТРОКА] [-j N]\n"
+	             "  DIR — каталог сценариев (по умолчанию tests/scenarios), -k — только id с подстрокой,\n"
+	             "  -j — число потоков (по умолчанию — ядра)\n";
+	return 2;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+	fs::path root = "tests/scenarios";
+	std::string filter;
+	unsigned jobs = std::max(1u, std::thread::hardware_concurrency());
+	for (int i = 1; i < argc; ++i) {
+		const std::string a = argv[i];
+		if (a == "-k" && i + 1 < argc) filter = argv[++i];
+		else if (a == "-j" && i + 1 < argc) jobs = static_cast<unsigned>(std::max(1, std::atoi(argv[++i])));
+		else if (a == "-h" || a == "--help") return usage();
+		else if (!a.empty() && a[0] == '-') return usage();
+		else root = a;
+	}
+	if (!fs::is_directory(root)) { std::cerr << "Нет каталога сценариев: " << root.string() << "\n"; return 2; }
+
+	std::vector<ScenarioReport> reports;
+	std::vector<fs::path> files;
+	for (const auto& file : discover(root)) {
+		ScenarioReport rep;
+		rep.id = file.parent_path().lexically_relative(root).generic_string();
+		if (!filter.empty() && rep.id.find(filter) == std::string::npos) continue;
+		reports.push_back(std::move(rep));
+		files.push_back(file);
+	}
+	if (files.empty()) { std::cerr << "Сценарии не найдены в " << root.string() << "\n"; return 2; }
+
+	const auto t0 = std::chrono::steady_clock::now();
+	std::atomic<size_t> next{0};
+	auto worker = [&]() {
+		for (size_t k = next++; k < files.size(); k = next++) run_scenario(files[k], reports[k]);
+	};
+	jobs = std::min<unsigned>(jobs, static_cast<unsigned>(files.size()));
+	std::vector<std::thread> pool;
+	for (unsigned t = 1; t < jobs; ++t) pool.emplace_back(worker);
+	worker();
+	for (auto& th : pool) th.join();
+	const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+	size_t failed_count = 0;
+	for (const auto& rep : reports) {
+		if (rep.ok) { std::cout << "ok   " << rep.id << "\n"; continue; }
+		++failed_count;
+		std::cout << "FAIL " << rep.id << (rep.description.empty() ? "" : " — " + rep.description) << "\n";
+		std::istringstream lines(rep.error);
+		for (std::string line; std::getline(lines, line);) std::cout << "     " << line << "\n";
+	}
+	std::cout << reports.size() << " сценариев: " << reports.size() - failed_count << " ok, " << failed_count
+	          << " упало (" << static_cast<long long>(ms * 1000) / 1000.0 << " мс, потоков: " << jobs << ")\n";
+	return failed_count == 0 ? 0 : 1;
+}
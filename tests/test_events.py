@@ -0,0 +1,76 @@
+"""
+Лента событий (<state>.events, JSONL): команды с существующим файлом ленты дописывают в него
+события с seq, растущим на 1 без пропусков; undo объявляет reset и не возвращает seq назад;
+состояние со старым EVSEQ (подменённое копией) продолжает нумерацию с хвоста файла.
+Запуск: из корня репозитория  pytest tests/test_events.py
+"""
+from __future__ import annotations
+
+import json
+import shutil
+import sys
+from pathlib import Path
+
+TESTS_DIR = Path(__file__).resolve().parent
+sys.path.insert(0, str(TESTS_DIR))
+
+import scenario_lib as scn  # noqa: E402
+
+
+def _lab(lab: Path, args: list[str]) -> str:
+    code, out, err = scn.run_lab(lab, args)
+    assert code == 0, f"{' '.join(args)}: {err}"
+    return out
+
+
+def _events(path: Path) -> list[dict]:
+    return [json.loads(line) for line in path.read_text(encoding="utf-8").splitlines() if line]
+
+
+def test_feed_seq_reset_and_resume(tmp_path: Path, lab_binary: Path):
+    state = tmp_path / "state.txt"
+    s = str(state)
+    events = Path(s + ".events")
+    _lab(lab_binary, [
+        "generate", "--width", "8", "--height", "8", "--out", s, "--openness", "0.5",
+        "--seed", "47", "--turns", "1", "--bot-steps", "2",
+    ])
+    _lab(lab_binary, ["add-player", "--state", s, "--name", "Alice", "--x", "3", "--y", "1"])
+    _lab(lab_binary, ["add-player", "--state", s, "--name", "Bob", "--x", "4", "--y", "7"])
+    _lab(lab_binary, ["init-turns", "--state", s])
+    before_feed = tmp_path / "before_feed.txt"
+    shutil.copyfile(s, before_feed)
+
+    # лента включается существованием файла
+    events.write_text("", encoding="utf-8")
+    _lab(lab_binary, ["move", "--state", s, "--name", "Alice", "left"])
+    _lab(lab_binary, ["move", "--state", s, "--name", "Bob", "left"])
+    _lab(lab_binary, ["resolve-bots", "--state", s])
+    played = _events(events)
+    types = [e["type"] for e in played]
+    assert "player_moved" in types and "turn" in types and "bot_moved" in types, types
+    assert [e["seq"] for e in played] == list(range(1, len(played) + 1)), "seq должен идти 1, 2, 3… без пропусков"
+
+    _lab(lab_binary, ["undo", "--state", s])
+    after_undo = _events(events)
+    assert len(after_undo) == len(played) + 1
+    reset = after_undo[-1]
+    assert reset["type"] == "reset" and reset["count"] == 1, reset
+    assert reset["seq"] == played[-1]["seq"] + 1, "откат не возвращает seq назад"
+
+    _lab(lab_binary, ["move", "--state", s, "--name", "Alice", "left"])
+    tail = _events(events)[len(after_undo):]
+    assert tail and tail[0]["seq"] == reset["seq"] + 1
+
+    # состояние из копии до ленты (EVSEQ 0): нумерация продолжается с хвоста файла
+    last = _events(events)[-1]["seq"]
+    shutil.copyfile(before_feed, s)
+    _lab(lab_binary, ["move", "--state", s, "--name", "Alice", "left"])
+    resumed = _events(events)
+    new = [e["seq"] for e in resumed if e["seq"] > last]
+    assert new and new[0] == last + 1, "после подмены состояния seq продолжается с хвоста ленты"
+    seqs = [e["seq"] for e in resumed]
+    assert seqs == sorted(seqs) and len(set(seqs)) == len(seqs), "seq в файле строго растёт"
+
+    scn.remove_state_files(s)
+    events.unlink()
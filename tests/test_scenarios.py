@@ -6,7 +6,6 @@
 """
 from __future__ import annotations
 
-import subprocess
 import sys
 import warnings
 from pathlib import Path
@@ -18,46 +17,6 @@ sys.path.insert(0, str(TESTS_DIR))
 
 import scenario_lib as scn  # noqa: E402
 
-ROOT = TESTS_DIR.parent
-
-LAB = ROOT / "build" / "labyrinth"
-
-
-def _ensure_lab_binary() -> None:
-    """Если бинарника нет — при необходимости конфигурируем и собираем CMake-проект."""
-    if LAB.is_file():
-        return
-    cache = ROOT / "build" / "CMakeCache.txt"
-    if not cache.is_file():
-        configure = subprocess.run(
-            ["cmake", "-S", ".", "-B", "build"],
-            cwd=ROOT,
-            capture_output=True,
-            text=True,
-        )
-        if configure.returncode != 0:
-            pytest.fail(
-                "cmake -S . -B build не удался (нужен cmake и компилятор C++):\n"
-                + (configure.stderr or configure.stdout or "")
-            )
-    build = subprocess.run(
-        ["cmake", "--build", "build"],
-        cwd=ROOT,
-        capture_output=True,
-        text=True,
-    )
-    if build.returncode != 0 or not LAB.is_file():
-        pytest.fail(
-            f"cmake --build build не собрал {LAB}:\n"
-            + (build.stderr or build.stdout or "")
-        )
-
-
-@pytest.fixture(scope="session")
-def lab_binary() -> Path:
-    _ensure_lab_binary()
-    return LAB
-
 
 def _scenario_dirs():
     return scn.discover_scenario_dirs()
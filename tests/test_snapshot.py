@@ -0,0 +1,136 @@
+"""
+Снимок комнаты (<state>.shm): player-status и turn-info с --snapshot отвечают то же, что полное
+чтение состояния; устаревший отпечаток файла состояния даёт код 4; читатели переживают рост
+файла снимка (переотображение), пока писатель добавляет игроков.
+Запуск: из корня репозитория  pytest tests/test_snapshot.py
+"""
+from __future__ import annotations
+
+import json
+import os
+import shutil
+import subprocess
+import sys
+import threading
+from pathlib import Path
+
+TESTS_DIR = Path(__file__).resolve().parent
+sys.path.insert(0, str(TESTS_DIR))
+
+import scenario_lib as scn  # noqa: E402
+
+# длинные имена, чтобы полезная нагрузка снимка быстро переросла начальные 4 КиБ
+NAME = "player_with_a_rather_long_name_{:03d}"
+
+
+def _generate(lab: Path, s: str) -> None:
+    code, _, err = scn.run_lab(lab, [
+        "generate", "--width", "20", "--height", "20", "--out", s, "--openness", "0.4",
+        "--seed", "5", "--turns", "1",
+    ])
+    assert code == 0, err
+
+
+def _add_players(lab: Path, s: str, names: list[str]) -> None:
+    for n in names:
+        code, _, err = scn.run_lab(lab, ["add-player-random", "--state", s, "--name", n])
+        assert code == 0, err
+
+
+def _run_raw(lab: Path, args: list[str]) -> tuple[int, bytes]:
+    res = subprocess.run([str(lab)] + args, capture_output=True)
+    return res.returncode, res.stdout
+
+
+def test_snapshot_matches_full_read(tmp_path: Path, lab_binary: Path):
+    s = str(tmp_path / "state.txt")
+    _generate(lab_binary, s)
+    names = [NAME.format(i) for i in range(5)]
+    _add_players(lab_binary, s, names)
+    code, _, err = scn.run_lab(lab_binary, ["init-turns", "--state", s])
+    assert code == 0, err
+    code, _, err = scn.run_lab(lab_binary, ["give-item", "--state", s, "--name", names[1], "--item", "rifle"])
+    assert code == 0, err
+
+    for n in names:
+        full = _run_raw(lab_binary, ["player-status", "--state", s, "--name", n])
+        snap = _run_raw(lab_binary, ["player-status", "--state", s, "--name", n, "--snapshot"])
+        assert full[0] == 0 and snap[0] == 0
+        assert snap[1] == full[1], f"player-status --snapshot для {n} отличается от полного чтения"
+    full = _run_raw(lab_binary, ["turn-info", "--state", s])
+    snap = _run_raw(lab_binary, ["turn-info", "--state", s, "--snapshot"])
+    assert full[0] == 0 and snap[0] == 0
+    assert snap[1] == full[1], "turn-info --snapshot отличается от чтения сайдкара"
+    scn.remove_state_files(s)
+
+
+def test_stale_snapshot_exits_4(tmp_path: Path, lab_binary: Path):
+    s = str(tmp_path / "state.txt")
+    _generate(lab_binary, s)
+    _add_players(lab_binary, s, ["a"])
+    code, _, _ = scn.run_lab(lab_binary, ["player-status", "--state", s, "--name", "a", "--snapshot"])
+    assert code == 0
+
+    # файл состояния подменён без save (копия старой версии) — отпечаток в снимке не совпадает
+    old = str(tmp_path / "old.txt")
+    shutil.copyfile(s, old)
+    _add_players(lab_binary, s, ["b"])
+    os.replace(old, s)
+    code, _, err = scn.run_lab(lab_binary, ["player-status", "--state", s, "--name", "a", "--snapshot"])
+    assert code == 4, f"устаревший снимок должен давать код 4, а не {code}: {err}"
+    code, _, _ = scn.run_lab(lab_binary, ["turn-info", "--state", s, "--snapshot"])
+    assert code == 4
+
+    # без снимка — тоже 4, полное чтение при этом работает
+    os.unlink(s + ".shm")
+    code, _, _ = scn.run_lab(lab_binary, ["player-status", "--state", s, "--name", "a", "--snapshot"])
+    assert code == 4
+    code, _, _ = scn.run_lab(lab_binary, ["player-status", "--state", s, "--name", "a"])
+    assert code == 0
+    scn.remove_state_files(s)
+
+
+def test_readers_survive_snapshot_growth(tmp_path: Path, lab_binary: Path):
+    s = str(tmp_path / "state.txt")
+    _generate(lab_binary, s)
+    first = NAME.format(0)
+    _add_players(lab_binary, s, [first])
+    size_before = os.path.getsize(s + ".shm")
+
+    stop = threading.Event()
+    bad: list[str] = []
+    ok_reads = [0]
+
+    def reader() -> None:
+        while not stop.is_set():
+            code, out = _run_raw(lab_binary, ["player-status", "--state", s, "--name", first, "--snapshot"])
+            if code == 4:
+                continue  # между записью состояния и публикацией снимка отпечаток ещё старый
+            if code != 0:
+                bad.append(f"код {code}")
+                continue
+            try:
+                if json.loads(out)["name"] != first:
+                    bad.append(out.decode("utf-8", "replace")[:200])
+            except ValueError:
+                bad.append(out.decode("utf-8", "replace")[:200])
+            ok_reads[0] += 1
+
+    threads = [threading.Thread(target=reader) for _ in range(3)]
+    for t in threads:
+        t.start()
+    try:
+        _add_players(lab_binary, s, [NAME.format(i) for i in range(1, 200)])
+    finally:
+        stop.set()
+        for t in threads:
+            t.join()
+
+    assert not bad, f"читатель получил мусор при росте снимка: {bad[:3]}"
+    assert ok_reads[0] > 0
+    assert os.path.getsize(s + ".shm") > 2 * size_before, "снимок не вырос — рост не проверен"
+    last = NAME.format(199)
+    full = _run_raw(lab_binary, ["player-status", "--state", s, "--name", last])
+    snap = _run_raw(lab_binary, ["player-status", "--state", s, "--name", last, "--snapshot"])
+    assert snap[0] == 0 and snap[1] == full[1]
+    scn.remove_state_files(s)
@@ -0,0 +1,71 @@
+"""
+Откат (labyrinth undo): после каждой команды, изменившей состояние, undo возвращает файл
+состояния к виду до неё. Журнал пишется в точках записи (undo.hpp) — тест ловит пропущенную.
+Запуск: из корня репозитория  pytest tests/test_undo.py
+"""
+from __future__ import annotations
+
+import sys
+from pathlib import Path
+
+import pytest
+
+TESTS_DIR = Path(__file__).resolve().parent
+sys.path.insert(0, str(TESTS_DIR))
+
+import scenario_lib as scn  # noqa: E402
+
+
+def _snapshot(state: Path) -> list[str]:
+    """Состояние без секции UNDO; строки отсортированы — порядок обхода unordered_map не важен."""
+    text = state.read_text(encoding="utf-8")
+    cut = text.find("\nUNDO ")
+    if cut >= 0:
+        text = text[:cut]
+    return sorted(text.split("\n"))
+
+
+def _commands(s: str) -> list[list[str]]:
+    cmds = [["add-player-random", "--state", s, "--name", p] for p in ("a", "b", "c")]
+    for item in ("rifle", "flashlight", "treasure", "armor"):
+        cmds.append(["add-item-random", "--state", s, "--item", item])
+        cmds.append(["give-item", "--state", s, "--name", "a", "--item", item, "--charges", "2"])
+    cmds.append(["init-turns", "--state", s])
+    cmds.append(["set-cell", "--state", s, "--x", "1", "--y", "1", "treasure"])
+    cmds.append(["set-vwall", "--state", s, "--x", "2", "--y", "2", "--present=1"])
+    cmds.append(["set-knife", "--state", s, "--name", "b", "--broken", "1"])
+    for d in ("right", "down", "left", "up"):
+        for p in ("a", "b", "c"):
+            cmds.append(["use-item", "--state", s, "--name", p, "--item", "rifle", d])
+            cmds.append(["move", "--state", s, "--name", p, d])
+            cmds.append(["attack", "--state", s, "--name", p, d])
+    return cmds
+
+
+@pytest.mark.parametrize("seed", [1, 2, 3])
+def test_undo_restores_state_before_command(tmp_path: Path, lab_binary: Path, seed: int):
+    state = tmp_path / "state.txt"
+    s = str(state)
+    code, _, err = scn.run_lab(lab_binary, [
+        "generate", "--width", "10", "--height", "8", "--out", s, "--openness", "0.4",
+        "--seed", str(seed), "--turns", "1", "--bot-steps", "2",
+    ])
+    assert code == 0, err
+    # загрузка канонизирует очередь ходов — исходное состояние берём уже пересохранённым
+    code, _, err = scn.run_lab(lab_binary, ["save-as", "--state", s, "--out", s])
+    assert code == 0, err
+    history = [_snapshot(state)]
+    for cmd in _commands(s):
+        scn.run_lab(lab_binary, cmd)
+        now = _snapshot(state)
+        if now != history[-1]:
+            history.append(now)
+    assert len(history) > 20, "команды почти ничего не изменили — проверять нечего"
+
+    for k in range(len(history) - 2, -1, -1):
+        code, _, err = scn.run_lab(lab_binary, ["undo", "--state", s])
+        assert code == 0, f"undo к шагу {k}: {err}"
+        assert _snapshot(state) == history[k], f"undo к шагу {k} дал не то состояние"
+    code, _, _ = scn.run_lab(lab_binary, ["undo", "--state", s])
+    assert code != 0, "журнал должен кончиться на исходном состоянии"
+    scn.remove_state_files(s)
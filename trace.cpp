@@ -0,0 +1,96 @@
+#include "trace.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <functional>
+#include <mutex>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+namespace trace {
+
+static std::mutex g_mu;
+static std::string g_path;
+static std::string g_events;   // буфер событий; пишется в файл в close() под flock
+static std::atomic<bool> g_on{false};
+
+static long long now_us() {
+	// системные часы, а не steady: спаны разных процессов ложатся на одну ось времени
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+static unsigned tid_small() {
+	return static_cast<unsigned>(std::hash<std::thread::id>{}(std::this_thread::get_id()) % 100000u);
+}
+
+bool open(const std::string& path, std::string& err) {
+	std::lock_guard<std::mutex> lk(g_mu);
+	if (g_on) return true;
+	std::FILE* f = std::fopen(path.c_str(), "a");
+	if (!f) { err = "Не могу открыть файл трассы: " + path; return false; }
+	std::fclose(f);
+	g_path = path;
+	g_on = true;
+	static bool registered = false;
+	if (!registered) { std::atexit(close); registered = true; }
+	return true;
+}
+
+bool enabled() {
+	return g_on;
+}
+
+void close() {
+	std::lock_guard<std::mutex> lk(g_mu);
+	if (!g_on) return;
+	g_on = false;
+	if (g_events.empty()) return;
+	const int fd = ::open(g_path.c_str(), O_WRONLY | O_APPEND | O_CREAT, 0644);
+	if (fd < 0) return;
+	// несколько процессов пишут в один файл: проверка размера и запись — под одной блокировкой,
+	// иначе двое увидят пустой файл и оба откроют массив
+	while (::flock(fd, LOCK_EX) < 0 && errno == EINTR) {}
+	struct stat sb{};
+	const bool empty = ::fstat(fd, &sb) == 0 && sb.st_size == 0;
+	// пустой файл открывает массив; иначе продолжаем его запятой
+	std::string out = (empty ? "[\n" : ",\n") + g_events;
+	const char* p = out.data();
+	size_t left = out.size();
+	while (left > 0) {
+		const ssize_t n = ::write(fd, p, left);
+		if (n < 0 && errno == EINTR) continue;
+		if (n <= 0) break;
+		p += n;
+		left -= static_cast<size_t>(n);
+	}
+	::close(fd); // закрытие снимает flock
+	g_events.clear();
+}
+
+Span::Span(const char* name, const char* cat) : name_(name), cat_(cat) {
+	if (g_on) start_us_ = now_us();
+}
+
+void Span::end() {
+	if (start_us_ < 0) return;
+	long long dur = now_us() - start_us_;
+	char buf[384];
+	int n = std::snprintf(buf, sizeof(buf),
+		"{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%lld,\"pid\":%d,\"tid\":%u}",
+		name_, cat_, start_us_, dur, static_cast<int>(::getpid()), tid_small());
+	start_us_ = -1;
+	if (n <= 0) return;
+	std::lock_guard<std::mutex> lk(g_mu);
+	if (!g_on) return;
+	if (!g_events.empty()) g_events += ",\n";
+	g_events.append(buf, static_cast<size_t>(std::min<int>(n, sizeof(buf) - 1)));
+}
+
+} // namespace trace
@@ -0,0 +1,37 @@
+#pragma once
+#include <string>
+
+/**
+ * Трассировка фаз команды в формате Chrome trace-event (chrome://tracing, Perfetto).
+ * Включается trace::open (флаг --trace FILE или переменная окружения LABYRINTH_TRACE);
+ * выключенная трасса стоит одну проверку указателя на спан.
+ * Файл — JSON Array Format без закрывающей скобки: события нескольких запусков дописываются в один файл.
+ */
+namespace trace {
+
+bool open(const std::string& path, std::string& err);
+/** Сбрасывает накопленные события в файл (вызывается и автоматически при выходе). */
+void close();
+bool enabled();
+
+/** Спан "X" (complete event) от конструктора до end() или деструктора. name/cat — строки со статическим временем жизни. */
+class Span {
+public:
+	explicit Span(const char* name, const char* cat = "lab");
+	~Span() { end(); }
+	Span(const Span&) = delete;
+	Span& operator=(const Span&) = delete;
+	/** Закрыть спан раньше конца области видимости (фазы внутри длинной функции). */
+	void end();
+private:
+	const char* name_;
+	const char* cat_;
+	long long start_us_{-1};
+};
+
+} // namespace trace
+
+#define LAB_TRACE_CAT2(a, b) a##b
+#define LAB_TRACE_CAT(a, b) LAB_TRACE_CAT2(a, b)
+/** Спан на остаток текущей области видимости. */
+#define LAB_TRACE_SCOPE(name) trace::Span LAB_TRACE_CAT(lab_trace_span_, __LINE__)(name)
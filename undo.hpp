@@ -0,0 +1,34 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+struct LabyrinthMap;
+struct PlayerTable;
+struct Game;
+struct UndoMark;
+
+/**
+ * Точки записи журнала отката (journal.hpp): изменяющий код зовёт их прямо перед записью,
+ * живая UndoMark запоминает прежнее значение при первом касании. Копии карты и игры отметка
+ * не замечает; без отметки — одна проверка указателя.
+ */
+namespace undo {
+
+/** Самая внутренняя живая отметка потока; nullptr — команда не записывается. */
+extern thread_local UndoMark* active;
+
+void touch_cell(const LabyrinthMap& m, size_t x, size_t y);
+void touch_wall(const LabyrinthMap& m, bool vertical, size_t y, size_t x);
+void touch_player(const PlayerTable& p, uint32_t id);
+void touch_loot(const Game& g, long long key);
+void touch_ground(const Game& g, long long key);
+
+inline void cell(const LabyrinthMap& m, size_t x, size_t y) { if (active) touch_cell(m, x, y); }
+inline void vwall(const LabyrinthMap& m, size_t y, size_t x) { if (active) touch_wall(m, true, y, x); }
+inline void hwall(const LabyrinthMap& m, size_t y, size_t x) { if (active) touch_wall(m, false, y, x); }
+inline void player(const PlayerTable& p, uint32_t id) { if (active) touch_player(p, id); }
+/** key — y*1e6 + x, как у Game::loot_treasure / ground_items. */
+inline void loot(const Game& g, long long key) { if (active) touch_loot(g, key); }
+inline void ground(const Game& g, long long key) { if (active) touch_ground(g, key); }
+
+} // namespace undo
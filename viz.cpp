@@ -1,311 +1,424 @@
 #include "viz.hpp"
+#include "alloc.hpp"
+#include "trace.hpp"
 #include <sstream>
 #include <iomanip>
 #include <unordered_map>
 #include <vector>
 #include <map>
+#include <set>
 #include <algorithm>
 #include <sstream>
 
-std::string render_svg(const AppState& st, float cell_px, float margin_px) {
-	const auto& map = st.map;
-	float map_w = static_cast<float>(map.width) * cell_px;
-	float map_h = static_cast<float>(map.height) * cell_px;
-	float panel_w = std::max(cell_px * 7.0f, 160.0f);
-	float panel_gap = margin_px;
-	float w = margin_px * 2.0f + map_w + panel_gap + panel_w;
-	float h = margin_px * 2.0f + map_h;
-	float sw = std::max(cell_px, 8.0f) / 12.0f;
-	std::ostringstream oss;
-	oss << R"(<svg xmlns="http://www.w3.org/2000/svg")"
-	    << " viewBox=\"0 0 " << w << " " << h << "\""
-	    << " width=\"" << w << "\" height=\"" << h << "\">";
-	oss << "<rect x=\"0\" y=\"0\" width=\"" << w << "\" height=\"" << h << "\" fill=\"#ffffff\"/>\n";
-	// Precompute players per cell for data attributes
-	std::map<long long, std::vector<std::string>> players_in_cell;
-	for (const auto& kv : st.game.players) {
-		long long key = (long long)kv.second.second * 1000000LL + (long long)kv.second.first;
-		players_in_cell[key].push_back(kv.first);
-	}
-	// grid faint
-	for (size_t y = 0; y < map.height; ++y) {
-		for (size_t x = 0; x < map.width; ++x) {
-			long long key = (long long)y * 1000000LL + (long long)x;
-			// content label
-			std::string cstr = "Empty";
-			switch (map.get_cell(x, y)) {
-				case CellContent::Empty: cstr = "Empty"; break;
-				case CellContent::Treasure: cstr = "Treasure"; break;
-				case CellContent::Hospital: cstr = "Hospital"; break;
-				case CellContent::Arsenal: cstr = "Arsenal"; break;
-				case CellContent::Exit: cstr = "Exit"; break;
-			}
-			// players CSV
-			std::string pcsv;
-			{
-				auto it = players_in_cell.find(key);
-				if (it != players_in_cell.end()) {
-					for (size_t i = 0; i < it->second.size(); ++i) {
-						if (i) pcsv.push_back(',');
-						pcsv += it->second[i];
-					}
-				}
-			}
-			// ground items compact string "id:cnt;id:cnt"
-			std::string gitems;
-			{
-				auto it = st.game.ground_items.find(key);
-				if (it != st.game.ground_items.end()) {
-					bool first = true;
-					for (const auto& iv : it->second) {
-						if (!first) gitems.push_back(';');
-						first = false;
-						gitems += iv.first;
-						gitems.push_back(':');
-						gitems += std::to_string(iv.second);
-					}
-				}
-			}
-			int loot = 0;
-			{
-				auto itL = st.game.loot_treasure.find(key);
-				if (itL != st.game.loot_treasure.end()) loot = itL->second;
+/**
+ * Стены одной линии сетки (столбец x для вертикальных, строка y для горизонтальных) в виде одного
+ * <path data-col|data-row>: соседние сегменты склеены в максимальные прямые отрезки, первый — абсолютный
+ * `M`, следующие — относительные `m` от конца предыдущего. По data-атрибуту патч заменяет линию целиком.
+ * runs: (x0, y0, длина) в клетках; vertical — рисовать `v`, иначе `h`.
+ */
+struct WallRun { size_t x, y, len; };
+static void emit_wall_path(std::ostringstream& oss, const std::vector<WallRun>& runs, bool vertical, size_t line,
+                           float cell_px, float ox, float oy, float sw) {
+	if (runs.empty()) return;
+	oss << "<path " << (vertical ? "data-col" : "data-row") << "=\"" << line << "\" d=\"";
+	float cur_x = 0.0f, cur_y = 0.0f;
+	bool first = true;
+	for (const auto& r : runs) {
+		float px = ox + r.x * cell_px;
+		float py = oy + r.y * cell_px;
+		if (first) oss << "M" << px << " " << py;
+		else oss << "m" << (px - cur_x) << " " << (py - cur_y);
+		first = false;
+		float len = r.len * cell_px;
+		oss << (vertical ? "v" : "h") << len;
+		cur_x = vertical ? px : px + len;
+		cur_y = vertical ? py + len : py;
+	}
+	oss << "\" fill=\"none\" stroke=\"#000\" stroke-width=\"" << sw << "\" stroke-linecap=\"square\"/>\n";
+}
+
+SvgLod resolve_svg_lod(SvgLod lod, float cell_px) {
+	if (lod != SvgLod::Auto) return lod;
+	if (cell_px >= 16.0f) return SvgLod::Full;
+	if (cell_px >= 6.0f) return SvgLod::Lite;
+	return SvgLod::Coarse;
+}
+
+/** Геометрия одного рендера: окно, масштаб, сдвиг начала координат и размеры холста. */
+struct SvgFrame {
+	MapRect view;
+	size_t vx1{0}, vy1{0};
+	float cell_px{0}, margin_px{0}, ox{0}, oy{0}, sw{0};
+	float map_w{0}, panel_w{0}, panel_gap{0}, w{0}, h{0};
+	SvgLod lod{SvgLod::Full};
+	bool text{true};
+};
+
+static SvgFrame make_frame(const LabyrinthMap& map, float cell_px, float margin_px, const SvgOptions& opt) {
+	SvgFrame f;
+	f.view = opt.has_view ? map.clip_rect(opt.view) : map.full_rect();
+	f.vx1 = f.view.x + f.view.w;
+	f.vy1 = f.view.y + f.view.h;
+	f.cell_px = cell_px;
+	f.margin_px = margin_px;
+	f.lod = resolve_svg_lod(opt.lod, cell_px);
+	f.text = f.lod == SvgLod::Full;
+	// начало координат сдвинуто так, чтобы левый верхний угол окна лёг в (margin, margin)
+	f.ox = margin_px - f.view.x * cell_px;
+	f.oy = margin_px - f.view.y * cell_px;
+	f.map_w = static_cast<float>(f.view.w) * cell_px;
+	float map_h = static_cast<float>(f.view.h) * cell_px;
+	f.panel_w = std::max(cell_px * 7.0f, 160.0f);
+	f.panel_gap = margin_px;
+	f.w = margin_px * 2.0f + f.map_w + (opt.panel ? f.panel_gap + f.panel_w : 0.0f);
+	f.h = margin_px * 2.0f + map_h;
+	f.sw = std::max(cell_px, 8.0f) / 12.0f;
+	return f;
+}
+
+using CellPlayers = std::map<long long, std::vector<std::string>>;
+
+static CellPlayers players_by_cell(const AppState& st, const MapRect& view) {
+	CellPlayers out;
+	const PlayerTable& pl = st.game.players;
+	for (PlayerId id = 0; id < pl.size(); ++id) {
+		const auto& p = pl.pos[id];
+		if (!view.contains(p.first, p.second)) continue;
+		long long key = (long long)p.second * 1000000LL + (long long)p.first;
+		out[key].push_back(pl.name[id]);
+	}
+	return out;
+}
+
+/** Прозрачный прямоугольник клетки с data-атрибутами (по ним кликает HTML и адресуется патч). */
+static void emit_cell_rect(std::ostringstream& oss, const AppState& st, const SvgFrame& f,
+                           const CellPlayers& players_in_cell, size_t x, size_t y) {
+	long long key = (long long)y * 1000000LL + (long long)x;
+	// content label
+	std::string cstr = "Empty";
+	switch (st.map.get_cell(x, y)) {
+		case CellContent::Empty: cstr = "Empty"; break;
+		case CellContent::Treasure: cstr = "Treasure"; break;
+		case CellContent::Hospital: cstr = "Hospital"; break;
+		case CellContent::Arsenal: cstr = "Arsenal"; break;
+		case CellContent::Exit: cstr = "Exit"; break;
+	}
+	// players CSV
+	std::string pcsv;
+	{
+		auto it = players_in_cell.find(key);
+		if (it != players_in_cell.end()) {
+			for (size_t i = 0; i < it->second.size(); ++i) {
+				if (i) pcsv.push_back(',');
+				pcsv += it->second[i];
 			}
-			oss << "<rect class=\"cell\" data-x=\"" << x << "\" data-y=\"" << y
-			    << "\" data-content=\"" << cstr << "\" data-players=\"" << pcsv
-			    << "\" data-ground=\"" << gitems << "\" data-loot=\"" << loot
-			    << "\" x=\"" << (margin_px + x * cell_px) << "\" y=\"" << (margin_px + y * cell_px)
-			    << "\" width=\"" << cell_px << "\" height=\"" << cell_px
-			    << "\" fill=\"#ffffff\" stroke=\"#f0f0f0\" stroke-width=\"1\"/>\n";
 		}
 	}
-	// per-cell coordinate labels (x,y) in top-left corner
+	// ground items compact string "id:cnt;id:cnt"
+	std::string gitems;
 	{
-		for (size_t y = 0; y < map.height; ++y) {
-			for (size_t x = 0; x < map.width; ++x) {
-				float tx = margin_px + x * cell_px + cell_px * 0.5f;
-				float ty = margin_px + y * cell_px + cell_px * 0.5f;
-				oss << "<text x=\"" << tx << "\" y=\"" << ty << "\" fill=\"#000000\" fill-opacity=\"0.22\" font-size=\""
-				    << (cell_px*0.28f) << "\" font-family=\"monospace\" text-anchor=\"middle\" dominant-baseline=\"central\">"
-				    << x << "," << y << "</text>\n";
+		auto it = st.game.ground_items.find(key);
+		if (it != st.game.ground_items.end()) {
+			bool first = true;
+			for (const auto& iv : it->second) {
+				if (!first) gitems.push_back(';');
+				first = false;
+				gitems += iv.first;
+				gitems.push_back(':');
+				gitems += std::to_string(iv.second);
 			}
 		}
 	}
-	// walls
-	for (size_t y = 0; y < map.height; ++y) {
-		for (size_t x = 0; x <= map.width; ++x) {
-			if (map.v_walls[y][x]) {
-				float xp = margin_px + x * cell_px;
-				float y1 = margin_px + y * cell_px;
-				float y2 = margin_px + (y + 1) * cell_px;
-				oss << "<line x1=\"" << xp << "\" y1=\"" << y1 << "\" x2=\"" << xp << "\" y2=\"" << y2
-				    << "\" stroke=\"#000\" stroke-width=\"" << sw << "\" stroke-linecap=\"square\"/>\n";
-			} else if (map.has_exit && map.exit_vertical && map.exit_y == y && map.exit_x == x) {
-				// draw exit mark (short green tick)
-				float xp = margin_px + x * cell_px;
-				float cy = margin_px + y * cell_px + cell_px * 0.5f;
-				float len = cell_px * 0.3f;
-				oss << "<line x1=\"" << xp << "\" y1=\"" << (cy - len*0.5f) << "\" x2=\"" << xp << "\" y2=\"" << (cy + len*0.5f)
-				    << "\" stroke=\"#2e7d32\" stroke-width=\"" << (sw*1.2f) << "\" stroke-linecap=\"round\"/>\n";
-			}
+	int loot = 0;
+	{
+		auto itL = st.game.loot_treasure.find(key);
+		if (itL != st.game.loot_treasure.end()) loot = itL->second;
+	}
+	const float cell_px = f.cell_px;
+	oss << "<rect class=\"cell\" data-x=\"" << x << "\" data-y=\"" << y
+	    << "\" data-content=\"" << cstr << "\" data-players=\"" << pcsv
+	    << "\" data-ground=\"" << gitems << "\" data-loot=\"" << loot
+	    << "\" x=\"" << (f.ox + x * cell_px) << "\" y=\"" << (f.oy + y * cell_px)
+	    << "\" width=\"" << cell_px << "\" height=\"" << cell_px
+	    << "\" fill=\"#ffffff\" stroke=\"#f0f0f0\" stroke-width=\"1\"/>\n";
+}
+
+/** Содержимое клетки и предметы на земле; непустой вывод обёрнут в <g data-x data-y>. */
+static void emit_cell_items(std::ostringstream& oss, const AppState& st, const SvgFrame& f, size_t x, size_t y) {
+	const auto& map = st.map;
+	const float cell_px = f.cell_px, sw = f.sw;
+	long long key = (long long)y * 1000000LL + (long long)x;
+	auto itL = st.game.loot_treasure.find(key);
+	auto itGI = st.game.ground_items.find(key);
+	bool has_loot = itL != st.game.loot_treasure.end() && itL->second > 0;
+	bool has_ground = itGI != st.game.ground_items.end() && !itGI->second.empty();
+	if (map.get_cell(x, y) == CellContent::Empty && !has_loot && !has_ground) return;
+	oss << "<g data-x=\"" << x << "\" data-y=\"" << y << "\">";
+	float cx = f.ox + x * cell_px + cell_px * 0.5f;
+	float cy = f.oy + y * cell_px + cell_px * 0.5f;
+	switch (map.get_cell(x, y)) {
+		case CellContent::Empty: break;
+		case CellContent::Treasure:
+			oss << "<circle cx=\"" << cx << "\" cy=\"" << cy << "\" r=\"" << (cell_px*0.25f)
+			    << "\" fill=\"#d4af37\" stroke=\"#8b7d2b\" stroke-width=\"" << (sw*0.5f) << "\"/>\n";
+			break;
+		case CellContent::Hospital:
+			oss << "<rect x=\"" << (f.ox + x*cell_px) << "\" y=\"" << (f.oy + y*cell_px) << "\" width=\"" << cell_px
+			    << "\" height=\"" << cell_px << "\" fill=\"#d32f2f\" fill-opacity=\"0.7\"/>\n";
+			break;
+		case CellContent::Arsenal:
+			oss << "<rect x=\"" << (f.ox + x*cell_px) << "\" y=\"" << (f.oy + y*cell_px) << "\" width=\"" << cell_px
+			    << "\" height=\"" << cell_px << "\" fill=\"#ffd54f\" fill-opacity=\"0.7\"/>\n";
+			break;
+		case CellContent::Exit:
+			oss << "<rect x=\"" << (f.ox + x*cell_px+sw) << "\" y=\"" << (f.oy + y*cell_px+sw) << "\" width=\"" << (cell_px-2*sw)
+			    << "\" height=\"" << (cell_px-2*sw) << "\" fill=\"none\" stroke=\"#2e7d32\" stroke-width=\"" << sw << "\"/>\n";
+			break;
+	}
+	// overlay ground loot (treasure) always if present
+	if (has_loot) {
+		float lx = f.ox + x * cell_px + cell_px * 0.78f;
+		float ly = f.oy + y * cell_px + cell_px * 0.78f;
+		float rr = cell_px * 0.12f;
+		oss << "<circle cx=\"" << lx << "\" cy=\"" << ly << "\" r=\"" << rr
+		    << "\" fill=\"#d4af37\" stroke=\"#8b7d2b\" stroke-width=\"" << (sw*0.4f) << "\"/>\n";
+		if (itL->second > 1 && f.text) {
+			oss << "<text x=\"" << lx << "\" y=\"" << (ly + cell_px*0.01f) << "\" fill=\"#5d4300\" font-size=\""
+			    << (cell_px*0.3f) << "\" font-family=\"monospace\" text-anchor=\"middle\" dominant-baseline=\"central\">"
+			    << itL->second << "</text>\n";
+		}
+	}
+	// overlay ground items (centered letters; на Lite — точка)
+	if (has_ground && !f.text) {
+		oss << "<circle cx=\"" << cx << "\" cy=\"" << cy << "\" r=\"" << (cell_px*0.15f) << "\" fill=\"#111\"/>\n";
+	} else if (has_ground) {
+		bool hasK = itGI->second.count("knife") > 0;
+		bool hasF = itGI->second.count("flashlight") > 0;
+		bool hasR = itGI->second.count("rifle") > 0;
+		bool hasS = itGI->second.count("shotgun") > 0;
+		bool hasA = itGI->second.count("armor") > 0;
+		int cntK = hasK ? itGI->second.at("knife") : 0;
+		int cntF = hasF ? itGI->second.at("flashlight") : 0;
+		int cntR = hasR ? itGI->second.at("rifle") : 0;
+		int cntS = hasS ? itGI->second.at("shotgun") : 0;
+		int cntA = hasA ? itGI->second.at("armor") : 0;
+		int distinct = (hasK?1:0) + (hasF?1:0) + (hasR?1:0) + (hasS?1:0) + (hasA?1:0);
+		std::string label;
+		if (hasK) label.push_back('K');
+		if (hasF) label.push_back('F');
+		if (hasR) label.push_back('R');
+		if (hasS) label.push_back('S');
+		if (hasA) label.push_back('A');
+		if (distinct == 1) {
+			int c = hasK?cntK : hasF?cntF : hasR?cntR : hasS?cntS : cntA;
+			if (c > 1) label += std::to_string(c);
 		}
+		oss << "<text x=\"" << cx << "\" y=\"" << cy << "\" fill=\"#111\" font-size=\""
+		    << (cell_px*0.55f) << "\" font-family=\"monospace\" text-anchor=\"middle\" dominant-baseline=\"central\">"
+		    << label << "</text>\n";
 	}
-	for (size_t y = 0; y <= map.height; ++y) {
-		for (size_t x = 0; x < map.width; ++x) {
-			if (map.h_walls[y][x]) {
-				float yp = margin_px + y * cell_px;
-				float x1 = margin_px + x * cell_px;
-				float x2 = margin_px + (x + 1) * cell_px;
-				oss << "<line x1=\"" << x1 << "\" y1=\"" << yp << "\" x2=\"" << x2 << "\" y2=\"" << yp
-				    << "\" stroke=\"#000\" stroke-width=\"" << sw << "\" stroke-linecap=\"square\"/>\n";
+	oss << "</g>\n";
+}
+
+/** Coarse: соседние одинаковые спецклетки строки склеены в один прямоугольник. */
+static void emit_coarse_items(std::ostringstream& oss, const LabyrinthMap& map, const SvgFrame& f) {
+	for (size_t y = f.view.y; y < f.vy1; ++y) {
+		size_t x = f.view.x;
+		while (x < f.vx1) {
+			CellContent c = map.get_cell(x, y);
+			size_t x0 = x;
+			while (x < f.vx1 && map.get_cell(x, y) == c) ++x;
+			const char* fill = nullptr;
+			switch (c) {
+				case CellContent::Empty: break;
+				case CellContent::Treasure: fill = "#d4af37"; break;
+				case CellContent::Hospital: fill = "#d32f2f"; break;
+				case CellContent::Arsenal: fill = "#ffd54f"; break;
+				case CellContent::Exit: fill = "#2e7d32"; break;
 			}
+			if (!fill) continue;
+			oss << "<rect x=\"" << (f.ox + x0*f.cell_px) << "\" y=\"" << (f.oy + y*f.cell_px) << "\" width=\"" << ((x - x0)*f.cell_px)
+			    << "\" height=\"" << f.cell_px << "\" fill=\"" << fill << "\" fill-opacity=\"0.7\"/>\n";
 		}
 	}
+}
+
+/** Вертикальные стены столбца x в окне; runs — буфер вызывающего, переиспользуется между линиями. */
+static void emit_wall_col(std::ostringstream& oss, const LabyrinthMap& map, const SvgFrame& f, size_t x, std::vector<WallRun>& runs) {
+	runs.clear();
+	size_t y = f.view.y;
+	while (y < f.vy1) {
+		if (!map.v_walls[y][x]) { ++y; continue; }
+		size_t y0 = y;
+		while (y < f.vy1 && map.v_walls[y][x]) ++y;
+		runs.push_back({x, y0, y - y0});
+	}
+	emit_wall_path(oss, runs, true, x, f.cell_px, f.ox, f.oy, f.sw);
+}
+
+/** Горизонтальные стены строки y в окне. */
+static void emit_wall_row(std::ostringstream& oss, const LabyrinthMap& map, const SvgFrame& f, size_t y, std::vector<WallRun>& runs) {
+	runs.clear();
+	size_t x = f.view.x;
+	while (x < f.vx1) {
+		if (!map.h_walls[y][x]) { ++x; continue; }
+		size_t x0 = x;
+		while (x < f.vx1 && map.h_walls[y][x]) ++x;
+		runs.push_back({x0, y, x - x0});
+	}
+	emit_wall_path(oss, runs, false, y, f.cell_px, f.ox, f.oy, f.sw);
+}
+
+/** Отметки выхода в <g class="exit"> (пустая группа — выхода в окне нет); патч шлёт её целиком. */
+static void emit_exit_marks(std::ostringstream& oss, const LabyrinthMap& map, const SvgFrame& f) {
+	const float cell_px = f.cell_px, sw = f.sw;
+	oss << "<g class=\"exit\">";
+	const bool exit_in_view = map.has_exit && (map.exit_vertical
+		? (map.exit_x >= f.view.x && map.exit_x <= f.vx1 && map.exit_y >= f.view.y && map.exit_y < f.vy1)
+		: (map.exit_y >= f.view.y && map.exit_y <= f.vy1 && map.exit_x >= f.view.x && map.exit_x < f.vx1));
+	// exit mark on the open vertical border edge (short green tick)
+	if (exit_in_view && map.exit_vertical && map.exit_y < map.height && map.exit_x <= map.width
+	    && !map.v_walls[map.exit_y][map.exit_x]) {
+		float xp = f.ox + map.exit_x * cell_px;
+		float cy = f.oy + map.exit_y * cell_px + cell_px * 0.5f;
+		float len = cell_px * 0.3f;
+		oss << "<line x1=\"" << xp << "\" y1=\"" << (cy - len*0.5f) << "\" x2=\"" << xp << "\" y2=\"" << (cy + len*0.5f)
+		    << "\" stroke=\"#2e7d32\" stroke-width=\"" << (sw*1.2f) << "\" stroke-linecap=\"round\"/>\n";
+	}
 	// Exit overlay (always draw mark regardless of wall presence)
-	if (map.has_exit) {
+	if (exit_in_view) {
 		if (map.exit_vertical) {
-			float xp = margin_px + map.exit_x * cell_px;
-			float cy = margin_px + map.exit_y * cell_px + cell_px * 0.5f;
+			float xp = f.ox + map.exit_x * cell_px;
+			float cy = f.oy + map.exit_y * cell_px + cell_px * 0.5f;
 			float len = cell_px * 0.36f;
 			oss << "<line x1=\"" << xp << "\" y1=\"" << (cy - len*0.5f) << "\" x2=\"" << xp << "\" y2=\"" << (cy + len*0.5f)
 			    << "\" stroke=\"#2e7d32\" stroke-width=\"" << (sw*1.4f) << "\" stroke-linecap=\"round\"/>\n";
 		} else {
-			float yp = margin_px + map.exit_y * cell_px;
-			float cx = margin_px + map.exit_x * cell_px + cell_px * 0.5f;
+			float yp = f.oy + map.exit_y * cell_px;
+			float cx = f.ox + map.exit_x * cell_px + cell_px * 0.5f;
 			float len = cell_px * 0.36f;
 			oss << "<line x1=\"" << (cx - len*0.5f) << "\" y1=\"" << yp << "\" x2=\"" << (cx + len*0.5f) << "\" y2=\"" << yp
 			    << "\" stroke=\"#2e7d32\" stroke-width=\"" << (sw*1.4f) << "\" stroke-linecap=\"round\"/>\n";
 		}
 	}
-	// items
-	for (size_t y = 0; y < map.height; ++y) {
-		for (size_t x = 0; x < map.width; ++x) {
-			float cx = margin_px + x * cell_px + cell_px * 0.5f;
-			float cy = margin_px + y * cell_px + cell_px * 0.5f;
-			switch (map.get_cell(x, y)) {
-				case CellContent::Empty: break;
-				case CellContent::Treasure:
-					oss << "<circle cx=\"" << cx << "\" cy=\"" << cy << "\" r=\"" << (cell_px*0.25f)
-					    << "\" fill=\"#d4af37\" stroke=\"#8b7d2b\" stroke-width=\"" << (sw*0.5f) << "\"/>\n";
-					break;
-				case CellContent::Hospital:
-					oss << "<rect x=\"" << (margin_px + x*cell_px) << "\" y=\"" << (margin_px + y*cell_px) << "\" width=\"" << cell_px
-					    << "\" height=\"" << cell_px << "\" fill=\"#d32f2f\" fill-opacity=\"0.7\"/>\n";
-					break;
-				case CellContent::Arsenal:
-					oss << "<rect x=\"" << (margin_px + x*cell_px) << "\" y=\"" << (margin_px + y*cell_px) << "\" width=\"" << cell_px
-					    << "\" height=\"" << cell_px << "\" fill=\"#ffd54f\" fill-opacity=\"0.7\"/>\n";
-					break;
-				case CellContent::Exit:
-					oss << "<rect x=\"" << (margin_px + x*cell_px+sw) << "\" y=\"" << (margin_px + y*cell_px+sw) << "\" width=\"" << (cell_px-2*sw)
-					    << "\" height=\"" << (cell_px-2*sw) << "\" fill=\"none\" stroke=\"#2e7d32\" stroke-width=\"" << sw << "\"/>\n";
-					break;
-			}
-			// overlay ground loot (treasure) always if present
-			long long key = (long long)y * 1000000LL + (long long)x;
-			auto itL = st.game.loot_treasure.find(key);
-			if (itL != st.game.loot_treasure.end() && itL->second > 0) {
-				float lx = margin_px + x * cell_px + cell_px * 0.78f;
-				float ly = margin_px + y * cell_px + cell_px * 0.78f;
-				float rr = cell_px * 0.12f;
-				oss << "<circle cx=\"" << lx << "\" cy=\"" << ly << "\" r=\"" << rr
-				    << "\" fill=\"#d4af37\" stroke=\"#8b7d2b\" stroke-width=\"" << (sw*0.4f) << "\"/>\n";
-				if (itL->second > 1) {
-					oss << "<text x=\"" << lx << "\" y=\"" << (ly + cell_px*0.01f) << "\" fill=\"#5d4300\" font-size=\""
-					    << (cell_px*0.3f) << "\" font-family=\"monospace\" text-anchor=\"middle\" dominant-baseline=\"central\">"
-					    << itL->second << "</text>\n";
-				}
-			}
-			// overlay ground items (centered letters)
-			auto itGI = st.game.ground_items.find(key);
-			if (itGI != st.game.ground_items.end() && !itGI->second.empty()) {
-				bool hasK = itGI->second.count("knife") > 0;
-				bool hasF = itGI->second.count("flashlight") > 0;
-				bool hasR = itGI->second.count("rifle") > 0;
-				bool hasS = itGI->second.count("shotgun") > 0;
-				bool hasA = itGI->second.count("armor") > 0;
-				int cntK = hasK ? itGI->second.at("knife") : 0;
-				int cntF = hasF ? itGI->second.at("flashlight") : 0;
-				int cntR = hasR ? itGI->second.at("rifle") : 0;
-				int cntS = hasS ? itGI->second.at("shotgun") : 0;
-				int cntA = hasA ? itGI->second.at("armor") : 0;
-				int distinct = (hasK?1:0) + (hasF?1:0) + (hasR?1:0) + (hasS?1:0) + (hasA?1:0);
-				std::string label;
-				if (hasK) label.push_back('K');
-				if (hasF) label.push_back('F');
-				if (hasR) label.push_back('R');
-				if (hasS) label.push_back('S');
-				if (hasA) label.push_back('A');
-				if (distinct == 1) {
-					int c = hasK?cntK : hasF?cntF : hasR?cntR : hasS?cntS : cntA;
-					if (c > 1) label += std::to_string(c);
-				}
-				oss << "<text x=\"" << cx << "\" y=\"" << cy << "\" fill=\"#111\" font-size=\""
-				    << (cell_px*0.55f) << "\" font-family=\"monospace\" text-anchor=\"middle\" dominant-baseline=\"central\">"
-				    << label << "</text>\n";
-			}
-		}
+	oss << "</g>\n";
+}
+
+/** Стены окна (склеенные прогоны, по path на линию) и отметки выхода. */
+static void emit_walls(std::ostringstream& oss, const LabyrinthMap& map, const SvgFrame& f) {
+	std::vector<WallRun> runs;
+	for (size_t x = f.view.x; x <= f.vx1; ++x) emit_wall_col(oss, map, f, x, runs);
+	for (size_t y = f.view.y; y <= f.vy1; ++y) emit_wall_row(oss, map, f, y, runs);
+	emit_exit_marks(oss, map, f);
+}
+
+/** Игроки (несколько в клетке — кластером) и бот; O(игроков), целиком уходит в каждый патч. */
+static void emit_markers(std::ostringstream& oss, const AppState& st, const SvgFrame& f) {
+	const float cell_px = f.cell_px, sw = f.sw;
+	// Build turn order index for stable ordering when enforced
+	std::unordered_map<std::string, size_t> orderIndex;
+	if (st.game.enforce_turns && !st.game.turn_order.empty()) {
+		for (size_t i = 0; i < st.game.turn_order.size(); ++i) orderIndex[st.game.turn_order[i]] = i;
 	}
-	// players (support multiple per cell - draw smaller circles in cluster)
-	{
-		// Build turn order index for stable ordering when enforced
-		std::unordered_map<std::string, size_t> orderIndex;
-		if (st.game.enforce_turns && !st.game.turn_order.empty()) {
-			for (size_t i = 0; i < st.game.turn_order.size(); ++i) orderIndex[st.game.turn_order[i]] = i;
-		}
-		std::map<long long, std::vector<std::pair<std::string,std::string>>> groups;
-		for (const auto& kv : st.game.players) {
-			long long key = (long long)kv.second.second * 1000000LL + (long long)kv.second.first;
-			std::string col = "#1f77b4";
-			auto itc = st.game.player_color.find(kv.first);
-			if (itc != st.game.player_color.end()) col = itc->second;
-			groups[key].push_back({kv.first, col});
-		}
-		std::string current_actor;
-		if (st.game.enforce_turns && !st.game.turn_order.empty() && st.game.turn_index < st.game.turn_order.size()) {
-			current_actor = st.game.turn_order[st.game.turn_index];
+	std::map<long long, std::vector<std::pair<std::string,std::string>>> groups;
+	const PlayerTable& pl = st.game.players;
+	for (PlayerId id = 0; id < pl.size(); ++id) {
+		long long key = (long long)pl.pos[id].second * 1000000LL + (long long)pl.pos[id].first;
+		const std::string col = pl.color[id].empty() ? std::string("#1f77b4") : pl.color[id];
+		groups[key].push_back({pl.name[id], col});
+	}
+	std::string current_actor;
+	if (st.game.enforce_turns && !st.game.turn_order.empty() && st.game.turn_index < st.game.turn_order.size()) {
+		current_actor = st.game.turn_order[st.game.turn_index];
+	}
+	for (const auto& g : groups) {
+		size_t gy = (size_t)(g.first / 1000000LL);
+		size_t gx = (size_t)(g.first % 1000000LL);
+		float base_x = f.ox + gx * cell_px + cell_px * 0.5f;
+		float base_y = f.oy + gy * cell_px + cell_px * 0.5f;
+		auto vec = g.second;
+		std::sort(vec.begin(), vec.end(), [&](const auto& a, const auto& b){
+			auto ia = orderIndex.find(a.first);
+			auto ib = orderIndex.find(b.first);
+			if (ia != orderIndex.end() && ib != orderIndex.end()) return ia->second < ib->second;
+			if (ia != orderIndex.end() && ib == orderIndex.end()) return true;
+			if (ia == orderIndex.end() && ib != orderIndex.end()) return false;
+			return a.first < b.first;
+		});
+		size_t n = f.view.contains(gx, gy) ? vec.size() : 0;
+		// offsets and sizes
+		std::vector<std::pair<float,float>> offs;
+		float rr = (n <= 1 ? cell_px*0.28f : cell_px*0.20f);
+		float txdy = (n <= 1 ? cell_px*0.02f : 0.0f);
+		if (n == 1) {
+			offs = {{0.0f, 0.0f}};
+		} else if (n == 2) {
+			float d = cell_px * 0.18f;
+			offs = {{-d, 0.0f}, {d, 0.0f}};
+		} else if (n == 3) {
+			float dx = cell_px * 0.16f, dy = cell_px * 0.14f;
+			offs = {{0.0f, -dy}, {-dx, dy}, {dx, dy}};
+		} else if (n > 3) {
+			float dx = cell_px * 0.18f, dy = cell_px * 0.18f;
+			offs = {{-dx,-dy}, {dx,-dy}, {-dx,dy}, {dx,dy}};
 		}
-		for (const auto& g : groups) {
-			size_t gy = (size_t)(g.first / 1000000LL);
-			size_t gx = (size_t)(g.first % 1000000LL);
-			float base_x = margin_px + gx * cell_px + cell_px * 0.5f;
-			float base_y = margin_px + gy * cell_px + cell_px * 0.5f;
-			auto vec = g.second;
-			std::sort(vec.begin(), vec.end(), [&](const auto& a, const auto& b){
-				auto ia = orderIndex.find(a.first);
-				auto ib = orderIndex.find(b.first);
-				if (ia != orderIndex.end() && ib != orderIndex.end()) return ia->second < ib->second;
-				if (ia != orderIndex.end() && ib == orderIndex.end()) return true;
-				if (ia == orderIndex.end() && ib != orderIndex.end()) return false;
-				return a.first < b.first;
-			});
-			size_t n = vec.size();
-			// offsets and sizes
-			std::vector<std::pair<float,float>> offs;
-			float rr = (n <= 1 ? cell_px*0.28f : cell_px*0.20f);
-			float txdy = (n <= 1 ? cell_px*0.02f : 0.0f);
-			if (n == 1) {
-				offs = {{0.0f, 0.0f}};
-			} else if (n == 2) {
-				float d = cell_px * 0.18f;
-				offs = {{-d, 0.0f}, {d, 0.0f}};
-			} else if (n == 3) {
-				float dx = cell_px * 0.16f, dy = cell_px * 0.14f;
-				offs = {{0.0f, -dy}, {-dx, dy}, {dx, dy}};
-			} else {
-				float dx = cell_px * 0.18f, dy = cell_px * 0.18f;
-				offs = {{-dx,-dy}, {dx,-dy}, {-dx,dy}, {dx,dy}};
+		for (size_t i = 0; i < vec.size() && i < offs.size(); ++i) {
+			float cx = base_x + offs[i].first;
+			float cy = base_y + offs[i].second;
+			const std::string& name = vec[i].first;
+			const std::string& col = vec[i].second;
+			oss << "<circle cx=\"" << cx << "\" cy=\"" << cy << "\" r=\"" << rr
+			    << "\" fill=\"" << col << "\" opacity=\"0.9\"/>\n";
+			// highlight current actor
+			if (!current_actor.empty() && name == current_actor) {
+				oss << "<circle cx=\"" << cx << "\" cy=\"" << cy << "\" r=\"" << (rr + sw*0.8f)
+				    << "\" fill=\"none\" stroke=\"#ff9800\" stroke-width=\"" << (sw*1.6f) << "\"/>\n";
 			}
-			for (size_t i = 0; i < vec.size() && i < offs.size(); ++i) {
-				float cx = base_x + offs[i].first;
-				float cy = base_y + offs[i].second;
-				const std::string& name = vec[i].first;
-				const std::string& col = vec[i].second;
-				oss << "<circle cx=\"" << cx << "\" cy=\"" << cy << "\" r=\"" << rr
-				    << "\" fill=\"" << col << "\" opacity=\"0.9\"/>\n";
-				// highlight current actor
-				if (!current_actor.empty() && name == current_actor) {
-					oss << "<circle cx=\"" << cx << "\" cy=\"" << cy << "\" r=\"" << (rr + sw*0.8f)
+			if (!f.text) continue;
+			char label = name.empty() ? 'P' : static_cast<char>(::toupper(name[0]));
+			oss << "<text x=\"" << cx << "\" y=\"" << (cy + txdy) << "\" fill=\"#ffffff\" font-size=\""
+			    << (n <= 1 ? cell_px*0.45f : cell_px*0.34f) << "\" font-family=\"monospace\" text-anchor=\"middle\" dominant-baseline=\"central\">"
+			    << label << "</text>\n";
+		}
+		// Draw bot at its final position as distinct diamond
+		if (st.game.bot_enabled) {
+			size_t bx = st.game.bot_x, by = st.game.bot_y;
+			if (bx < st.map.width && by < st.map.height && f.view.contains(bx, by)) {
+				float cx = f.ox + bx * cell_px + cell_px * 0.5f;
+				float cy = f.oy + by * cell_px + cell_px * 0.5f;
+				float rr2 = cell_px * 0.26f;
+				oss << "<polygon points=\""
+				    << cx << "," << (cy - rr2) << " "
+				    << (cx + rr2) << "," << cy << " "
+				    << cx << "," << (cy + rr2) << " "
+				    << (cx - rr2) << "," << cy
+				    << "\" fill=\"#9c27b0\" stroke=\"#4a148c\" stroke-width=\"" << (sw*0.9f) << "\"/>\n";
+				// Highlight if bot's turn
+				if (st.game.enforce_turns && !st.game.turn_order.empty() && st.game.turn_index < st.game.turn_order.size()
+				    && st.game.turn_order[st.game.turn_index] == "bot") {
+					oss << "<polygon points=\""
+					    << cx << "," << (cy - rr2 - sw*0.8f) << " "
+					    << (cx + rr2 + sw*0.8f) << "," << cy << " "
+					    << cx << "," << (cy + rr2 + sw*0.8f) << " "
+					    << (cx - rr2 - sw*0.8f) << "," << cy
 					    << "\" fill=\"none\" stroke=\"#ff9800\" stroke-width=\"" << (sw*1.6f) << "\"/>\n";
 				}
-				char label = name.empty() ? 'P' : static_cast<char>(::toupper(name[0]));
-				oss << "<text x=\"" << cx << "\" y=\"" << (cy + txdy) << "\" fill=\"#ffffff\" font-size=\""
-				    << (n <= 1 ? cell_px*0.45f : cell_px*0.34f) << "\" font-family=\"monospace\" text-anchor=\"middle\" dominant-baseline=\"central\">"
-				    << label << "</text>\n";
-			}
-			// Draw bot at its final position as distinct diamond
-			if (st.game.bot_enabled) {
-				size_t bx = st.game.bot_x, by = st.game.bot_y;
-				if (bx < st.map.width && by < st.map.height) {
-					float cx = margin_px + bx * cell_px + cell_px * 0.5f;
-					float cy = margin_px + by * cell_px + cell_px * 0.5f;
-					float rr2 = cell_px * 0.26f;
-					oss << "<polygon points=\""
-					    << cx << "," << (cy - rr2) << " "
-					    << (cx + rr2) << "," << cy << " "
-					    << cx << "," << (cy + rr2) << " "
-					    << (cx - rr2) << "," << cy
-					    << "\" fill=\"#9c27b0\" stroke=\"#4a148c\" stroke-width=\"" << (sw*0.9f) << "\"/>\n";
-					// Highlight if bot's turn
-					if (st.game.enforce_turns && !st.game.turn_order.empty() && st.game.turn_index < st.game.turn_order.size()
-					    && st.game.turn_order[st.game.turn_index] == "bot") {
-						oss << "<polygon points=\""
-						    << cx << "," << (cy - rr2 - sw*0.8f) << " "
-						    << (cx + rr2 + sw*0.8f) << "," << cy << " "
-						    << cx << "," << (cy + rr2 + sw*0.8f) << " "
-						    << (cx - rr2 - sw*0.8f) << "," << cy
-						    << "\" fill=\"none\" stroke=\"#ff9800\" stroke-width=\"" << (sw*1.6f) << "\"/>\n";
-					}
+				if (f.text) {
 					oss << "<text x=\"" << cx << "\" y=\"" << (cy + cell_px*0.02f) << "\" fill=\"#ffffff\" font-size=\""
 					    << (cell_px*0.4f) << "\" font-family=\"monospace\" text-anchor=\"middle\" dominant-baseline=\"central\">B</text>\n";
 				}
 			}
 		}
 	}
+}
+
+/** Панель игроков справа от карты. */
+static void emit_panel(std::ostringstream& oss, const AppState& st, const SvgFrame& f) {
+	const float cell_px = f.cell_px, sw = f.sw, panel_w = f.panel_w;
 	// Stats panel on the right
-	float panel_left = margin_px + map_w + panel_gap;
-	float panel_top = margin_px;
-	float panel_bottom = h - margin_px;
+	float panel_left = f.margin_px + f.map_w + f.panel_gap;
+	float panel_top = f.margin_px;
+	float panel_bottom = f.h - f.margin_px;
 	oss << "<rect x=\"" << panel_left << "\" y=\"" << panel_top << "\" width=\"" << panel_w << "\" height=\"" << (panel_bottom - panel_top)
 	    << "\" fill=\"#ffffff\" stroke=\"#cccccc\" stroke-width=\"" << (sw*0.6f) << "\"/>\n";
 	oss << "<text x=\"" << (panel_left + panel_w*0.5f) << "\" y=\"" << (panel_top + cell_px*0.6f) << "\" fill=\"#111\" font-size=\""
@@ -321,23 +434,20 @@ std::string render_svg(const AppState& st, float cell_px, float margin_px) {
 	if (st.game.enforce_turns && !st.game.turn_order.empty()) {
 		// Use fixed turn order for panel; filter to currently present players
 		for (const auto& n : st.game.turn_order) {
-			if (st.game.players.count(n)) names.push_back(n);
+			if (st.game.players.contains(n)) names.push_back(n);
 		}
 		// Append any stragglers (unlikely), alphabetically
-		for (const auto& kv : st.game.players) {
-			if (std::find(names.begin(), names.end(), kv.first) == names.end()) names.push_back(kv.first);
+		for (const auto& n : st.game.players.name) {
+			if (std::find(names.begin(), names.end(), n) == names.end()) names.push_back(n);
 		}
 	} else {
-		names.reserve(st.game.players.size());
-		for (const auto& kv : st.game.players) names.push_back(kv.first);
+		names = st.game.players.name;
 		std::sort(names.begin(), names.end());
 	}
 	for (const auto& name : names) {
-		auto itp = st.game.players.find(name);
-		if (itp == st.game.players.end()) continue;
-		std::string col = "#1f77b4";
-		auto itc = st.game.player_color.find(name);
-		if (itc != st.game.player_color.end()) col = itc->second;
+		const PlayerId id = st.game.players.find(name);
+		if (id == kNoPlayer) continue;
+		const std::string col = st.game.players.color[id].empty() ? std::string("#1f77b4") : st.game.players.color[id];
 		float cx = panel_left + cell_px * 0.5f;
 		float cy = ycur + row_h * 0.5f;
 		oss << "<circle cx=\"" << cx << "\" cy=\"" << cy << "\" r=\"" << (cell_px*0.35f)
@@ -353,7 +463,7 @@ std::string render_svg(const AppState& st, float cell_px, float margin_px) {
 		oss << "<text x=\"" << (panel_left + cell_px*1.2f) << "\" y=\"" << (cy + cell_px*0.02f) << "\" fill=\"#111\" font-size=\""
 		    << (cell_px*0.5f) << "\" font-family=\"monospace\" dominant-baseline=\"central\">" << name << "</text>\n";
 		// items: knife status, treasure
-		bool broken = st.game.broken_knife.count(name) > 0;
+		bool broken = st.game.players.knife_broken[id] != 0;
 		std::string kcol = broken ? "#d32f2f" : "#2e7d32";
 		// layout anchors
 		float fx = panel_left + panel_w - cell_px * 3.8f;
@@ -362,11 +472,8 @@ std::string render_svg(const AppState& st, float cell_px, float margin_px) {
 		float kx = panel_left + panel_w - cell_px * 2.2f;
 		std::string icol = "#333333";
 		// show items the player has; grey out when charges==0
-		auto itInv = st.game.inventories.find(name);
-		auto get_ch = [&](const char* id)->int {
-			if (itInv == st.game.inventories.end()) return 0;
-			return itInv->second.getCharges(id);
-		};
+		const Inventory& inv = st.game.players.inventory[id];
+		auto get_ch = [&](const char* item)->int { return inv.getCharges(item); };
 		auto draw_item = [&](float x, const char* label, bool present, bool active, const std::string& active_col) {
 			if (!present) return;
 			const std::string coltxt = active ? active_col : std::string("#999999");
@@ -374,18 +481,18 @@ std::string render_svg(const AppState& st, float cell_px, float margin_px) {
 			    << "\" font-size=\"" << (cell_px*0.6f) << "\" font-family=\"monospace\" text-anchor=\"middle\" dominant-baseline=\"central\">"
 			    << label << "</text>\n";
 		};
-		bool hasFlash = itInv != st.game.inventories.end() && itInv->second.item_charges.count("flashlight");
-		bool hasRifle  = itInv != st.game.inventories.end() && itInv->second.item_charges.count("rifle");
-		bool hasShot   = itInv != st.game.inventories.end() && itInv->second.item_charges.count("shotgun");
-		bool hasKnife  = itInv != st.game.inventories.end() && itInv->second.item_charges.count("knife");
-		bool hasArmor  = itInv != st.game.inventories.end() && itInv->second.item_charges.count("armor");
+		bool hasFlash = inv.item_charges.count("flashlight");
+		bool hasRifle  = inv.item_charges.count("rifle");
+		bool hasShot   = inv.item_charges.count("shotgun");
+		bool hasKnife  = inv.item_charges.count("knife");
+		bool hasArmor  = inv.item_charges.count("armor");
 		float ax = panel_left + panel_w - cell_px * 4.6f;
 		draw_item(ax, "A", hasArmor, get_ch("armor") > 0, std::string("#1565c0"));
 		draw_item(fx, "F", hasFlash, get_ch("flashlight") > 0, icol);
 		draw_item(rx, "R", hasRifle,  get_ch("rifle") > 0,      icol);
 		draw_item(sx, "S", hasShot,   get_ch("shotgun") > 0,    icol);
 		draw_item(kx, "K", true,      get_ch("knife") > 0 && !broken, kcol);
-		bool hasT = player_has_treasure(st.game, name);
+		bool hasT = player_has_treasure(st.game, id);
 		if (hasT) {
 			float tx = panel_left + panel_w - cell_px * 0.9f;
 			oss << "<circle cx=\"" << tx << "\" cy=\"" << cy << "\" r=\"" << (cell_px*0.22f)
@@ -393,11 +500,179 @@ std::string render_svg(const AppState& st, float cell_px, float margin_px) {
 		}
 		ycur += row_h;
 	}
+}
+
+std::string render_svg(const AppState& st, float cell_px, float margin_px, const SvgOptions& opt) {
+	LAB_TRACE_SCOPE("render.svg");
+	LAB_ALLOC_SCOPE("render.svg");
+	const auto& map = st.map;
+	const SvgFrame f = make_frame(map, cell_px, margin_px, opt);
+	std::ostringstream oss;
+	oss << R"(<svg xmlns="http://www.w3.org/2000/svg")"
+	    << " viewBox=\"0 0 " << f.w << " " << f.h << "\""
+	    << " width=\"" << f.w << "\" height=\"" << f.h << "\">";
+	oss << "<rect x=\"0\" y=\"0\" width=\"" << f.w << "\" height=\"" << f.h << "\" fill=\"#ffffff\"/>\n";
+	// слои в именованных группах — svg-patch заменяет их содержимое или отдельные клетки по data-x/data-y
+	// grid faint (на Coarse сетки нет — клетка меньше нескольких пикселей)
+	oss << "<g id=\"lab-cells\">\n";
+	if (f.lod != SvgLod::Coarse) {
+		const CellPlayers players_in_cell = players_by_cell(st, f.view);
+		for (size_t y = f.view.y; y < f.vy1; ++y)
+			for (size_t x = f.view.x; x < f.vx1; ++x) emit_cell_rect(oss, st, f, players_in_cell, x, y);
+	}
+	oss << "</g>\n";
+	// per-cell coordinate labels (x,y) in top-left corner
+	if (opt.coord_labels && f.text) {
+		oss << "<g id=\"lab-labels\">\n";
+		for (size_t y = f.view.y; y < f.vy1; ++y) {
+			for (size_t x = f.view.x; x < f.vx1; ++x) {
+				float tx = f.ox + x * cell_px + cell_px * 0.5f;
+				float ty = f.oy + y * cell_px + cell_px * 0.5f;
+				oss << "<text x=\"" << tx << "\" y=\"" << ty << "\" fill=\"#000000\" fill-opacity=\"0.22\" font-size=\""
+				    << (cell_px*0.28f) << "\" font-family=\"monospace\" text-anchor=\"middle\" dominant-baseline=\"central\">"
+				    << x << "," << y << "</text>\n";
+			}
+		}
+		oss << "</g>\n";
+	}
+	oss << "<g id=\"lab-walls\">\n";
+	emit_walls(oss, map, f);
+	oss << "</g>\n<g id=\"lab-items\">\n";
+	if (f.lod == SvgLod::Coarse) {
+		emit_coarse_items(oss, map, f);
+	} else {
+		for (size_t y = f.view.y; y < f.vy1; ++y)
+			for (size_t x = f.view.x; x < f.vx1; ++x) emit_cell_items(oss, st, f, x, y);
+	}
+	oss << "</g>\n<g id=\"lab-markers\">\n";
+	emit_markers(oss, st, f);
+	oss << "</g>\n";
+	if (opt.panel) {
+		oss << "<g id=\"lab-panel\">\n";
+		emit_panel(oss, st, f);
+		oss << "</g>\n";
+	}
 	oss << "</svg>\n";
 	return oss.str();
 }
 
-std::string render_html(const AppState& st, float cell_px, float margin_px) {
+static void json_svg_string(std::ostringstream& js, const std::string& s) {
+	js << '"';
+	for (char c : s) {
+		if (c == '"') js << "\\\"";
+		else if (c == '\\') js << "\\\\";
+		else if (c == '\n') js << "\\n";
+		else js << c;
+	}
+	js << '"';
+}
+
+std::string render_svg_patch(const AppState& before, const AppState& st, float cell_px, float margin_px, const SvgOptions& opt) {
+	LAB_TRACE_SCOPE("render.svg_patch");
+	LAB_ALLOC_SCOPE("render.svg_patch");
+	const auto& map = st.map;
+	const SvgFrame f = make_frame(map, cell_px, margin_px, opt);
+	// другой размер карты или склеенные полосы Coarse — клетку не заменить точечно
+	if (before.map.width != map.width || before.map.height != map.height || f.lod == SvgLod::Coarse) {
+		return "{\"full\":true}\n";
+	}
+	// что могло измениться — из дельт журнала между версиями, без обхода окна; общего шага нет — полный рендер
+	std::vector<const StateDelta*> steps;
+	if (!journal_divergence(before.journal, st.journal, steps)) return "{\"full\":true}\n";
+	auto in_view = [&](long long key) {
+		return f.view.contains((size_t)(key % 1000000LL), (size_t)(key / 1000000LL));
+	};
+	std::set<long long> changed;
+	std::set<size_t> wall_cols, wall_rows;
+	for (const StateDelta* d : steps) {
+		for (const auto& c : d->cells)
+			if (f.view.contains(c.x, c.y)) changed.insert((long long)c.y * 1000000LL + (long long)c.x);
+		for (const auto& w : d->walls) {
+			if (w.vertical && w.x >= f.view.x && w.x <= f.vx1 && w.y >= f.view.y && w.y < f.vy1) wall_cols.insert(w.x);
+			if (!w.vertical && w.y >= f.view.y && w.y <= f.vy1 && w.x >= f.view.x && w.x < f.vx1) wall_rows.insert(w.y);
+		}
+	}
+	// лут, предметы на земле и состав игроков в клетке — только по ключам, O(изменяемых объектов)
+	auto diff_keys = [&](const auto& a, const auto& b) {
+		for (const auto& kv : a) {
+			auto it = b.find(kv.first);
+			if ((it == b.end() || !(it->second == kv.second)) && in_view(kv.first)) changed.insert(kv.first);
+		}
+		for (const auto& kv : b)
+			if (!a.count(kv.first) && in_view(kv.first)) changed.insert(kv.first);
+	};
+	diff_keys(before.game.loot_treasure, st.game.loot_treasure);
+	diff_keys(before.game.ground_items, st.game.ground_items);
+	// игроки в клетке идут по PlayerId в обеих версиях — списки сравнимы без сортировки
+	const CellPlayers pa = players_by_cell(before, f.view);
+	const CellPlayers pb = players_by_cell(st, f.view);
+	diff_keys(pa, pb);
+
+	std::ostringstream js;
+	js << "{\"full\":false,\"cells\":[";
+	bool first = true;
+	for (long long key : changed) {
+		size_t x = (size_t)(key % 1000000LL), y = (size_t)(key / 1000000LL);
+		std::ostringstream frag;
+		emit_cell_rect(frag, st, f, pb, x, y);
+		emit_cell_items(frag, st, f, x, y);
+		if (!first) js << ",";
+		first = false;
+		js << "{\"x\":" << x << ",\"y\":" << y << ",\"svg\":";
+		json_svg_string(js, frag.str());
+		js << "}";
+	}
+	js << "],\"walls\":";
+	const auto& bm = before.map;
+	const bool exit_changed = bm.has_exit != map.has_exit || bm.exit_vertical != map.exit_vertical ||
+		bm.exit_x != map.exit_x || bm.exit_y != map.exit_y;
+	if (!wall_cols.empty() || !wall_rows.empty() || exit_changed) {
+		std::vector<WallRun> runs;
+		auto lines = [&](const char* name, const std::set<size_t>& idx, bool vertical) {
+			js << "\"" << name << "\":[";
+			bool first_line = true;
+			for (size_t i : idx) {
+				std::ostringstream frag;
+				if (vertical) emit_wall_col(frag, map, f, i, runs);
+				else emit_wall_row(frag, map, f, i, runs);
+				js << (first_line ? "" : ",") << "{\"i\":" << i << ",\"svg\":";
+				json_svg_string(js, frag.str());
+				js << "}";
+				first_line = false;
+			}
+			js << "]";
+		};
+		js << "{";
+		lines("cols", wall_cols, true);
+		js << ",";
+		lines("rows", wall_rows, false);
+		js << ",\"exit\":";
+		std::ostringstream frag;
+		emit_exit_marks(frag, map, f);
+		json_svg_string(js, frag.str());
+		js << "}";
+	} else {
+		js << "null";
+	}
+	js << ",\"markers\":";
+	{
+		std::ostringstream frag;
+		emit_markers(frag, st, f);
+		json_svg_string(js, frag.str());
+	}
+	js << ",\"panel\":";
+	if (opt.panel) {
+		std::ostringstream frag;
+		emit_panel(frag, st, f);
+		json_svg_string(js, frag.str());
+	} else {
+		js << "null";
+	}
+	js << "}\n";
+	return js.str();
+}
+
+std::string render_html(const AppState& st, float cell_px, float margin_px, const SvgOptions& opt) {
 	std::ostringstream html;
 	html << "<!doctype html>\n<html lang=\"en\">\n<head>\n<meta charset=\"utf-8\"/>\n"
 	     << "<meta name=\"viewport\" content=\"width=device-width, initial-scale=1\"/>\n"
@@ -411,7 +686,7 @@ std::string render_html(const AppState& st, float cell_px, float margin_px) {
 	     << "#info{margin-top:10px;font-size:14px;line-height:1.45;color:#333;}\n"
 	     << "#info code{background:#f0f0f0;padding:2px 4px;border-radius:4px;}\n"
 	     << "</style>\n</head>\n<body>\n<div class=\"wrap\"><div class=\"card\">\n";
-	html << render_svg(st, cell_px, margin_px);
+	html << render_svg(st, cell_px, margin_px, opt);
 	html << "\n<div id=\"info\"></div>\n";
 	html << "<script>\n";
 	html << "(() => {\n"
@@ -2,7 +2,37 @@
 #include "state.hpp"
 #include <string>
 
-std::string render_svg(const AppState& st, float cell_px, float margin_px);
-std::string render_html(const AppState& st, float cell_px, float margin_px);
+/**
+ * Уровень детализации SVG: Full — всё как раньше; Lite — без подписей координат и текста
+ * поверх клеток; Coarse — без сетки клеток, спецклетки склеены в полосы, предметы на земле не рисуются.
+ * Auto выбирает уровень по размеру клетки в пикселях.
+ */
+enum class SvgLod { Auto, Full, Lite, Coarse };
 
+/** Параметры SVG-экспорта; по умолчанию — полный вид, как раньше. */
+struct SvgOptions {
+	/** Подписи координат «x,y» в каждой клетке (самая тяжёлая часть SVG на больших картах). */
+	bool coord_labels{true};
+	/** Окно просмотра в клетках; без него рисуется вся карта. Стоимость рендера — по площади окна. */
+	bool has_view{false};
+	MapRect view;
+	SvgLod lod{SvgLod::Full};
+	/** Панель игроков справа (для тайлов отключается). */
+	bool panel{true};
+};
 
+/** Auto → конкретный уровень по cell_px; остальные значения возвращаются как есть. */
+SvgLod resolve_svg_lod(SvgLod lod, float cell_px);
+
+std::string render_svg(const AppState& st, float cell_px, float margin_px, const SvgOptions& opt = SvgOptions{});
+/**
+ * JSON-патч между двумя состояниями для уже показанного render_svg с теми же параметрами:
+ * {"full":bool, "cells":[{x,y,svg}], "walls":{cols:[{i,svg}], rows:[{i,svg}], exit:svg}|null,
+ * "markers":svg, "panel":svg|null}. cells — клетки окна, тронутые шагами журнала между версиями, и клетки
+ * с другим лутом, предметами или составом игроков: svg заменяет rect.cell из #lab-cells и группу
+ * g[data-x][data-y] из #lab-items. walls — только изменённые линии: svg заменяет path[data-col=i] /
+ * path[data-row=i] в #lab-walls, exit — группу g.exit; markers/panel — содержимое одноимённых групп.
+ * full:true — размер карты другой, Coarse или у журналов нет общего шага: нужен полный render_svg.
+ */
+std::string render_svg_patch(const AppState& before, const AppState& after, float cell_px, float margin_px, const SvgOptions& opt = SvgOptions{});
+std::string render_html(const AppState& st, float cell_px, float margin_px, const SvgOptions& opt = SvgOptions{});